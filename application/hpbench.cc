@@ -0,0 +1,89 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/logstream.h>
+
+#include <factory.h>
+#include <global.h>
+#include <instrumentation.h>
+#include <parameter.h>
+
+#ifdef LIKWID_PERFMON
+#  include <likwid-marker.h>
+#endif
+
+
+int
+main(int argc, char *argv[])
+{
+  try
+    {
+      dealii::Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+
+#ifdef LIKWID_PERFMON
+      LIKWID_MARKER_INIT;
+#endif
+
+      Parameter prm;
+
+      const std::string filename        = (argc > 1) ? argv[1] : "";
+      const std::string output_filename = (argc > 1) ? "" : "hpbench.prm";
+      dealii::ParameterAcceptor::initialize(filename, output_filename);
+      Instrumentation::set_mode(prm.instrumentation);
+
+      if (prm.log_deallog && getPCOut().is_active())
+        dealii::deallog.attach(getPCOut().get_stream());
+
+      getPCOut() << "Running with " << prm.linear_algebra << " on "
+                 << dealii::Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD) << " MPI rank(s)..."
+                 << std::endl;
+
+      AssertThrow(prm.problem_type == "Poisson",
+                  dealii::ExcMessage("Only the Poisson operators can be benchmarked so far."));
+
+      std::unique_ptr<ProblemBase> problem = Factory::create_application(
+        "Poisson benchmark", prm.operator_type, prm.dimension, prm.linear_algebra, prm);
+      problem->run();
+
+#ifdef LIKWID_PERFMON
+      LIKWID_MARKER_CLOSE;
+#endif
+    }
+  catch (std::exception &exc)
+    {
+      std::cerr << std::endl
+                << std::endl
+                << "----------------------------------------------------" << std::endl;
+      std::cerr << "Exception on processing: " << std::endl
+                << exc.what() << std::endl
+                << "Aborting!" << std::endl
+                << "----------------------------------------------------" << std::endl;
+
+      return 1;
+    }
+  catch (...)
+    {
+      std::cerr << std::endl
+                << std::endl
+                << "----------------------------------------------------" << std::endl;
+      std::cerr << "Unknown exception!" << std::endl
+                << "Aborting!" << std::endl
+                << "----------------------------------------------------" << std::endl;
+      return 1;
+    }
+
+  return 0;
+}
@@ -14,37 +14,149 @@
 // ---------------------------------------------------------------------
 
 
+#include <deal.II/base/exceptions.h>
 #include <deal.II/base/logstream.h>
+#include <deal.II/base/multithread_info.h>
 
 #include <factory.h>
 #include <global.h>
+#include <instrumentation.h>
 #include <parameter.h>
 
+#include <string>
+#include <vector>
 
-int
-main(int argc, char *argv[])
+#ifdef LIKWID_PERFMON
+#  include <likwid-marker.h>
+#endif
+
+
+namespace
 {
-  try
-    {
-      dealii::Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+  void
+  run_problem(const std::string &filename, const std::string &output_filename)
+  {
+    Parameter prm;
+    dealii::ParameterAcceptor::initialize(filename, output_filename);
+    Instrumentation::set_mode(prm.instrumentation);
+
+    // Threads are only used for the setup of smoothers and the assembly of
+    // matrix-based operators, for which we share the cores of each node
+    // among its MPI ranks.
+    if (prm.prm_multigrid.threaded_smoother_setup || prm.threaded_assembly)
+      {
+        MPI_Comm node_communicator;
+        int      ierr = MPI_Comm_split_type(
+          MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_communicator);
+        AssertThrowMPI(ierr);
+        const unsigned int n_ranks_on_node =
+          dealii::Utilities::MPI::n_mpi_processes(node_communicator);
+        ierr = MPI_Comm_free(&node_communicator);
+        AssertThrowMPI(ierr);
 
-      Parameter prm;
+        dealii::MultithreadInfo::set_thread_limit(
+          std::max(1u, dealii::MultithreadInfo::n_cores() / n_ranks_on_node));
+      }
 
-      const std::string filename        = (argc > 1) ? argv[1] : "";
-      const std::string output_filename = (argc > 1) ? "" : "poisson.prm";
-      dealii::ParameterAcceptor::initialize(filename, output_filename);
+    if (prm.log_deallog && getPCOut().is_active())
+      dealii::deallog.attach(getPCOut().get_stream());
 
-      if (prm.log_deallog && getPCOut().is_active())
-        dealii::deallog.attach(getPCOut().get_stream());
+    getPCOut() << "Running with " << prm.linear_algebra << " on "
+               << dealii::Utilities::MPI::n_mpi_processes(getCommunicator()) << " MPI rank(s)..."
+               << std::endl;
 
-      getPCOut() << "Running with " << prm.linear_algebra << " on "
-                 << dealii::Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD) << " MPI rank(s)..."
-                 << std::endl;
+    MPI_Comm shared_memory_communicator = MPI_COMM_SELF;
+    if (prm.shared_memory_ghosts)
+      {
+        const int ierr =
+          MPI_Comm_split_type(getCommunicator(),
+                              MPI_COMM_TYPE_SHARED,
+                              dealii::Utilities::MPI::this_mpi_process(getCommunicator()),
+                              MPI_INFO_NULL,
+                              &shared_memory_communicator);
+        AssertThrowMPI(ierr);
+        getSharedMemoryCommunicator() = shared_memory_communicator;
+      }
 
+    {
       std::unique_ptr<ProblemBase> problem = Factory::create_application(
         prm.problem_type, prm.operator_type, prm.dimension, prm.linear_algebra, prm);
       problem->run();
     }
+
+    if (prm.shared_memory_ghosts)
+      {
+        getSharedMemoryCommunicator() = MPI_COMM_SELF;
+        const int ierr = MPI_Comm_free(&shared_memory_communicator);
+        AssertThrowMPI(ierr);
+      }
+  }
+
+
+
+  /**
+   * Split all processes into equally sized groups, one per parameter file
+   * unless there are fewer processes. Each group works through its share of
+   * the parameter files one after the other, with timer and table of its own.
+   */
+  void
+  run_ensemble(const std::vector<std::string> &filenames)
+  {
+    const unsigned int n_processes = dealii::Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD);
+    const unsigned int rank        = dealii::Utilities::MPI::this_mpi_process(MPI_COMM_WORLD);
+
+    const unsigned int n_groups = std::min<unsigned int>(filenames.size(), n_processes);
+    const unsigned int group    = static_cast<unsigned long>(rank) * n_groups / n_processes;
+
+    MPI_Comm group_communicator;
+    int ierr = MPI_Comm_split(MPI_COMM_WORLD, group, rank, &group_communicator);
+    AssertThrowMPI(ierr);
+    getCommunicator() = group_communicator;
+
+    for (unsigned int i = group; i < filenames.size(); i += n_groups)
+      {
+        getPCOut() << "Group " << group << " of " << n_groups << ": " << filenames[i]
+                   << std::endl;
+
+        // parameters of the previous problem are declared anew
+        dealii::ParameterAcceptor::prm.clear();
+        run_problem(filenames[i], "");
+
+        getTimer().reset();
+        getTable().clear();
+      }
+
+    getCommunicator() = MPI_COMM_WORLD;
+    ierr = MPI_Comm_free(&group_communicator);
+    AssertThrowMPI(ierr);
+  }
+} // namespace
+
+
+
+int
+main(int argc, char *argv[])
+{
+  try
+    {
+      dealii::Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
+
+#ifdef LIKWID_PERFMON
+      LIKWID_MARKER_INIT;
+#endif
+
+      // several parameter files are run concurrently on groups of processes
+      if (argc > 2)
+        run_ensemble(std::vector<std::string>(argv + 1, argv + argc));
+      else if (argc > 1)
+        run_problem(argv[1], "");
+      else
+        run_problem("", "poisson.prm");
+
+#ifdef LIKWID_PERFMON
+      LIKWID_MARKER_CLOSE;
+#endif
+    }
   catch (std::exception &exc)
     {
       std::cerr << std::endl
@@ -19,6 +19,10 @@
 
 #include <deal.II/lac/vector.h>
 
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <vector>
+
 
 namespace Adaptation
 {
@@ -46,6 +50,43 @@ namespace Adaptation
     get_error_estimates() const = 0;
     virtual const dealii::Vector<float> &
     get_hp_indicators() const = 0;
+
+    // Measured cost of one cell for each finite element of the collection.
+    // Only strategies that weigh error reduction against cost use them.
+    virtual void
+    set_cost_per_cell(const std::vector<double> & /*cost_per_cell*/)
+    {}
+
+    // MatrixFree object of the operator on the current mesh, which the
+    // matrix-free error estimator uses instead of setting up its own. A null
+    // pointer makes it set up its own again.
+    void
+    set_matrix_free(const dealii::MatrixFree<2, double> *matrix_free)
+    {
+      matrix_free_2d = matrix_free;
+    }
+    void
+    set_matrix_free(const dealii::MatrixFree<3, double> *matrix_free)
+    {
+      matrix_free_3d = matrix_free;
+    }
+
+  protected:
+    template <int dim>
+    const dealii::MatrixFree<dim, double> *
+    get_matrix_free() const
+    {
+      static_assert(dim == 2 || dim == 3, "Only implemented for dim = 2 and dim = 3.");
+
+      if constexpr (dim == 2)
+        return matrix_free_2d;
+      else
+        return matrix_free_3d;
+    }
+
+  private:
+    const dealii::MatrixFree<2, double> *matrix_free_2d = nullptr;
+    const dealii::MatrixFree<3, double> *matrix_free_3d = nullptr;
   };
 } // namespace Adaptation
 
@@ -0,0 +1,129 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef adaptation_fe_series_cache_h
+#define adaptation_fe_series_cache_h
+
+
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/utilities.h>
+
+#include <deal.II/hp/fe_collection.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include <global.h>
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace Adaptation
+{
+  /**
+   * Precalculate all transformation matrices of @p fe_series.
+   *
+   * If @p directory is not empty, the matrices are stored in a cache file in
+   * this directory, identified by @p name, the finite elements and the number
+   * of coefficients. Only the root process reads or computes the matrices,
+   * all others receive them in serialized form.
+   */
+  template <typename FESeriesType, int dim, int spacedim>
+  void
+  precalculate_transformation_matrices(
+    FESeriesType                                  &fe_series,
+    const std::string                             &name,
+    const dealii::hp::FECollection<dim, spacedim> &fe_collection,
+    const std::vector<unsigned int>               &n_coefficients_per_direction,
+    const std::string                             &directory,
+    const MPI_Comm                                 mpi_communicator)
+  {
+    using namespace dealii;
+
+    TimerOutput::Scope t(getTimer(), "calculate_transformation");
+
+    if (directory.empty())
+      {
+        fe_series.precalculate_all_transformation_matrices();
+        return;
+      }
+
+    std::string key = name + "-" + std::to_string(dim) + "-" + std::to_string(spacedim);
+    for (unsigned int i = 0; i < fe_collection.size(); ++i)
+      key += "-" + fe_collection[i].get_name() + "-" +
+             std::to_string(n_coefficients_per_direction[i]);
+
+    const std::string filename = directory + "/fe_series-" +
+                                 Utilities::to_string(std::hash<std::string>()(key)) + ".cache";
+
+    const bool is_root = (Utilities::MPI::this_mpi_process(mpi_communicator) == 0);
+
+    // The cache file starts with the full key to detect hash collisions.
+    std::string buffer;
+    bool        precalculated = false;
+    if (is_root)
+      {
+        std::ifstream file(filename, std::ios::binary);
+        if (file)
+          buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        if (buffer.compare(0, key.size() + 1, key + "\n") != 0)
+          {
+            fe_series.precalculate_all_transformation_matrices();
+            precalculated = true;
+
+            std::ostringstream oss;
+            oss << key << '\n';
+            {
+              boost::archive::binary_oarchive archive(oss);
+              fe_series.save_transformation_matrices(archive, 0);
+            }
+            buffer = oss.str();
+
+            // Other jobs might share the cache directory: only move complete
+            // files into place, so that they never read partially written ones.
+            const std::string tmp_filename = filename + ".tmp." + std::to_string(getpid());
+            std::ofstream file(tmp_filename, std::ios::binary);
+            file << buffer;
+            file.close();
+            if (!file || std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+              std::remove(tmp_filename.c_str());
+          }
+      }
+
+    buffer = Utilities::MPI::broadcast(mpi_communicator, buffer);
+
+    if (!precalculated)
+      {
+        std::istringstream iss(buffer);
+        std::string        stored_key;
+        std::getline(iss, stored_key);
+
+        boost::archive::binary_iarchive archive(iss);
+        fe_series.load_transformation_matrices(archive, 0);
+      }
+  }
+} // namespace Adaptation
+
+
+#endif
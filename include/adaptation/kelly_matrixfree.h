@@ -0,0 +1,56 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef adaptation_kelly_matrixfree_h
+#define adaptation_kelly_matrixfree_h
+
+
+#include <deal.II/dofs/dof_handler.h>
+
+#include <deal.II/lac/vector.h>
+
+#include <deal.II/matrix_free/matrix_free.h>
+
+
+namespace Adaptation
+{
+  namespace KellyMatrixFree
+  {
+    /**
+     * Same as KellyErrorEstimator::estimate() with the strategy
+     * face_diameter_over_twice_max_degree and no Neumann boundaries, but with
+     * face integrals evaluated by FEFaceEvaluation.
+     *
+     * Each inner face is processed once, by one of the processes owning an
+     * adjacent cell. Contributions to ghost cells are sent to their owners.
+     * Only scalar finite elements are supported.
+     *
+     * If given, @p matrix_free is used instead of setting up a MatrixFree
+     * object of our own. It has to be built on @p dof_handler with gradients,
+     * normal vectors and JxW values on inner faces, like the one of
+     * PoissonMatrixFree::PoissonOperator after enable_inner_faces(). Its
+     * constraints are ignored, since @p solution has them applied already.
+     */
+    template <int dim, typename VectorType>
+    void
+    estimate(const dealii::DoFHandler<dim>         &dof_handler,
+             const VectorType                      &solution,
+             dealii::Vector<float>                 &error_estimates,
+             const dealii::MatrixFree<dim, double> *matrix_free = nullptr);
+  } // namespace KellyMatrixFree
+} // namespace Adaptation
+
+
+#endif
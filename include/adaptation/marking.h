@@ -0,0 +1,104 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef adaptation_marking_h
+#define adaptation_marking_h
+
+
+#include <deal.II/base/array_view.h>
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/distributed/tria.h>
+
+#include <deal.II/dofs/dof_handler.h>
+
+#include <deal.II/lac/vector.h>
+
+#include <cmath>
+
+
+namespace Adaptation
+{
+  /**
+   * Marking of cells shared by all adaptation strategies.
+   *
+   * Criteria of locally owned cells are gathered into flat arrays first.
+   * Thresholds are found by a bisection over all processes, in which local
+   * counts are computed by parallel tasks, so that criteria are never sorted.
+   * Flags and future FE indices are set in a single pass afterwards, since
+   * the triangulation does not allow to set them concurrently.
+   */
+  namespace Marking
+  {
+    /**
+     * Return a threshold, so that about @p n_target of the @p criteria on
+     * all processes are larger than it.
+     */
+    float
+    compute_threshold(const dealii::ArrayView<const float> &criteria,
+                      const dealii::types::global_cell_index n_target,
+                      const MPI_Comm                         mpi_communicator);
+
+    /**
+     * Same as
+     * parallel::distributed::GridRefinement::refine_and_coarsen_fixed_number().
+     */
+    template <int dim, int spacedim>
+    void
+    refine_and_coarsen_fixed_number(
+      dealii::parallel::distributed::Triangulation<dim, spacedim> &triangulation,
+      const dealii::Vector<float>                                 &criteria,
+      const double                                                 top_fraction_of_cells,
+      const double                                                 bottom_fraction_of_cells);
+
+    /**
+     * Same as hp::Refinement::p_adaptivity_fixed_number() for the default
+     * comparison functions.
+     */
+    template <int dim, int spacedim>
+    void
+    p_adaptivity_fixed_number(dealii::DoFHandler<dim, spacedim> &dof_handler,
+                              const dealii::Vector<float>       &hp_indicators,
+                              const double                       p_refine_fraction,
+                              const double                       p_coarsen_fraction);
+
+    /**
+     * Same as hp::Refinement::predict_error(). Decay factors are tabulated for
+     * all combinations of degrees, so that the prediction is a single
+     * multiplication on flat per-cell arrays.
+     */
+    template <int dim, int spacedim>
+    void
+    predict_error(const dealii::DoFHandler<dim, spacedim> &dof_handler,
+                  const dealii::Vector<float>             &error_indicators,
+                  dealii::Vector<float>                   &predicted_errors,
+                  const double                             gamma_p = std::sqrt(0.4),
+                  const double                             gamma_h = 2.,
+                  const double                             gamma_n = 1.);
+
+    /**
+     * Clear refine flags on @p max_h_level and coarsen flags on
+     * @p min_h_level.
+     */
+    template <int dim, int spacedim>
+    void
+    limit_levels(dealii::parallel::distributed::Triangulation<dim, spacedim> &triangulation,
+                 const unsigned int                                           min_h_level,
+                 const unsigned int                                           max_h_level);
+  } // namespace Marking
+} // namespace Adaptation
+
+
+#endif
@@ -19,6 +19,8 @@
 
 #include <deal.II/base/parameter_acceptor.h>
 
+#include <string>
+
 
 namespace Adaptation
 {
@@ -62,6 +64,15 @@ namespace Adaptation
 
       weighting_exponent = 1.;
       add_parameter("weighting exponent", weighting_exponent);
+
+      measured_cell_weights = false;
+      add_parameter("measured cell weights", measured_cell_weights);
+
+      matrix_free_error_estimator = false;
+      add_parameter("matrix-free error estimator", matrix_free_error_estimator);
+
+      fe_series_cache_directory = "";
+      add_parameter("fe series cache directory", fe_series_cache_directory);
     }
 
     unsigned int n_cycles;
@@ -74,6 +85,14 @@ namespace Adaptation
     double p_refine_fraction, p_coarsen_fraction;
 
     double weighting_factor, weighting_exponent;
+
+    // replace the weighting above by cell costs measured in the first cycle
+    bool measured_cell_weights;
+
+    bool matrix_free_error_estimator;
+
+    // store FESeries transformation matrices here, empty disables the cache
+    std::string fe_series_cache_directory;
   };
 } // namespace Adaptation
 
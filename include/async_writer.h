@@ -0,0 +1,165 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef async_writer_h
+#define async_writer_h
+
+
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/numerics/data_out.h>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Write files in a background thread.
+ *
+ * Files are handed over as functions that encode their content into a stream,
+ * which own all the data they need, and are queued. At most @p max_queue_size
+ * files are pending at any time, further calls of write() wait until the queue
+ * has some room. The destructor waits for all pending files.
+ */
+class AsyncWriter
+{
+public:
+  AsyncWriter(const unsigned int max_queue_size);
+
+  ~AsyncWriter();
+
+  using EncodeFunction = std::function<void(std::ostream &)>;
+
+  void
+  write(const std::string &filename, EncodeFunction &&encode);
+
+  /**
+   * Wait until all pending files have been written.
+   */
+  void
+  wait();
+
+private:
+  void
+  run();
+
+  const unsigned int max_queue_size;
+
+  std::deque<std::pair<std::string, EncodeFunction>> queue;
+  bool                                               busy     = false;
+  bool                                               finished = false;
+
+  std::mutex              mutex;
+  std::condition_variable queue_changed;
+
+  std::thread thread;
+};
+
+
+
+namespace internal
+{
+  /**
+   * DataOut only hands out its patches and the names of its data sets to
+   * derived classes.
+   */
+  template <int dim, int spacedim>
+  struct DataOutAccess : public dealii::DataOut<dim, spacedim>
+  {
+    static std::vector<dealii::DataOutBase::Patch<dim, spacedim>>
+    copy_patches(const dealii::DataOut<dim, spacedim> &data_out)
+    {
+      return (data_out.*&DataOutAccess::get_patches)();
+    }
+
+    static std::vector<std::string>
+    copy_dataset_names(const dealii::DataOut<dim, spacedim> &data_out)
+    {
+      return (data_out.*&DataOutAccess::get_dataset_names)();
+    }
+
+    static auto
+    copy_nonscalar_data_ranges(const dealii::DataOut<dim, spacedim> &data_out)
+    {
+      return (data_out.*&DataOutAccess::get_nonscalar_data_ranges)();
+    }
+  };
+} // namespace internal
+
+
+
+/**
+ * Same as DataOut::write_vtu_with_pvtu_record(), but the vtu file of each
+ * process is encoded and written by @p writer in the background, including
+ * its compression. To this end, the background task gets its own copy of the
+ * patches built by @p data_out. Every process writes its own vtu file, since
+ * collective MPI-IO is not available in the background thread. The small pvtu
+ * record is written right away.
+ */
+template <int dim, int spacedim>
+void
+write_vtu_with_pvtu_record(AsyncWriter                         &writer,
+                           const dealii::DataOut<dim, spacedim> &data_out,
+                           const dealii::DataOutBase::VtkFlags  &flags,
+                           const std::string                    &directory,
+                           const std::string                    &filename_without_extension,
+                           const unsigned int                    counter,
+                           const MPI_Comm                        mpi_communicator,
+                           const unsigned int                    n_digits_for_counter)
+{
+  using namespace dealii;
+
+  const unsigned int this_process = Utilities::MPI::this_mpi_process(mpi_communicator);
+  const unsigned int n_processes  = Utilities::MPI::n_mpi_processes(mpi_communicator);
+  const unsigned int n_digits     = Utilities::needed_digits(n_processes - 1);
+
+  const std::string stem =
+    filename_without_extension + "_" + Utilities::int_to_string(counter, n_digits_for_counter);
+
+  const auto get_filename = [&](const unsigned int process) {
+    return stem + "." + Utilities::int_to_string(process, n_digits) + ".vtu";
+  };
+
+  using Access = internal::DataOutAccess<dim, spacedim>;
+
+  writer.write(directory + get_filename(this_process),
+               [patches       = Access::copy_patches(data_out),
+                dataset_names = Access::copy_dataset_names(data_out),
+                ranges        = Access::copy_nonscalar_data_ranges(data_out),
+                flags](std::ostream &out) {
+                 DataOutBase::write_vtu(patches, dataset_names, ranges, flags, out);
+               });
+
+  if (this_process == 0)
+    {
+      std::vector<std::string> filenames;
+      for (unsigned int process = 0; process < n_processes; ++process)
+        filenames.push_back(get_filename(process));
+
+      std::ofstream pvtu(directory + stem + ".pvtu");
+      data_out.write_pvtu_record(pvtu, filenames);
+    }
+}
+
+
+#endif
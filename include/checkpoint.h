@@ -0,0 +1,58 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef checkpoint_h
+#define checkpoint_h
+
+
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/distributed/tria.h>
+
+#include <string>
+#include <vector>
+
+
+namespace Checkpoint
+{
+  /**
+   * Load the checkpoint @p filename into @p triangulation. Cells are
+   * partitioned uniformly, so the triangulation has to be repartitioned once
+   * the active FE indices have been deserialized and cell weights apply.
+   */
+  template <int dim, int spacedim = dim>
+  void
+  load(const std::string                                           &filename,
+       dealii::parallel::distributed::Triangulation<dim, spacedim> &triangulation);
+
+  /**
+   * Store @p values, which are the same on all processes, next to the
+   * checkpoint @p filename.
+   */
+  void
+  write_values(const std::string         &filename,
+               const std::vector<double> &values,
+               const MPI_Comm             mpi_communicator);
+
+  /**
+   * Return the values stored by write_values(), or an empty vector if there
+   * are none.
+   */
+  std::vector<double>
+  read_values(const std::string &filename, const MPI_Comm mpi_communicator);
+} // namespace Checkpoint
+
+
+#endif
@@ -0,0 +1,51 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef errors_matrixfree_h
+#define errors_matrixfree_h
+
+
+#include <deal.II/base/function.h>
+
+#include <deal.II/dofs/dof_handler.h>
+
+#include <deal.II/hp/mapping_collection.h>
+#include <deal.II/hp/q_collection.h>
+
+#include <utility>
+
+
+namespace ErrorsMatrixFree
+{
+  /**
+   * Same as VectorTools::integrate_difference() with the L2 and the H1 norm,
+   * each followed by VectorTools::compute_global_error(), but with both norms
+   * computed in a single pass with FEEvaluation. Returns the pair of global
+   * L2 and H1 errors.
+   *
+   * The exact solution is evaluated by Function::VectorizedEvaluator. Only
+   * scalar finite elements are supported.
+   */
+  template <int dim, typename VectorType>
+  std::pair<double, double>
+  compute_L2_H1_errors(const dealii::hp::MappingCollection<dim> &mapping_collection,
+                       const dealii::DoFHandler<dim>            &dof_handler,
+                       const VectorType                         &solution,
+                       const dealii::Function<dim>              &exact_solution,
+                       const dealii::hp::QCollection<dim>       &quadrature_collection);
+} // namespace ErrorsMatrixFree
+
+
+#endif
@@ -20,6 +20,7 @@
 #include <deal.II/base/exceptions.h>
 
 #include <adaptation/h.h>
+#include <adaptation/hp_cost.h>
 #include <adaptation/hp_fourier.h>
 #include <adaptation/hp_full.h>
 #include <adaptation/hp_history.h>
@@ -28,6 +29,9 @@
 #include <function.h>
 #include <grid.h>
 #include <linear_algebra.h>
+#include <poisson/benchmark.h>
+#include <poisson/matrixbased_operator.h>
+#include <poisson/matrixfree_operator.h>
 #include <poisson/problem.h>
 #include <stokes_matrixbased/problem.h>
 #include <stokes_matrixfree/problem.h>
@@ -47,6 +51,9 @@ namespace Factory
     else if (type == "p")
       return std::make_unique<Adaptation::p<dim, VectorType, spacedim>>(
         std::forward<Args>(args)...);
+    else if (type == "hp Cost")
+      return std::make_unique<Adaptation::hpCost<dim, VectorType, spacedim>>(
+        std::forward<Args>(args)...);
     else if (type == "hp Fourier")
       return std::make_unique<Adaptation::hpFourier<dim, VectorType, spacedim>>(
         std::forward<Args>(args)...);
@@ -116,6 +123,46 @@ namespace Factory
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim = dim, typename... Args>
+  std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>>
+  create_poisson_operator(const std::string &type, Args &&...args)
+  {
+    if (type == "MatrixBased")
+      {
+        if constexpr (!std::is_same_v<LinearAlgebra, dealiiTrilinosFloat>)
+          {
+            return std::make_unique<
+              PoissonMatrixBased::PoissonOperator<dim, LinearAlgebra, spacedim>>(
+              std::forward<Args>(args)...);
+          }
+        else
+          {
+            AssertThrow(false,
+                        dealii::ExcMessage("MatrixBased only available in double precision!"));
+          }
+      }
+    else if (type == "MatrixFree")
+      {
+        if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos> ||
+                      std::is_same_v<LinearAlgebra, dealiiTrilinosFloat>)
+          {
+            return std::make_unique<
+              PoissonMatrixFree::PoissonOperator<dim, LinearAlgebra, spacedim>>(
+              std::forward<Args>(args)...);
+          }
+        else
+          {
+            AssertThrow(false,
+                        dealii::ExcMessage("MatrixFree only available with dealii & Trilinos!"));
+          }
+      }
+
+    AssertThrow(false, dealii::ExcNotImplemented());
+    return std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>>();
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim = dim, typename... Args>
   std::unique_ptr<ProblemBase>
   create_problem(const std::string &problem_type, const std::string operator_type, Args &&...args)
@@ -125,6 +172,11 @@ namespace Factory
         return std::make_unique<Poisson::Problem<dim, LinearAlgebra, spacedim>>(
           std::forward<Args>(args)...);
       }
+    else if (problem_type == "Poisson benchmark")
+      {
+        return std::make_unique<Poisson::Benchmark<dim, LinearAlgebra, spacedim>>(
+          std::forward<Args>(args)...);
+      }
     else if (problem_type == "Stokes")
       {
         if (operator_type == "MatrixBased")
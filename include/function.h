@@ -17,13 +17,84 @@
 #define function_h
 
 
+#include <deal.II/base/array_view.h>
 #include <deal.II/base/function.h>
+#include <deal.II/base/vectorization.h>
+
+#include <vector>
 
 
 namespace Function
 {
   template <int dim>
-  class ReentrantCorner : public dealii::Function<dim>
+  using VectorizedPoint = dealii::Point<dim, dealii::VectorizedArray<double>>;
+
+  template <int dim>
+  using VectorizedTensor = dealii::Tensor<1, dim, dealii::VectorizedArray<double>>;
+
+
+
+  /**
+   * Interface for functions that can be evaluated on a batch of points at
+   * once, e.g., on the quadrature points of a cell batch in FEEvaluation.
+   *
+   * Like for dealii::Function, vector_value() calls value() for each
+   * component unless overridden.
+   */
+  template <int dim>
+  class VectorizedFunction
+  {
+  public:
+    virtual ~VectorizedFunction() = default;
+
+    virtual dealii::VectorizedArray<double>
+    value(const VectorizedPoint<dim> &p, const unsigned int component = 0) const;
+
+    virtual VectorizedTensor<dim>
+    gradient(const VectorizedPoint<dim> &p, const unsigned int component = 0) const;
+
+    virtual void
+    vector_value(const VectorizedPoint<dim>                               &p,
+                 const dealii::ArrayView<dealii::VectorizedArray<double>> &values) const;
+  };
+
+
+
+  /**
+   * Evaluate an arbitrary function on a batch of points.
+   *
+   * Functions derived from VectorizedFunction are evaluated on the whole batch
+   * at once, and constant functions are only evaluated once on construction.
+   * All other functions are evaluated point by point.
+   */
+  template <int dim>
+  class VectorizedEvaluator
+  {
+  public:
+    explicit VectorizedEvaluator(const dealii::Function<dim> &function);
+
+    dealii::VectorizedArray<double>
+    value(const VectorizedPoint<dim> &p, const unsigned int component = 0) const;
+
+    VectorizedTensor<dim>
+    gradient(const VectorizedPoint<dim> &p, const unsigned int component = 0) const;
+
+    void
+    vector_value(const VectorizedPoint<dim>                               &p,
+                 const dealii::ArrayView<dealii::VectorizedArray<double>> &values) const;
+
+  private:
+    const dealii::Function<dim>   &function;
+    const VectorizedFunction<dim> *vectorized_function;
+
+    // values of all components, only filled for constant functions
+    std::vector<double> constant_values;
+  };
+
+
+
+  template <int dim>
+  class ReentrantCorner : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     ReentrantCorner(const double alpha = 2. / 3.);
@@ -34,6 +105,17 @@ namespace Function
     virtual dealii::Tensor<1, dim>
     gradient(const dealii::Point<dim> &p, const unsigned int component = 0) const override;
 
+    virtual void
+    value_list(const std::vector<dealii::Point<dim>> &points,
+               std::vector<double>                   &values,
+               const unsigned int                     component = 0) const override;
+
+    virtual dealii::VectorizedArray<double>
+    value(const VectorizedPoint<dim> &p, const unsigned int component = 0) const override;
+
+    virtual VectorizedTensor<dim>
+    gradient(const VectorizedPoint<dim> &p, const unsigned int component = 0) const override;
+
   private:
     const double alpha;
   };
@@ -42,27 +124,43 @@ namespace Function
    * Function from step-55.
    */
   template <int dim>
-  class KovasznayExactVelocity : public dealii::Function<dim>
+  class KovasznayExactVelocity : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     KovasznayExactVelocity();
 
     virtual void
     vector_value(const dealii::Point<dim> &p, dealii::Vector<double> &values) const override;
+
+    virtual void
+    vector_value_list(const std::vector<dealii::Point<dim>> &points,
+                      std::vector<dealii::Vector<double>>   &values) const override;
+
+    virtual void
+    vector_value(const VectorizedPoint<dim>                               &p,
+                 const dealii::ArrayView<dealii::VectorizedArray<double>> &values) const override;
   };
 
   template <int dim>
-  class KovasznayExactPressure : public dealii::Function<dim>
+  class KovasznayExactPressure : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     KovasznayExactPressure();
 
     virtual double
     value(const dealii::Point<dim> &p, const unsigned int component = 0) const override;
+
+    virtual void
+    value_list(const std::vector<dealii::Point<dim>> &points,
+               std::vector<double>                   &values,
+               const unsigned int                     component = 0) const override;
+
+    virtual dealii::VectorizedArray<double>
+    value(const VectorizedPoint<dim> &p, const unsigned int component = 0) const override;
   };
 
   template <int dim>
-  class KovasznayExact : public dealii::Function<dim>
+  class KovasznayExact : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     KovasznayExact();
@@ -70,23 +168,35 @@ namespace Function
     virtual void
     vector_value(const dealii::Point<dim> &p, dealii::Vector<double> &values) const override;
 
-  private:
-    KovasznayExactVelocity<dim> velocity_function;
-    KovasznayExactPressure<dim> pressure_function;
+    virtual void
+    vector_value_list(const std::vector<dealii::Point<dim>> &points,
+                      std::vector<dealii::Vector<double>>   &values) const override;
+
+    virtual void
+    vector_value(const VectorizedPoint<dim>                               &p,
+                 const dealii::ArrayView<dealii::VectorizedArray<double>> &values) const override;
   };
 
   template <int dim>
-  class KovasznayRHSVelocity : public dealii::Function<dim>
+  class KovasznayRHSVelocity : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     KovasznayRHSVelocity();
 
     virtual void
     vector_value(const dealii::Point<dim> &p, dealii::Vector<double> &values) const override;
+
+    virtual void
+    vector_value_list(const std::vector<dealii::Point<dim>> &points,
+                      std::vector<dealii::Vector<double>>   &values) const override;
+
+    virtual void
+    vector_value(const VectorizedPoint<dim>                               &p,
+                 const dealii::ArrayView<dealii::VectorizedArray<double>> &values) const override;
   };
 
   template <int dim>
-  class KovasznayRHS : public dealii::Function<dim>
+  class KovasznayRHS : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     KovasznayRHS();
@@ -94,15 +204,20 @@ namespace Function
     virtual void
     vector_value(const dealii::Point<dim> &p, dealii::Vector<double> &values) const override;
 
-  private:
-    KovasznayRHSVelocity<dim> velocity_function;
+    virtual void
+    vector_value_list(const std::vector<dealii::Point<dim>> &points,
+                      std::vector<dealii::Vector<double>>   &values) const override;
+
+    virtual void
+    vector_value(const VectorizedPoint<dim>                               &p,
+                 const dealii::ArrayView<dealii::VectorizedArray<double>> &values) const override;
   };
 
   /**
    * Component version of PoisseuilleFlow
    */
   template <int dim>
-  class PoisseuilleFlowVelocity : public dealii::Function<dim>
+  class PoisseuilleFlowVelocity : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     PoisseuilleFlowVelocity(const double r);
@@ -110,12 +225,20 @@ namespace Function
     virtual void
     vector_value(const dealii::Point<dim> &p, dealii::Vector<double> &values) const override;
 
+    virtual void
+    vector_value_list(const std::vector<dealii::Point<dim>> &points,
+                      std::vector<dealii::Vector<double>>   &values) const override;
+
+    virtual void
+    vector_value(const VectorizedPoint<dim>                               &p,
+                 const dealii::ArrayView<dealii::VectorizedArray<double>> &values) const override;
+
   private:
     const double inv_sqr_radius;
   };
 
   template <int dim>
-  class PoisseuilleFlowPressure : public dealii::Function<dim>
+  class PoisseuilleFlowPressure : public dealii::Function<dim>, public VectorizedFunction<dim>
   {
   public:
     PoisseuilleFlowPressure(const double r, const double Re);
@@ -123,6 +246,14 @@ namespace Function
     virtual double
     value(const dealii::Point<dim> &p, const unsigned int component = 0) const override;
 
+    virtual void
+    value_list(const std::vector<dealii::Point<dim>> &points,
+               std::vector<double>                   &values,
+               const unsigned int                     component = 0) const override;
+
+    virtual dealii::VectorizedArray<double>
+    value(const VectorizedPoint<dim> &p, const unsigned int component = 0) const override;
+
   private:
     const double inv_sqr_radius;
     const double Reynolds;
@@ -18,9 +18,23 @@
 
 
 #include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/mpi.h>
 #include <deal.II/base/table_handler.h>
 #include <deal.II/base/timer.h>
 
+#include <ostream>
+
+
+// Table of all cycles, which can also write its current row on its own.
+class CycleTable : public dealii::TableHandler
+{
+public:
+  // Write the current row as a single JSON object on one line. Entries are
+  // formatted as in write_text(), and columns without an entry are skipped.
+  void
+  write_current_row_json(std::ostream &out) const;
+};
+
 
 // Use 'construct on first use' idiom for global static variables.
 //
@@ -30,13 +44,26 @@
 // the ConditionalOStream object after construction, but no longer once passed
 // to TimerOutput.
 
+// Communicator of all problems, which is MPI_COMM_WORLD unless the processes
+// are split into groups that run different problems. In that case, it needs
+// to be assigned before any of the other singletons is used, which are then
+// shared only within each group.
+MPI_Comm &
+getCommunicator();
+
+// Processes of getCommunicator() on the same node, among which MatrixFree
+// objects exchange ghost values via MPI-3 shared memory. MPI_COMM_SELF
+// disables this, which is the default.
+MPI_Comm &
+getSharedMemoryCommunicator();
+
 dealii::ConditionalOStream &
 getPCOut();
 
 dealii::TimerOutput &
 getTimer();
 
-dealii::TableHandler &
+CycleTable &
 getTable();
 
 
@@ -0,0 +1,130 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef instrumentation_h
+#define instrumentation_h
+
+
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/table_handler.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+/**
+ * Wall times and call counts of sections in hot loops, like operator
+ * applications in smoothers, at a fraction of the cost of TimerOutput.
+ *
+ * Sections are enumerated at compile time. A Scope adds its wall time to
+ * counters of its own thread without any lookup or lock. Counters are only
+ * reduced over threads and processes in add_to_table(), which is supposed to
+ * be called at the end of each cycle while no sections are active.
+ */
+namespace Instrumentation
+{
+  enum Section
+  {
+    vmult,
+    vmult_asm,
+    vmult_extdiag,
+    vmult_diagonal,
+    vmult_diagonal_a_block,
+    vmult_diagonal_schur_block,
+    vmult_a_block_operator,
+    vmult_schur_block_operator,
+    vmult_stokes_operator,
+    vmult_block_schur_preconditioner,
+    n_sections
+  };
+
+  /**
+   * Off records nothing. Summary adds the maximum wall time and the number
+   * of calls of each section to the table, while detailed adds minimum,
+   * maximum and average wall time over all processes like
+   * Log::log_timing_statistics() does.
+   */
+  enum class Mode
+  {
+    off,
+    summary,
+    detailed
+  };
+
+  void
+  set_mode(const std::string &mode);
+
+  Mode
+  get_mode();
+
+  std::string
+  get_name(const Section section);
+
+  void
+  add(const Section section, const double wall_time);
+
+  /**
+   * Add all sections called on any process to @p table and reset all
+   * counters. Has to be called collectively.
+   */
+  void
+  add_to_table(dealii::TableHandler &table, const MPI_Comm mpi_communicator);
+
+  /**
+   * Discard everything recorded while this object exists, e.g. during
+   * calibration runs. The counters are restored on destruction, which has to
+   * happen while no sections are active.
+   */
+  class Discard
+  {
+  public:
+    Discard();
+
+    ~Discard();
+
+  private:
+    std::vector<double>             wall_time;
+    std::vector<unsigned long long> n_calls;
+  };
+
+  class Scope
+  {
+  public:
+    explicit Scope(const Section section)
+      : section(section)
+      , active(get_mode() != Mode::off)
+    {
+      if (active)
+        start = std::chrono::steady_clock::now();
+    }
+
+    ~Scope()
+    {
+      if (active)
+        add(section,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+  private:
+    const Section section;
+    const bool    active;
+
+    std::chrono::time_point<std::chrono::steady_clock> start;
+  };
+} // namespace Instrumentation
+
+
+#endif
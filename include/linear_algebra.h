@@ -145,6 +145,30 @@ struct dealiiTrilinos
   using SolverCG           = dealii::SolverCG<Vector>;
 };
 
+/**
+ * Single precision variant of dealiiTrilinos, meant for the level operators of
+ * mixed-precision multigrid methods.
+ *
+ * Trilinos only provides sparse matrices in double precision, so matrices and
+ * sparsity patterns are the same as in dealiiTrilinos.
+ *
+ * Only available if deal.II has been configured with Trilinos.
+ */
+struct dealiiTrilinosFloat
+{
+  using SparsityPattern = dealii::TrilinosWrappers::SparsityPattern;
+  using SparseMatrix    = dealii::TrilinosWrappers::SparseMatrix;
+  using Vector          = dealii::LinearAlgebra::distributed::Vector<float>;
+
+  using BlockSparsityPattern = dealii::TrilinosWrappers::BlockSparsityPattern;
+  using BlockSparseMatrix    = dealii::TrilinosWrappers::BlockSparseMatrix;
+  using BlockVector          = dealii::LinearAlgebra::distributed::BlockVector<float>;
+
+  using PreconditionAMG    = dealii::TrilinosWrappers::PreconditionAMG;
+  using PreconditionJacobi = dealii::TrilinosWrappers::PreconditionJacobi;
+  using SolverCG           = dealii::SolverCG<Vector>;
+};
+
 template <int dim, int spacedim>
 inline void
 initialize_sparse_matrix(dealii::TrilinosWrappers::SparseMatrix  &system_matrix,
@@ -215,6 +239,15 @@ struct Trilinos
 struct dealiiTrilinos
 {};
 
+/**
+ * Single precision variant of dealiiTrilinos, meant for the level operators of
+ * mixed-precision multigrid methods.
+ *
+ * Only available if deal.II has been configured with Trilinos.
+ */
+struct dealiiTrilinosFloat
+{};
+
 #endif // DEAL_II_WITH_TRILINOS
 
 
@@ -255,4 +288,103 @@ struct PETSc
 #endif // DEAL_II_WITH_PETSC
 
 
+
+/**
+ * Hash of everything that determines the sparsity pattern of a matrix on the
+ * current process: the global DoF indices on locally owned cells, and the
+ * constrained DoFs together with the DoFs they depend on.
+ */
+template <int dim, int spacedim>
+inline std::size_t
+compute_sparsity_hash(const dealii::DoFHandler<dim, spacedim> &dof_handler,
+                      const dealii::AffineConstraints<double> &constraints)
+{
+  std::size_t hash = 0;
+
+  const auto hash_combine = [&hash](const std::size_t value) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  };
+
+  std::vector<dealii::types::global_dof_index> local_dof_indices;
+  for (const auto &cell : dof_handler.active_cell_iterators())
+    if (cell->is_locally_owned())
+      {
+        local_dof_indices.resize(cell->get_fe().n_dofs_per_cell());
+        cell->get_dof_indices(local_dof_indices);
+        for (const auto i : local_dof_indices)
+          hash_combine(i);
+      }
+
+  for (const auto &line : constraints.get_lines())
+    {
+      hash_combine(line.index);
+      for (const auto &entry : line.entries)
+        hash_combine(entry.first);
+    }
+
+  return hash;
+}
+
+
+
+/**
+ * Like initialize_sparse_matrix(), but keep the sparsity pattern and storage
+ * of @p system_matrix if @p sparsity_hash shows that neither DoFs nor
+ * constraints have changed on any process since the last call. In that case,
+ * only the values are set to zero.
+ */
+template <int dim, typename MatrixType, int spacedim>
+inline void
+reinit_or_zero_sparse_matrix(MatrixType                              &system_matrix,
+                             std::size_t                             &sparsity_hash,
+                             const dealii::DoFHandler<dim, spacedim> &dof_handler,
+                             const dealii::AffineConstraints<double> &constraints,
+                             const Partitioning                      &partitioning)
+{
+  const std::size_t  hash     = compute_sparsity_hash(dof_handler, constraints);
+  const unsigned int matching = (hash == sparsity_hash) && (system_matrix.m() > 0);
+
+  if (dealii::Utilities::MPI::min(matching, dof_handler.get_communicator()) == 1)
+    {
+      system_matrix = 0.;
+    }
+  else
+    {
+      initialize_sparse_matrix(system_matrix, dof_handler, constraints, partitioning);
+      sparsity_hash = hash;
+    }
+}
+
+
+
+/**
+ * Block variant of reinit_or_zero_sparse_matrix(). The @p coupling has to be
+ * the same in every call.
+ */
+template <int dim, typename BlockMatrixType, int spacedim>
+inline void
+reinit_or_zero_block_sparse_matrix(BlockMatrixType                         &system_matrix,
+                                   std::size_t                             &sparsity_hash,
+                                   const dealii::DoFHandler<dim, spacedim> &dof_handler,
+                                   const dealii::AffineConstraints<double> &constraints,
+                                   const Partitioning                      &partitioning,
+                                   const dealii::Table<2, dealii::DoFTools::Coupling> &coupling)
+{
+  const std::size_t  hash     = compute_sparsity_hash(dof_handler, constraints);
+  const unsigned int matching = (hash == sparsity_hash) && (system_matrix.m() > 0);
+
+  if (dealii::Utilities::MPI::min(matching, dof_handler.get_communicator()) == 1)
+    {
+      system_matrix = 0.;
+    }
+  else
+    {
+      system_matrix.clear();
+      initialize_block_sparse_matrix(
+        system_matrix, dof_handler, constraints, partitioning, coupling);
+      sparsity_hash = hash;
+    }
+}
+
+
 #endif
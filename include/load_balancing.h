@@ -0,0 +1,39 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef load_balancing_h
+#define load_balancing_h
+
+
+#include <vector>
+
+
+namespace LoadBalancing
+{
+  /**
+   * Translate measured @p costs per cell of each finite element into integer
+   * weights for parallel::CellWeights, with the cheapest element at 1000.
+   *
+   * Elements without measurement, marked by zero cost, get the cost of the
+   * power law c * n^e in their number of DoFs per cell @p n_dofs_per_cell,
+   * fitted to the measured ones in the least-squares sense. With only one
+   * measurement, the cost is assumed to grow linearly with n.
+   */
+  std::vector<unsigned int>
+  fit_weights(const std::vector<double> &costs, const std::vector<unsigned int> &n_dofs_per_cell);
+} // namespace LoadBalancing
+
+
+#endif
@@ -24,8 +24,11 @@
 #include <deal.II/lac/affine_constraints.h>
 #include <deal.II/lac/solver_control.h>
 
+#include <multigrid/patch_indices.h>
 #include <parameter.h>
 
+#include <string>
+
 
 namespace Log
 {
@@ -56,10 +59,28 @@ namespace Log
   void
   log_timing_statistics(const MPI_Comm mpi_communicator);
 
+  // Add min, max and avg over all processes of @p bytes in MB to the table.
+  void
+  log_memory_consumption(const std::string &name,
+                         const std::size_t  bytes,
+                         const MPI_Comm     mpi_communicator);
+
+  // Add current and peak resident memory of the processes to the table.
+  void
+  log_memory_statistics(const MPI_Comm mpi_communicator);
+
+  // Write the table on the first process. The format text rewrites the whole
+  // table to @p filename, while jsonl appends the current row as a single
+  // line to @p filename with extension .jsonl instead of .log.
+  void
+  write_table(const std::string &filename,
+              const std::string &format,
+              const MPI_Comm     mpi_communicator);
+
   template <int dim, int spacedim>
   void
-  log_patch_dofs(const std::vector<std::vector<dealii::types::global_dof_index>> &patch_indices,
-                 const dealii::DoFHandler<dim, spacedim>                         &dof_handler);
+  log_patch_dofs(const PatchIndices                      &patch_indices,
+                 const dealii::DoFHandler<dim, spacedim> &dof_handler);
 } // namespace Log
 
 
@@ -0,0 +1,102 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef matrix_free_dispatch_h
+#define matrix_free_dispatch_h
+
+
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <type_traits>
+#include <utility>
+
+
+/**
+ * Highest polynomial degree for which matrix-free kernels are compiled with a
+ * fixed degree. Higher degrees use FEEvaluation with runtime degree.
+ */
+constexpr int max_precompiled_fe_degree = 8;
+
+
+
+/**
+ * Call @p f with std::integral_constant<int, fe_degree>, if @p fe_degree is
+ * in the range [@p min_degree, max_precompiled_fe_degree]. Return whether
+ * @p f has been called.
+ */
+template <int min_degree = 1, typename Function>
+bool
+expand_fe_degree(const unsigned int fe_degree, const Function &f)
+{
+  if constexpr (min_degree > max_precompiled_fe_degree)
+    {
+      (void)fe_degree;
+      (void)f;
+      return false;
+    }
+  else
+    {
+      if (fe_degree == min_degree)
+        {
+          f(std::integral_constant<int, min_degree>());
+          return true;
+        }
+
+      return expand_fe_degree<min_degree + 1>(fe_degree, f);
+    }
+}
+
+
+
+/**
+ * Call @p f with the polynomial degree of the cell batches in @p range as a
+ * compile-time constant. MatrixFree groups cells by their active FE index, so
+ * all batches in @p range share the same element. Dispatch only happens for
+ * elements with fe_degree + 1 quadrature points in each direction, for which
+ * FEEvaluation<dim, fe_degree> is valid. Return whether @p f has been called.
+ *
+ * The element is the one of DoFHandler @p dof_no, evaluated with quadrature
+ * @p quad_no of @p matrix_free.
+ */
+template <int dim, typename Number, typename Function>
+bool
+dispatch_fe_degree(const dealii::MatrixFree<dim, Number>       &matrix_free,
+                   const std::pair<unsigned int, unsigned int> &range,
+                   const unsigned int                           dof_no,
+                   const unsigned int                           quad_no,
+                   const Function                              &f)
+{
+  const unsigned int fe_index = matrix_free.get_cell_active_fe_index(range);
+
+  const auto &shape_info = matrix_free.get_shape_info(dof_no, quad_no, 0, fe_index, fe_index);
+  if (shape_info.data[0].n_q_points_1d != shape_info.data[0].fe_degree + 1)
+    return false;
+
+  return expand_fe_degree(shape_info.data[0].fe_degree, f);
+}
+
+
+
+template <int dim, typename Number, typename Function>
+bool
+dispatch_fe_degree(const dealii::MatrixFree<dim, Number>       &matrix_free,
+                   const std::pair<unsigned int, unsigned int> &range,
+                   const Function                              &f)
+{
+  return dispatch_fe_degree(matrix_free, range, 0, 0, f);
+}
+
+
+#endif
@@ -0,0 +1,182 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_amg_cache_h
+#define multigrid_amg_cache_h
+
+
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/timer.h>
+
+#ifdef DEAL_II_WITH_TRILINOS
+#  include <deal.II/lac/trilinos_precondition.h>
+#  include <deal.II/lac/trilinos_sparse_matrix.h>
+#endif
+
+#include <global.h>
+
+#include <functional>
+#include <string>
+#include <type_traits>
+
+
+/**
+ * AMG preconditioner that persists across solves.
+ *
+ * The matrix it has been set up for is identified by its address together
+ * with hashes of sparsity pattern and values on the locally owned rows. On
+ * initialize(), the setup is skipped entirely if the very same matrix did not
+ * change on any process. If only the values changed, the AMG of Trilinos keeps
+ * its aggregation and only recomputes the level matrices and smoothers via
+ * TrilinosWrappers::PreconditionAMG::reinit(). In all other cases, the
+ * preconditioner is set up anew.
+ *
+ * The AdditionalData passed to initialize() is expected to be the same in
+ * every call.
+ */
+template <typename PreconditionerType>
+class AMGCache
+{
+public:
+  enum class Setup
+  {
+    full,
+    reinit,
+    skipped
+  };
+
+  template <typename MatrixType>
+  Setup
+  initialize(const MatrixType                                  &matrix,
+             const typename PreconditionerType::AdditionalData &data);
+
+  /**
+   * Forget the matrix, so that the next call of initialize() sets up the
+   * preconditioner anew.
+   */
+  void
+  clear()
+  {
+    matrix_address = nullptr;
+    pattern_hash   = 0;
+    values_hash    = 0;
+  }
+
+  const PreconditionerType &
+  get_preconditioner() const
+  {
+    return preconditioner;
+  }
+
+  static std::string
+  get_name(const Setup setup)
+  {
+    switch (setup)
+      {
+        case Setup::full:
+          return "full";
+        case Setup::reinit:
+          return "reinit";
+        case Setup::skipped:
+          return "skipped";
+      }
+    return "";
+  }
+
+private:
+  PreconditionerType preconditioner;
+
+  // identifies the matrix the preconditioner has been set up for
+  const void *matrix_address = nullptr;
+  std::size_t pattern_hash   = 0;
+  std::size_t values_hash    = 0;
+};
+
+
+
+template <typename PreconditionerType>
+template <typename MatrixType>
+typename AMGCache<PreconditionerType>::Setup
+AMGCache<PreconditionerType>::initialize(const MatrixType                                  &matrix,
+                                         const typename PreconditionerType::AdditionalData &data)
+{
+  using namespace dealii;
+
+  TimerOutput::Scope t(getTimer(), "setup_amg");
+
+  // Trilinos matrices might replace their Epetra matrix on reinit, to which
+  // the AMG keeps a pointer.
+  const void *address = &matrix;
+#ifdef DEAL_II_WITH_TRILINOS
+  if constexpr (std::is_same_v<MatrixType, TrilinosWrappers::SparseMatrix>)
+    address = &matrix.trilinos_matrix();
+#endif
+
+  std::size_t new_pattern_hash = 0, new_values_hash = 0;
+
+  const auto hash_combine = [](std::size_t &hash, const std::size_t value) {
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  };
+
+  const auto local_range = matrix.local_range();
+  for (auto row = local_range.first; row < local_range.second; ++row)
+    for (auto entry = matrix.begin(row); entry != matrix.end(row); ++entry)
+      {
+        hash_combine(new_pattern_hash, entry->row());
+        hash_combine(new_pattern_hash, entry->column());
+        hash_combine(new_values_hash, std::hash<double>()(entry->value()));
+      }
+
+  const unsigned int same_pattern =
+    (address == matrix_address) && (new_pattern_hash == pattern_hash);
+  const unsigned int same_values = same_pattern && (new_values_hash == values_hash);
+
+  const MPI_Comm     communicator     = matrix.get_mpi_communicator();
+  const unsigned int all_same_pattern = Utilities::MPI::min(same_pattern, communicator);
+  const unsigned int all_same_values  = Utilities::MPI::min(same_values, communicator);
+
+  Setup setup = Setup::full;
+  if (all_same_values == 1)
+    {
+      setup = Setup::skipped;
+    }
+  else if (all_same_pattern == 1)
+    {
+#ifdef DEAL_II_WITH_TRILINOS
+      if constexpr (std::is_same_v<PreconditionerType, TrilinosWrappers::PreconditionAMG>)
+        {
+          preconditioner.reinit();
+          setup = Setup::reinit;
+        }
+      else
+#endif
+        {
+          preconditioner.initialize(matrix, data);
+        }
+    }
+  else
+    {
+      preconditioner.initialize(matrix, data);
+    }
+
+  matrix_address = address;
+  pattern_hash   = new_pattern_hash;
+  values_hash    = new_values_hash;
+
+  return setup;
+}
+
+
+#endif
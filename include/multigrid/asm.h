@@ -23,6 +23,9 @@
 #include <deal.II/lac/sparse_matrix_tools.h>
 
 #include <global.h>
+#include <instrumentation.h>
+#include <multigrid/patch_batches.h>
+#include <multigrid/patch_indices.h>
 
 
 // NOTE:
@@ -49,56 +52,93 @@ private:
   using Number = typename VectorType::value_type;
 
 public:
-  PreconditionASM(const std::vector<std::vector<types::global_dof_index>> &patch_indices)
-    : indices(patch_indices)
+  PreconditionASM(const PatchIndices &patch_indices, const bool threaded_setup = false)
+    : threaded_setup(threaded_setup)
+    , indices(patch_indices)
   {}
 
-  PreconditionASM(std::vector<std::vector<types::global_dof_index>> &&patch_indices)
-    : indices(std::move(patch_indices))
+  PreconditionASM(PatchIndices &&patch_indices, const bool threaded_setup = false)
+    : threaded_setup(threaded_setup)
+    , indices(std::move(patch_indices))
   {}
 
+  // If @p inverse_diagonal is given, the 1x1 blocks of DoFs outside of any
+  // patch are taken from it, and @p global_sparse_matrix only needs to contain
+  // entries between patch DoFs.
   template <typename GlobalSparseMatrixType, typename GlobalSparsityPattern, int dim, int spacedim>
   void
   initialize(const GlobalSparseMatrixType    &global_sparse_matrix,
              const GlobalSparsityPattern     &global_sparsity_pattern,
-             const DoFHandler<dim, spacedim> &dof_handler)
+             const DoFHandler<dim, spacedim> &dof_handler,
+             const VectorType                *inverse_diagonal = nullptr)
+  {
+    initialize(global_sparse_matrix,
+               global_sparsity_pattern,
+               dof_handler.locally_owned_dofs(),
+               DoFTools::extract_locally_relevant_dofs(dof_handler),
+               dof_handler.get_communicator(),
+               inverse_diagonal);
+  }
+
+  // Same as above for a numbering that is not the one of a single DoFHandler,
+  // e.g., the monolithic one of a block system. All patch indices have to be
+  // part of @p relevant.
+  template <typename GlobalSparseMatrixType, typename GlobalSparsityPattern>
+  void
+  initialize(const GlobalSparseMatrixType &global_sparse_matrix,
+             const GlobalSparsityPattern  &global_sparsity_pattern,
+             const IndexSet               &owned,
+             const IndexSet               &relevant,
+             const MPI_Comm                communicator,
+             const VectorType             *inverse_diagonal = nullptr)
   {
     TimerOutput::Scope t(getTimer(), "initialize_asm");
 
     // treat unprocessed DoFs as blocks of size 1x1
 
-    // TODO: I do not need a dof_handler but rather a partitioner here
-    //       Move this part into the constructor
-
     // ATTENTION: This function modifies indices. Do not call this twice!
 
-    const IndexSet relevant = DoFTools::extract_locally_relevant_dofs(dof_handler);
-    VectorType     unprocessed_indices(dof_handler.locally_owned_dofs(),
-                                   relevant,
-                                   dof_handler.get_communicator());
+    VectorType unprocessed_indices(owned, relevant, communicator);
 
     // 'indices' contains global indices on locally owned cells
-    for (const auto &indices_i : indices)
-      for (const auto i : indices_i)
-        unprocessed_indices[i]++;
+    for (const auto i : indices.get_all_indices())
+      unprocessed_indices[i]++;
 
     unprocessed_indices.compress(VectorOperation::add);
 
+    const unsigned int n_patches = indices.size();
+
     for (const auto &i : unprocessed_indices.locally_owned_elements())
       if (unprocessed_indices[i] == 0)
-        indices.emplace_back(std::vector<types::global_dof_index>{i});
+        {
+          indices.add_index(i);
+          indices.close_patch();
+        }
 
     //
     // build blocks
     //
+    std::vector<FullMatrix<Number>> blocks;
     SparseMatrixTools::restrict_to_full_matrices(global_sparse_matrix,
                                                  global_sparsity_pattern,
-                                                 indices,
+                                                 indices.get_patch_vectors(),
                                                  blocks);
 
-    for (auto &block : blocks)
-      if (block.m() > 0 && block.n() > 0)
-        block.gauss_jordan();
+    if (inverse_diagonal != nullptr)
+      for (unsigned int b = n_patches; b < blocks.size(); ++b)
+        {
+          blocks[b].reinit(1, 1);
+          blocks[b](0, 0) = Number(1.) / (*inverse_diagonal)[indices[b][0]];
+        }
+
+    apply_to_patch_ranges(
+      blocks.size(),
+      [&](const unsigned int begin, const unsigned int end) {
+        for (unsigned int b = begin; b < end; ++b)
+          if (blocks[b].m() > 0 && blocks[b].n() > 0)
+            blocks[b].gauss_jordan();
+      },
+      threaded_setup);
 
     //
     // prepare weights
@@ -107,7 +147,7 @@ public:
     Vector<Number> vector_weights;
     if (weighting_type != WeightingType::none)
       {
-        weights.reinit(dof_handler.locally_owned_dofs(), relevant, dof_handler.get_communicator());
+        weights.reinit(owned, relevant, communicator);
 
         for (unsigned int c = 0; c < indices.size(); ++c)
           {
@@ -132,71 +172,88 @@ public:
     //
     if (weighting_type != WeightingType::none)
       {
-        for (unsigned int cell = 0; cell < indices.size(); ++cell)
-          {
-            const unsigned int dofs_per_cell = indices[cell].size();
-
-            vector_weights.reinit(dofs_per_cell);
-            for (unsigned int i = 0; i < dofs_per_cell; ++i)
-              vector_weights[i] += weights[indices[cell][i]];
-
-            auto &block = blocks[cell];
-
-            if (weighting_type == WeightingType::symm || weighting_type == WeightingType::right)
-              {
-                // multiply weights from right B(wI), i.e.,
-                // multiply one weight for each column
-                for (unsigned int r = 0; r < dofs_per_cell; ++r)
-                  for (unsigned int c = 0; c < dofs_per_cell; ++c)
-                    block(r, c) *= vector_weights[c];
-              }
-
-            if (weighting_type == WeightingType::symm || weighting_type == WeightingType::left)
-              {
-                // multiply weights from left (wI)B, i.e.,
-                // multiply one weight for each row
-                for (unsigned int r = 0; r < dofs_per_cell; ++r)
-                  for (unsigned int c = 0; c < dofs_per_cell; ++c)
-                    block(r, c) *= vector_weights[r];
-              }
-          }
+        const auto apply_weights = [&](const unsigned int begin, const unsigned int end) {
+          Vector<Number> vector_weights;
+
+          for (unsigned int cell = begin; cell < end; ++cell)
+            {
+              const unsigned int dofs_per_cell = indices[cell].size();
+
+              vector_weights.reinit(dofs_per_cell);
+              for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                vector_weights[i] += weights[indices[cell][i]];
+
+              auto &block = blocks[cell];
+
+              if (weighting_type == WeightingType::symm || weighting_type == WeightingType::right)
+                {
+                  // multiply weights from right B(wI), i.e.,
+                  // multiply one weight for each column
+                  for (unsigned int r = 0; r < dofs_per_cell; ++r)
+                    for (unsigned int c = 0; c < dofs_per_cell; ++c)
+                      block(r, c) *= vector_weights[c];
+                }
+
+              if (weighting_type == WeightingType::symm || weighting_type == WeightingType::left)
+                {
+                  // multiply weights from left (wI)B, i.e.,
+                  // multiply one weight for each row
+                  for (unsigned int r = 0; r < dofs_per_cell; ++r)
+                    for (unsigned int c = 0; c < dofs_per_cell; ++c)
+                      block(r, c) *= vector_weights[r];
+                }
+            }
+        };
+
+        apply_to_patch_ranges(indices.size(), apply_weights, threaded_setup);
       }
+
+    //
+    // store blocks in batches for vectorized application
+    //
+    batches.reinit(indices, blocks, owned);
   }
 
   void
   vmult(VectorType &dst, const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult_asm");
+    Instrumentation::Scope t(Instrumentation::vmult_asm);
+
+    // Hide the ghost exchanges behind interior patches: one half is applied
+    // while ghost values of src arrive, the other one while dst is compressed.
+    const unsigned int n_interior = batches.n_interior_batches();
+    const unsigned int n_first    = n_interior / 2;
 
     dst = 0.0;
-    src.update_ghost_values();
+    src.update_ghost_values_start();
 
-    Vector<Number> vector_src, vector_dst;
+    batches.vmult_add(dst, src, 0, n_first);
 
-    for (unsigned int c = 0; c < indices.size(); ++c)
-      {
-        const unsigned int dofs_per_cell = indices[c].size();
+    src.update_ghost_values_finish();
 
-        vector_src.reinit(dofs_per_cell);
-        vector_dst.reinit(dofs_per_cell);
+    batches.vmult_add(dst, src, n_interior, batches.n_batches());
 
-        for (unsigned int i = 0; i < dofs_per_cell; ++i)
-          vector_src[i] += src[indices[c][i]];
+    dst.compress_start(VectorOperation::add);
 
-        blocks[c].vmult(vector_dst, vector_src);
-
-        for (unsigned int i = 0; i < dofs_per_cell; ++i)
-          dst[indices[c][i]] += vector_dst[i];
-      }
+    batches.vmult_add(dst, src, n_first, n_interior);
 
+    dst.compress_finish(VectorOperation::add);
     src.zero_out_ghost_values();
-    dst.compress(VectorOperation::add);
+  }
+
+  std::size_t
+  memory_consumption() const
+  {
+    return indices.memory_consumption() + batches.memory_consumption();
   }
 
 private:
+  // invert and weight patch matrices in parallel tasks
+  const bool threaded_setup;
+
   // make indices const!
-  std::vector<std::vector<types::global_dof_index>> indices;
-  std::vector<FullMatrix<Number>>                   blocks;
+  PatchIndices         indices;
+  PatchBatches<Number> batches;
 };
 
 DEAL_II_NAMESPACE_CLOSE
@@ -19,15 +19,15 @@
 
 #include <deal.II/lac/diagonal_matrix.h>
 
-#include <global.h>
+#include <instrumentation.h>
 
 
 template <typename VectorType>
 class DiagonalMatrixTimer : public dealii::Subscriptor
 {
 public:
-  DiagonalMatrixTimer(const std::string timer_section_name = "vmult_diagonal")
-    : timer_section_name(timer_section_name){};
+  DiagonalMatrixTimer(const Instrumentation::Section section = Instrumentation::vmult_diagonal)
+    : section(section){};
 
   VectorType &
   get_vector()
@@ -38,11 +38,28 @@ public:
   void
   vmult(VectorType &dst, const VectorType &src) const
   {
-    dealii::TimerOutput::Scope t(getTimer(), timer_section_name);
+    Instrumentation::Scope t(section);
 
     inverse_diagonal.vmult(dst, src);
   }
 
+  // Apply the inverse diagonal on the locally owned entries [begin, end).
+  // With this function, PreconditionChebyshev merges its vector updates into
+  // the cell loop of matrix-free operators. It is not timed, since it is
+  // called many times within a single operator application.
+  void
+  apply_to_subrange(const unsigned int                    begin,
+                    const unsigned int                    end,
+                    const typename VectorType::value_type *src_ptr,
+                    typename VectorType::value_type       *dst_ptr) const
+  {
+    const auto *diagonal_ptr = inverse_diagonal.get_vector().begin();
+
+    DEAL_II_OPENMP_SIMD_PRAGMA
+    for (unsigned int i = begin; i < end; ++i)
+      dst_ptr[i] = diagonal_ptr[i] * src_ptr[i];
+  }
+
   void
   precondition_Jacobi(VectorType                           &dst,
                       const VectorType                     &src,
@@ -52,8 +69,14 @@ public:
     dst *= omega;
   };
 
+  std::size_t
+  memory_consumption() const
+  {
+    return inverse_diagonal.memory_consumption();
+  }
+
 private:
-  const std::string timer_section_name;
+  const Instrumentation::Section section;
 
   dealii::DiagonalMatrix<VectorType> inverse_diagonal;
 };
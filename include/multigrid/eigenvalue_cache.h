@@ -0,0 +1,90 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_eigenvalue_cache_h
+#define multigrid_eigenvalue_cache_h
+
+
+#include <deal.II/base/mpi.h>
+
+#include <map>
+#include <vector>
+
+
+/**
+ * Eigenvalue estimates of the smoothers on each multigrid level, that persist
+ * across adaptation cycles.
+ *
+ * Estimates are identified by the hash of their level, see MGHierarchy. An
+ * estimate is only reused if it is available on all processes. With a
+ * positive @p max_age, estimates are recomputed once they have been reused
+ * that many times.
+ */
+class EigenvalueCache
+{
+public:
+  /**
+   * Prepare the cache for a new multigrid hierarchy with the given level
+   * hashes. Estimates of levels that no longer exist are dropped.
+   */
+  void
+  reinit(const std::vector<std::size_t> &level_hashes,
+         const MPI_Comm                  communicator,
+         const bool                      enabled,
+         const unsigned int              max_age);
+
+  /**
+   * Return the estimate on @p level if it is valid on all processes.
+   * Has to be called collectively.
+   */
+  bool
+  get(const unsigned int level, double &min_eigenvalue, double &max_eigenvalue);
+
+  void
+  set(const unsigned int level, const double min_eigenvalue, const double max_eigenvalue);
+
+  unsigned int
+  n_hits() const
+  {
+    return hits;
+  }
+
+  unsigned int
+  n_misses() const
+  {
+    return misses;
+  }
+
+private:
+  struct Entry
+  {
+    double       min_eigenvalue;
+    double       max_eigenvalue;
+    unsigned int age;
+  };
+
+  std::map<std::size_t, Entry> entries;
+  std::vector<std::size_t>     level_hashes;
+
+  MPI_Comm     communicator = MPI_COMM_WORLD;
+  bool         enabled      = true;
+  unsigned int max_age      = 0;
+
+  unsigned int hits   = 0;
+  unsigned int misses = 0;
+};
+
+
+#endif
@@ -25,6 +25,9 @@
 #include <deal.II/multigrid/mg_transfer_global_coarsening.templates.h>
 
 #include <global.h>
+#include <instrumentation.h>
+#include <multigrid/patch_batches.h>
+#include <multigrid/patch_indices.h>
 
 
 DEAL_II_NAMESPACE_OPEN
@@ -46,21 +49,23 @@ private:
   using Number = typename VectorType::value_type;
 
 public:
-  PreconditionExtendedDiagonal(
-    const std::vector<std::vector<types::global_dof_index>> &patch_indices)
-    : patch_indices(patch_indices)
+  PreconditionExtendedDiagonal(const PatchIndices &patch_indices,
+                               const bool          threaded_setup = false)
+    : threaded_setup(threaded_setup)
+    , patch_indices(patch_indices)
   {}
 
-  PreconditionExtendedDiagonal(std::vector<std::vector<types::global_dof_index>> &&patch_indices)
-    : patch_indices(std::move(patch_indices))
+  PreconditionExtendedDiagonal(PatchIndices &&patch_indices, const bool threaded_setup = false)
+    : threaded_setup(threaded_setup)
+    , patch_indices(std::move(patch_indices))
   {}
 
   template <typename GlobalSparseMatrixType, typename GlobalSparsityPattern>
   void
-  initialize(const GlobalSparseMatrixType            &global_sparse_matrix,
-             const GlobalSparsityPattern             &global_sparsity_pattern,
-             const VectorType                        &inverse_diagonal,
-             const std::set<types::global_dof_index> &all_indices_relevant)
+  initialize(const GlobalSparseMatrixType &global_sparse_matrix,
+             const GlobalSparsityPattern  &global_sparsity_pattern,
+             const VectorType             &inverse_diagonal,
+             const IndexSet               &all_indices_relevant)
   {
     TimerOutput::Scope t(getTimer(), "initialize_extended_diagonal");
 
@@ -69,13 +74,19 @@ public:
     //
     // build patch matrices
     //
+    std::vector<FullMatrix<Number>> patch_matrices;
     SparseMatrixTools::restrict_to_full_matrices(global_sparse_matrix,
                                                  global_sparsity_pattern,
-                                                 patch_indices,
+                                                 patch_indices.get_patch_vectors(),
                                                  patch_matrices);
 
-    for (auto &block : patch_matrices)
-      block.gauss_jordan();
+    apply_to_patch_ranges(
+      patch_matrices.size(),
+      [&](const unsigned int begin, const unsigned int end) {
+        for (unsigned int b = begin; b < end; ++b)
+          patch_matrices[b].gauss_jordan();
+      },
+      threaded_setup);
 
     //
     // prepare weights
@@ -109,36 +120,47 @@ public:
     //
     if (weighting_type != WeightingType::none)
       {
-        for (unsigned int cell = 0; cell < patch_indices.size(); ++cell)
-          {
-            const unsigned int dofs_per_cell = patch_indices[cell].size();
-
-            vector_weights.reinit(dofs_per_cell);
-            for (unsigned int i = 0; i < dofs_per_cell; ++i)
-              vector_weights[i] += weights[patch_indices[cell][i]];
-
-            auto &block = patch_matrices[cell];
-
-            if (weighting_type == WeightingType::symm || weighting_type == WeightingType::right)
-              {
-                // multiply weights from right B(wI), i.e.,
-                // multiply one weight for each column
-                for (unsigned int r = 0; r < dofs_per_cell; ++r)
-                  for (unsigned int c = 0; c < dofs_per_cell; ++c)
-                    block(r, c) *= vector_weights[c];
-              }
-
-            if (weighting_type == WeightingType::symm || weighting_type == WeightingType::left)
-              {
-                // multiply weights from left (wI)B, i.e.,
-                // multiply one weight for each row
-                for (unsigned int r = 0; r < dofs_per_cell; ++r)
-                  for (unsigned int c = 0; c < dofs_per_cell; ++c)
-                    block(r, c) *= vector_weights[r];
-              }
-          }
+        const auto apply_weights = [&](const unsigned int begin, const unsigned int end) {
+          Vector<Number> vector_weights;
+
+          for (unsigned int cell = begin; cell < end; ++cell)
+            {
+              const unsigned int dofs_per_cell = patch_indices[cell].size();
+
+              vector_weights.reinit(dofs_per_cell);
+              for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                vector_weights[i] += weights[patch_indices[cell][i]];
+
+              auto &block = patch_matrices[cell];
+
+              if (weighting_type == WeightingType::symm || weighting_type == WeightingType::right)
+                {
+                  // multiply weights from right B(wI), i.e.,
+                  // multiply one weight for each column
+                  for (unsigned int r = 0; r < dofs_per_cell; ++r)
+                    for (unsigned int c = 0; c < dofs_per_cell; ++c)
+                      block(r, c) *= vector_weights[c];
+                }
+
+              if (weighting_type == WeightingType::symm || weighting_type == WeightingType::left)
+                {
+                  // multiply weights from left (wI)B, i.e.,
+                  // multiply one weight for each row
+                  for (unsigned int r = 0; r < dofs_per_cell; ++r)
+                    for (unsigned int c = 0; c < dofs_per_cell; ++c)
+                      block(r, c) *= vector_weights[r];
+                }
+            }
+        };
+
+        apply_to_patch_ranges(patch_indices.size(), apply_weights, threaded_setup);
       }
 
+    //
+    // store patch matrices in batches for vectorized application
+    //
+    batches.reinit(patch_indices, patch_matrices, large_partitioner->locally_owned_range());
+
     //
     // clear diagonal entries assigned to an ASM patch
     //
@@ -163,8 +185,6 @@ public:
           ghost_indices.push_back(i);
       }
 
-    // TODO: translate patch_indices to local_elements to optimize
-
     //
     // set embedded partitioner
     //
@@ -190,52 +210,98 @@ public:
   void
   vmult(VectorType &dst, const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult_extdiag");
+    Instrumentation::Scope t(Instrumentation::vmult_extdiag);
 
     // apply inverse diagonal
     internal::DiagonalMatrix::assign_and_scale(dst, src, reduced_inverse_diagonal);
 
-    // apply ASM: 1) update ghost values
-    internal::SimpleVectorDataExchange<Number> data_exchange(embedded_partitioner, buffer);
-    data_exchange.update_ghost_values(src);
+    // apply ASM, and hide the ghost exchanges behind interior patches: one half
+    // is applied while ghost values of src arrive, the other one while dst is
+    // compressed
+    const unsigned int n_interior = batches.n_interior_batches();
+    const unsigned int n_first    = n_interior / 2;
 
-    Vector<Number> vector_src, vector_dst;
+    // ... 1) update ghost values
+    update_ghost_values_start(src);
+    batches.vmult_add(dst, src, 0, n_first);
+    update_ghost_values_finish(src);
 
-    // ... 2) loop over patches
-    for (unsigned int p = 0; p < patch_matrices.size(); ++p)
-      {
-        // ... 2a) gather
-        const unsigned int dofs_per_cell = patch_indices[p].size();
-
-        vector_src.reinit(dofs_per_cell);
-        vector_dst.reinit(dofs_per_cell);
-
-        // TODO: patch indices are *global*
-        //       use local indices for faster access like this:
-        // for (unsigned int i = 0; i < dofs_per_cell; ++i)
-        //   vector_src[i] = src.local_element(patch_indices[p][i]);
-        for (unsigned int i = 0; i < dofs_per_cell; ++i)
-          vector_src[i] = src[patch_indices[p][i]];
-
-        // ... 2b) apply preconditioner
-        patch_matrices[p].vmult(vector_dst, vector_src);
-
-        // ... 2c) scatter
-        // for (unsigned int i = 0; i < dofs_per_cell; ++i)
-        //   dst.local_element(patch_indices[p][i]) += vector_dst[i];
-        for (unsigned int i = 0; i < dofs_per_cell; ++i)
-          dst[patch_indices[p][i]] += vector_dst[i];
-      }
+    // ... 2) loop over boundary patches
+    batches.vmult_add(dst, src, n_interior, batches.n_batches());
 
     // ... 3) compress
-    data_exchange.compress(dst);
+    compress_start(dst);
+    batches.vmult_add(dst, src, n_first, n_interior);
+    compress_finish(dst);
+
+    internal::SimpleVectorDataExchange<Number> data_exchange(embedded_partitioner, buffer);
     data_exchange.zero_out_ghost_values(src);
   }
 
+  std::size_t
+  memory_consumption() const
+  {
+    return patch_indices.memory_consumption() + batches.memory_consumption() +
+           reduced_inverse_diagonal.memory_consumption() + buffer.memory_consumption();
+  }
+
 private:
+  // Split-phase versions of the exchanges of internal::SimpleVectorDataExchange
+  // on the embedded partitioner.
+  ArrayView<Number>
+  ghost_array(const VectorType &vec) const
+  {
+    return ArrayView<Number>(const_cast<Number *>(vec.begin()) + vec.locally_owned_size(),
+                             vec.get_partitioner()->n_ghost_indices());
+  }
+
+  void
+  update_ghost_values_start(const VectorType &vec) const
+  {
+    buffer.resize_fast(embedded_partitioner->n_import_indices());
+    embedded_partitioner->export_to_ghosted_array_start<Number>(
+      /*communication_channel=*/0,
+      ArrayView<const Number>(vec.begin(), vec.locally_owned_size()),
+      ArrayView<Number>(buffer.data(), buffer.size()),
+      ghost_array(vec),
+      requests);
+  }
+
+  void
+  update_ghost_values_finish(const VectorType &vec) const
+  {
+    embedded_partitioner->export_to_ghosted_array_finish<Number>(ghost_array(vec), requests);
+  }
+
+  void
+  compress_start(VectorType &vec) const
+  {
+    buffer.resize_fast(embedded_partitioner->n_import_indices());
+    embedded_partitioner->import_from_ghosted_array_start<Number>(
+      VectorOperation::add,
+      /*communication_channel=*/0,
+      ghost_array(vec),
+      ArrayView<Number>(buffer.data(), buffer.size()),
+      requests);
+  }
+
+  void
+  compress_finish(VectorType &vec) const
+  {
+    embedded_partitioner->import_from_ghosted_array_finish<Number>(
+      VectorOperation::add,
+      ArrayView<const Number>(buffer.data(), buffer.size()),
+      ArrayView<Number>(vec.begin(), vec.locally_owned_size()),
+      ghost_array(vec),
+      requests);
+  }
+
+  // invert and weight patch matrices in parallel tasks
+  const bool threaded_setup;
+
   // ASM
-  const std::vector<std::vector<types::global_dof_index>> patch_indices;
-  std::vector<FullMatrix<Number>>                         patch_matrices;
+  const PatchIndices   patch_indices;
+  PatchBatches<Number> batches;
 
   // inverse diagonal
   VectorType reduced_inverse_diagonal;
@@ -243,6 +309,7 @@ private:
   // embedded partitioner
   std::shared_ptr<const Utilities::MPI::Partitioner> embedded_partitioner;
   mutable AlignedVector<Number>                      buffer;
+  mutable std::vector<MPI_Request>                   requests;
 };
 
 DEAL_II_NAMESPACE_CLOSE
@@ -0,0 +1,222 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_mg_coarse_agglomeration_h
+#define multigrid_mg_coarse_agglomeration_h
+
+
+#include <deal.II/base/config.h>
+
+#ifdef DEAL_II_WITH_TRILINOS
+
+#  include <deal.II/base/array_view.h>
+#  include <deal.II/base/index_set.h>
+#  include <deal.II/base/mpi.h>
+#  include <deal.II/base/mpi_noncontiguous_partitioner.h>
+
+#  include <deal.II/lac/la_parallel_vector.h>
+#  include <deal.II/lac/precondition.h>
+#  include <deal.II/lac/solver_cg.h>
+#  include <deal.II/lac/solver_control.h>
+#  include <deal.II/lac/trilinos_precondition.h>
+#  include <deal.II/lac/trilinos_sparse_matrix.h>
+#  include <deal.II/lac/trilinos_sparsity_pattern.h>
+
+#  include <deal.II/multigrid/mg_base.h>
+
+#  include <global.h>
+#  include <multigrid/parameter.h>
+
+#  include <algorithm>
+#  include <map>
+#  include <utility>
+#  include <vector>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Coarse-grid solver that agglomerates the coarse level onto the first
+ * MGSolverParameters::coarse_solver_ranks processes.
+ *
+ * The rows of the coarse system matrix are redistributed in contiguous chunks
+ * onto these processes, which solve on their own communicator. The global
+ * reductions of the coarse solver thus only involve few processes. Right hand
+ * side and solution are exchanged point-to-point with the owners of the
+ * coarse level DoFs. Supports the coarse solvers "cg" and "cg_with_amg".
+ */
+template <typename VectorType>
+class MGCoarseGridAgglomeration : public MGCoarseGridBase<VectorType>
+{
+public:
+  using CoarseVectorType = LinearAlgebra::distributed::Vector<double>;
+
+  MGCoarseGridAgglomeration(const TrilinosWrappers::SparseMatrix &system_matrix,
+                            const MGSolverParameters             &mg_data)
+    : mg_data(mg_data)
+  {
+    TimerOutput::Scope t(getTimer(), "setup_coarse_agglomeration");
+
+    AssertThrow(mg_data.coarse_solver.type == "cg" || mg_data.coarse_solver.type == "cg_with_amg",
+                ExcNotImplemented());
+
+    const MPI_Comm     communicator = system_matrix.get_mpi_communicator();
+    const unsigned int n_procs      = Utilities::MPI::n_mpi_processes(communicator);
+    const unsigned int my_rank      = Utilities::MPI::this_mpi_process(communicator);
+
+    const unsigned int n_coarse_ranks = std::min(mg_data.coarse_solver_ranks, n_procs);
+    AssertThrow(n_coarse_ranks > 0, ExcMessage("Coarse solver needs at least one rank."));
+
+    const bool is_coarse_rank = (my_rank < n_coarse_ranks);
+
+    const int ierr = MPI_Comm_split(communicator,
+                                    is_coarse_rank ? 0 : MPI_UNDEFINED,
+                                    my_rank,
+                                    &coarse_communicator);
+    AssertThrowMPI(ierr);
+
+    // Distribute rows in contiguous chunks onto the coarse ranks.
+    const types::global_dof_index        n_rows = system_matrix.m();
+    std::vector<types::global_dof_index> range_begin(n_coarse_ranks + 1);
+    for (unsigned int r = 0; r <= n_coarse_ranks; ++r)
+      range_begin[r] = n_rows * r / n_coarse_ranks;
+
+    IndexSet coarse_owned(n_rows);
+    if (is_coarse_rank)
+      coarse_owned.add_range(range_begin[my_rank], range_begin[my_rank + 1]);
+    coarse_owned.compress();
+
+    const IndexSet owned = system_matrix.locally_owned_range_indices();
+
+    to_coarse.reinit(owned, coarse_owned, communicator);
+    from_coarse.reinit(coarse_owned, owned, communicator);
+
+    // Send locally owned rows to their coarse rank.
+    using EntryType =
+      std::pair<types::global_dof_index, std::pair<types::global_dof_index, double>>;
+
+    std::map<unsigned int, std::vector<EntryType>> entries_to_send;
+    for (const auto row : owned)
+      {
+        const unsigned int target =
+          std::upper_bound(range_begin.begin(), range_begin.end(), row) - range_begin.begin() - 1;
+
+        for (auto entry = system_matrix.begin(row); entry != system_matrix.end(row); ++entry)
+          entries_to_send[target].emplace_back(row,
+                                               std::make_pair(entry->column(), entry->value()));
+      }
+
+    const auto entries_received = Utilities::MPI::some_to_some(communicator, entries_to_send);
+
+    if (is_coarse_rank)
+      {
+        TrilinosWrappers::SparsityPattern sparsity_pattern(coarse_owned, coarse_communicator);
+        for (const auto &[rank, entries] : entries_received)
+          for (const auto &[row, entry] : entries)
+            sparsity_pattern.add(row, entry.first);
+        sparsity_pattern.compress();
+
+        coarse_matrix.reinit(sparsity_pattern);
+        for (const auto &[rank, entries] : entries_received)
+          for (const auto &[row, entry] : entries)
+            coarse_matrix.set(row, entry.first, entry.second);
+        coarse_matrix.compress(VectorOperation::insert);
+
+        if (mg_data.coarse_solver.type == "cg_with_amg")
+          {
+            TrilinosWrappers::PreconditionAMG::AdditionalData amg_data;
+            amg_data.smoother_sweeps = mg_data.coarse_solver.smoother_sweeps;
+            amg_data.n_cycles        = mg_data.coarse_solver.n_cycles;
+            amg_data.smoother_type   = mg_data.coarse_solver.smoother_type.c_str();
+
+            precondition_amg.initialize(coarse_matrix, amg_data);
+          }
+
+        coarse_src.reinit(coarse_owned, coarse_communicator);
+        coarse_dst.reinit(coarse_owned, coarse_communicator);
+      }
+  }
+
+  ~MGCoarseGridAgglomeration() override
+  {
+    // Trilinos objects need to go before their communicator.
+    precondition_amg.clear();
+    coarse_matrix.clear();
+    coarse_src.reinit(0);
+    coarse_dst.reinit(0);
+
+    if (coarse_communicator != MPI_COMM_NULL)
+      Utilities::MPI::free_communicator(coarse_communicator);
+  }
+
+  void
+  operator()(const unsigned int, VectorType &dst, const VectorType &src) const override
+  {
+    // gather right hand side on the coarse ranks
+    buffer.resize(src.locally_owned_size());
+    for (unsigned int i = 0; i < buffer.size(); ++i)
+      buffer[i] = src.local_element(i);
+
+    to_coarse.export_to_ghosted_array(ArrayView<const double>(buffer),
+                                      ArrayView<double>(coarse_src.begin(),
+                                                        coarse_src.locally_owned_size()));
+
+    // solve on the coarse ranks only
+    if (coarse_communicator != MPI_COMM_NULL)
+      {
+        ReductionControl solver_control(mg_data.coarse_solver.maxiter,
+                                        mg_data.coarse_solver.abstol,
+                                        mg_data.coarse_solver.reltol);
+        SolverCG<CoarseVectorType> solver(solver_control);
+
+        coarse_dst = 0.;
+        if (mg_data.coarse_solver.type == "cg_with_amg")
+          solver.solve(coarse_matrix, coarse_dst, coarse_src, precondition_amg);
+        else
+          solver.solve(coarse_matrix, coarse_dst, coarse_src, PreconditionIdentity());
+      }
+
+    // send solution back to the owners of the coarse level DoFs
+    buffer.resize(dst.locally_owned_size());
+    from_coarse.export_to_ghosted_array(ArrayView<const double>(coarse_dst.begin(),
+                                                                coarse_dst.locally_owned_size()),
+                                        ArrayView<double>(buffer));
+
+    for (unsigned int i = 0; i < buffer.size(); ++i)
+      dst.local_element(i) = buffer[i];
+  }
+
+private:
+  const MGSolverParameters &mg_data;
+
+  MPI_Comm coarse_communicator = MPI_COMM_NULL;
+
+  Utilities::MPI::NoncontiguousPartitioner to_coarse;
+  Utilities::MPI::NoncontiguousPartitioner from_coarse;
+
+  TrilinosWrappers::SparseMatrix    coarse_matrix;
+  TrilinosWrappers::PreconditionAMG precondition_amg;
+
+  mutable CoarseVectorType    coarse_src;
+  mutable CoarseVectorType    coarse_dst;
+  mutable std::vector<double> buffer;
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif // DEAL_II_WITH_TRILINOS
+
+
+#endif
@@ -0,0 +1,111 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_mg_cycle_h
+#define multigrid_mg_cycle_h
+
+
+#include <deal.II/multigrid/mg_smoother.h>
+#include <deal.II/multigrid/multigrid.h>
+
+#include <multigrid/parameter.h>
+
+#include <string>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Translate the "cycle" parameter into the cycle type of the Multigrid class.
+ */
+template <typename VectorType>
+typename Multigrid<VectorType>::Cycle
+get_mg_cycle(const MGSolverParameters &mg_data)
+{
+  if (mg_data.cycle == "V")
+    return Multigrid<VectorType>::v_cycle;
+  else if (mg_data.cycle == "W")
+    return Multigrid<VectorType>::w_cycle;
+  else if (mg_data.cycle == "F")
+    return Multigrid<VectorType>::f_cycle;
+
+  AssertThrow(false, ExcMessage("Unknown multigrid cycle: " + mg_data.cycle));
+  return Multigrid<VectorType>::v_cycle;
+}
+
+
+
+/**
+ * Degree of the Chebyshev smoother on @p level. Levels from @p min_level_p
+ * on live on the fine mesh and only differ in their polynomial degree. A
+ * degree of zero means that no smoothing happens on that level.
+ */
+inline unsigned int
+get_smoother_degree(const MGSolverParameters &mg_data,
+                    const unsigned int        level,
+                    const unsigned int        min_level_p)
+{
+  return (level < min_level_p) ? mg_data.smoother_degree_h_levels :
+                                 mg_data.smoother_degree_p_levels;
+}
+
+
+
+/**
+ * Relaxation smoother that leaves out all levels with a smoother degree of
+ * zero, see get_smoother_degree().
+ */
+template <typename MatrixType, typename RelaxationType, typename VectorType>
+class MGSmootherSkipLevels : public MGSmootherRelaxation<MatrixType, RelaxationType, VectorType>
+{
+public:
+  using Base = MGSmootherRelaxation<MatrixType, RelaxationType, VectorType>;
+
+  MGSmootherSkipLevels(const MGSolverParameters &mg_data, const unsigned int min_level_p)
+    : mg_data(mg_data)
+    , min_level_p(min_level_p)
+  {}
+
+  bool
+  skip_level(const unsigned int level) const
+  {
+    return get_smoother_degree(mg_data, level, min_level_p) == 0;
+  }
+
+  void
+  smooth(const unsigned int level, VectorType &u, const VectorType &rhs) const override
+  {
+    if (skip_level(level) == false)
+      Base::smooth(level, u, rhs);
+  }
+
+  void
+  apply(const unsigned int level, VectorType &u, const VectorType &rhs) const override
+  {
+    if (skip_level(level))
+      u = 0.;
+    else
+      Base::apply(level, u, rhs);
+  }
+
+private:
+  const MGSolverParameters &mg_data;
+  const unsigned int        min_level_p;
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
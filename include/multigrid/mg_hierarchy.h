@@ -0,0 +1,546 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_mg_hierarchy_h
+#define multigrid_mg_hierarchy_h
+
+
+#include <deal.II/base/mg_level_object.h>
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/distributed/repartitioning_policy_tools.h>
+
+#include <deal.II/dofs/dof_handler.h>
+
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/precondition.h>
+
+#include <deal.II/multigrid/mg_base.h>
+#include <deal.II/multigrid/mg_transfer_global_coarsening.h>
+
+#include <global.h>
+#include <log.h>
+#include <multigrid/amg_cache.h>
+#include <multigrid/eigenvalue_cache.h>
+#include <multigrid/mg_transfer_tensor_product.h>
+#include <multigrid/operator_base.h>
+#include <multigrid/parameter.h>
+#include <partitioning.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+/**
+ * Common base class for all multigrid hierarchies, so that problems can keep
+ * one across adaptation cycles without knowing its precision or smoother.
+ */
+class MGHierarchyBase
+{
+public:
+  virtual ~MGHierarchyBase() = default;
+
+protected:
+  /**
+   * Hash of the locally owned cells of @p dof_handler and their active FE
+   * indices, which identifies a level across adaptation cycles.
+   */
+  template <int dim, int spacedim>
+  static std::size_t
+  compute_hash(const dealii::DoFHandler<dim, spacedim> &dof_handler)
+  {
+    std::size_t hash = 0;
+
+    const auto hash_combine = [&hash](const std::size_t value) {
+      hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    for (const auto &cell : dof_handler.active_cell_iterators())
+      if (cell->is_locally_owned())
+        {
+          for (const auto i : cell->id().template to_binary<dim>())
+            hash_combine(i);
+          hash_combine(cell->active_fe_index());
+        }
+
+    return hash;
+  }
+};
+
+
+
+/**
+ * Multigrid hierarchy for global coarsening that persists across adaptation
+ * cycles.
+ *
+ * Levels are identified by a hash of their locally owned cells and active FE
+ * indices. On reinit(), each level that matches a level of the previous
+ * hierarchy on all processes is taken over together with its DoFHandler,
+ * constraints, operator and smoother preconditioner. Only levels that have
+ * changed are set up anew. Transfer operators are rebuilt every time, with
+ * MGTwoLevelTransferTensorProduct applied between p-levels if
+ * MGSolverParameters::tensor_product_transfer is set.
+ */
+template <int dim,
+          typename LevelLinearAlgebra,
+          typename SmootherPreconditionerType,
+          int spacedim = dim>
+class MGHierarchy : public MGHierarchyBase
+{
+public:
+  using VectorType  = typename LevelLinearAlgebra::Vector;
+  using LevelNumber = typename VectorType::value_type;
+
+  using LevelOperatorType = OperatorType<dim, LevelLinearAlgebra, spacedim>;
+  using MGTransferType    = dealii::MGTransferTensorProduct<dim, VectorType, spacedim>;
+
+#ifdef DEAL_II_WITH_TRILINOS
+  using CoarseAMGType = AMGCache<dealii::TrilinosWrappers::PreconditionAMG>;
+#else
+  using CoarseAMGType = AMGCache<dealii::PreconditionIdentity>;
+#endif
+
+  /**
+   * All data belonging to one multigrid level.
+   */
+  struct Level
+  {
+    Level(const std::shared_ptr<const dealii::Triangulation<dim, spacedim>> &triangulation)
+      : triangulation(triangulation)
+      , dof_handler(*triangulation)
+    {}
+
+    /**
+     * Constraints in the precision of the multigrid hierarchy.
+     */
+    const dealii::AffineConstraints<LevelNumber> &
+    get_level_constraints() const
+    {
+      if constexpr (std::is_same_v<LevelNumber, double>)
+        return constraints;
+      else
+        return constraints_level_precision;
+    }
+
+    std::size_t hash = 0;
+
+    std::shared_ptr<const dealii::Triangulation<dim, spacedim>> triangulation;
+    dealii::DoFHandler<dim, spacedim>                           dof_handler;
+
+    Partitioning partitioning;
+
+    dealii::AffineConstraints<double>      constraints;
+    dealii::AffineConstraints<LevelNumber> constraints_level_precision;
+
+    std::shared_ptr<LevelOperatorType>          level_operator;
+    std::shared_ptr<SmootherPreconditionerType> smoother_preconditioner;
+  };
+
+  /**
+   * Set up the hierarchy for the fine @p dof_handler.
+   *
+   * The function @p setup_level is called on each level that could not be
+   * reused, once DoFs have been distributed and the partitioning is known. It
+   * has to fill constraints, the level operator and the smoother
+   * preconditioner. The second argument flags the finest level.
+   */
+  void
+  reinit(const dealii::DoFHandler<dim, spacedim>           &dof_handler,
+         const MGSolverParameters                          &mg_data,
+         const std::function<void(Level &, const bool)>    &setup_level);
+
+  unsigned int
+  min_level() const
+  {
+    return 0;
+  }
+
+  unsigned int
+  max_level() const
+  {
+    return levels.size() - 1;
+  }
+
+  /**
+   * First level on the fine mesh. Coarser levels differ by h-coarsening,
+   * finer ones by p-coarsening.
+   */
+  unsigned int
+  min_level_p() const
+  {
+    return n_h_levels;
+  }
+
+  const Level &
+  get_level(const unsigned int level) const
+  {
+    return *levels[level];
+  }
+
+  const dealii::MGLevelObject<std::shared_ptr<LevelOperatorType>> &
+  get_operators() const
+  {
+    return operators;
+  }
+
+  const dealii::MGLevelObject<std::shared_ptr<SmootherPreconditionerType>> &
+  get_smoother_preconditioners() const
+  {
+    return smoother_preconditioners;
+  }
+
+  const MGTransferType &
+  get_transfer() const
+  {
+    return *mg_transfer;
+  }
+
+  EigenvalueCache &
+  get_eigenvalue_cache()
+  {
+    return eigenvalue_cache;
+  }
+
+  /**
+   * AMG on the coarsest level, which is only set up again if that level
+   * changed.
+   */
+  CoarseAMGType &
+  get_coarse_amg()
+  {
+    return coarse_amg;
+  }
+
+  /**
+   * Coarse-grid solver on a subset of ranks, see
+   * MGSolverParameters::coarse_solver_ranks. It is set up by mg_solve() and
+   * dropped once the coarsest level changes.
+   */
+  std::shared_ptr<dealii::MGCoarseGridBase<VectorType>> &
+  get_coarse_agglomeration()
+  {
+    return coarse_agglomeration;
+  }
+
+  unsigned int
+  n_reused_levels() const
+  {
+    return n_reused;
+  }
+
+  /**
+   * Add the memory consumption of all level operators, smoother
+   * preconditioners and transfers to the table.
+   */
+  void
+  log_memory_consumption() const
+  {
+    std::size_t memory_operators = 0, memory_smoothers = 0, memory_transfers = 0;
+    for (unsigned int l = min_level(); l <= max_level(); ++l)
+      {
+        memory_operators += operators[l]->memory_consumption();
+        memory_smoothers += smoother_preconditioners[l]->memory_consumption();
+      }
+
+    // transfers connect each level to the next coarser one
+    for (unsigned int l = min_level() + 1; l <= max_level(); ++l)
+      {
+        memory_transfers += transfers[l].memory_consumption();
+        if (tensor_product_transfers[l])
+          memory_transfers += tensor_product_transfers[l]->memory_consumption();
+      }
+
+    const MPI_Comm communicator = levels.back()->dof_handler.get_communicator();
+    Log::log_memory_consumption("mg_operators", memory_operators, communicator);
+    Log::log_memory_consumption("mg_smoothers", memory_smoothers, communicator);
+    Log::log_memory_consumption("mg_transfers", memory_transfers, communicator);
+  }
+
+private:
+  std::vector<std::shared_ptr<Level>> levels;
+  unsigned int                        n_h_levels = 0;
+  unsigned int                        n_reused   = 0;
+
+  dealii::MGLevelObject<std::shared_ptr<LevelOperatorType>>          operators;
+  dealii::MGLevelObject<std::shared_ptr<SmootherPreconditionerType>> smoother_preconditioners;
+  dealii::MGLevelObject<dealii::MGTwoLevelTransfer<dim, VectorType>> transfers;
+  dealii::MGLevelObject<std::shared_ptr<typename MGTransferType::TensorProductTransferType>>
+                                  tensor_product_transfers;
+  std::unique_ptr<MGTransferType> mg_transfer;
+
+  EigenvalueCache eigenvalue_cache;
+  CoarseAMGType   coarse_amg;
+
+  std::shared_ptr<dealii::MGCoarseGridBase<VectorType>> coarse_agglomeration;
+};
+
+
+
+template <int dim, typename LevelLinearAlgebra, typename SmootherPreconditionerType, int spacedim>
+void
+MGHierarchy<dim, LevelLinearAlgebra, SmootherPreconditionerType, spacedim>::reinit(
+  const dealii::DoFHandler<dim, spacedim>        &dof_handler,
+  const MGSolverParameters                       &mg_data,
+  const std::function<void(Level &, const bool)> &setup_level)
+{
+  using namespace dealii;
+
+  TimerOutput::Scope t(getTimer(), "setup_mg_hierarchy");
+
+  const MPI_Comm communicator = dof_handler.get_communicator();
+
+  std::vector<std::shared_ptr<const Triangulation<dim, spacedim>>> coarse_grid_triangulations;
+  if (mg_data.transfer.perform_h_transfer && mg_data.repartitioning_policy != "none")
+    {
+      // Each h-level gets its own partitioning. The fine triangulation keeps
+      // its partitioning, since p-levels are set up on it.
+      std::unique_ptr<RepartitioningPolicyTools::Base<dim, spacedim>> policy;
+      if (mg_data.repartitioning_policy == "first child")
+        policy = std::make_unique<RepartitioningPolicyTools::FirstChildPolicy<dim, spacedim>>(
+          dof_handler.get_triangulation());
+      else if (mg_data.repartitioning_policy == "minimal granularity")
+        policy =
+          std::make_unique<RepartitioningPolicyTools::MinimalGranularityPolicy<dim, spacedim>>(
+            mg_data.repartitioning_min_cells);
+      else
+        AssertThrow(false,
+                    ExcMessage("Unknown repartitioning policy: " + mg_data.repartitioning_policy));
+
+      coarse_grid_triangulations =
+        MGTransferGlobalCoarseningTools::create_geometric_coarsening_sequence(
+          dof_handler.get_triangulation(),
+          *policy,
+          /*preserve_fine_triangulation=*/true,
+          /*repartition_fine_triangulation=*/false);
+    }
+  else if (mg_data.transfer.perform_h_transfer)
+    coarse_grid_triangulations =
+      MGTransferGlobalCoarseningTools::create_geometric_coarsening_sequence(
+        dof_handler.get_triangulation());
+  else
+    coarse_grid_triangulations.emplace_back(
+      const_cast<Triangulation<dim, spacedim> *>(&(dof_handler.get_triangulation())), [](auto &) {
+        // empty deleter, since fine_triangulation_in is an external field
+        // and its destructor is called somewhere else
+      });
+
+  n_h_levels = coarse_grid_triangulations.size() - 1;
+
+  // Determine the number of levels.
+  const auto get_max_active_fe_degree = [&](const auto &dof_handler) {
+    unsigned int max = 0;
+
+    for (auto &cell : dof_handler.active_cell_iterators())
+      if (cell->is_locally_owned())
+        max = std::max(max, dof_handler.get_fe(cell->active_fe_index()).degree);
+
+    return Utilities::MPI::max(max, communicator);
+  };
+
+  const unsigned int n_p_levels =
+    MGTransferGlobalCoarseningTools::create_polynomial_coarsening_sequence(
+      get_max_active_fe_degree(dof_handler), mg_data.transfer.p_sequence)
+      .size();
+
+  std::map<unsigned int, unsigned int> fe_index_for_degree;
+  for (unsigned int i = 0; i < dof_handler.get_fe_collection().size(); ++i)
+    {
+      const unsigned int degree = dof_handler.get_fe(i).degree;
+      Assert(fe_index_for_degree.find(degree) == fe_index_for_degree.end(),
+             ExcMessage("FECollection does not contain unique degrees."));
+      fe_index_for_degree[degree] = i;
+    }
+
+  const unsigned int minlevel   = 0;
+  const unsigned int minlevel_p = n_h_levels;
+  const unsigned int maxlevel   = n_h_levels + n_p_levels - 1;
+
+  // Keep the previous levels alive until the new hierarchy is complete,
+  // and sort them by their hash.
+  std::vector<std::shared_ptr<Level>>            previous_levels = std::move(levels);
+  std::map<std::size_t, std::shared_ptr<Level>> previous_levels_by_hash;
+  if (mg_data.reuse_hierarchy)
+    for (const auto &level : previous_levels)
+      previous_levels_by_hash.emplace(level->hash, level);
+
+  levels.clear();
+  levels.resize(maxlevel + 1);
+  n_reused = 0;
+
+  std::vector<bool> reused(maxlevel + 1, false);
+
+  // Take over a level from the previous hierarchy if it matches on all
+  // processes.
+  const auto reuse_or_keep = [&](const unsigned int l, std::shared_ptr<Level> &&new_level) {
+    new_level->hash = compute_hash(new_level->dof_handler);
+
+    const auto         it          = previous_levels_by_hash.find(new_level->hash);
+    const unsigned int local_match = (it != previous_levels_by_hash.end()) ? 1 : 0;
+
+    if (Utilities::MPI::min(local_match, communicator) == 1)
+      {
+        levels[l] = it->second;
+        reused[l] = true;
+        ++n_reused;
+      }
+    else
+      {
+        levels[l] = std::move(new_level);
+      }
+  };
+
+  // Loop from min to max level and set up DoFHandler with coarser mesh...
+  for (unsigned int l = 0; l < n_h_levels; ++l)
+    reuse_or_keep(l, std::make_shared<Level>(coarse_grid_triangulations[l]));
+
+  // ... with lower polynomial degrees
+  const std::shared_ptr<const Triangulation<dim, spacedim>> fine_triangulation(
+    &(dof_handler.get_triangulation()), [](auto *) {
+      // empty deleter, since the fine triangulation is an external field
+      // and its destructor is called somewhere else
+    });
+
+  for (unsigned int i = 0, l = maxlevel; i < n_p_levels; ++i, --l)
+    {
+      auto  new_level      = std::make_shared<Level>(fine_triangulation);
+      auto &dof_handler_mg = new_level->dof_handler;
+
+      if (l == maxlevel) // finest level
+        {
+          auto cell_other = dof_handler.begin_active();
+          for (auto &cell : dof_handler_mg.active_cell_iterators())
+            {
+              if (cell->is_locally_owned())
+                cell->set_active_fe_index(cell_other->active_fe_index());
+              cell_other++;
+            }
+        }
+      else // coarse level
+        {
+          const auto &dof_handler_fine = levels[l + 1]->dof_handler;
+
+          auto cell_other = dof_handler_fine.begin_active();
+          for (auto &cell : dof_handler_mg.active_cell_iterators())
+            {
+              if (cell->is_locally_owned())
+                {
+                  const unsigned int next_degree =
+                    MGTransferGlobalCoarseningTools::create_next_polynomial_coarsening_degree(
+                      cell_other->get_fe().degree, mg_data.transfer.p_sequence);
+                  Assert(fe_index_for_degree.find(next_degree) != fe_index_for_degree.end(),
+                         ExcMessage("Next polynomial degree in sequence "
+                                    "does not exist in FECollection."));
+
+                  cell->set_active_fe_index(fe_index_for_degree[next_degree]);
+                }
+              cell_other++;
+            }
+        }
+
+      reuse_or_keep(l, std::move(new_level));
+    }
+
+  // Set up all levels that could not be reused.
+  for (unsigned int l = minlevel; l <= maxlevel; ++l)
+    if (reused[l] == false)
+      {
+        Level &level = *levels[l];
+
+        level.dof_handler.distribute_dofs(dof_handler.get_fe_collection());
+        level.partitioning.reinit(level.dof_handler);
+
+        setup_level(level, l == maxlevel);
+      }
+
+  getTable().add_value("mg_levels_reused", n_reused);
+
+  // Coarse AMG and agglomeration refer to the matrix of the previous coarsest
+  // level.
+  if (reused[minlevel] == false)
+    {
+      coarse_amg.clear();
+      coarse_agglomeration.reset();
+    }
+
+  std::vector<std::size_t> level_hashes(maxlevel + 1);
+  for (unsigned int l = minlevel; l <= maxlevel; ++l)
+    level_hashes[l] = levels[l]->hash;
+  eigenvalue_cache.reinit(level_hashes,
+                          communicator,
+                          mg_data.cache_eigenvalues,
+                          mg_data.eigenvalue_cache_max_age);
+
+  // Collect level operators and smoothers.
+  operators.resize(minlevel, maxlevel);
+  smoother_preconditioners.resize(minlevel, maxlevel);
+  for (unsigned int l = minlevel; l <= maxlevel; ++l)
+    {
+      operators[l]                = levels[l]->level_operator;
+      smoother_preconditioners[l] = levels[l]->smoother_preconditioner;
+    }
+
+  // Set up intergrid operators. The previous transfer refers to the old ones.
+  mg_transfer.reset();
+  transfers.resize(minlevel, maxlevel);
+  tensor_product_transfers.resize(minlevel, maxlevel);
+
+  for (unsigned int l = minlevel; l < minlevel_p; ++l)
+    transfers[l + 1].reinit_geometric_transfer(levels[l + 1]->dof_handler,
+                                               levels[l]->dof_handler,
+                                               levels[l + 1]->get_level_constraints(),
+                                               levels[l]->get_level_constraints());
+
+  // The polynomial transfers are also needed with tensor-product transfers,
+  // since MGTransferGlobalCoarsening sets up its level vectors with them.
+  for (unsigned int l = minlevel_p; l < maxlevel; ++l)
+    {
+      transfers[l + 1].reinit_polynomial_transfer(levels[l + 1]->dof_handler,
+                                                  levels[l]->dof_handler,
+                                                  levels[l + 1]->get_level_constraints(),
+                                                  levels[l]->get_level_constraints());
+
+      if (mg_data.tensor_product_transfer &&
+          MGTransferType::TensorProductTransferType::is_applicable(levels[l + 1]->dof_handler,
+                                                                   levels[l]->dof_handler))
+        {
+          // work on the level vectors of the operators directly if possible
+          VectorType vec_fine, vec_coarse;
+          operators[l + 1]->initialize_dof_vector(vec_fine);
+          operators[l]->initialize_dof_vector(vec_coarse);
+
+          tensor_product_transfers[l + 1] =
+            std::make_shared<typename MGTransferType::TensorProductTransferType>();
+          tensor_product_transfers[l + 1]->reinit(levels[l + 1]->dof_handler,
+                                                  levels[l]->dof_handler,
+                                                  levels[l + 1]->get_level_constraints(),
+                                                  levels[l]->get_level_constraints(),
+                                                  vec_fine.get_partitioner(),
+                                                  vec_coarse.get_partitioner());
+        }
+    }
+
+  // Collect transfer operators within a single operator as needed by
+  // the Multigrid solver class.
+  mg_transfer = std::make_unique<MGTransferType>(transfers,
+                                                 tensor_product_transfers,
+                                                 [&](const auto l, auto &vec) {
+                                                   operators[l]->initialize_dof_vector(vec);
+                                                 });
+}
+
+
+#endif
@@ -0,0 +1,135 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_mg_level_profiler_h
+#define multigrid_mg_level_profiler_h
+
+
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/types.h>
+
+#include <deal.II/multigrid/multigrid.h>
+
+#ifdef LIKWID_PERFMON
+#  include <likwid-marker.h>
+#endif
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+/**
+ * Call counts and wall times of each step of the multigrid cycle on each
+ * level, recorded via the signals of the Multigrid class.
+ *
+ * If compiled with LIKWID_PERFMON, each step on each level is also a LIKWID
+ * marker region named "mg_level_<level>_<step>", so that hardware counters
+ * like memory traffic and floating point operations can be attributed to it.
+ */
+class MGLevelProfiler
+{
+public:
+  enum Step
+  {
+    pre_smoother_step,
+    residual_step,
+    restriction,
+    coarse_solve,
+    prolongation,
+    edge_prolongation,
+    post_smoother_step,
+    n_steps
+  };
+
+  MGLevelProfiler(const unsigned int n_levels);
+
+  template <typename VectorType>
+  void
+  connect(dealii::Multigrid<VectorType> &mg);
+
+  static std::string
+  get_name(const Step step);
+
+  unsigned int
+  n_levels() const
+  {
+    return records.size();
+  }
+
+  unsigned int
+  get_n_calls(const unsigned int level, const Step step) const
+  {
+    return records[level][step].n_calls;
+  }
+
+  double
+  get_wall_time(const unsigned int level, const Step step) const
+  {
+    return records[level][step].wall_time;
+  }
+
+  /**
+   * Write all records to @p filename in JSON format, with min, max and avg
+   * of wall times over all processes. Together with the number of DoFs
+   * @p n_dofs on each level, this allows to compute the throughput of each
+   * step. Has to be called collectively.
+   */
+  void
+  write_json(const std::string                                  &filename,
+             const std::vector<dealii::types::global_dof_index> &n_dofs,
+             const MPI_Comm                                      communicator) const;
+
+private:
+  void
+  signal(const unsigned int level, const Step step, const bool start);
+
+  struct Record
+  {
+    unsigned int n_calls   = 0;
+    double       wall_time = 0.;
+
+    std::chrono::time_point<std::chrono::steady_clock> start;
+
+    std::string region;
+  };
+
+  std::vector<std::array<Record, n_steps>> records;
+};
+
+
+
+template <typename VectorType>
+void
+MGLevelProfiler::connect(dealii::Multigrid<VectorType> &mg)
+{
+  const auto create_signal = [this](const Step step) {
+    return [this, step](const bool start, const unsigned int level) {
+      signal(level, step, start);
+    };
+  };
+
+  mg.connect_pre_smoother_step(create_signal(pre_smoother_step));
+  mg.connect_residual_step(create_signal(residual_step));
+  mg.connect_restriction(create_signal(restriction));
+  mg.connect_coarse_solve(create_signal(coarse_solve));
+  mg.connect_prolongation(create_signal(prolongation));
+  mg.connect_edge_prolongation(create_signal(edge_prolongation));
+  mg.connect_post_smoother_step(create_signal(post_smoother_step));
+}
+
+
+#endif
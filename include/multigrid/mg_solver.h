@@ -37,9 +37,16 @@
 #include <deal.II/multigrid/multigrid.h>
 
 #include <global.h>
+#include <multigrid/eigenvalue_cache.h>
+#include <multigrid/mg_coarse_agglomeration.h>
+#include <multigrid/mg_cycle.h>
+#include <multigrid/mg_level_profiler.h>
+#include <multigrid/mixed_precision.h>
 #include <multigrid/operator_base.h>
 #include <multigrid/parameter.h>
+#include <solver_pipelined_cg.h>
 
+#include <cmath>
 #include <vector>
 
 
@@ -56,7 +63,9 @@ template <typename VectorType,
           typename SystemMatrixType,
           typename LevelMatrixType,
           typename SmootherPreconditionerType,
-          typename MGTransferType>
+          typename MGTransferType,
+          typename CoarseAMGType,
+          typename CoarseAgglomerationType>
 static void
 mg_solve(
   SolverControl                                                    &solver_control,
@@ -65,31 +74,49 @@ mg_solve(
   const MGSolverParameters                                         &mg_data,
   const DoFHandler<dim, spacedim>                                  &dof,
   const SystemMatrixType                                           &fine_matrix,
-  const MGLevelObject<std::unique_ptr<LevelMatrixType>>            &mg_matrices,
+  const MGLevelObject<std::shared_ptr<LevelMatrixType>>            &mg_matrices,
   const MGLevelObject<std::shared_ptr<SmootherPreconditionerType>> &mg_smoother_preconditioners,
   const MGTransferType                                             &mg_transfer,
-  const std::string                                                &filename_mg_level)
+  EigenvalueCache                                                  &eigenvalue_cache,
+  CoarseAMGType                                                    &coarse_amg,
+  CoarseAgglomerationType                                          &coarse_agglomeration,
+  const unsigned int                                                min_level_p,
+  const std::string                                                &filename_mg_level,
+  const bool                                                        pipelined       = false,
+  const unsigned int                                                smoother_degree = 0)
 {
   AssertThrow(mg_data.smoother.type == "chebyshev", ExcNotImplemented());
 
   const unsigned int min_level = mg_matrices.min_level();
   const unsigned int max_level = mg_matrices.max_level();
 
+  // The multigrid hierarchy might operate in a different precision than the
+  // outer solver, see MGSolverParameters::mixed_precision.
+  using LevelVectorType = typename LevelMatrixType::vector_type;
+
   using SmootherType =
-    PreconditionChebyshev<LevelMatrixType, VectorType, SmootherPreconditionerType>;
-  using PreconditionerType = PreconditionMG<dim, VectorType, MGTransferType>;
+    PreconditionChebyshev<LevelMatrixType, LevelVectorType, SmootherPreconditionerType>;
+  using PreconditionerType = PreconditionMG<dim, LevelVectorType, MGTransferType>;
 
   // Initialize level operators.
-  mg::Matrix<VectorType> mg_matrix(mg_matrices);
+  mg::Matrix<LevelVectorType> mg_matrix(mg_matrices);
 
   // Initialize smoothers.
   MGLevelObject<typename SmootherType::AdditionalData> smoother_data(min_level, max_level);
 
   for (unsigned int level = min_level; level <= max_level; level++)
     {
+      // Levels without smoothing still need a valid smoother, which is never applied.
+      // A nonzero smoother_degree replaces the degree on all smoothed levels.
+      unsigned int degree = get_smoother_degree(mg_data, level, min_level_p);
+      if (degree == 0)
+        degree = mg_data.smoother.degree;
+      else if (smoother_degree > 0)
+        degree = smoother_degree;
+
       smoother_data[level].preconditioner      = mg_smoother_preconditioners[level];
       smoother_data[level].smoothing_range     = mg_data.smoother.smoothing_range;
-      smoother_data[level].degree              = mg_data.smoother.degree;
+      smoother_data[level].degree              = degree;
       smoother_data[level].eig_cg_n_iterations = mg_data.smoother.eig_cg_n_iterations;
     }
 
@@ -103,29 +130,45 @@ mg_solve(
     {
       for (unsigned int level = min_level + 1; level <= max_level; level++)
         {
-          SmootherType chebyshev;
-          chebyshev.initialize(*mg_matrices[level], smoother_data[level]);
+          // Levels without smoothing do not need eigenvalues.
+          if (get_smoother_degree(mg_data, level, min_level_p) == 0)
+            continue;
 
-          VectorType vec;
-          mg_matrices[level]->initialize_dof_vector(vec);
-          const auto evs = chebyshev.estimate_eigenvalues(vec);
+          // Only estimate eigenvalues of levels that did not appear before.
+          if (eigenvalue_cache.get(level, min_eigenvalues[level], max_eigenvalues[level]) == false)
+            {
+              SmootherType chebyshev;
+              chebyshev.initialize(*mg_matrices[level], smoother_data[level]);
 
-          min_eigenvalues[level] = evs.min_eigenvalue_estimate;
-          max_eigenvalues[level] = evs.max_eigenvalue_estimate;
+              LevelVectorType vec;
+              mg_matrices[level]->initialize_dof_vector(vec);
+              const auto evs = chebyshev.estimate_eigenvalues(vec);
+
+              min_eigenvalues[level] = evs.min_eigenvalue_estimate;
+              max_eigenvalues[level] = evs.max_eigenvalue_estimate;
+
+              eigenvalue_cache.set(level, min_eigenvalues[level], max_eigenvalues[level]);
+            }
 
           // We already computed eigenvalues, reset the one in the actual smoother
           smoother_data[level].eig_cg_n_iterations = 0;
-          smoother_data[level].max_eigenvalue      = evs.max_eigenvalue_estimate * 1.1;
+          smoother_data[level].max_eigenvalue      = max_eigenvalues[level] * 1.1;
         }
 
-      // log maximum over all levels
-      const double max = *std::max_element(++(max_eigenvalues.begin()), max_eigenvalues.end());
+      // log maximum over all smoothed levels
+      double max = 0.;
+      for (unsigned int level = min_level + 1; level <= max_level; level++)
+        if (std::isnan(max_eigenvalues[level]) == false)
+          max = std::max(max, max_eigenvalues[level]);
       getPCOut() << "   Max EV on all MG levels:      " << max << std::endl;
       getTable().add_value("max_ev", max);
+      getTable().add_value("ev_cache_hits", eigenvalue_cache.n_hits());
+      getTable().add_value("ev_cache_misses", eigenvalue_cache.n_misses());
     }
   // ----------
 
-  MGSmootherRelaxation<LevelMatrixType, SmootherType, VectorType> mg_smoother;
+  MGSmootherSkipLevels<LevelMatrixType, SmootherType, LevelVectorType> mg_smoother(mg_data,
+                                                                                    min_level_p);
   mg_smoother.initialize(mg_matrices, smoother_data);
 
   // Initialize coarse-grid solver.
@@ -134,29 +177,43 @@ mg_solve(
                                               mg_data.coarse_solver.reltol,
                                               /*log_history=*/true,
                                               /*log_result=*/true);
-  SolverCG<VectorType> coarse_grid_solver(coarse_grid_solver_control);
+  SolverCG<LevelVectorType> coarse_grid_solver(coarse_grid_solver_control);
 
   PreconditionIdentity precondition_identity;
-  PreconditionChebyshev<LevelMatrixType, VectorType, DiagonalMatrix<VectorType>>
+  PreconditionChebyshev<LevelMatrixType, LevelVectorType, DiagonalMatrix<LevelVectorType>>
     precondition_chebyshev;
 
 #ifdef DEAL_II_WITH_TRILINOS
-  TrilinosWrappers::PreconditionAMG precondition_amg;
+  PreconditionMixedPrecision<LevelVectorType, TrilinosWrappers::PreconditionAMG>
+    precondition_amg_mixed(coarse_amg.get_preconditioner());
+#else
+  (void)coarse_amg;
 #endif
 
-  std::unique_ptr<MGCoarseGridBase<VectorType>> mg_coarse;
+  std::unique_ptr<MGCoarseGridBase<LevelVectorType>> mg_coarse;
 
-  if (mg_data.coarse_solver.type == "cg")
+  if (mg_data.coarse_solver_ranks > 0)
+    {
+      // CG on a subset of ranks, which keeps the redistributed matrix, its
+      // communicator and AMG as long as the coarse level does not change
+
+#ifdef DEAL_II_WITH_TRILINOS
+      if (coarse_agglomeration == nullptr)
+        coarse_agglomeration = std::make_shared<MGCoarseGridAgglomeration<LevelVectorType>>(
+          mg_matrices[min_level]->get_system_matrix(), mg_data);
+#else
+      AssertThrow(false, ExcNotImplemented());
+#endif
+    }
+  else if (mg_data.coarse_solver.type == "cg")
     {
       // CG with identity matrix as preconditioner
 
-      mg_coarse =
-        std::make_unique<MGCoarseGridIterativeSolver<VectorType,
-                                                     SolverCG<VectorType>,
-                                                     LevelMatrixType,
-                                                     PreconditionIdentity>>(coarse_grid_solver,
-                                                                            *mg_matrices[min_level],
-                                                                            precondition_identity);
+      mg_coarse = std::make_unique<MGCoarseGridIterativeSolver<LevelVectorType,
+                                                               SolverCG<LevelVectorType>,
+                                                               LevelMatrixType,
+                                                               PreconditionIdentity>>(
+        coarse_grid_solver, *mg_matrices[min_level], precondition_identity);
     }
   else if (mg_data.coarse_solver.type == "cg_with_chebyshev")
     {
@@ -164,7 +221,7 @@ mg_solve(
 
       typename decltype(precondition_chebyshev)::AdditionalData smoother_data;
 
-      smoother_data.preconditioner = std::make_shared<DiagonalMatrix<VectorType>>();
+      smoother_data.preconditioner = std::make_shared<DiagonalMatrix<LevelVectorType>>();
       mg_matrices[min_level]->compute_inverse_diagonal(smoother_data.preconditioner->get_vector());
       smoother_data.smoothing_range     = mg_data.smoother.smoothing_range;
       smoother_data.degree              = mg_data.smoother.degree;
@@ -172,8 +229,8 @@ mg_solve(
 
       precondition_chebyshev.initialize(*mg_matrices[min_level], smoother_data);
 
-      mg_coarse = std::make_unique<MGCoarseGridIterativeSolver<VectorType,
-                                                               SolverCG<VectorType>,
+      mg_coarse = std::make_unique<MGCoarseGridIterativeSolver<LevelVectorType,
+                                                               SolverCG<LevelVectorType>,
                                                                LevelMatrixType,
                                                                decltype(precondition_chebyshev)>>(
         coarse_grid_solver, *mg_matrices[min_level], precondition_chebyshev);
@@ -188,14 +245,17 @@ mg_solve(
       amg_data.n_cycles        = mg_data.coarse_solver.n_cycles;
       amg_data.smoother_type   = mg_data.coarse_solver.smoother_type.c_str();
 
-      // CG with AMG as preconditioner
-      precondition_amg.initialize(mg_matrices[min_level]->get_system_matrix(), amg_data);
+      // CG with AMG as preconditioner, which is only set up again if the
+      // coarse matrix changed
+      const auto setup =
+        coarse_amg.initialize(mg_matrices[min_level]->get_system_matrix(), amg_data);
+      getTable().add_value("coarse_amg_setup", coarse_amg.get_name(setup));
 
-      mg_coarse = std::make_unique<MGCoarseGridIterativeSolver<VectorType,
-                                                               SolverCG<VectorType>,
+      mg_coarse = std::make_unique<MGCoarseGridIterativeSolver<LevelVectorType,
+                                                               SolverCG<LevelVectorType>,
                                                                LevelMatrixType,
-                                                               decltype(precondition_amg)>>(
-        coarse_grid_solver, *mg_matrices[min_level], precondition_amg);
+                                                               decltype(precondition_amg_mixed)>>(
+        coarse_grid_solver, *mg_matrices[min_level], precondition_amg_mixed);
 #else
       AssertThrow(false, ExcNotImplemented());
 #endif
@@ -206,66 +266,54 @@ mg_solve(
     }
 
   // Create multigrid object.
-  Multigrid<VectorType> mg(mg_matrix, *mg_coarse, mg_transfer, mg_smoother, mg_smoother);
-
-  // ----------
-  // TODO: timing based on peters dealii-multigrid
-  // https://github.com/peterrum/dealii-multigrid/blob/c50581883c0dbe35c83132699e6de40da9b1b255/multigrid_throughput.cc#L1183-L1192
-  std::vector<std::vector<std::pair<double, std::chrono::time_point<std::chrono::system_clock>>>>
-    all_mg_timers(max_level - min_level + 1);
-
-  for (unsigned int i = 0; i < all_mg_timers.size(); ++i)
-    all_mg_timers[i].resize(7);
-
+  Multigrid<LevelVectorType> mg(mg_matrix,
+                                mg_coarse ? *mg_coarse : *coarse_agglomeration,
+                                mg_transfer,
+                                mg_smoother,
+                                mg_smoother,
+                                min_level,
+                                max_level,
+                                get_mg_cycle<LevelVectorType>(mg_data));
+
+  // Record the timings of each step of the multigrid cycle on each level.
+  MGLevelProfiler profiler(max_level - min_level + 1);
   if (mg_data.log_levels == true)
-    {
-      const auto create_mg_timer_function = [&](const unsigned int i, const std::string &label) {
-        return [i, label, &all_mg_timers](const bool flag, const unsigned int level) {
-          // if (false && flag)
-          //   std::cout << label << " " << level << std::endl;
-          if (flag)
-            all_mg_timers[level][i].second = std::chrono::system_clock::now();
-          else
-            all_mg_timers[level][i].first +=
-              std::chrono::duration_cast<std::chrono::nanoseconds>(
-                std::chrono::system_clock::now() - all_mg_timers[level][i].second)
-                .count() /
-              1e9;
-        };
-      };
-
-      mg.connect_pre_smoother_step(create_mg_timer_function(0, "pre_smoother_step"));
-      mg.connect_residual_step(create_mg_timer_function(1, "residual_step"));
-      mg.connect_restriction(create_mg_timer_function(2, "restriction"));
-      mg.connect_coarse_solve(create_mg_timer_function(3, "coarse_solve"));
-      mg.connect_prolongation(create_mg_timer_function(4, "prolongation"));
-      mg.connect_edge_prolongation(create_mg_timer_function(5, "edge_prolongation"));
-      mg.connect_post_smoother_step(create_mg_timer_function(6, "post_smoother_step"));
-    }
-  // ----------
+    profiler.connect(mg);
 
   // Convert it to a preconditioner.
   PreconditionerType preconditioner(dof, mg, mg_transfer);
 
   // Finally, solve.
-  SolverCG<VectorType>(solver_control).solve(fine_matrix, dst, src, preconditioner);
+  if (pipelined)
+    SolverPipelinedCG<VectorType>(solver_control).solve(fine_matrix, dst, src, preconditioner);
+  else
+    SolverCG<VectorType>(solver_control).solve(fine_matrix, dst, src, preconditioner);
+
+  // dump to Table and JSON file
+  if (mg_data.log_levels == true)
+    {
+      std::vector<types::global_dof_index> n_dofs;
+      for (unsigned int level = min_level; level <= max_level; ++level)
+        n_dofs.push_back(mg_matrices[level]->m());
+
+      std::string filename_json = filename_mg_level;
+      if (const auto pos = filename_json.rfind(".log"); pos != std::string::npos)
+        filename_json.erase(pos);
+      profiler.write_json(filename_json + ".json", n_dofs, dof.get_communicator());
+    }
 
-  // ----------
-  // dump to Table and then file system
   if ((mg_data.log_levels == true) &&
       (Utilities::MPI::this_mpi_process(dof.get_communicator()) == 0))
     {
       dealii::ConvergenceTable table;
-      for (unsigned int level = 0; level < all_mg_timers.size(); ++level)
+      for (unsigned int level = 0; level < profiler.n_levels(); ++level)
         {
           table.add_value("level", level);
-          table.add_value("pre_smoother_step", all_mg_timers[level][0].first);
-          table.add_value("residual_step", all_mg_timers[level][1].first);
-          table.add_value("restriction", all_mg_timers[level][2].first);
-          table.add_value("coarse_solve", all_mg_timers[level][3].first);
-          table.add_value("prolongation", all_mg_timers[level][4].first);
-          table.add_value("edge_prolongation", all_mg_timers[level][5].first);
-          table.add_value("post_smoother_step", all_mg_timers[level][6].first);
+          for (unsigned int step = 0; step < MGLevelProfiler::n_steps; ++step)
+            {
+              const auto s = static_cast<MGLevelProfiler::Step>(step);
+              table.add_value(MGLevelProfiler::get_name(s), profiler.get_wall_time(level, s));
+            }
           if (mg_data.estimate_eigenvalues == true)
             {
               table.add_value("min_eigenvalue", min_eigenvalues[level]);
@@ -275,7 +323,6 @@ mg_solve(
       std::ofstream mg_level_stream(filename_mg_level);
       table.write_text(mg_level_stream);
     }
-  // ----------
 }
 
 DEAL_II_NAMESPACE_CLOSE
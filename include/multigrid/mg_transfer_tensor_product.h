@@ -0,0 +1,666 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_mg_transfer_tensor_product_h
+#define multigrid_mg_transfer_tensor_product_h
+
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/mg_level_object.h>
+#include <deal.II/base/partitioner.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_tools.h>
+
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_tools.h>
+
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/vector.h>
+
+#include <deal.II/multigrid/mg_transfer_global_coarsening.h>
+
+#include <global.h>
+#include <matrix_free_dispatch.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace internal
+{
+  namespace MGTransferTensorProduct
+  {
+    /**
+     * Apply the 1D matrix @p matrix with @p n_rows rows and @p n_columns
+     * columns in row-major order along all directions of the tensor @p in, or
+     * its transpose if @p transpose is set. Sizes given as template arguments
+     * are known at compile time, zero selects the runtime ones. The buffers
+     * @p tmp0 and @p tmp1 need room for max(n_rows, n_columns)^dim entries.
+     */
+    template <int dim, int n_rows_static, int n_columns_static, bool transpose, typename Number>
+    void
+    apply_tensor_product(const typename Number::value_type *matrix,
+                         const unsigned int                 n_rows_runtime,
+                         const unsigned int                 n_columns_runtime,
+                         const Number                      *in,
+                         Number                            *out,
+                         Number                            *tmp0,
+                         Number                            *tmp1)
+    {
+      const unsigned int n_rows    = (n_rows_static > 0) ? n_rows_static : n_rows_runtime;
+      const unsigned int n_columns = (n_columns_static > 0) ? n_columns_static : n_columns_runtime;
+
+      const unsigned int n_in  = transpose ? n_rows : n_columns;
+      const unsigned int n_out = transpose ? n_columns : n_rows;
+
+      const Number *src = in;
+      for (unsigned int d = 0; d < dim; ++d)
+        {
+          Number *dst = (d == dim - 1) ? out : ((d % 2 == 0) ? tmp0 : tmp1);
+
+          // directions before d have already been transformed
+          const unsigned int n_before = Utilities::pow(n_out, d);
+          const unsigned int n_after  = Utilities::pow(n_in, dim - 1 - d);
+
+          for (unsigned int a = 0; a < n_after; ++a)
+            for (unsigned int b = 0; b < n_before; ++b)
+              for (unsigned int i = 0; i < n_out; ++i)
+                {
+                  Number sum = 0.;
+                  for (unsigned int j = 0; j < n_in; ++j)
+                    sum += (transpose ? matrix[j * n_columns + i] : matrix[i * n_columns + j]) *
+                           src[b + n_before * (j + n_in * a)];
+                  dst[b + n_before * (i + n_out * a)] = sum;
+                }
+
+          src = dst;
+        }
+    }
+  } // namespace MGTransferTensorProduct
+} // namespace internal
+
+
+
+/**
+ * Polynomial transfer between two multigrid levels on the same mesh with
+ * continuous Lagrange elements, as an alternative to
+ * MGTwoLevelTransfer::reinit_polynomial_transfer().
+ *
+ * On each cell, prolongation interpolates the coarse function in the support
+ * points of the fine element. This is the tensor product of a 1D
+ * interpolation matrix, which is precomputed for each pair of fine and coarse
+ * degrees and applied with sum factorization. Cells with the same pair of
+ * degrees are processed in batches of VectorizedArray::size() cells. The 1D
+ * kernels are compiled for all pairs of the decrease_by_one sequence up to
+ * max_precompiled_fe_degree. Restriction is the transpose of prolongation.
+ *
+ * Fine DoFs shared by several cells are weighted by the inverse number of
+ * cells, and constrained fine DoFs are left out. Coarse constraints are
+ * resolved before prolongation and condensed after restriction.
+ */
+template <int dim, typename Number, int spacedim = dim>
+class MGTwoLevelTransferTensorProduct
+{
+public:
+  using VectorType          = LinearAlgebra::distributed::Vector<Number>;
+  using VectorizedArrayType = VectorizedArray<Number>;
+
+  static constexpr unsigned int n_lanes = VectorizedArrayType::size();
+
+  /**
+   * Whether both DoFHandlers share one triangulation and only use scalar
+   * FE_Q elements.
+   */
+  static bool
+  is_applicable(const DoFHandler<dim, spacedim> &dof_handler_fine,
+                const DoFHandler<dim, spacedim> &dof_handler_coarse)
+  {
+    if (&dof_handler_fine.get_triangulation() != &dof_handler_coarse.get_triangulation())
+      return false;
+
+    for (const auto *dof_handler : {&dof_handler_fine, &dof_handler_coarse})
+      for (unsigned int i = 0; i < dof_handler->get_fe_collection().size(); ++i)
+        if (dynamic_cast<const FE_Q<dim, spacedim> *>(&dof_handler->get_fe(i)) == nullptr)
+          return false;
+
+    return true;
+  }
+
+  /**
+   * Set up the transfer. If the optional partitioners of the level vectors
+   * hold all DoFs of locally owned cells on all processes, prolongation and
+   * restriction work on the level vectors directly instead of copying them
+   * into internal ones.
+   */
+  void
+  reinit(const DoFHandler<dim, spacedim>                            &dof_handler_fine,
+         const DoFHandler<dim, spacedim>                            &dof_handler_coarse,
+         const AffineConstraints<Number>                            &constraints_fine,
+         const AffineConstraints<Number>                            &constraints_coarse,
+         const std::shared_ptr<const Utilities::MPI::Partitioner> &level_partitioner_fine = {},
+         const std::shared_ptr<const Utilities::MPI::Partitioner> &level_partitioner_coarse = {})
+  {
+    TimerOutput::Scope t(getTimer(), "setup_transfer_tensor_product");
+
+    AssertThrow(is_applicable(dof_handler_fine, dof_handler_coarse),
+                ExcMessage("Tensor-product transfer needs FE_Q elements on the same mesh."));
+
+    const MPI_Comm communicator = dof_handler_fine.get_communicator();
+
+    this->constraints_coarse = &constraints_coarse;
+
+    // Restriction also accesses the DoFs that coarse constraints resolve to.
+    const IndexSet accessed_fine   = DoFTools::extract_locally_active_dofs(dof_handler_fine);
+    IndexSet       accessed_coarse = DoFTools::extract_locally_active_dofs(dof_handler_coarse);
+    for (const auto index : DoFTools::extract_locally_active_dofs(dof_handler_coarse))
+      if (const auto entries = constraints_coarse.get_constraint_entries(index))
+        for (const auto &entry : *entries)
+          accessed_coarse.add_index(entry.first);
+
+    const auto partitioner_fine =
+      choose_partitioner(dof_handler_fine, accessed_fine, level_partitioner_fine, in_place_fine);
+    const auto partitioner_coarse = choose_partitioner(dof_handler_coarse,
+                                                       accessed_coarse,
+                                                       level_partitioner_coarse,
+                                                       in_place_coarse);
+
+    if (!in_place_fine)
+      vec_fine.reinit(partitioner_fine);
+    vec_coarse.reinit(partitioner_coarse);
+    weights.reinit(partitioner_fine);
+
+    // Sort locally owned cells by their pair of degrees.
+    using CellPair = std::pair<typename DoFHandler<dim, spacedim>::active_cell_iterator,
+                               typename DoFHandler<dim, spacedim>::active_cell_iterator>;
+
+    std::map<std::pair<unsigned int, unsigned int>, std::vector<CellPair>> cells_by_degrees;
+
+    auto cell_coarse = dof_handler_coarse.begin_active();
+    for (const auto &cell_fine : dof_handler_fine.active_cell_iterators())
+      {
+        if (cell_fine->is_locally_owned())
+          cells_by_degrees[{cell_fine->get_fe().degree, cell_coarse->get_fe().degree}]
+            .emplace_back(cell_fine, cell_coarse);
+        ++cell_coarse;
+      }
+
+    schemes.clear();
+    schemes.reserve(cells_by_degrees.size());
+
+    std::vector<types::global_dof_index> dof_indices_fine, dof_indices_coarse;
+
+    for (const auto &[degrees, cells] : cells_by_degrees)
+      {
+        Scheme &scheme       = schemes.emplace_back();
+        scheme.degree_fine   = degrees.first;
+        scheme.degree_coarse = degrees.second;
+
+        const unsigned int n_fine_1d   = scheme.degree_fine + 1;
+        const unsigned int n_coarse_1d = scheme.degree_coarse + 1;
+        const unsigned int n_fine      = scheme.n_dofs_fine();
+        const unsigned int n_coarse    = scheme.n_dofs_coarse();
+
+        // Interpolation matrix in lexicographic numbering.
+        {
+          const FE_Q<1> fe_fine(scheme.degree_fine);
+          const FE_Q<1> fe_coarse(scheme.degree_coarse);
+
+          const auto lexicographic_fine =
+            FETools::lexicographic_to_hierarchic_numbering<1>(scheme.degree_fine);
+          const auto lexicographic_coarse =
+            FETools::lexicographic_to_hierarchic_numbering<1>(scheme.degree_coarse);
+
+          scheme.prolongation_matrix_1d.resize_fast(n_fine_1d * n_coarse_1d);
+          for (unsigned int i = 0; i < n_fine_1d; ++i)
+            for (unsigned int j = 0; j < n_coarse_1d; ++j)
+              scheme.prolongation_matrix_1d[i * n_coarse_1d + j] = fe_coarse.shape_value(
+                lexicographic_coarse[j], fe_fine.get_unit_support_points()[lexicographic_fine[i]]);
+        }
+
+        const auto lexicographic_fine =
+          FETools::lexicographic_to_hierarchic_numbering<dim>(scheme.degree_fine);
+        const auto lexicographic_coarse =
+          FETools::lexicographic_to_hierarchic_numbering<dim>(scheme.degree_coarse);
+
+        const unsigned int n_batches = (cells.size() + n_lanes - 1) / n_lanes;
+        scheme.n_filled_lanes.resize(n_batches);
+        scheme.indices_fine.resize(n_batches * n_fine * n_lanes);
+        scheme.indices_coarse.resize(n_batches * n_coarse * n_lanes);
+
+        dof_indices_fine.resize(n_fine);
+        dof_indices_coarse.resize(n_coarse);
+
+        for (unsigned int c = 0; c < cells.size(); ++c)
+          {
+            const unsigned int batch = c / n_lanes;
+            const unsigned int v     = c % n_lanes;
+
+            scheme.n_filled_lanes[batch] = v + 1;
+
+            cells[c].first->get_dof_indices(dof_indices_fine);
+            cells[c].second->get_dof_indices(dof_indices_coarse);
+
+            for (unsigned int i = 0; i < n_fine; ++i)
+              {
+                const auto index = dof_indices_fine[lexicographic_fine[i]];
+                scheme.indices_fine[(batch * n_fine + i) * n_lanes + v] =
+                  partitioner_fine->global_to_local(index);
+                weights(index) += Number(1.);
+              }
+
+            bool has_constraints = false;
+            for (unsigned int i = 0; i < n_coarse; ++i)
+              {
+                const auto index = dof_indices_coarse[lexicographic_coarse[i]];
+                scheme.indices_coarse[(batch * n_coarse + i) * n_lanes + v] =
+                  partitioner_coarse->global_to_local(index);
+                has_constraints |= constraints_coarse.is_constrained(index);
+              }
+
+            // Restriction condenses coarse constraints with global indices.
+            if (has_constraints)
+              {
+                auto &indices = scheme.constrained_cells[c];
+                for (unsigned int i = 0; i < n_coarse; ++i)
+                  indices.push_back(dof_indices_coarse[lexicographic_coarse[i]]);
+              }
+          }
+      }
+
+    // Each fine DoF contributes once in sum, constrained ones not at all.
+    weights.compress(VectorOperation::add);
+    for (unsigned int i = 0; i < weights.locally_owned_size(); ++i)
+      weights.local_element(i) =
+        constraints_fine.is_constrained(partitioner_fine->local_to_global(i)) ?
+          Number(0.) :
+          Number(1.) / weights.local_element(i);
+    weights.update_ghost_values();
+
+    // Scratch space of the cell-wise kernels, sized for the largest scheme.
+    unsigned int max_n_fine = 0, max_n_coarse = 0;
+    for (const auto &scheme : schemes)
+      {
+        max_n_fine   = std::max(max_n_fine, scheme.n_dofs_fine());
+        max_n_coarse = std::max(max_n_coarse, scheme.n_dofs_coarse());
+      }
+    values_fine.resize_fast(max_n_fine);
+    values_coarse.resize_fast(max_n_coarse);
+    tmp0.resize_fast(max_n_fine);
+    tmp1.resize_fast(max_n_fine);
+    local_values.reinit(max_n_coarse);
+  }
+
+  /**
+   * Compute dst += P src.
+   */
+  void
+  prolongate_and_add(VectorType &dst, const VectorType &src) const
+  {
+    // Coarse constraints have to be resolved without modifying src.
+    vec_coarse.copy_locally_owned_data_from(src);
+    constraints_coarse->distribute(vec_coarse);
+    vec_coarse.update_ghost_values();
+
+    VectorType *fine = &dst;
+    if (in_place_fine)
+      dst.zero_out_ghost_values();
+    else
+      {
+        vec_fine = Number(0.);
+        fine     = &vec_fine;
+      }
+
+    for (const auto &scheme : schemes)
+      {
+        const bool dispatched = (scheme.degree_coarse + 1 == scheme.degree_fine) &&
+                                expand_fe_degree<2>(scheme.degree_fine, [&](const auto degree) {
+                                  constexpr int n_1d = decltype(degree)::value + 1;
+                                  prolongate_scheme<n_1d, n_1d - 1>(scheme, vec_coarse, *fine);
+                                });
+        if (!dispatched)
+          prolongate_scheme<0, 0>(scheme, vec_coarse, *fine);
+      }
+
+    fine->compress(VectorOperation::add);
+    if (!in_place_fine)
+      for (unsigned int i = 0; i < dst.locally_owned_size(); ++i)
+        dst.local_element(i) += vec_fine.local_element(i);
+
+    vec_coarse.zero_out_ghost_values();
+  }
+
+  /**
+   * Compute dst += P^T src.
+   */
+  void
+  restrict_and_add(VectorType &dst, const VectorType &src) const
+  {
+    const VectorType *fine = &src;
+    bool              zero_out_ghosts = false;
+    if (in_place_fine)
+      {
+        zero_out_ghosts = !src.has_ghost_elements();
+        if (zero_out_ghosts)
+          src.update_ghost_values();
+      }
+    else
+      {
+        vec_fine.copy_locally_owned_data_from(src);
+        vec_fine.update_ghost_values();
+        fine            = &vec_fine;
+        zero_out_ghosts = true;
+      }
+
+    VectorType *coarse = &dst;
+    if (in_place_coarse)
+      dst.zero_out_ghost_values();
+    else
+      {
+        vec_coarse = Number(0.);
+        coarse     = &vec_coarse;
+      }
+
+    for (const auto &scheme : schemes)
+      {
+        const bool dispatched = (scheme.degree_coarse + 1 == scheme.degree_fine) &&
+                                expand_fe_degree<2>(scheme.degree_fine, [&](const auto degree) {
+                                  constexpr int n_1d = decltype(degree)::value + 1;
+                                  restrict_scheme<n_1d, n_1d - 1>(scheme, *fine, *coarse);
+                                });
+        if (!dispatched)
+          restrict_scheme<0, 0>(scheme, *fine, *coarse);
+      }
+
+    coarse->compress(VectorOperation::add);
+    if (!in_place_coarse)
+      for (unsigned int i = 0; i < dst.locally_owned_size(); ++i)
+        dst.local_element(i) += vec_coarse.local_element(i);
+
+    if (zero_out_ghosts)
+      fine->zero_out_ghost_values();
+  }
+
+  std::size_t
+  memory_consumption() const
+  {
+    std::size_t memory = weights.memory_consumption() + vec_coarse.memory_consumption();
+    memory += values_fine.memory_consumption() + values_coarse.memory_consumption() +
+              tmp0.memory_consumption() + tmp1.memory_consumption() +
+              local_values.memory_consumption();
+    if (!in_place_fine)
+      memory += vec_fine.memory_consumption();
+    for (const auto &scheme : schemes)
+      memory += MemoryConsumption::memory_consumption(scheme.prolongation_matrix_1d) +
+                MemoryConsumption::memory_consumption(scheme.indices_fine) +
+                MemoryConsumption::memory_consumption(scheme.indices_coarse) +
+                MemoryConsumption::memory_consumption(scheme.constrained_cells);
+    return memory;
+  }
+
+private:
+  /**
+   * All locally owned cells with the same pair of degrees.
+   */
+  struct Scheme
+  {
+    unsigned int
+    n_dofs_fine() const
+    {
+      return Utilities::pow(degree_fine + 1, dim);
+    }
+
+    unsigned int
+    n_dofs_coarse() const
+    {
+      return Utilities::pow(degree_coarse + 1, dim);
+    }
+
+    unsigned int degree_fine   = 0;
+    unsigned int degree_coarse = 0;
+
+    AlignedVector<Number> prolongation_matrix_1d;
+
+    // local indices into vec_fine and vec_coarse in lexicographic order,
+    // lane by lane within each batch
+    std::vector<unsigned int>  indices_fine;
+    std::vector<unsigned int>  indices_coarse;
+    std::vector<unsigned char> n_filled_lanes;
+
+    // global coarse indices of cells with constrained coarse DoFs
+    std::map<unsigned int, std::vector<types::global_dof_index>> constrained_cells;
+  };
+
+  /**
+   * Return @p level_partitioner if it holds the locally owned DoFs and all
+   * @p accessed_dofs on every process, and a partitioner of the locally
+   * relevant DoFs otherwise. The choice is stored in @p in_place.
+   */
+  static std::shared_ptr<const Utilities::MPI::Partitioner>
+  choose_partitioner(const DoFHandler<dim, spacedim>                           &dof_handler,
+                     const IndexSet                                            &accessed_dofs,
+                     const std::shared_ptr<const Utilities::MPI::Partitioner> &level_partitioner,
+                     bool                                                      &in_place)
+  {
+    const MPI_Comm communicator = dof_handler.get_communicator();
+
+    in_place = static_cast<bool>(level_partitioner) &&
+               (level_partitioner->locally_owned_range() == dof_handler.locally_owned_dofs());
+    if (in_place)
+      for (const auto index : accessed_dofs)
+        if (!level_partitioner->in_local_range(index) &&
+            !level_partitioner->is_ghost_entry(index))
+          {
+            in_place = false;
+            break;
+          }
+
+    // All processes have to take the same path for the ghost exchange.
+    in_place = (Utilities::MPI::min(static_cast<unsigned int>(in_place), communicator) == 1);
+
+    if (in_place)
+      return level_partitioner;
+
+    return std::make_shared<const Utilities::MPI::Partitioner>(
+      dof_handler.locally_owned_dofs(),
+      DoFTools::extract_locally_relevant_dofs(dof_handler),
+      communicator);
+  }
+
+  template <int n_fine_1d, int n_coarse_1d>
+  void
+  prolongate_scheme(const Scheme &scheme, const VectorType &coarse, VectorType &fine) const
+  {
+    const unsigned int n_fine   = scheme.n_dofs_fine();
+    const unsigned int n_coarse = scheme.n_dofs_coarse();
+
+    for (unsigned int batch = 0; batch < scheme.n_filled_lanes.size(); ++batch)
+      {
+        const unsigned int  n_filled = scheme.n_filled_lanes[batch];
+        const unsigned int *indices_coarse =
+          scheme.indices_coarse.data() + batch * n_coarse * n_lanes;
+        const unsigned int *indices_fine = scheme.indices_fine.data() + batch * n_fine * n_lanes;
+
+        for (unsigned int i = 0; i < n_coarse; ++i)
+          for (unsigned int v = 0; v < n_lanes; ++v)
+            values_coarse[i][v] =
+              (v < n_filled) ? coarse.local_element(indices_coarse[i * n_lanes + v]) : Number(0.);
+
+        internal::MGTransferTensorProduct::
+          apply_tensor_product<dim, n_fine_1d, n_coarse_1d, false, VectorizedArrayType>(
+            scheme.prolongation_matrix_1d.data(),
+            scheme.degree_fine + 1,
+            scheme.degree_coarse + 1,
+            values_coarse.data(),
+            values_fine.data(),
+            tmp0.data(),
+            tmp1.data());
+
+        for (unsigned int i = 0; i < n_fine; ++i)
+          for (unsigned int v = 0; v < n_filled; ++v)
+            {
+              const unsigned int index = indices_fine[i * n_lanes + v];
+              fine.local_element(index) += values_fine[i][v] * weights.local_element(index);
+            }
+      }
+  }
+
+  template <int n_fine_1d, int n_coarse_1d>
+  void
+  restrict_scheme(const Scheme &scheme, const VectorType &fine, VectorType &coarse) const
+  {
+    const unsigned int n_fine   = scheme.n_dofs_fine();
+    const unsigned int n_coarse = scheme.n_dofs_coarse();
+
+    // shrinking keeps the memory allocated in reinit()
+    local_values.reinit(n_coarse, /*omit_zeroing_entries=*/true);
+
+    for (unsigned int batch = 0; batch < scheme.n_filled_lanes.size(); ++batch)
+      {
+        const unsigned int  n_filled = scheme.n_filled_lanes[batch];
+        const unsigned int *indices_coarse =
+          scheme.indices_coarse.data() + batch * n_coarse * n_lanes;
+        const unsigned int *indices_fine = scheme.indices_fine.data() + batch * n_fine * n_lanes;
+
+        for (unsigned int i = 0; i < n_fine; ++i)
+          for (unsigned int v = 0; v < n_lanes; ++v)
+            {
+              const unsigned int index = indices_fine[i * n_lanes + v];
+              values_fine[i][v] =
+                (v < n_filled) ? fine.local_element(index) * weights.local_element(index) :
+                                 Number(0.);
+            }
+
+        internal::MGTransferTensorProduct::
+          apply_tensor_product<dim, n_fine_1d, n_coarse_1d, true, VectorizedArrayType>(
+            scheme.prolongation_matrix_1d.data(),
+            scheme.degree_fine + 1,
+            scheme.degree_coarse + 1,
+            values_fine.data(),
+            values_coarse.data(),
+            tmp0.data(),
+            tmp1.data());
+
+        for (unsigned int v = 0; v < n_filled; ++v)
+          {
+            const auto constrained = scheme.constrained_cells.find(batch * n_lanes + v);
+            if (constrained != scheme.constrained_cells.end())
+              {
+                for (unsigned int i = 0; i < n_coarse; ++i)
+                  local_values[i] = values_coarse[i][v];
+                constraints_coarse->distribute_local_to_global(local_values,
+                                                               constrained->second,
+                                                               coarse);
+              }
+            else
+              for (unsigned int i = 0; i < n_coarse; ++i)
+                coarse.local_element(indices_coarse[i * n_lanes + v]) += values_coarse[i][v];
+          }
+      }
+  }
+
+  std::vector<Scheme> schemes;
+
+  SmartPointer<const AffineConstraints<Number>> constraints_coarse;
+
+  // inverse number of cells sharing each fine DoF, zero on constrained ones
+  VectorType weights;
+
+  // whether the level vectors share the partitioners of the internal ones
+  bool in_place_fine   = false;
+  bool in_place_coarse = false;
+
+  mutable VectorType vec_fine;
+  mutable VectorType vec_coarse;
+
+  // scratch space of prolongate_scheme() and restrict_scheme()
+  mutable AlignedVector<VectorizedArrayType> values_fine;
+  mutable AlignedVector<VectorizedArrayType> values_coarse;
+  mutable AlignedVector<VectorizedArrayType> tmp0;
+  mutable AlignedVector<VectorizedArrayType> tmp1;
+  mutable Vector<Number>                     local_values;
+};
+
+
+
+/**
+ * Transfer of the global-coarsening multigrid that applies
+ * MGTwoLevelTransferTensorProduct on those levels it has been set up for, and
+ * MGTwoLevelTransfer everywhere else.
+ */
+template <int dim, typename VectorType, int spacedim = dim>
+class MGTransferTensorProduct : public MGTransferGlobalCoarsening<dim, VectorType>
+{
+public:
+  using Base = MGTransferGlobalCoarsening<dim, VectorType>;
+
+  using TensorProductTransferType =
+    MGTwoLevelTransferTensorProduct<dim, typename VectorType::value_type, spacedim>;
+
+  MGTransferTensorProduct(
+    const MGLevelObject<MGTwoLevelTransfer<dim, VectorType>>         &transfer,
+    const MGLevelObject<std::shared_ptr<TensorProductTransferType>> &tensor_product_transfer,
+    const std::function<void(const unsigned int, VectorType &)>     &initialize_dof_vector)
+    : Base(transfer, initialize_dof_vector)
+    , tensor_product_transfer(tensor_product_transfer)
+  {}
+
+  void
+  prolongate(const unsigned int to_level, VectorType &dst, const VectorType &src) const override
+  {
+    dst = 0.;
+    prolongate_and_add(to_level, dst, src);
+  }
+
+  void
+  prolongate_and_add(const unsigned int to_level,
+                     VectorType        &dst,
+                     const VectorType  &src) const override
+  {
+    if (tensor_product_transfer[to_level])
+      tensor_product_transfer[to_level]->prolongate_and_add(dst, src);
+    else
+      Base::prolongate_and_add(to_level, dst, src);
+  }
+
+  void
+  restrict_and_add(const unsigned int from_level,
+                   VectorType        &dst,
+                   const VectorType  &src) const override
+  {
+    if (tensor_product_transfer[from_level])
+      tensor_product_transfer[from_level]->restrict_and_add(dst, src);
+    else
+      Base::restrict_and_add(from_level, dst, src);
+  }
+
+private:
+  MGLevelObject<std::shared_ptr<TensorProductTransferType>> tensor_product_transfer;
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
@@ -0,0 +1,76 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_mixed_precision_h
+#define multigrid_mixed_precision_h
+
+
+#include <deal.II/base/subscriptor.h>
+
+#include <deal.II/lac/la_parallel_vector.h>
+
+#include <type_traits>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Apply a preconditioner that only works on double precision vectors, e.g., the
+ * AMG of Trilinos, to vectors of type @p VectorType.
+ *
+ * For single precision vectors, @p src and @p dst are copied to double precision
+ * vectors on the fly. For double precision vectors, the preconditioner is called
+ * directly.
+ */
+template <typename VectorType, typename PreconditionerType>
+class PreconditionMixedPrecision : public Subscriptor
+{
+public:
+  PreconditionMixedPrecision(const PreconditionerType &preconditioner)
+    : preconditioner(preconditioner)
+  {}
+
+  void
+  vmult(VectorType &dst, const VectorType &src) const
+  {
+    if constexpr (std::is_same_v<typename VectorType::value_type, double>)
+      {
+        preconditioner.vmult(dst, src);
+      }
+    else
+      {
+        if (src_double.get_partitioner().get() != src.get_partitioner().get())
+          {
+            src_double.reinit(src.get_partitioner());
+            dst_double.reinit(src.get_partitioner());
+          }
+
+        src_double.copy_locally_owned_data_from(src);
+        preconditioner.vmult(dst_double, src_double);
+        dst.copy_locally_owned_data_from(dst_double);
+      }
+  }
+
+private:
+  const PreconditionerType &preconditioner;
+
+  mutable LinearAlgebra::distributed::Vector<double> src_double;
+  mutable LinearAlgebra::distributed::Vector<double> dst_double;
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
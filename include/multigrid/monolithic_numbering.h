@@ -0,0 +1,161 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_monolithic_numbering_h
+#define multigrid_monolithic_numbering_h
+
+
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/lac/la_parallel_vector.h>
+
+#include <algorithm>
+#include <vector>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Numbering of a block system as a single vector, in which every process
+ * owns one contiguous range of indices. Processes follow each other in the
+ * order of their ranks. Within the range of each process, the locally owned
+ * DoFs of all blocks follow each other in the order of the blocks.
+ *
+ * The locally owned entries of the blocks of a block vector thus lie back
+ * to back in the locally owned entries of a vector in this numbering.
+ */
+class MonolithicNumbering
+{
+public:
+  /**
+   * Set up the numbering from the index sets of locally owned and relevant
+   * DoFs of each block. Monolithic indices of ghost DoFs are communicated.
+   */
+  void
+  reinit(const std::vector<IndexSet> &owned_dofs,
+         const std::vector<IndexSet> &relevant_dofs,
+         const MPI_Comm               communicator)
+  {
+    AssertDimension(owned_dofs.size(), relevant_dofs.size());
+
+    types::global_dof_index n_owned = 0, n_dofs = 0;
+    for (unsigned int b = 0; b < owned_dofs.size(); ++b)
+      {
+        n_owned += owned_dofs[b].n_elements();
+        n_dofs += owned_dofs[b].size();
+      }
+
+    // First index of this process, i.e., the exclusive prefix sum of the
+    // number of locally owned DoFs. It is undefined on the first process.
+    types::global_dof_index start = 0;
+    const int               ierr =
+      MPI_Exscan(&n_owned, &start, 1, DEAL_II_DOF_INDEX_MPI_TYPE, MPI_SUM, communicator);
+    AssertThrowMPI(ierr);
+    if (Utilities::MPI::this_mpi_process(communicator) == 0)
+      start = 0;
+
+    this->relevant_dofs = relevant_dofs;
+
+    owned_monolithic.clear();
+    owned_monolithic.set_size(n_dofs);
+    owned_monolithic.add_range(start, start + n_owned);
+
+    std::vector<types::global_dof_index> relevant_indices;
+
+    types::global_dof_index offset = start;
+
+    monolithic_indices.resize(owned_dofs.size());
+    for (unsigned int b = 0; b < owned_dofs.size(); ++b)
+      {
+        // Indices are exchanged as floating point numbers, which represent
+        // them exactly up to 2^53.
+        LinearAlgebra::distributed::Vector<double> indices(owned_dofs[b],
+                                                           relevant_dofs[b],
+                                                           communicator);
+        for (unsigned int i = 0; i < owned_dofs[b].n_elements(); ++i)
+          indices.local_element(i) = offset + i;
+        indices.update_ghost_values();
+
+        monolithic_indices[b].clear();
+        monolithic_indices[b].reserve(relevant_dofs[b].n_elements());
+        for (const auto index : relevant_dofs[b])
+          monolithic_indices[b].push_back(static_cast<types::global_dof_index>(indices(index)));
+
+        relevant_indices.insert(relevant_indices.end(),
+                                monolithic_indices[b].begin(),
+                                monolithic_indices[b].end());
+
+        offset += owned_dofs[b].n_elements();
+      }
+
+    std::sort(relevant_indices.begin(), relevant_indices.end());
+
+    relevant_monolithic.clear();
+    relevant_monolithic.set_size(n_dofs);
+    relevant_monolithic.add_indices(relevant_indices.begin(), relevant_indices.end());
+    relevant_monolithic.compress();
+  }
+
+  /**
+   * Monolithic index of the locally relevant DoF @p index of @p block.
+   */
+  types::global_dof_index
+  to_monolithic(const unsigned int block, const types::global_dof_index index) const
+  {
+    AssertIndexRange(block, monolithic_indices.size());
+    Assert(relevant_dofs[block].is_element(index),
+           ExcMessage("Only locally relevant DoFs have a monolithic index."));
+
+    return monolithic_indices[block][relevant_dofs[block].index_within_set(index)];
+  }
+
+  const IndexSet &
+  get_owned_dofs() const
+  {
+    return owned_monolithic;
+  }
+
+  const IndexSet &
+  get_relevant_dofs() const
+  {
+    return relevant_monolithic;
+  }
+
+  std::size_t
+  memory_consumption() const
+  {
+    std::size_t memory =
+      owned_monolithic.memory_consumption() + relevant_monolithic.memory_consumption();
+    for (unsigned int b = 0; b < monolithic_indices.size(); ++b)
+      memory += relevant_dofs[b].memory_consumption() +
+                MemoryConsumption::memory_consumption(monolithic_indices[b]);
+    return memory;
+  }
+
+private:
+  IndexSet owned_monolithic;
+  IndexSet relevant_monolithic;
+
+  // monolithic indices of the locally relevant DoFs of each block
+  std::vector<IndexSet>                             relevant_dofs;
+  std::vector<std::vector<types::global_dof_index>> monolithic_indices;
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
@@ -20,6 +20,8 @@
 #include <deal.II/base/subscriptor.h>
 #include <deal.II/base/types.h>
 
+#include <functional>
+
 
 // ----------------------------------------
 // NOTE:
@@ -33,7 +35,8 @@ template <int dim, typename VectorType, typename MatrixType>
 class MGSolverOperatorBase : public Subscriptor
 {
 public:
-  using value_type = typename VectorType::value_type;
+  using vector_type = VectorType;
+  using value_type  = typename VectorType::value_type;
 
   // Return number of rows of the matrix. Since we are dealing with a
   // symmetrical matrix, the returned value is the same as the number of
@@ -54,6 +57,19 @@ public:
   virtual void
   vmult(VectorType &dst, const VectorType &src) const;
 
+  // Perform an operator application on the vector @p src, and call
+  // @p operation_before_loop and @p operation_after_loop on ranges of locally
+  // owned entries before they are touched first and after they are touched
+  // last. PreconditionChebyshev uses this to merge its vector updates into
+  // the operator application. By default, both operations are performed on
+  // the whole range around vmult().
+  virtual void
+  vmult(VectorType                                                        &dst,
+        const VectorType                                                  &src,
+        const std::function<void(const unsigned int, const unsigned int)> &operation_before_loop,
+        const std::function<void(const unsigned int, const unsigned int)> &operation_after_loop)
+    const;
+
   // Perform the transposed operator evaluation. Since we are considering
   // symmetric matrices, this function is identical to the above function.
   virtual void
@@ -70,6 +86,11 @@ public:
   virtual const MatrixType &
   get_system_matrix() const;
 
+  // Return the memory consumption of this operator in bytes, including the
+  // system matrix if it has been set up.
+  virtual std::size_t
+  memory_consumption() const = 0;
+
 private:
   const MatrixType dummy_sparse_matrix;
 };
@@ -80,7 +101,7 @@ template <int dim, typename VectorType, typename MatrixType>
 types::global_dof_index
 MGSolverOperatorBase<dim, VectorType, MatrixType>::m() const
 {
-  Assert(false, ExcNotImplemented());
+  AssertThrow(false, ExcNotImplemented());
   return 0;
 }
 
@@ -90,7 +111,7 @@ template <int dim, typename VectorType, typename MatrixType>
 typename MGSolverOperatorBase<dim, VectorType, MatrixType>::value_type
 MGSolverOperatorBase<dim, VectorType, MatrixType>::el(unsigned int, unsigned int) const
 {
-  Assert(false, ExcNotImplemented());
+  AssertThrow(false, ExcNotImplemented());
   return 0;
 }
 
@@ -100,7 +121,7 @@ template <int dim, typename VectorType, typename MatrixType>
 void
 MGSolverOperatorBase<dim, VectorType, MatrixType>::initialize_dof_vector(VectorType &vec) const
 {
-  Assert(false, ExcNotImplemented());
+  AssertThrow(false, ExcNotImplemented());
   (void)vec;
 }
 
@@ -111,19 +132,40 @@ void
 MGSolverOperatorBase<dim, VectorType, MatrixType>::vmult(VectorType       &dst,
                                                          const VectorType &src) const
 {
-  Assert(false, ExcNotImplemented());
+  AssertThrow(false, ExcNotImplemented());
   (void)dst;
   (void)src;
 }
 
 
 
+template <int dim, typename VectorType, typename MatrixType>
+void
+MGSolverOperatorBase<dim, VectorType, MatrixType>::vmult(
+  VectorType                                                        &dst,
+  const VectorType                                                  &src,
+  const std::function<void(const unsigned int, const unsigned int)> &operation_before_loop,
+  const std::function<void(const unsigned int, const unsigned int)> &operation_after_loop) const
+{
+  const unsigned int locally_owned_size = dst.locally_owned_elements().n_elements();
+
+  if (operation_before_loop)
+    operation_before_loop(0, locally_owned_size);
+
+  vmult(dst, src);
+
+  if (operation_after_loop)
+    operation_after_loop(0, locally_owned_size);
+}
+
+
+
 template <int dim, typename VectorType, typename MatrixType>
 void
 MGSolverOperatorBase<dim, VectorType, MatrixType>::Tvmult(VectorType       &dst,
                                                           const VectorType &src) const
 {
-  Assert(false, ExcNotImplemented());
+  AssertThrow(false, ExcNotImplemented());
   (void)dst;
   (void)src;
 }
@@ -135,7 +177,7 @@ void
 MGSolverOperatorBase<dim, VectorType, MatrixType>::compute_inverse_diagonal(
   VectorType &diagonal) const
 {
-  Assert(false, ExcNotImplemented());
+  AssertThrow(false, ExcNotImplemented());
   (void)diagonal;
 }
 
@@ -145,7 +187,7 @@ template <int dim, typename VectorType, typename MatrixType>
 const MatrixType &
 MGSolverOperatorBase<dim, VectorType, MatrixType>::get_system_matrix() const
 {
-  Assert(false, ExcNotImplemented());
+  AssertThrow(false, ExcNotImplemented());
   return dummy_sparse_matrix;
 }
 
@@ -155,17 +197,23 @@ DEAL_II_NAMESPACE_CLOSE
 // ----------------------------------------
 
 
+#include <deal.II/base/index_set.h>
+
 #include <multigrid/mg_solver.h>
 #include <partitioning.h>
 
 #include <memory>
+#include <vector>
 
 
 template <int dim, typename VectorType, typename MatrixType, int spacedim = dim>
 class OperatorBase : public dealii::MGSolverOperatorBase<dim, VectorType, MatrixType>
 {
 public:
-  static_assert(std::is_same_v<typename VectorType::value_type, typename MatrixType::value_type>);
+  // Vectors may come in lower precision than the matrix, e.g., for level
+  // operators of mixed-precision multigrid with double precision Trilinos matrices.
+  static_assert(sizeof(typename VectorType::value_type) <=
+                sizeof(typename MatrixType::value_type));
   using value_type = typename VectorType::value_type;
 
   virtual ~OperatorBase() = default;
@@ -188,6 +236,31 @@ public:
 
   virtual const MatrixType &
   get_system_matrix() const override = 0;
+
+  // Add the entries of the system matrix that couple the DoFs in
+  // @p all_indices_assemble to @p matrix, condensed with @p constraints_reduced.
+  // Patch smoothers are set up this way without the full system matrix.
+  virtual void
+  compute_partial_matrix(const dealii::IndexSet                  &all_indices_assemble,
+                         const dealii::AffineConstraints<double> &constraints_reduced,
+                         MatrixType                              &matrix) const
+  {
+    AssertThrow(false, dealii::ExcNotImplemented());
+    (void)all_indices_assemble;
+    (void)constraints_reduced;
+    (void)matrix;
+  }
+
+  // Measure the wall time of the cell integrals per cell and operator
+  // application for each active FE index, taken over @p n_repetitions
+  // applications on all processes. FE indices without any cells get zero.
+  virtual std::vector<double>
+  measure_cost_per_cell(const unsigned int n_repetitions) const
+  {
+    AssertThrow(false, dealii::ExcNotImplemented());
+    (void)n_repetitions;
+    return {};
+  }
 };
 
 
@@ -22,6 +22,7 @@
 #include <deal.II/multigrid/mg_transfer_global_coarsening.h>
 
 #include <string>
+#include <vector>
 
 
 // ----------------------------------------
@@ -66,16 +67,97 @@ struct MGSolverParameters : public dealii::ParameterAcceptor
     smoother_preconditioner_type = "Extended Diagonal";
     add_parameter("smoother preconditioner type", smoother_preconditioner_type);
 
+    auto_smoother_preconditioner_types = {"Diagonal", "Extended Diagonal", "ASM"};
+    add_parameter("auto smoother preconditioner types", auto_smoother_preconditioner_types);
+
+    auto_smoother_degrees = {};
+    add_parameter("auto smoother degrees", auto_smoother_degrees);
+
+    auto_n_iterations = 5;
+    add_parameter("auto n iterations", auto_n_iterations);
+
     estimate_eigenvalues = true;
     add_parameter("estimate eigenvalues", estimate_eigenvalues);
 
     log_levels = false;
     add_parameter("log levels", log_levels);
+
+    mixed_precision = false;
+    add_parameter("mixed precision", mixed_precision);
+
+    reuse_hierarchy = true;
+    add_parameter("reuse hierarchy", reuse_hierarchy);
+
+    threaded_smoother_setup = false;
+    add_parameter("threaded smoother setup", threaded_smoother_setup);
+
+    cache_eigenvalues = true;
+    add_parameter("cache eigenvalues", cache_eigenvalues);
+
+    eigenvalue_cache_max_age = 0;
+    add_parameter("eigenvalue cache max age", eigenvalue_cache_max_age);
+
+    cycle = "V";
+    add_parameter("cycle", cycle);
+
+    smoother_degree_h_levels = smoother.degree;
+    add_parameter("smoother degree h levels", smoother_degree_h_levels);
+
+    smoother_degree_p_levels = smoother.degree;
+    add_parameter("smoother degree p levels", smoother_degree_p_levels);
+
+    coarse_solver_ranks = 0;
+    add_parameter("coarse solver ranks", coarse_solver_ranks);
+
+    repartitioning_policy = "none";
+    add_parameter("repartitioning policy", repartitioning_policy);
+
+    repartitioning_min_cells = 64;
+    add_parameter("repartitioning min cells", repartitioning_min_cells);
+
+    tensor_product_transfer = false;
+    add_parameter("tensor product transfer", tensor_product_transfer);
   }
 
+  // Diagonal, Extended Diagonal, ASM, or auto to pick one of them by calibration
   std::string smoother_preconditioner_type;
   bool        estimate_eigenvalues;
   bool        log_levels;
+  bool        mixed_precision;
+  bool        reuse_hierarchy;
+  bool        threaded_smoother_setup;
+  bool        cache_eigenvalues;
+
+  unsigned int eigenvalue_cache_max_age;
+
+  // candidates for smoother preconditioner type auto, which are compared by
+  // calibration solves with this many iterations on the first solve
+  std::vector<std::string> auto_smoother_preconditioner_types;
+  unsigned int             auto_n_iterations;
+
+  // Chebyshev degrees compared by the same calibration, each replacing the
+  // degree on all smoothed levels; empty keeps the degrees given above
+  std::vector<unsigned int> auto_smoother_degrees;
+
+  // V, W or F
+  std::string cycle;
+
+  // Chebyshev degree on levels below and from minlevel_p on, zero skips smoothing;
+  // number of Vanka iterations with monolithic Stokes multigrid
+  unsigned int smoother_degree_h_levels;
+  unsigned int smoother_degree_p_levels;
+
+  // agglomerate the coarse level onto this many ranks, zero uses all ranks
+  unsigned int coarse_solver_ranks;
+
+  // partitioning of the h-levels: none keeps the one of the fine mesh,
+  // alternatives are first child and minimal granularity
+  std::string  repartitioning_policy;
+  unsigned int repartitioning_min_cells;
+
+  // transfer between p-levels with precomputed sum-factorization kernels,
+  // see MGTwoLevelTransferTensorProduct
+  bool tensor_product_transfer;
 };
 
 
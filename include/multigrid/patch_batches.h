@@ -0,0 +1,274 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_patch_batches_h
+#define multigrid_patch_batches_h
+
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/partitioner.h>
+#include <deal.II/base/vectorization.h>
+
+#include <deal.II/lac/full_matrix.h>
+
+#include <multigrid/patch_indices.h>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Call @p f(begin, end) on subranges of the patches [0, n_patches). The
+ * subranges are processed by parallel tasks if @p threaded is set.
+ */
+template <typename Function>
+void
+apply_to_patch_ranges(const unsigned int n_patches, const Function &f, const bool threaded)
+{
+  if (threaded)
+    parallel::apply_to_subranges(0u, n_patches, f, /*grainsize=*/32);
+  else
+    f(0u, n_patches);
+}
+
+
+
+/**
+ * Patch matrices of an additive Schwarz type smoother, stored in a single
+ * contiguous arena and grouped into batches of patches with the same size.
+ *
+ * Each batch holds VectorizedArray::size() patches, so that one batch is
+ * applied with SIMD instructions. Incomplete batches are padded with zero
+ * matrices that act on the indices of the first patch in the batch. Patch
+ * indices are translated to local indices of the vectors the smoother is
+ * applied to, which happens whenever a vector with a new partitioner shows up.
+ *
+ * Interior patches, which only contain locally owned DoFs, come first. They
+ * can be applied while ghost values are exchanged.
+ */
+template <typename Number>
+class PatchBatches
+{
+public:
+  using VectorizedArrayType = VectorizedArray<Number>;
+
+  static constexpr unsigned int n_lanes = VectorizedArrayType::size();
+
+  /**
+   * Sort patches into interior and boundary ones, each by size, and copy their
+   * matrices into the arena.
+   */
+  void
+  reinit(const PatchIndices                    &patch_indices,
+         const std::vector<FullMatrix<Number>> &patch_matrices,
+         const IndexSet                        &locally_owned_dofs)
+  {
+    AssertDimension(patch_indices.size(), patch_matrices.size());
+
+    std::vector<bool> is_boundary(patch_indices.size());
+    for (unsigned int p = 0; p < patch_indices.size(); ++p)
+      is_boundary[p] = std::any_of(patch_indices[p].begin(),
+                                   patch_indices[p].end(),
+                                   [&](const auto i) { return !locally_owned_dofs.is_element(i); });
+
+    std::vector<unsigned int> patches(patch_indices.size());
+    std::iota(patches.begin(), patches.end(), 0);
+    std::stable_sort(patches.begin(), patches.end(), [&](const auto a, const auto b) {
+      return std::make_pair(is_boundary[a], patch_indices[a].size()) <
+             std::make_pair(is_boundary[b], patch_indices[b].size());
+    });
+
+    batch_sizes.clear();
+    matrix_offsets.assign(1, 0);
+    index_offsets.assign(1, 0);
+    global_indices.clear();
+    local_indices.clear();
+    local_partitioner.reset();
+
+    unsigned int max_size = 0;
+    n_interior            = 0;
+
+    // Collect batches of patches with the same size and location.
+    std::vector<std::vector<unsigned int>> batches;
+    for (unsigned int i = 0; i < patches.size();)
+      {
+        const unsigned int size     = patch_indices[patches[i]].size();
+        const bool         boundary = is_boundary[patches[i]];
+
+        std::vector<unsigned int> batch;
+        for (; i < patches.size() && batch.size() < n_lanes &&
+               patch_indices[patches[i]].size() == size && is_boundary[patches[i]] == boundary;
+             ++i)
+          batch.push_back(patches[i]);
+
+        if (size == 0)
+          continue;
+
+        if (boundary == false)
+          ++n_interior;
+
+        batches.emplace_back(std::move(batch));
+        batch_sizes.push_back(size);
+        matrix_offsets.push_back(matrix_offsets.back() + size * size);
+        index_offsets.push_back(index_offsets.back() + size * n_lanes);
+        max_size = std::max(max_size, size);
+      }
+
+    // Fill matrices and indices, lane by lane.
+    matrices.resize_fast(matrix_offsets.back());
+    global_indices.resize(index_offsets.back());
+
+    for (unsigned int b = 0; b < batches.size(); ++b)
+      {
+        const unsigned int   size    = batch_sizes[b];
+        VectorizedArrayType *matrix  = matrices.data() + matrix_offsets[b];
+        auto                *indices = global_indices.data() + index_offsets[b];
+
+        for (unsigned int v = 0; v < n_lanes; ++v)
+          {
+            const bool         padded = (v >= batches[b].size());
+            const unsigned int p      = batches[b][padded ? 0 : v];
+
+            for (unsigned int i = 0; i < size; ++i)
+              indices[i * n_lanes + v] = patch_indices[p][i];
+
+            for (unsigned int r = 0; r < size; ++r)
+              for (unsigned int c = 0; c < size; ++c)
+                matrix[r * size + c][v] = padded ? Number(0.) : patch_matrices[p](r, c);
+          }
+      }
+
+    src_batch.resize_fast(max_size);
+    dst_batch.resize_fast(max_size);
+  }
+
+  unsigned int
+  n_batches() const
+  {
+    return batch_sizes.size();
+  }
+
+  /**
+   * Number of batches of interior patches, which are the first ones.
+   */
+  unsigned int
+  n_interior_batches() const
+  {
+    return n_interior;
+  }
+
+  /**
+   * Compute dst += sum_p R_p^T A_p^{-1} R_p src. Both vectors need to share
+   * the same partitioner and their ghost values need to be up to date.
+   */
+  template <typename VectorType>
+  void
+  vmult_add(VectorType &dst, const VectorType &src) const
+  {
+    vmult_add(dst, src, 0, n_batches());
+  }
+
+  /**
+   * Same as above, but only for the batches [@p batch_begin, @p batch_end).
+   * Interior batches neither read nor write ghost values.
+   */
+  template <typename VectorType>
+  void
+  vmult_add(VectorType        &dst,
+            const VectorType  &src,
+            const unsigned int batch_begin,
+            const unsigned int batch_end) const
+  {
+    Assert(dst.get_partitioner().get() == src.get_partitioner().get(),
+           ExcMessage("Vectors need to share the same partitioner!"));
+    AssertIndexRange(batch_end, n_batches() + 1);
+
+    if (local_partitioner != src.get_partitioner())
+      reinit_local_indices(src.get_partitioner());
+
+    for (unsigned int b = batch_begin; b < batch_end; ++b)
+      {
+        const unsigned int         size    = batch_sizes[b];
+        const VectorizedArrayType *matrix  = matrices.data() + matrix_offsets[b];
+        const unsigned int        *indices = local_indices.data() + index_offsets[b];
+
+        // gather
+        for (unsigned int i = 0; i < size; ++i)
+          for (unsigned int v = 0; v < n_lanes; ++v)
+            src_batch[i][v] = src.local_element(indices[i * n_lanes + v]);
+
+        // apply patch inverses
+        for (unsigned int r = 0; r < size; ++r)
+          {
+            VectorizedArrayType sum = matrix[r * size] * src_batch[0];
+            for (unsigned int c = 1; c < size; ++c)
+              sum += matrix[r * size + c] * src_batch[c];
+            dst_batch[r] = sum;
+          }
+
+        // scatter
+        for (unsigned int i = 0; i < size; ++i)
+          for (unsigned int v = 0; v < n_lanes; ++v)
+            dst.local_element(indices[i * n_lanes + v]) += dst_batch[i][v];
+      }
+  }
+
+  std::size_t
+  memory_consumption() const
+  {
+    return MemoryConsumption::memory_consumption(matrices) +
+           MemoryConsumption::memory_consumption(global_indices) +
+           MemoryConsumption::memory_consumption(local_indices);
+  }
+
+private:
+  void
+  reinit_local_indices(const std::shared_ptr<const Utilities::MPI::Partitioner> &partitioner) const
+  {
+    local_indices.resize(global_indices.size());
+    for (unsigned int i = 0; i < global_indices.size(); ++i)
+      local_indices[i] = partitioner->global_to_local(global_indices[i]);
+
+    local_partitioner = partitioner;
+  }
+
+  std::vector<unsigned int> batch_sizes;
+  unsigned int              n_interior = 0;
+  std::vector<std::size_t>  matrix_offsets;
+  std::vector<std::size_t>  index_offsets;
+
+  AlignedVector<VectorizedArrayType>   matrices;
+  std::vector<types::global_dof_index> global_indices;
+
+  // Keep the partitioner alive, so that its address identifies the local
+  // indices.
+  mutable std::vector<unsigned int>                          local_indices;
+  mutable std::shared_ptr<const Utilities::MPI::Partitioner> local_partitioner;
+
+  mutable AlignedVector<VectorizedArrayType> src_batch;
+  mutable AlignedVector<VectorizedArrayType> dst_batch;
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
@@ -17,19 +17,127 @@
 #define multigrid_patch_indices_h
 
 
+#include <deal.II/base/array_view.h>
+#include <deal.II/base/memory_consumption.h>
+
 #include <deal.II/dofs/dof_handler.h>
 
 #include <deal.II/grid/filtered_iterator.h>
 
 #include <deal.II/lac/affine_constraints.h>
 
+#include <multigrid/monolithic_numbering.h>
+
+#include <vector>
+
+
+/**
+ * Indices of a collection of patches in compressed row storage: the indices
+ * of all patches are stored back to back in a single array, and patch p owns
+ * the range [offsets[p], offsets[p+1]) of it.
+ *
+ * Patches are built by adding their indices one by one and closing them
+ * afterwards, which avoids one allocation per patch.
+ */
+class PatchIndices
+{
+public:
+  PatchIndices()
+    : offsets(1, 0)
+  {}
+
+  unsigned int
+  size() const
+  {
+    return offsets.size() - 1;
+  }
+
+  bool
+  empty() const
+  {
+    return size() == 0;
+  }
+
+  /**
+   * Total number of indices over all patches.
+   */
+  std::size_t
+  n_indices() const
+  {
+    return indices.size();
+  }
+
+  dealii::ArrayView<const dealii::types::global_dof_index>
+  operator[](const unsigned int p) const
+  {
+    AssertIndexRange(p, size());
+    return dealii::ArrayView<const dealii::types::global_dof_index>(indices.data() + offsets[p],
+                                                                    offsets[p + 1] - offsets[p]);
+  }
+
+  /**
+   * Indices of all patches back to back.
+   */
+  dealii::ArrayView<const dealii::types::global_dof_index>
+  get_all_indices() const
+  {
+    return dealii::ArrayView<const dealii::types::global_dof_index>(indices.data(),
+                                                                    indices.size());
+  }
+
+  /**
+   * Add an index to the patch that is currently built.
+   */
+  void
+  add_index(const dealii::types::global_dof_index index)
+  {
+    indices.push_back(index);
+  }
+
+  /**
+   * Finish the patch that is currently built. Empty patches are skipped.
+   */
+  void
+  close_patch()
+  {
+    if (indices.size() > offsets.back())
+      offsets.push_back(indices.size());
+  }
+
+  /**
+   * Copy into one vector per patch, as expected by
+   * SparseMatrixTools::restrict_to_full_matrices().
+   */
+  std::vector<std::vector<dealii::types::global_dof_index>>
+  get_patch_vectors() const
+  {
+    std::vector<std::vector<dealii::types::global_dof_index>> patch_vectors(size());
+    for (unsigned int p = 0; p < size(); ++p)
+      patch_vectors[p].assign(indices.begin() + offsets[p], indices.begin() + offsets[p + 1]);
+    return patch_vectors;
+  }
+
+  std::size_t
+  memory_consumption() const
+  {
+    return dealii::MemoryConsumption::memory_consumption(offsets) +
+           dealii::MemoryConsumption::memory_consumption(indices);
+  }
+
+private:
+  std::vector<std::size_t>                     offsets;
+  std::vector<dealii::types::global_dof_index> indices;
+};
+
+
+
 
 template <int dim, int spacedim, typename Number>
-std::vector<std::vector<dealii::types::global_dof_index>>
+PatchIndices
 prepare_patch_indices(const dealii::DoFHandler<dim, spacedim> &dof_handler,
                       const dealii::AffineConstraints<Number> &constraints)
 {
-  std::vector<std::vector<dealii::types::global_dof_index>> patch_indices;
+  PatchIndices patch_indices;
 
   std::vector<dealii::types::global_dof_index> local_indices;
   for (const auto &cell :
@@ -61,14 +169,12 @@ prepare_patch_indices(const dealii::DoFHandler<dim, spacedim> &dof_handler,
 
           for (unsigned int c = 0; c < cell->get_fe().n_components(); ++c)
             {
-              std::vector<dealii::types::global_dof_index> local_unconstrained_indices;
               for (unsigned int i = 0; i < local_indices.size(); ++i)
                 if (cell->get_fe().face_system_to_component_index(i).first == c)
                   if (constraints.is_constrained(local_indices[i]) == false)
-                    local_unconstrained_indices.emplace_back(local_indices[i]);
+                    patch_indices.add_index(local_indices[i]);
 
-              if (local_unconstrained_indices.empty() == false)
-                patch_indices.push_back(std::move(local_unconstrained_indices));
+              patch_indices.close_patch();
             }
         }
 
@@ -76,4 +182,51 @@ prepare_patch_indices(const dealii::DoFHandler<dim, spacedim> &dof_handler,
 }
 
 
+
+/**
+ * Cell-based Vanka patches for a Stokes system with velocity and pressure on
+ * separate DoFHandlers. Each patch contains the unconstrained velocity and
+ * pressure DoFs of one locally owned cell.
+ *
+ * Indices refer to @p numbering, in which velocity is the first block and
+ * pressure the second one.
+ */
+template <int dim, int spacedim, typename Number>
+PatchIndices
+prepare_vanka_patch_indices(const dealii::DoFHandler<dim, spacedim> &dof_handler_v,
+                            const dealii::DoFHandler<dim, spacedim> &dof_handler_p,
+                            const dealii::AffineConstraints<Number> &constraints_v,
+                            const dealii::AffineConstraints<Number> &constraints_p,
+                            const dealii::MonolithicNumbering       &numbering)
+{
+  PatchIndices patch_indices;
+
+  std::vector<dealii::types::global_dof_index> local_indices;
+
+  auto cell_p = dof_handler_p.begin_active();
+  for (const auto &cell_v : dof_handler_v.active_cell_iterators())
+    {
+      if (cell_v->is_locally_owned())
+        {
+          local_indices.resize(cell_v->get_fe().n_dofs_per_cell());
+          cell_v->get_dof_indices(local_indices);
+          for (const auto i : local_indices)
+            if (constraints_v.is_constrained(i) == false)
+              patch_indices.add_index(numbering.to_monolithic(0, i));
+
+          local_indices.resize(cell_p->get_fe().n_dofs_per_cell());
+          cell_p->get_dof_indices(local_indices);
+          for (const auto i : local_indices)
+            if (constraints_p.is_constrained(i) == false)
+              patch_indices.add_index(numbering.to_monolithic(1, i));
+
+          patch_indices.close_patch();
+        }
+      ++cell_p;
+    }
+
+  return patch_indices;
+}
+
+
 #endif
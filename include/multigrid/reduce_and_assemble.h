@@ -17,6 +17,8 @@
 #define multigrid_reduce_and_assemble_h
 
 
+#include <deal.II/base/index_set.h>
+
 #include <deal.II/dofs/dof_handler.h>
 #include <deal.II/dofs/dof_tools.h>
 
@@ -29,15 +31,22 @@
 #include <deal.II/lac/full_matrix.h>
 #include <deal.II/lac/sparsity_pattern_base.h>
 
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <multigrid/patch_indices.h>
+#include <partitioning.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
 
 template <int dim, int spacedim>
-std::set<dealii::types::global_dof_index>
-extract_relevant(const std::vector<std::vector<dealii::types::global_dof_index>> &patch_indices,
-                 const Partitioning                                              &partitioning,
-                 const dealii::DoFHandler<dim, spacedim>                         &dof_handler)
+dealii::IndexSet
+extract_relevant(const PatchIndices                      &patch_indices,
+                 const Partitioning                      &partitioning,
+                 const dealii::DoFHandler<dim, spacedim> &dof_handler)
 {
-  std::set<dealii::types::global_dof_index> all_indices_relevant;
-
   // ----------
   // TODO: is there a better way to do that?
   //       via GridTools::exchange_cell_data_to_ghosts
@@ -46,16 +55,22 @@ extract_relevant(const std::vector<std::vector<dealii::types::global_dof_index>>
     partitioning.get_relevant_dofs(),
     dof_handler.get_communicator());
 
-  for (const auto &indices : patch_indices)
-    for (const auto i : indices)
-      ++count_patch_dofs[i];
+  for (const auto i : patch_indices.get_all_indices())
+    ++count_patch_dofs[i];
 
   count_patch_dofs.compress(dealii::VectorOperation::add);
   count_patch_dofs.update_ghost_values();
 
+  // relevant dofs are visited in ascending order, so that the index set is built from sorted
+  // indices in one go
+  std::vector<dealii::types::global_dof_index> indices_relevant;
   for (const auto i : partitioning.get_relevant_dofs())
     if (count_patch_dofs[i] > 0.)
-      all_indices_relevant.insert(i);
+      indices_relevant.push_back(i);
+
+  dealii::IndexSet all_indices_relevant(dof_handler.n_dofs());
+  all_indices_relevant.add_indices(indices_relevant.begin(), indices_relevant.end());
+  all_indices_relevant.compress();
   // ----------
 
   // all_indices_relevant now contains locally relevant dofs that are patch dofs
@@ -67,11 +82,11 @@ extract_relevant(const std::vector<std::vector<dealii::types::global_dof_index>>
 
 template <typename Number>
 void
-reduce_constraints(const dealii::AffineConstraints<Number>         &constraints_full,
-                   const dealii::IndexSet                          &locally_active_dofs,
-                   const std::set<dealii::types::global_dof_index> &all_indices_relevant,
-                   dealii::AffineConstraints<Number>               &constraints_reduced,
-                   std::set<dealii::types::global_dof_index>       &all_indices_assemble)
+reduce_constraints(const dealii::AffineConstraints<Number> &constraints_full,
+                   const dealii::IndexSet                  &locally_active_dofs,
+                   const dealii::IndexSet                  &all_indices_relevant,
+                   dealii::AffineConstraints<Number>       &constraints_reduced,
+                   dealii::IndexSet                        &all_indices_assemble)
 {
   Assert(constraints_full.is_closed(),
          dealii::ExcMessage("constraints_full needs to have all chains of constraints "
@@ -79,8 +94,9 @@ reduce_constraints(const dealii::AffineConstraints<Number>         &constraints_
 
   // 1) reduce constraints
 
-  // store those locally active indices that are constrained
-  std::set<dealii::types::global_dof_index> all_indices_constrained;
+  // store those locally active indices that are constrained, in ascending order
+  std::vector<dealii::types::global_dof_index> all_indices_constrained;
+  std::vector<std::pair<dealii::types::global_dof_index, Number>> constraint_entries_reduced;
 
   // extract constraints of locally active dofs against any locally relevant patch index
   for (const auto i : locally_active_dofs)
@@ -88,16 +104,15 @@ reduce_constraints(const dealii::AffineConstraints<Number>         &constraints_
       {
         const auto constraint_entries = constraints_full.get_constraint_entries(i);
 
-        std::vector<std::pair<dealii::types::global_dof_index, Number>> constraint_entries_reduced;
-
+        constraint_entries_reduced.clear();
         if (constraint_entries != nullptr)
           for (const auto &entry : *constraint_entries)
-            if (all_indices_relevant.contains(entry.first))
+            if (all_indices_relevant.is_element(entry.first))
               constraint_entries_reduced.push_back(entry);
 
         if (constraint_entries_reduced.empty() == false)
           {
-            all_indices_constrained.insert(i);
+            all_indices_constrained.push_back(i);
 
             constraints_reduced.add_line(i);
             constraints_reduced.add_entries(i, constraint_entries_reduced);
@@ -109,27 +124,23 @@ reduce_constraints(const dealii::AffineConstraints<Number>         &constraints_
 
   // 2) to assemble sparse matrices partially only on patch indices, we will create the set of
   // indices necessary in all_indices_assemble.
-  all_indices_assemble.clear();
 
   // first, we need all patch indices on locally active cells
-  std::set_intersection(all_indices_relevant.begin(),
-                        all_indices_relevant.end(),
-                        locally_active_dofs.begin(),
-                        locally_active_dofs.end(),
-                        std::inserter(all_indices_assemble, all_indices_assemble.begin()));
+  all_indices_assemble = all_indices_relevant & locally_active_dofs;
 
   // second, we need those locally active indices that are constrained
-  all_indices_assemble.merge(all_indices_constrained);
+  all_indices_assemble.add_indices(all_indices_constrained.begin(), all_indices_constrained.end());
+  all_indices_assemble.compress();
 }
 
 
 
 template <int dim, int spacedim, typename Number = double>
 void
-make_sparsity_pattern(const dealii::DoFHandler<dim, spacedim>         &dof_handler,
-                      const std::set<dealii::types::global_dof_index> &all_indices_assemble,
-                      dealii::SparsityPatternBase                     &sparsity_pattern,
-                      const dealii::AffineConstraints<Number>         &constraints = {})
+make_sparsity_pattern(const dealii::DoFHandler<dim, spacedim> &dof_handler,
+                      const dealii::IndexSet                  &all_indices_assemble,
+                      dealii::SparsityPatternBase             &sparsity_pattern,
+                      const dealii::AffineConstraints<Number> &constraints = {})
 {
   std::vector<dealii::types::global_dof_index> local_dof_indices;
   std::vector<dealii::types::global_dof_index> local_dof_indices_reduced;
@@ -149,7 +160,7 @@ make_sparsity_pattern(const dealii::DoFHandler<dim, spacedim>         &dof_handl
 
       local_dof_indices_reduced.clear();
       for (const auto i : local_dof_indices)
-        if (all_indices_assemble.contains(i))
+        if (all_indices_assemble.is_element(i))
           local_dof_indices_reduced.push_back(i);
 
       constraints.add_entries_local_to_global(local_dof_indices_reduced,
@@ -162,11 +173,11 @@ make_sparsity_pattern(const dealii::DoFHandler<dim, spacedim>         &dof_handl
 
 template <int dim, int spacedim, typename Number, typename SparseMatrixType>
 void
-partially_assemble_poisson(const dealii::DoFHandler<dim, spacedim>         &dof_handler,
-                           const dealii::AffineConstraints<Number>         &constraints_reduced,
-                           const dealii::hp::QCollection<dim>              &quadrature_collection,
-                           const std::set<dealii::types::global_dof_index> &all_indices_assemble,
-                           SparseMatrixType                                &sparse_matrix)
+partially_assemble_poisson(const dealii::DoFHandler<dim, spacedim> &dof_handler,
+                           const dealii::AffineConstraints<Number> &constraints_reduced,
+                           const dealii::hp::QCollection<dim>      &quadrature_collection,
+                           const dealii::IndexSet                  &all_indices_assemble,
+                           SparseMatrixType                        &sparse_matrix)
 {
   //
   // build local matrices, distribute to sparse matrix
@@ -178,6 +189,8 @@ partially_assemble_poisson(const dealii::DoFHandler<dim, spacedim>         &dof_
 
   dealii::FullMatrix<double>                   cell_matrix;
   std::vector<dealii::types::global_dof_index> local_dof_indices;
+  std::vector<dealii::types::global_dof_index> local_dof_indices_reduced;
+  std::vector<unsigned int>                    dof_indices;
 
   // loop over locally owned cells
   for (const auto &cell :
@@ -188,11 +201,10 @@ partially_assemble_poisson(const dealii::DoFHandler<dim, spacedim>         &dof_
       local_dof_indices.resize(cell->get_fe().dofs_per_cell);
       cell->get_dof_indices(local_dof_indices);
 
-      std::vector<dealii::types::global_dof_index> local_dof_indices_reduced;
-      std::vector<unsigned int>                    dof_indices;
-
+      local_dof_indices_reduced.clear();
+      dof_indices.clear();
       for (unsigned int i = 0; i < local_dof_indices.size(); ++i)
-        if (all_indices_assemble.contains(local_dof_indices[i]))
+        if (all_indices_assemble.is_element(local_dof_indices[i]))
           {
             local_dof_indices_reduced.push_back(local_dof_indices[i]);
             dof_indices.push_back(i);
@@ -227,11 +239,11 @@ partially_assemble_poisson(const dealii::DoFHandler<dim, spacedim>         &dof_
 
 template <int dim, int spacedim, typename Number, typename SparseMatrixType>
 void
-partially_assemble_ablock(const dealii::DoFHandler<dim, spacedim>         &dof_handler,
-                          const dealii::AffineConstraints<Number>         &constraints_reduced,
-                          const dealii::hp::QCollection<dim>              &quadrature_collection,
-                          const std::set<dealii::types::global_dof_index> &all_indices_assemble,
-                          SparseMatrixType                                &sparse_matrix)
+partially_assemble_ablock(const dealii::DoFHandler<dim, spacedim> &dof_handler,
+                          const dealii::AffineConstraints<Number> &constraints_reduced,
+                          const dealii::hp::QCollection<dim>      &quadrature_collection,
+                          const dealii::IndexSet                  &all_indices_assemble,
+                          SparseMatrixType                        &sparse_matrix)
 {
   //
   // build local matrices, distribute to sparse matrix
@@ -247,6 +259,8 @@ partially_assemble_ablock(const dealii::DoFHandler<dim, spacedim>         &dof_h
   dealii::FullMatrix<double>                   cell_matrix;
   std::vector<dealii::Tensor<2, dim>>          grad_phi_u;
   std::vector<dealii::types::global_dof_index> local_dof_indices;
+  std::vector<dealii::types::global_dof_index> local_dof_indices_reduced;
+  std::vector<unsigned int>                    dof_indices;
 
   // loop over locally owned cells
   for (const auto &cell :
@@ -257,11 +271,10 @@ partially_assemble_ablock(const dealii::DoFHandler<dim, spacedim>         &dof_h
       local_dof_indices.resize(cell->get_fe().dofs_per_cell);
       cell->get_dof_indices(local_dof_indices);
 
-      std::vector<dealii::types::global_dof_index> local_dof_indices_reduced;
-      std::vector<unsigned int>                    dof_indices;
-
+      local_dof_indices_reduced.clear();
+      dof_indices.clear();
       for (unsigned int i = 0; i < local_dof_indices.size(); ++i)
-        if (all_indices_assemble.contains(local_dof_indices[i]))
+        if (all_indices_assemble.is_element(local_dof_indices[i]))
           {
             local_dof_indices_reduced.push_back(local_dof_indices[i]);
             dof_indices.push_back(i);
@@ -300,4 +313,120 @@ partially_assemble_ablock(const dealii::DoFHandler<dim, spacedim>         &dof_h
 }
 
 
+
+template <typename FECellIntegrator,
+          int dim,
+          typename Number,
+          typename SparseMatrixType,
+          typename LocalOperation>
+void
+partially_compute_matrix(const dealii::MatrixFree<dim, Number>   &matrix_free,
+                         const dealii::AffineConstraints<double> &constraints_reduced,
+                         const dealii::IndexSet                  &all_indices_assemble,
+                         SparseMatrixType                        &sparse_matrix,
+                         const LocalOperation                    &local_operation)
+{
+  //
+  // compute local matrices column by column with FEEvaluation, distribute to sparse matrix
+  //
+  // Only columns of patch indices are computed, and cells without any of them are skipped.
+  // Unlike MatrixFreeTools::compute_matrix, this never touches the full sparse matrix.
+  //
+  constexpr unsigned int n_lanes = dealii::VectorizedArray<Number>::size();
+
+  const auto &fe_collection = matrix_free.get_dof_handler().get_fe_collection();
+
+  std::vector<std::unique_ptr<FECellIntegrator>> integrators(fe_collection.size());
+
+  std::array<dealii::FullMatrix<double>, n_lanes>                   lane_matrices;
+  std::array<std::vector<dealii::types::global_dof_index>, n_lanes> lane_dof_indices_reduced;
+  std::array<std::vector<unsigned int>, n_lanes>                    lane_dof_positions;
+
+  dealii::FullMatrix<double>                   cell_matrix;
+  std::vector<dealii::types::global_dof_index> local_dof_indices;
+  std::vector<bool>                            column_needed;
+
+  for (unsigned int cell = 0; cell < matrix_free.n_cell_batches(); ++cell)
+    {
+      const unsigned int fe_index = matrix_free.get_cell_active_fe_index({cell, cell + 1});
+
+      if (integrators[fe_index] == nullptr)
+        integrators[fe_index] =
+          std::make_unique<FECellIntegrator>(matrix_free, std::make_pair(cell, cell + 1));
+
+      FECellIntegrator &integrator = *integrators[fe_index];
+      integrator.reinit(cell);
+
+      const unsigned int dofs_per_cell  = integrator.dofs_per_cell;
+      const unsigned int n_filled_lanes = matrix_free.n_active_entries_per_cell_batch(cell);
+
+      // FEEvaluation works on lexicographic numbering of the shape functions
+      const auto &lexicographic_numbering =
+        matrix_free.get_shape_info(0, 0, 0, fe_index, fe_index).lexicographic_numbering;
+
+      column_needed.assign(dofs_per_cell, false);
+      local_dof_indices.resize(dofs_per_cell);
+
+      bool any_needed = false;
+      for (unsigned int v = 0; v < n_filled_lanes; ++v)
+        {
+          matrix_free.get_cell_iterator(cell, v)->get_dof_indices(local_dof_indices);
+
+          lane_dof_indices_reduced[v].clear();
+          lane_dof_positions[v].clear();
+          for (unsigned int i = 0; i < dofs_per_cell; ++i)
+            {
+              const auto index = local_dof_indices[lexicographic_numbering[i]];
+              if (all_indices_assemble.is_element(index))
+                {
+                  lane_dof_indices_reduced[v].push_back(index);
+                  lane_dof_positions[v].push_back(i);
+                  column_needed[i] = true;
+                  any_needed       = true;
+                }
+            }
+        }
+
+      if (any_needed == false)
+        continue;
+
+      for (unsigned int v = 0; v < n_filled_lanes; ++v)
+        lane_matrices[v].reinit(dofs_per_cell, dofs_per_cell);
+
+      for (unsigned int j = 0; j < dofs_per_cell; ++j)
+        {
+          if (column_needed[j] == false)
+            continue;
+
+          for (unsigned int i = 0; i < dofs_per_cell; ++i)
+            integrator.begin_dof_values()[i] = (i == j) ? Number(1.) : Number(0.);
+
+          local_operation(integrator);
+
+          for (unsigned int v = 0; v < n_filled_lanes; ++v)
+            for (unsigned int i = 0; i < dofs_per_cell; ++i)
+              lane_matrices[v](i, j) = integrator.begin_dof_values()[i][v];
+        }
+
+      for (unsigned int v = 0; v < n_filled_lanes; ++v)
+        {
+          const auto &positions = lane_dof_positions[v];
+          if (positions.empty())
+            continue;
+
+          cell_matrix.reinit(positions.size(), positions.size());
+          for (unsigned int i = 0; i < positions.size(); ++i)
+            for (unsigned int j = 0; j < positions.size(); ++j)
+              cell_matrix(i, j) = lane_matrices[v](positions[i], positions[j]);
+
+          constraints_reduced.distribute_local_to_global(cell_matrix,
+                                                         lane_dof_indices_reduced[v],
+                                                         sparse_matrix);
+        }
+    }
+
+  sparse_matrix.compress(dealii::VectorOperation::values::add);
+}
+
+
 #endif
@@ -0,0 +1,56 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_smoother_dispatch_h
+#define multigrid_smoother_dispatch_h
+
+
+#include <multigrid/asm.h>
+#include <multigrid/diagonal_matrix_timer.h>
+#include <multigrid/extended_diagonal.h>
+
+#include <string>
+#include <type_traits>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Call @p f with std::type_identity of the preconditioner of the Chebyshev
+ * smoother named @p smoother_preconditioner_type, acting on vectors of type
+ * VectorType. See the "smoother preconditioner type" parameter of
+ * MGSolverParameters for the valid names.
+ */
+template <typename VectorType, typename Function>
+void
+dispatch_smoother_preconditioner(const std::string &smoother_preconditioner_type,
+                                 const Function    &f)
+{
+  if (smoother_preconditioner_type == "Extended Diagonal")
+    f(std::type_identity<PreconditionExtendedDiagonal<VectorType>>());
+  else if (smoother_preconditioner_type == "ASM")
+    f(std::type_identity<PreconditionASM<VectorType>>());
+  else if (smoother_preconditioner_type == "Diagonal")
+    f(std::type_identity<DiagonalMatrixTimer<VectorType>>());
+  else
+    AssertThrow(false,
+                ExcMessage("Unknown smoother preconditioner type: " +
+                           smoother_preconditioner_type));
+}
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
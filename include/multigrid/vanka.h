@@ -0,0 +1,119 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef multigrid_vanka_h
+#define multigrid_vanka_h
+
+
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/lac/la_parallel_vector.h>
+
+#include <multigrid/asm.h>
+#include <multigrid/monolithic_numbering.h>
+#include <multigrid/patch_indices.h>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Vanka smoother for saddle point systems on block vectors.
+ *
+ * Patches and the sparse matrix of the whole system both refer to the
+ * MonolithicNumbering of the block system, see prepare_vanka_patch_indices().
+ * Patch inverses are applied additively as in PreconditionASM, on vectors in
+ * the monolithic numbering into and out of which the locally owned entries of
+ * all blocks are copied.
+ */
+template <typename BlockVectorType>
+class PreconditionVanka
+{
+public:
+  using VectorType = LinearAlgebra::distributed::Vector<typename BlockVectorType::value_type>;
+
+  PreconditionVanka(PatchIndices &&patch_indices, const bool threaded_setup = false)
+    : patch_preconditioner(std::move(patch_indices), threaded_setup)
+  {}
+
+  /**
+   * Invert the patch blocks of @p global_sparse_matrix, which is given in
+   * @p numbering.
+   */
+  template <typename GlobalSparseMatrixType, typename GlobalSparsityPattern>
+  void
+  initialize(const GlobalSparseMatrixType &global_sparse_matrix,
+             const GlobalSparsityPattern  &global_sparsity_pattern,
+             const MonolithicNumbering    &numbering,
+             const MPI_Comm                communicator)
+  {
+    patch_preconditioner.initialize(global_sparse_matrix,
+                                    global_sparsity_pattern,
+                                    numbering.get_owned_dofs(),
+                                    numbering.get_relevant_dofs(),
+                                    communicator);
+
+    src_monolithic.reinit(numbering.get_owned_dofs(), numbering.get_relevant_dofs(), communicator);
+    dst_monolithic.reinit(src_monolithic);
+  }
+
+  void
+  vmult(BlockVectorType &dst, const BlockVectorType &src) const
+  {
+    // Locally owned indices of each block follow the ones of the previous
+    // blocks within the range of this process, see MonolithicNumbering.
+    for (unsigned int b = 0, offset = 0; b < src.n_blocks(); ++b)
+      {
+        const unsigned int n_owned = src.block(b).locally_owned_size();
+        for (unsigned int i = 0; i < n_owned; ++i)
+          src_monolithic.local_element(offset + i) = src.block(b).local_element(i);
+        offset += n_owned;
+      }
+
+    patch_preconditioner.vmult(dst_monolithic, src_monolithic);
+
+    for (unsigned int b = 0, offset = 0; b < dst.n_blocks(); ++b)
+      {
+        const unsigned int n_owned = dst.block(b).locally_owned_size();
+        for (unsigned int i = 0; i < n_owned; ++i)
+          dst.block(b).local_element(i) = dst_monolithic.local_element(offset + i);
+        offset += n_owned;
+      }
+  }
+
+  // patch matrices of symmetric systems are symmetric
+  void
+  Tvmult(BlockVectorType &dst, const BlockVectorType &src) const
+  {
+    vmult(dst, src);
+  }
+
+  std::size_t
+  memory_consumption() const
+  {
+    return patch_preconditioner.memory_consumption() + src_monolithic.memory_consumption() +
+           dst_monolithic.memory_consumption();
+  }
+
+private:
+  PreconditionASM<VectorType> patch_preconditioner;
+
+  mutable VectorType src_monolithic;
+  mutable VectorType dst_monolithic;
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
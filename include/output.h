@@ -0,0 +1,53 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef output_h
+#define output_h
+
+
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/numerics/data_out.h>
+
+#include <async_writer.h>
+#include <parameter.h>
+
+#include <string>
+
+
+namespace Output
+{
+  /**
+   * Whether @p field has been chosen with the parameter 'output fields'.
+   */
+  bool
+  has_field(const Parameter &prm, const std::string &field);
+
+  /**
+   * Write @p data_out as vtu files with pvtu record for @p cycle, compressed
+   * and grouped into files as specified in @p prm. If @p async_writer is
+   * given, every process writes its own vtu file in the background instead.
+   */
+  template <int dim, int spacedim>
+  void
+  write_vtu_with_pvtu_record(dealii::DataOut<dim, spacedim> &data_out,
+                             const Parameter                &prm,
+                             const unsigned int              cycle,
+                             const MPI_Comm                  mpi_communicator,
+                             AsyncWriter                    *async_writer);
+} // namespace Output
+
+
+#endif
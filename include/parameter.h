@@ -21,6 +21,10 @@
 
 #include <adaptation/parameter.h>
 #include <multigrid/parameter.h>
+#include <stokes_matrixfree/parameter.h>
+
+#include <string>
+#include <vector>
 
 
 struct Parameter : public dealii::ParameterAcceptor
@@ -57,6 +61,27 @@ struct Parameter : public dealii::ParameterAcceptor
     solver_tolerance_factor = 1e-12;
     add_parameter("solver tolerance factor", solver_tolerance_factor);
 
+    initial_guess_from_previous_cycle = false;
+    add_parameter("initial guess from previous cycle", initial_guess_from_previous_cycle);
+
+    threaded_assembly = false;
+    add_parameter("threaded assembly", threaded_assembly);
+
+    shared_memory_ghosts = false;
+    add_parameter("shared memory ghosts", shared_memory_ghosts);
+
+    matrix_free_error_computation = false;
+    add_parameter("matrix-free error computation", matrix_free_error_computation);
+
+    velocity_data_locality = false;
+    add_parameter("velocity data locality", velocity_data_locality);
+
+    nested_iteration_dofs = 0;
+    add_parameter("nested iteration dofs", nested_iteration_dofs);
+
+    nested_iteration_n_iterations = 2;
+    add_parameter("nested iteration n iterations", nested_iteration_n_iterations);
+
 
     *subsection = "input output";
 
@@ -66,17 +91,56 @@ struct Parameter : public dealii::ParameterAcceptor
     output_frequency = 1;
     add_parameter("output each n steps", output_frequency);
 
+    output_asynchronously = false;
+    add_parameter("output asynchronously", output_asynchronously);
+
+    output_queue_size = 2;
+    add_parameter("output queue size", output_queue_size);
+
+    output_fields = {"solution", "fe_degree", "subdomain", "error", "hp_indicator"};
+    add_parameter("output fields", output_fields);
+
+    output_subdivisions = 0;
+    add_parameter("output subdivisions", output_subdivisions);
+
+    output_compression = "best speed";
+    add_parameter("output compression", output_compression);
+
+    output_file_groups = 1;
+    add_parameter("output file groups", output_file_groups);
+
     resume_filename = "";
     add_parameter("resume from filename", resume_filename);
 
     checkpoint_frequency = 0;
     add_parameter("checkpoint each n steps", checkpoint_frequency);
 
+    checkpoint_solution = false;
+    add_parameter("checkpoint solution", checkpoint_solution);
+
     log_deallog = false;
     add_parameter("log deallog", log_deallog);
 
     log_nonzero_elements = false;
     add_parameter("log nonzero elements", log_nonzero_elements);
+
+    log_format = "text";
+    add_parameter("log format", log_format);
+
+    instrumentation = "off";
+    add_parameter("instrumentation", instrumentation);
+
+
+    *subsection = "benchmark";
+
+    n_repetitions = 10;
+    add_parameter("n repetitions", n_repetitions);
+
+    benchmark_operator_types = {"MatrixFree", "MatrixBased"};
+    add_parameter("operator types", benchmark_operator_types);
+
+    random_degrees = true;
+    add_parameter("random degrees", random_degrees);
   }
 
   unsigned int dimension;
@@ -86,18 +150,69 @@ struct Parameter : public dealii::ParameterAcceptor
   std::string adaptation_type;
   std::string grid_type;
   std::string operator_type;
+  // AMG or GMG, GMG pipelined for Poisson and GMG monolithic for Stokes
   std::string solver_type;
   double      solver_tolerance_factor;
+  bool        initial_guess_from_previous_cycle;
+
+  // share the cores of each node among its MPI ranks to assemble matrices
+  bool threaded_assembly;
+
+  // exchange ghost values of matrix-free operators among the processes of
+  // each node via MPI-3 shared memory
+  bool shared_memory_ghosts;
+
+  // compute L2 and H1 errors in a single pass with FEEvaluation
+  bool matrix_free_error_computation;
+
+  // renumber velocity DoFs of the matrix-free Stokes problem in the order in
+  // which cell loops access them
+  bool velocity_data_locality;
+
+  // solve inexactly with a fixed number of iterations on meshes with fewer
+  // DoFs, such cycles do not count towards the number of cycles, zero disables
+  unsigned int nested_iteration_dofs;
+  unsigned int nested_iteration_n_iterations;
 
   std::string  file_stem;
   unsigned int output_frequency;
+  bool         output_asynchronously;
+  unsigned int output_queue_size;
+
+  // subset of solution, fe_degree, subdomain, error and hp_indicator
+  std::vector<std::string> output_fields;
+  // subdivisions of each cell in the output, zero uses the default of DataOut
+  unsigned int output_subdivisions;
+  // none, best speed, best compression or default
+  std::string output_compression;
+  // number of vtu files written collectively, zero writes one per process
+  unsigned int output_file_groups;
+
   std::string  resume_filename;
   unsigned int checkpoint_frequency;
-  bool         log_deallog;
-  bool         log_nonzero_elements;
+  // additionally checkpoint converged solutions and measured cell costs, from
+  // which a resumed run continues with error estimation
+  bool checkpoint_solution;
+  bool log_deallog;
+  bool log_nonzero_elements;
+
+  // text rewrites the table every cycle, jsonl appends one line per cycle
+  std::string log_format;
+
+  // wall times of operator applications: off, summary or detailed
+  std::string instrumentation;
+
+  // repeat each operation this many times in the benchmark
+  unsigned int             n_repetitions;
+  std::vector<std::string> benchmark_operator_types;
+  // pick degrees between min and max degree at random, or use the max degree
+  bool random_degrees;
 
   Adaptation::Parameter prm_adaptation;
   MGSolverParameters    prm_multigrid;
+
+  StokesMatrixFree::BlockSchurParameters prm_block_schur;
+  StokesMatrixFree::MonolithicParameters prm_monolithic;
 };
 
 
@@ -0,0 +1,83 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef poisson_benchmark_h
+#define poisson_benchmark_h
+
+
+#include <deal.II/distributed/tria.h>
+
+#include <deal.II/hp/fe_collection.h>
+#include <deal.II/hp/mapping_collection.h>
+#include <deal.II/hp/q_collection.h>
+
+#include <multigrid/mg_hierarchy.h>
+#include <multigrid/operator_base.h>
+#include <parameter.h>
+#include <partitioning.h>
+#include <problem_base.h>
+
+
+namespace Poisson
+{
+  /**
+   * Micro-benchmark of the Poisson operators without adaptation.
+   *
+   * The grid is refined globally to the min level, and each cell is assigned
+   * a polynomial degree between min and max degree. For each of the operator
+   * types in Parameter::benchmark_operator_types, the operator application is
+   * repeated Parameter::n_repetitions times. With the GMG solver, the same
+   * number of CG iterations with a multigrid V-cycle as preconditioner is
+   * performed. Per-level timings of smoothers and transfers are written with
+   * the "log levels" option of the multigrid parameters.
+   */
+  template <int dim, typename LinearAlgebra, int spacedim = dim>
+  class Benchmark : public ProblemBase
+  {
+  public:
+    Benchmark(const Parameter &prm);
+
+    void
+    run() override;
+
+  private:
+    void
+    initialize_grid();
+    void
+    setup_system();
+
+    void
+    benchmark_operator(const std::string &operator_type);
+
+    MPI_Comm mpi_communicator;
+
+    const Parameter &prm;
+    std::string      filename_stem;
+
+    dealii::parallel::distributed::Triangulation<dim> triangulation;
+    dealii::DoFHandler<dim, spacedim>                 dof_handler;
+
+    dealii::hp::MappingCollection<dim, spacedim> mapping_collection;
+    dealii::hp::FECollection<dim, spacedim>      fe_collection;
+    dealii::hp::QCollection<dim>                 quadrature_collection;
+
+    Partitioning partitioning;
+
+    dealii::AffineConstraints<double> constraints;
+  };
+} // namespace Poisson
+
+
+#endif
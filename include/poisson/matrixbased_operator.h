@@ -21,8 +21,12 @@
 
 #include <deal.II/hp/fe_values.h>
 
+#include <deal.II/lac/full_matrix.h>
+
 #include <multigrid/operator_base.h>
 
+#include <array>
+
 
 namespace PoissonMatrixBased
 {
@@ -71,6 +75,9 @@ namespace PoissonMatrixBased
     const typename LinearAlgebra::SparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
@@ -86,8 +93,24 @@ namespace PoissonMatrixBased
 
     dealii::hp::FEValues<dim, spacedim> fe_values_collection;
 
+    // assemble the system matrix, and the right hand side if given
+    void
+    assemble_system(const dealii::DoFHandler<dim, spacedim>     &dof_handler,
+                    const dealii::AffineConstraints<value_type> &constraints,
+                    VectorType                                  *system_rhs);
+
+    void
+    setup_reference_matrices(const dealii::DoFHandler<dim, spacedim> &dof_handler);
+
+    // Laplace matrices on the unit cell per FE index, with derivatives in one
+    // direction each, for cells with orthogonal edges
+    std::vector<std::array<dealii::FullMatrix<double>, dim>> reference_matrices;
+
     typename LinearAlgebra::SparseMatrix system_matrix;
 
+    // identifies DoFs and constraints the sparsity pattern was built for
+    std::size_t sparsity_hash = 0;
+
     std::shared_ptr<const dealii::Utilities::MPI::Partitioner> dealii_partitioner;
   };
 } // namespace PoissonMatrixBased
@@ -55,6 +55,13 @@ namespace PoissonMatrixFree
     void
     vmult(VectorType &dst, const VectorType &src) const override;
 
+    void
+    vmult(VectorType                                                        &dst,
+          const VectorType                                                  &src,
+          const std::function<void(const unsigned int, const unsigned int)> &operation_before_loop,
+          const std::function<void(const unsigned int, const unsigned int)> &operation_after_loop)
+      const override;
+
     void
     initialize_dof_vector(VectorType &vec) const override;
 
@@ -67,9 +74,25 @@ namespace PoissonMatrixFree
     const typename LinearAlgebra::SparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
+    std::vector<double>
+    measure_cost_per_cell(const unsigned int n_repetitions) const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
+    /**
+     * Also set up mapping data on inner faces in reinit(), so that the
+     * MatrixFree object can be shared with Adaptation::KellyMatrixFree.
+     */
+    void
+    enable_inner_faces();
+
+    const dealii::MatrixFree<dim, value_type> &
+    get_matrix_free() const;
+
   private:
     // const Parameters &prm;
 
@@ -84,10 +107,9 @@ namespace PoissonMatrixFree
     void
     do_cell_integral_local(FECellIntegrator &integrator) const;
 
+    template <typename Integrator>
     void
-    do_cell_integral_global(FECellIntegrator &integrator,
-                            VectorType       &dst,
-                            const VectorType &src) const;
+    do_cell_integral_global(Integrator &integrator, VectorType &dst, const VectorType &src) const;
 
     void
     do_cell_integral_range(const dealii::MatrixFree<dim, value_type>   &matrix_free,
@@ -99,6 +121,8 @@ namespace PoissonMatrixFree
     Partitioning                        partitioning;
     dealii::MatrixFree<dim, value_type> matrix_free;
 
+    bool inner_faces = false;
+
     mutable typename LinearAlgebra::SparseMatrix system_matrix;
   };
 } // namespace PoissonMatrixFree
@@ -18,9 +18,15 @@
 
 
 #include <deal.II/distributed/cell_weights.h>
+#include <deal.II/distributed/solution_transfer.h>
 #include <deal.II/distributed/tria.h>
 
+#include <deal.II/lac/solver_control.h>
+
 #include <adaptation/base.h>
+#include <async_writer.h>
+#include <multigrid/amg_cache.h>
+#include <multigrid/mg_hierarchy.h>
 #include <multigrid/operator_base.h>
 #include <parameter.h>
 #include <problem_base.h>
@@ -45,6 +51,22 @@ namespace Poisson
     void
     initialize_system();
 
+    void
+    measure_cell_weights();
+    void
+    set_cell_weights(const std::vector<double> &costs);
+
+    // multigrid solve with the given smoother, see solve_gmg_with_smoother()
+    void
+    solve_with_gmg(dealii::SolverControl            &solver_control,
+                   typename LinearAlgebra::Vector   &dst,
+                   const std::string                &smoother_preconditioner_type,
+                   const unsigned int                smoother_degree,
+                   std::unique_ptr<MGHierarchyBase> &hierarchy);
+    // fastest combination of the candidates in MGSolverParameters on the
+    // current mesh, whose hierarchy is kept for the following solve
+    void
+    calibrate_smoother();
     void
     solve();
 
@@ -57,6 +79,8 @@ namespace Poisson
     resume_from_checkpoint();
     void
     write_to_checkpoint();
+    void
+    write_solution_to_checkpoint();
 
     MPI_Comm mpi_communicator;
 
@@ -73,6 +97,8 @@ namespace Poisson
 
     std::unique_ptr<Adaptation::Base>            adaptation_strategy;
     dealii::parallel::CellWeights<dim, spacedim> cell_weights;
+    bool                                         cell_weights_measured = false;
+    std::vector<double>                          cell_costs;
 
     std::unique_ptr<dealii::Function<dim>> boundary_function;
     std::unique_ptr<dealii::Function<dim>> solution_function;
@@ -84,10 +110,34 @@ namespace Poisson
 
     std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>> poisson_operator;
 
+    std::unique_ptr<MGHierarchyBase> mg_hierarchy;
+
+    // smoother picked by calibration, a degree of zero keeps the given ones
+    bool         smoother_calibrated = false;
+    std::string  auto_smoother_preconditioner_type;
+    unsigned int auto_smoother_degree = 0;
+
+    AMGCache<typename LinearAlgebra::PreconditionAMG> amg;
+
     typename LinearAlgebra::Vector locally_relevant_solution;
     typename LinearAlgebra::Vector system_rhs;
 
+    // carries the solution of the previous cycle over to the refined mesh
+    using SolutionTransferType = dealii::parallel::distributed::
+      SolutionTransfer<dim, typename LinearAlgebra::Vector, spacedim>;
+    std::unique_ptr<SolutionTransferType> solution_transfer;
+
+    // converged solution on the mesh of a resumed checkpoint, which spares
+    // operator setup and solve of that cycle
+    std::unique_ptr<typename LinearAlgebra::Vector> resumed_solution;
+
     unsigned int cycle;
+
+    // cycles with inexact solves on coarse meshes, see Parameter::nested_iteration_dofs
+    bool         nested_iteration_step     = false;
+    unsigned int n_nested_iteration_steps = 0;
+
+    std::unique_ptr<AsyncWriter> async_writer;
   };
 } // namespace Poisson
 
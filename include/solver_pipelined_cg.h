@@ -0,0 +1,136 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef solver_pipelined_cg_h
+#define solver_pipelined_cg_h
+
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/lac/solver.h>
+#include <deal.II/lac/solver_control.h>
+
+#include <array>
+#include <cmath>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+/**
+ * Preconditioned pipelined conjugate gradient method after Ghysels and
+ * Vanroose (2014) for distributed vectors.
+ *
+ * Each iteration needs a single global reduction for (r,u), (w,u) and (r,r),
+ * which is started with MPI_Iallreduce and overlapped with the application
+ * of preconditioner and matrix for the next iteration. In exact arithmetic,
+ * the iterates match those of SolverCG, at the cost of nine work vectors of
+ * the size of the solution, compared to three in SolverCG. All vector
+ * updates of one iteration happen in a single pass.
+ */
+template <typename VectorType>
+class SolverPipelinedCG : public SolverBase<VectorType>
+{
+public:
+  using Number = typename VectorType::value_type;
+
+  explicit SolverPipelinedCG(SolverControl &solver_control)
+    : SolverBase<VectorType>(solver_control)
+  {}
+
+  template <typename MatrixType, typename PreconditionerType>
+  void
+  solve(const MatrixType         &A,
+        VectorType               &x,
+        const VectorType         &b,
+        const PreconditionerType &preconditioner)
+  {
+    const MPI_Comm communicator = x.get_mpi_communicator();
+
+    VectorType r, u, w, m, n, p, s, q, z;
+    for (auto *v : {&r, &u, &w, &m, &n, &p, &s, &q, &z})
+      v->reinit(x);
+
+    A.vmult(r, x);
+    r.sadd(-1., 1., b);
+    preconditioner.vmult(u, r);
+    A.vmult(w, u);
+
+    const unsigned int n_local = x.locally_owned_size();
+
+    double gamma_old = 0., alpha_old = 0., residual_norm = 0.;
+
+    SolverControl::State state = SolverControl::iterate;
+    unsigned int         it    = 0;
+    for (;; ++it)
+      {
+        // local contributions to (r,u), (w,u) and (r,r)
+        std::array<double, 3> sums = {{0., 0., 0.}};
+        for (unsigned int i = 0; i < n_local; ++i)
+          {
+            sums[0] += r.local_element(i) * u.local_element(i);
+            sums[1] += w.local_element(i) * u.local_element(i);
+            sums[2] += r.local_element(i) * r.local_element(i);
+          }
+
+        MPI_Request request;
+        int         ierr = MPI_Iallreduce(
+          MPI_IN_PLACE, sums.data(), sums.size(), MPI_DOUBLE, MPI_SUM, communicator, &request);
+        AssertThrowMPI(ierr);
+
+        // hide the reduction behind the most expensive part of the iteration
+        preconditioner.vmult(m, w);
+        A.vmult(n, m);
+
+        ierr = MPI_Wait(&request, MPI_STATUS_IGNORE);
+        AssertThrowMPI(ierr);
+
+        residual_norm = std::sqrt(sums[2]);
+        state         = this->iteration_status(it, residual_norm, x);
+        if (state != SolverControl::iterate)
+          break;
+
+        const double gamma = sums[0];
+        const double delta = sums[1];
+
+        const double beta  = (it == 0) ? 0. : gamma / gamma_old;
+        const double alpha = (it == 0) ? gamma / delta : gamma / (delta - beta * gamma / alpha_old);
+
+        const Number a = alpha, c = beta;
+        for (unsigned int i = 0; i < n_local; ++i)
+          {
+            z.local_element(i) = n.local_element(i) + c * z.local_element(i);
+            q.local_element(i) = m.local_element(i) + c * q.local_element(i);
+            s.local_element(i) = w.local_element(i) + c * s.local_element(i);
+            p.local_element(i) = u.local_element(i) + c * p.local_element(i);
+
+            x.local_element(i) += a * p.local_element(i);
+            r.local_element(i) -= a * s.local_element(i);
+            u.local_element(i) -= a * q.local_element(i);
+            w.local_element(i) -= a * z.local_element(i);
+          }
+
+        gamma_old = gamma;
+        alpha_old = alpha;
+      }
+
+    AssertThrow(state == SolverControl::success, SolverControl::NoConvergence(it, residual_norm));
+  }
+};
+
+DEAL_II_NAMESPACE_CLOSE
+
+
+#endif
@@ -71,6 +71,9 @@ namespace StokesMatrixBased
     const typename LinearAlgebra::SparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
@@ -88,6 +91,9 @@ namespace StokesMatrixBased
 
     typename LinearAlgebra::BlockSparseMatrix a_block_matrix;
 
+    // identifies DoFs and constraints the sparsity pattern was built for
+    std::size_t sparsity_hash = 0;
+
     MPI_Comm     communicator;
     Partitioning partitioning;
 
@@ -141,6 +147,9 @@ namespace StokesMatrixBased
     const typename LinearAlgebra::SparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
@@ -158,6 +167,9 @@ namespace StokesMatrixBased
 
     typename LinearAlgebra::BlockSparseMatrix schur_block_matrix;
 
+    // identifies DoFs and constraints the sparsity pattern was built for
+    std::size_t sparsity_hash = 0;
+
     MPI_Comm     communicator;
     Partitioning partitioning;
 
@@ -211,6 +223,9 @@ namespace StokesMatrixBased
     const typename LinearAlgebra::BlockSparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
@@ -228,6 +243,9 @@ namespace StokesMatrixBased
 
     typename LinearAlgebra::BlockSparseMatrix system_matrix;
 
+    // identifies DoFs and constraints the sparsity pattern was built for
+    std::size_t sparsity_hash = 0;
+
     MPI_Comm     communicator;
     Partitioning partitioning;
 
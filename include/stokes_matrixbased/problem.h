@@ -25,6 +25,7 @@
 #include <deal.II/hp/fe_values.h>
 
 #include <adaptation/base.h>
+#include <async_writer.h>
 #include <parameter.h>
 #include <problem_base.h>
 #include <stokes_matrixbased/operators.h>
@@ -104,6 +105,8 @@ namespace StokesMatrixBased
     typename LinearAlgebra::BlockVector system_rhs;
 
     unsigned int cycle;
+
+    std::unique_ptr<AsyncWriter> async_writer;
   };
 } // namespace StokesMatrixBased
 
@@ -0,0 +1,440 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef stokes_matrixfree_mg_hierarchy_h
+#define stokes_matrixfree_mg_hierarchy_h
+
+
+#include <deal.II/base/mg_level_object.h>
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/dofs/dof_handler.h>
+
+#include <deal.II/lac/affine_constraints.h>
+
+#include <deal.II/multigrid/mg_transfer_global_coarsening.h>
+
+#include <global.h>
+#include <log.h>
+#include <multigrid/mg_hierarchy.h>
+#include <multigrid/monolithic_numbering.h>
+#include <multigrid/parameter.h>
+#include <multigrid/vanka.h>
+#include <partitioning.h>
+#include <stokes_matrixfree/operators.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+namespace StokesMatrixFree
+{
+  /**
+   * Hierarchy of the monolithic Stokes multigrid, see solve_gmg_monolithic(),
+   * that persists across adaptation cycles.
+   *
+   * Coarser meshes carry the lowest Taylor-Hood pair of the FECollections,
+   * finer levels lower the polynomial degrees on the fine mesh down to it.
+   * Velocity and pressure share their active FE indices on each level.
+   *
+   * Levels are reused just like in MGHierarchy: each level that matches a
+   * level of the previous hierarchy on all processes is taken over together
+   * with its DoFHandlers, constraints, operator and Vanka smoother. Transfer
+   * operators are rebuilt every time.
+   */
+  template <int dim, typename LinearAlgebra, int spacedim = dim>
+  class MGHierarchyMonolithic : public MGHierarchyBase
+  {
+  public:
+    using BlockVectorType = typename LinearAlgebra::BlockVector;
+    using VectorType      = typename LinearAlgebra::Vector;
+
+    using LevelOperatorType          = StokesOperator<dim, LinearAlgebra, spacedim>;
+    using SmootherPreconditionerType = dealii::PreconditionVanka<BlockVectorType>;
+    using MGTransferType             = dealii::MGTransferBlockGlobalCoarsening<dim, VectorType>;
+
+    /**
+     * All data belonging to one multigrid level.
+     */
+    struct Level
+    {
+      Level(const std::shared_ptr<const dealii::Triangulation<dim, spacedim>> &triangulation)
+        : triangulation(triangulation)
+        , dof_handler_v(*triangulation)
+        , dof_handler_p(*triangulation)
+      {}
+
+      std::size_t hash = 0;
+
+      std::shared_ptr<const dealii::Triangulation<dim, spacedim>> triangulation;
+      dealii::DoFHandler<dim, spacedim>                           dof_handler_v;
+      dealii::DoFHandler<dim, spacedim>                           dof_handler_p;
+
+      Partitioning partitioning_v;
+      Partitioning partitioning_p;
+
+      dealii::AffineConstraints<double> constraints_v;
+      dealii::AffineConstraints<double> constraints_p;
+
+      // of the saddle point matrix and the Vanka patches
+      dealii::MonolithicNumbering numbering;
+
+      // the level operator refers to these
+      std::vector<const dealii::DoFHandler<dim, spacedim> *> dof_handlers;
+      std::vector<const Partitioning *>                      partitionings;
+      std::vector<const dealii::AffineConstraints<double> *> constraints;
+
+      std::shared_ptr<LevelOperatorType>          level_operator;
+      std::shared_ptr<SmootherPreconditionerType> smoother_preconditioner;
+    };
+
+    /**
+     * Set up the hierarchy for the fine DoFHandlers @p dof_handler_v and
+     * @p dof_handler_p.
+     *
+     * The function @p setup_level is called on each level that could not be
+     * reused, once DoFs have been distributed and the partitionings are
+     * known. It has to fill constraints, the level operator and the smoother
+     * preconditioner.
+     */
+    void
+    reinit(const dealii::DoFHandler<dim, spacedim> &dof_handler_v,
+           const dealii::DoFHandler<dim, spacedim> &dof_handler_p,
+           const MGSolverParameters                &mg_data,
+           const std::function<void(Level &)>      &setup_level);
+
+    unsigned int
+    min_level() const
+    {
+      return 0;
+    }
+
+    unsigned int
+    max_level() const
+    {
+      return levels.size() - 1;
+    }
+
+    /**
+     * First level on the fine mesh. Coarser levels differ by h-coarsening,
+     * finer ones by p-coarsening.
+     */
+    unsigned int
+    min_level_p() const
+    {
+      return n_h_levels;
+    }
+
+    const Level &
+    get_level(const unsigned int level) const
+    {
+      return *levels[level];
+    }
+
+    const dealii::MGLevelObject<std::shared_ptr<LevelOperatorType>> &
+    get_operators() const
+    {
+      return operators;
+    }
+
+    const MGTransferType &
+    get_transfer() const
+    {
+      return *mg_transfer;
+    }
+
+    unsigned int
+    n_reused_levels() const
+    {
+      return n_reused;
+    }
+
+    /**
+     * Add the memory consumption of all level operators, smoother
+     * preconditioners and transfers to the table.
+     */
+    void
+    log_memory_consumption() const
+    {
+      std::size_t memory_operators = 0, memory_smoothers = 0, memory_transfers = 0;
+      for (unsigned int l = min_level(); l <= max_level(); ++l)
+        {
+          memory_operators += levels[l]->level_operator->memory_consumption();
+          memory_smoothers += levels[l]->smoother_preconditioner->memory_consumption() +
+                              levels[l]->numbering.memory_consumption();
+        }
+
+      // transfers connect each level to the next coarser one
+      for (unsigned int l = min_level() + 1; l <= max_level(); ++l)
+        memory_transfers +=
+          transfers_v[l].memory_consumption() + transfers_p[l].memory_consumption();
+
+      const MPI_Comm communicator = levels.back()->dof_handler_v.get_communicator();
+      Log::log_memory_consumption("mg_operators", memory_operators, communicator);
+      Log::log_memory_consumption("mg_smoothers", memory_smoothers, communicator);
+      Log::log_memory_consumption("mg_transfers", memory_transfers, communicator);
+    }
+
+  private:
+    std::vector<std::shared_ptr<Level>> levels;
+    unsigned int                        n_h_levels = 0;
+    unsigned int                        n_reused   = 0;
+
+    dealii::MGLevelObject<std::shared_ptr<LevelOperatorType>>          operators;
+    dealii::MGLevelObject<dealii::MGTwoLevelTransfer<dim, VectorType>> transfers_v;
+    dealii::MGLevelObject<dealii::MGTwoLevelTransfer<dim, VectorType>> transfers_p;
+
+    std::unique_ptr<dealii::MGTransferGlobalCoarsening<dim, VectorType>> transfer_v;
+    std::unique_ptr<dealii::MGTransferGlobalCoarsening<dim, VectorType>> transfer_p;
+    std::unique_ptr<MGTransferType>                                      mg_transfer;
+  };
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  MGHierarchyMonolithic<dim, LinearAlgebra, spacedim>::reinit(
+    const dealii::DoFHandler<dim, spacedim> &dof_handler_v,
+    const dealii::DoFHandler<dim, spacedim> &dof_handler_p,
+    const MGSolverParameters                &mg_data,
+    const std::function<void(Level &)>      &setup_level)
+  {
+    using namespace dealii;
+
+    TimerOutput::Scope t(getTimer(), "setup_mg_hierarchy");
+
+    const MPI_Comm communicator = dof_handler_v.get_communicator();
+
+    const auto &fe_collection_v = dof_handler_v.get_fe_collection();
+    const auto &fe_collection_p = dof_handler_p.get_fe_collection();
+
+    // Only Taylor-Hood pairs are stable. The lowest one is the element of all
+    // coarser meshes, below which p-coarsening stops.
+    std::map<unsigned int, unsigned int> fe_index_for_degree;
+    for (unsigned int i = 0; i < fe_collection_v.size(); ++i)
+      if (fe_collection_v[i].degree >= 2 &&
+          fe_collection_p[i].degree + 1 == fe_collection_v[i].degree)
+        {
+          const unsigned int degree = fe_collection_v[i].degree;
+          Assert(fe_index_for_degree.find(degree) == fe_index_for_degree.end(),
+                 ExcMessage("FECollection does not contain unique degrees."));
+          fe_index_for_degree[degree] = i;
+        }
+
+    AssertThrow(fe_index_for_degree.empty() == false,
+                ExcMessage("FECollections do not contain a Taylor-Hood pair."));
+
+    const unsigned int min_degree   = fe_index_for_degree.begin()->first;
+    const unsigned int min_fe_index = fe_index_for_degree.begin()->second;
+
+    std::vector<std::shared_ptr<const Triangulation<dim, spacedim>>> coarse_grid_triangulations;
+    if (mg_data.transfer.perform_h_transfer)
+      coarse_grid_triangulations =
+        MGTransferGlobalCoarseningTools::create_geometric_coarsening_sequence(
+          dof_handler_v.get_triangulation());
+
+    n_h_levels = coarse_grid_triangulations.empty() ? 0 : coarse_grid_triangulations.size() - 1;
+
+    const auto set_fe_indices = [](Level &level, const auto &get_fe_index) {
+      auto cell_p = level.dof_handler_p.begin_active();
+      for (const auto &cell_v : level.dof_handler_v.active_cell_iterators())
+        {
+          if (cell_v->is_locally_owned())
+            {
+              const unsigned int fe_index = get_fe_index(cell_v);
+              cell_v->set_active_fe_index(fe_index);
+              cell_p->set_active_fe_index(fe_index);
+            }
+          ++cell_p;
+        }
+    };
+
+    std::vector<std::shared_ptr<Level>> new_levels;
+
+    // Create levels with coarser meshes...
+    for (unsigned int l = 0; l < n_h_levels; ++l)
+      {
+        new_levels.emplace_back(std::make_shared<Level>(coarse_grid_triangulations[l]));
+        set_fe_indices(*new_levels.back(), [&](const auto &) { return min_fe_index; });
+      }
+
+    // ... and with lower polynomial degrees, from the finest level down to
+    // the lowest Taylor-Hood pair
+    const std::shared_ptr<const Triangulation<dim, spacedim>> fine_triangulation(
+      &(dof_handler_v.get_triangulation()), [](auto *) {
+        // empty deleter, since the fine triangulation is an external field
+        // and its destructor is called somewhere else
+      });
+
+    std::vector<std::shared_ptr<Level>> p_levels;
+    while (true)
+      {
+        auto level = std::make_shared<Level>(fine_triangulation);
+
+        const DoFHandler<dim, spacedim> &dof_handler_finer =
+          p_levels.empty() ? dof_handler_v : p_levels.back()->dof_handler_v;
+
+        unsigned int max_degree = 0;
+
+        // both DoFHandlers live on the fine mesh and visit its cells in the same order
+        auto cell_finer = dof_handler_finer.begin_active();
+        set_fe_indices(*level, [&](const auto &cell) {
+          while (cell_finer->id() != cell->id())
+            ++cell_finer;
+
+          unsigned int fe_index = cell_finer->active_fe_index();
+          if (p_levels.empty() == false)
+            {
+              const unsigned int next_degree = std::max(
+                min_degree,
+                MGTransferGlobalCoarseningTools::create_next_polynomial_coarsening_degree(
+                  fe_collection_v[fe_index].degree, mg_data.transfer.p_sequence));
+
+              const auto it = fe_index_for_degree.find(next_degree);
+              AssertThrow(it != fe_index_for_degree.end(),
+                          ExcMessage("Next polynomial degree in sequence "
+                                     "is not a Taylor-Hood pair in FECollection."));
+              fe_index = it->second;
+            }
+
+          max_degree = std::max(max_degree, fe_collection_v[fe_index].degree);
+          return fe_index;
+        });
+
+        p_levels.emplace_back(std::move(level));
+
+        if (Utilities::MPI::max(max_degree, communicator) <= min_degree)
+          break;
+      }
+
+    new_levels.insert(new_levels.end(), p_levels.rbegin(), p_levels.rend());
+
+    // Keep the previous levels alive until the new hierarchy is complete,
+    // and sort them by their hash.
+    std::vector<std::shared_ptr<Level>>            previous_levels = std::move(levels);
+    std::map<std::size_t, std::shared_ptr<Level>> previous_levels_by_hash;
+    if (mg_data.reuse_hierarchy)
+      for (const auto &level : previous_levels)
+        previous_levels_by_hash.emplace(level->hash, level);
+
+    levels.clear();
+    levels.resize(new_levels.size());
+    n_reused = 0;
+
+    std::vector<bool> reused(new_levels.size(), false);
+
+    // Take over a level from the previous hierarchy if it matches on all
+    // processes. Pressure shares the FE indices of the velocity.
+    for (unsigned int l = 0; l < new_levels.size(); ++l)
+      {
+        new_levels[l]->hash = compute_hash(new_levels[l]->dof_handler_v);
+
+        const auto         it          = previous_levels_by_hash.find(new_levels[l]->hash);
+        const unsigned int local_match = (it != previous_levels_by_hash.end()) ? 1 : 0;
+
+        if (Utilities::MPI::min(local_match, communicator) == 1)
+          {
+            levels[l] = it->second;
+            reused[l] = true;
+            ++n_reused;
+          }
+        else
+          {
+            levels[l] = std::move(new_levels[l]);
+          }
+      }
+
+    // Set up all levels that could not be reused.
+    for (unsigned int l = min_level(); l <= max_level(); ++l)
+      if (reused[l] == false)
+        {
+          Level &level = *levels[l];
+
+          level.dof_handler_v.distribute_dofs(fe_collection_v);
+          level.dof_handler_p.distribute_dofs(fe_collection_p);
+
+          level.partitioning_v.reinit(level.dof_handler_v);
+          level.partitioning_p.reinit(level.dof_handler_p);
+
+          level.dof_handlers  = {&level.dof_handler_v, &level.dof_handler_p};
+          level.partitionings = {&level.partitioning_v, &level.partitioning_p};
+          level.constraints   = {&level.constraints_v, &level.constraints_p};
+
+          setup_level(level);
+        }
+
+    getTable().add_value("mg_levels_reused", n_reused);
+
+    // Collect level operators.
+    operators.resize(min_level(), max_level());
+    for (unsigned int l = min_level(); l <= max_level(); ++l)
+      operators[l] = levels[l]->level_operator;
+
+    // Set up intergrid operators for each block. The previous transfers refer
+    // to the old ones.
+    mg_transfer.reset();
+    transfer_v.reset();
+    transfer_p.reset();
+    transfers_v.resize(min_level(), max_level());
+    transfers_p.resize(min_level(), max_level());
+
+    for (unsigned int l = min_level(); l < max_level(); ++l)
+      {
+        const Level &fine   = *levels[l + 1];
+        const Level &coarse = *levels[l];
+
+        if (l < min_level_p())
+          {
+            transfers_v[l + 1].reinit_geometric_transfer(fine.dof_handler_v,
+                                                         coarse.dof_handler_v,
+                                                         fine.constraints_v,
+                                                         coarse.constraints_v);
+            transfers_p[l + 1].reinit_geometric_transfer(fine.dof_handler_p,
+                                                         coarse.dof_handler_p,
+                                                         fine.constraints_p,
+                                                         coarse.constraints_p);
+          }
+        else
+          {
+            transfers_v[l + 1].reinit_polynomial_transfer(fine.dof_handler_v,
+                                                          coarse.dof_handler_v,
+                                                          fine.constraints_v,
+                                                          coarse.constraints_v);
+            transfers_p[l + 1].reinit_polynomial_transfer(fine.dof_handler_p,
+                                                          coarse.dof_handler_p,
+                                                          fine.constraints_p,
+                                                          coarse.constraints_p);
+          }
+      }
+
+    transfer_v = std::make_unique<MGTransferGlobalCoarsening<dim, VectorType>>(
+      transfers_v, [&](const auto l, auto &vec) {
+        operators[l]->get_matrix_free()->initialize_dof_vector(vec, 0);
+      });
+    transfer_p = std::make_unique<MGTransferGlobalCoarsening<dim, VectorType>>(
+      transfers_p, [&](const auto l, auto &vec) {
+        operators[l]->get_matrix_free()->initialize_dof_vector(vec, 1);
+      });
+
+    const std::vector<const MGTransferGlobalCoarsening<dim, VectorType> *> block_transfers = {
+      transfer_v.get(), transfer_p.get()};
+    mg_transfer = std::make_unique<MGTransferType>(block_transfers);
+  }
+} // namespace StokesMatrixFree
+
+
+#endif
@@ -19,6 +19,7 @@
 
 #include <deal.II/matrix_free/tools.h>
 
+#include <multigrid/monolithic_numbering.h>
 #include <multigrid/operator_base.h>
 
 
@@ -52,9 +53,26 @@ namespace StokesMatrixFree
            VectorType                                  &system_rhs,
            const dealii::Function<spacedim>            *rhs_function) override;
 
+    // Operate on DoFHandler @p dof_index and quadrature @p quad_index of a
+    // MatrixFree object shared with other operators, e.g., the one of
+    // StokesOperator. No separate partitioner or ghost exchange is set up.
+    void
+    reinit(const Partitioning                                               &partitioning,
+           const std::shared_ptr<const dealii::MatrixFree<dim, value_type>> &matrix_free,
+           const unsigned int                                                dof_index,
+           const unsigned int                                                quad_index,
+           const dealii::AffineConstraints<value_type>                      &constraints);
+
     void
     vmult(VectorType &dst, const VectorType &src) const override;
 
+    void
+    vmult(VectorType                                                        &dst,
+          const VectorType                                                  &src,
+          const std::function<void(const unsigned int, const unsigned int)> &operation_before_loop,
+          const std::function<void(const unsigned int, const unsigned int)> &operation_after_loop)
+      const override;
+
     void
     initialize_dof_vector(VectorType &vec) const override;
 
@@ -67,6 +85,14 @@ namespace StokesMatrixFree
     const typename LinearAlgebra::SparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
+    void
+    compute_partial_matrix(const dealii::IndexSet                  &all_indices_assemble,
+                           const dealii::AffineConstraints<double> &constraints_reduced,
+                           typename LinearAlgebra::SparseMatrix    &matrix) const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
@@ -84,10 +110,14 @@ namespace StokesMatrixFree
     void
     do_cell_integral_local(FECellIntegrator &integrator) const;
 
+    template <typename Integrator>
+    void
+    do_cell_integral_global(Integrator &integrator, VectorType &dst, const VectorType &src) const;
+
+    // viscous term on the gradients of all components on the reference cell
+    template <typename Integrator>
     void
-    do_cell_integral_global(FECellIntegrator &integrator,
-                            VectorType       &dst,
-                            const VectorType &src) const;
+    do_quadrature(Integrator &integrator) const;
 
     void
     do_cell_integral_range(const dealii::MatrixFree<dim, value_type>   &matrix_free,
@@ -96,8 +126,12 @@ namespace StokesMatrixFree
                            const std::pair<unsigned int, unsigned int> &range) const;
 
     // TODO: Make partitioning a pointer? Or leave it like this?
-    Partitioning                        partitioning;
-    dealii::MatrixFree<dim, value_type> matrix_free;
+    Partitioning partitioning;
+
+    // either owned or shared with StokesOperator
+    std::shared_ptr<const dealii::MatrixFree<dim, value_type>> matrix_free;
+    unsigned int                                               dof_index  = 0;
+    unsigned int                                               quad_index = 0;
 
     mutable typename LinearAlgebra::SparseMatrix a_block_matrix;
   };
@@ -130,6 +164,16 @@ namespace StokesMatrixFree
            VectorType                                  &system_rhs,
            const dealii::Function<spacedim>            *rhs_function) override;
 
+    // Operate on DoFHandler @p dof_index and quadrature @p quad_index of a
+    // MatrixFree object shared with other operators, e.g., the one of
+    // StokesOperator. No separate partitioner or ghost exchange is set up.
+    void
+    reinit(const Partitioning                                               &partitioning,
+           const std::shared_ptr<const dealii::MatrixFree<dim, value_type>> &matrix_free,
+           const unsigned int                                                dof_index,
+           const unsigned int                                                quad_index,
+           const dealii::AffineConstraints<value_type>                      &constraints);
+
     void
     vmult(VectorType &dst, const VectorType &src) const override;
 
@@ -145,6 +189,9 @@ namespace StokesMatrixFree
     const typename LinearAlgebra::SparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
@@ -158,10 +205,9 @@ namespace StokesMatrixFree
     void
     do_cell_integral_local(FECellIntegrator &integrator) const;
 
+    template <typename Integrator>
     void
-    do_cell_integral_global(FECellIntegrator &integrator,
-                            VectorType       &dst,
-                            const VectorType &src) const;
+    do_cell_integral_global(Integrator &integrator, VectorType &dst, const VectorType &src) const;
 
     void
     do_cell_integral_range(const dealii::MatrixFree<dim, value_type>   &matrix_free,
@@ -173,8 +219,12 @@ namespace StokesMatrixFree
     //       Grab and set as RHS in reinit
     // dealii::Function<dim> rhs_function;
 
-    Partitioning                        partitioning;
-    dealii::MatrixFree<dim, value_type> matrix_free;
+    Partitioning partitioning;
+
+    // either owned or shared with StokesOperator
+    std::shared_ptr<const dealii::MatrixFree<dim, value_type>> matrix_free;
+    unsigned int                                               dof_index  = 0;
+    unsigned int                                               quad_index = 0;
 
     mutable typename LinearAlgebra::SparseMatrix schur_block_matrix;
   };
@@ -189,9 +239,12 @@ namespace StokesMatrixFree
   {
   public:
     using VectorType = typename LinearAlgebra::BlockVector;
+    using BlockType  = typename LinearAlgebra::Vector;
     using value_type = typename VectorType::value_type;
 
     // using FECellIntegrator = dealii::FEEvaluation<dim, -1, 0, dim + 1, value_type>;
+    using FEVelocityIntegrator = dealii::FEEvaluation<dim, -1, 0, dim, value_type>;
+    using FEPressureIntegrator = dealii::FEEvaluation<dim, -1, 0, 1, value_type>;
 
     StokesOperator(const dealii::hp::MappingCollection<dim, spacedim> &mapping_collection,
                    const std::vector<dealii::hp::QCollection<dim>>    &quadrature_collections);
@@ -203,9 +256,34 @@ namespace StokesMatrixFree
            VectorType                                                       &system_rhs,
            const std::vector<const dealii::Function<spacedim> *>            &rhs_functions);
 
+    // Set up the operator without a right hand side, e.g., on multigrid
+    // levels with homogeneous constraints. All arguments have to outlive it.
+    void
+    reinit(const std::vector<const Partitioning *>                          &partitionings,
+           const std::vector<const dealii::DoFHandler<dim, spacedim> *>     &dof_handlers,
+           const std::vector<const dealii::AffineConstraints<value_type> *> &constraints);
+
     void
     vmult(VectorType &dst, const VectorType &src) const override;
 
+    /**
+     * Assemble the whole saddle point system into @p system_matrix in
+     * @p numbering, in which velocity is the first block and pressure the
+     * second one. Cell matrices are computed matrix-free by applying the cell
+     * operator to unit vectors, and constraints are resolved during assembly.
+     */
+    void
+    compute_monolithic_matrix(const dealii::MonolithicNumbering       &numbering,
+                              typename LinearAlgebra::SparsityPattern &sparsity_pattern,
+                              typename LinearAlgebra::SparseMatrix    &system_matrix) const;
+
+    /**
+     * Compute dst = B^T src, i.e., apply only the pressure gradient term of
+     * the momentum equation to the pressure @p src.
+     */
+    void
+    vmult_gradient(BlockType &dst, const BlockType &src) const;
+
     void
     initialize_dof_vector(VectorType &vec) const override;
 
@@ -218,9 +296,16 @@ namespace StokesMatrixFree
     const typename LinearAlgebra::BlockSparseMatrix &
     get_system_matrix() const override;
 
+    std::size_t
+    memory_consumption() const override;
+
     void
     Tvmult(VectorType &dst, const VectorType &src) const override;
 
+    // velocity and pressure on DoFHandler and quadrature 0 and 1
+    std::shared_ptr<const dealii::MatrixFree<dim, value_type>>
+    get_matrix_free() const;
+
   private:
     // const Parameters &prm;
 
@@ -229,12 +314,25 @@ namespace StokesMatrixFree
     const std::vector<const dealii::AffineConstraints<value_type> *>        *constraints;
     const std::vector<const dealii::Function<spacedim> *>                   *rhs_functions;
 
+    void
+    do_cell_integral_velocity_local(FEVelocityIntegrator &velocity) const;
+
+    void
+    do_quadrature_point_operation(FEVelocityIntegrator &velocity,
+                                  FEPressureIntegrator &pressure) const;
+
     void
     do_cell_integral_range(const dealii::MatrixFree<dim, value_type>   &matrix_free,
                            VectorType                                  &dst,
                            const VectorType                            &src,
                            const std::pair<unsigned int, unsigned int> &range) const;
 
+    void
+    do_cell_gradient_range(const dealii::MatrixFree<dim, value_type>   &matrix_free,
+                           BlockType                                   &dst,
+                           const BlockType                             &src,
+                           const std::pair<unsigned int, unsigned int> &range) const;
+
     void
     do_cell_rhs_function_range(const dealii::MatrixFree<dim, value_type> &matrix_free,
                                VectorType                                &system_rhs,
@@ -242,8 +340,9 @@ namespace StokesMatrixFree
                                const std::pair<unsigned int, unsigned int> &range) const;
 
     // TODO: Make partitioning a pointer? Or leave it like this?
-    Partitioning                        partitioning;
-    dealii::MatrixFree<dim, value_type> matrix_free;
+    Partitioning partitioning;
+
+    std::shared_ptr<const dealii::MatrixFree<dim, value_type>> matrix_free;
 
     mutable typename LinearAlgebra::BlockSparseMatrix dummy;
   };
@@ -0,0 +1,103 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+#ifndef stokes_matrixfree_parameter_h
+#define stokes_matrixfree_parameter_h
+
+
+#include <deal.II/base/parameter_acceptor.h>
+
+#include <string>
+
+
+namespace StokesMatrixFree
+{
+  struct BlockSchurParameters : public dealii::ParameterAcceptor
+  {
+    BlockSchurParameters()
+      : dealii::ParameterAcceptor("block preconditioner")
+    {
+      a_block_solver = "preconditioner";
+      add_parameter("a block solver", a_block_solver);
+
+      a_block_n_applications = 1;
+      add_parameter("a block n applications", a_block_n_applications);
+
+      a_block_tolerance = 1e-2;
+      add_parameter("a block tolerance", a_block_tolerance);
+
+      schur_complement_solver = "cg";
+      add_parameter("schur complement solver", schur_complement_solver);
+
+      schur_complement_n_applications = 1;
+      add_parameter("schur complement n applications", schur_complement_n_applications);
+
+      schur_complement_tolerance = 1e-6;
+      add_parameter("schur complement tolerance", schur_complement_tolerance);
+
+      schur_complement_preconditioner = "jacobi";
+      add_parameter("schur complement preconditioner", schur_complement_preconditioner);
+
+      schur_complement_chebyshev_degree = 3;
+      add_parameter("schur complement chebyshev degree", schur_complement_chebyshev_degree);
+
+      adaptive_tolerances = false;
+      add_parameter("adaptive tolerances", adaptive_tolerances);
+
+      max_adaptive_tolerance = 1e-1;
+      add_parameter("max adaptive tolerance", max_adaptive_tolerance);
+    }
+
+    // cg solves to the tolerance relative to the right hand side, preconditioner
+    // applies the preconditioner a fixed number of times as Richardson iteration
+    std::string  a_block_solver;
+    unsigned int a_block_n_applications;
+    double       a_block_tolerance;
+
+    std::string  schur_complement_solver;
+    unsigned int schur_complement_n_applications;
+    double       schur_complement_tolerance;
+
+    // jacobi or chebyshev on the pressure mass matrix, the latter with the
+    // diagonal as preconditioner and only with GMG
+    std::string  schur_complement_preconditioner;
+    unsigned int schur_complement_chebyshev_degree;
+
+    // relax inner tolerances by the ratio of the initial to the current outer
+    // residual, up to the maximum
+    bool   adaptive_tolerances;
+    double max_adaptive_tolerance;
+  };
+
+
+
+  struct MonolithicParameters : public dealii::ParameterAcceptor
+  {
+    MonolithicParameters()
+      : dealii::ParameterAcceptor("monolithic multigrid")
+    {
+      vanka_relaxation = 1.;
+      add_parameter("vanka relaxation", vanka_relaxation);
+    }
+
+    // damping of the Richardson iteration with the Vanka smoother, whose
+    // number of iterations per level is the smoother degree of the multigrid
+    // parameters
+    double vanka_relaxation;
+  };
+} // namespace StokesMatrixFree
+
+
+#endif
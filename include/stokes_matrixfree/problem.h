@@ -25,6 +25,8 @@
 #include <deal.II/hp/fe_values.h>
 
 #include <adaptation/base.h>
+#include <async_writer.h>
+#include <multigrid/mg_hierarchy.h>
 #include <parameter.h>
 #include <problem_base.h>
 #include <stokes_matrixfree/operators.h>
@@ -114,13 +116,19 @@ namespace StokesMatrixFree
     std::vector<const dealii::AffineConstraints<double> *> constraints;
 
     std::unique_ptr<StokesMatrixFree::StokesOperator<dim, LinearAlgebra, spacedim>> stokes_operator;
-    std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>> a_block_operator;
-    std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>> schur_block_operator;
+    std::unique_ptr<StokesMatrixFree::ABlockOperator<dim, LinearAlgebra, spacedim>>
+      a_block_operator;
+    std::unique_ptr<StokesMatrixFree::SchurBlockOperator<dim, LinearAlgebra, spacedim>>
+      schur_block_operator;
+
+    std::unique_ptr<MGHierarchyBase> mg_hierarchy;
 
     typename LinearAlgebra::BlockVector locally_relevant_solution;
     typename LinearAlgebra::BlockVector system_rhs;
 
     unsigned int cycle;
+
+    std::unique_ptr<AsyncWriter> async_writer;
   };
 } // namespace StokesMatrixFree
 
@@ -26,19 +26,47 @@
 #include <deal.II/lac/solver_control.h>
 #include <deal.II/lac/solver_gmres.h>
 
+#include <instrumentation.h>
 #include <linear_algebra.h>
 #include <multigrid/asm.h>
 #include <multigrid/diagonal_matrix_timer.h>
 #include <multigrid/extended_diagonal.h>
+#include <multigrid/mg_cycle.h>
+#include <multigrid/mg_level_profiler.h>
+#include <multigrid/mg_hierarchy.h>
 #include <multigrid/mg_solver.h>
+#include <multigrid/mixed_precision.h>
 #include <multigrid/parameter.h>
 #include <multigrid/patch_indices.h>
 #include <multigrid/reduce_and_assemble.h>
+#include <multigrid/vanka.h>
+#include <stokes_matrixfree/mg_hierarchy.h>
 #include <stokes_matrixfree/operators.h>
+#include <stokes_matrixfree/parameter.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 
 namespace StokesMatrixFree
 {
+  /**
+   * Block triangular preconditioner for the Stokes system.
+   *
+   * Both the Schur complement and the A-block are either solved with CG, or
+   * approximated by a fixed number of Richardson iterations with their
+   * preconditioners, see BlockSchurParameters. With adaptive tolerances, the
+   * inner CG tolerances are relaxed as the outer residual decreases, which is
+   * passed in via set_outer_residual(). Scratch vectors are reused across
+   * calls.
+   *
+   * Only the pressure gradient of the Stokes operator enters the right hand
+   * side of the A-block, see StokesOperator::vmult_gradient(). CG solves
+   * take this right hand side in the otherwise unused residual vector. The
+   * Richardson iteration needs residual and correction itself, and keeps the
+   * right hand side in a velocity vector of its own.
+   */
   template <typename LinearAlgebra,
             typename StokesMatrixType,
             typename ABlockMatrixType,
@@ -48,37 +76,67 @@ namespace StokesMatrixFree
   class BlockSchurPreconditioner : public dealii::Subscriptor
   {
   public:
+    using VectorType      = typename LinearAlgebra::Vector;
+    using BlockVectorType = typename LinearAlgebra::BlockVector;
+
     BlockSchurPreconditioner(
       const StokesMatrixType                  &stokes_matrix,
       const ABlockMatrixType                  &a_block,
       const SchurComplementMatrixType         &schur_complement_block,
       const ABlockPreconditionerType          &a_block_preconditioner,
       const SchurComplementPreconditionerType &schur_complement_preconditioner,
-      const bool                               do_solve_A,
-      const bool                               do_solve_Schur_complement)
+      const BlockSchurParameters              &prm)
       : stokes_matrix(&stokes_matrix)
       , a_block(&a_block)
       , schur_complement_block(&schur_complement_block)
       , a_block_preconditioner(a_block_preconditioner)
       , schur_complement_preconditioner(schur_complement_preconditioner)
-      , do_solve_A(do_solve_A)
-      , do_solve_Schur_complement(do_solve_Schur_complement)
-    {}
+      , prm(prm)
+    {
+      AssertThrow(prm.a_block_solver == "cg" || prm.a_block_solver == "preconditioner",
+                  dealii::ExcMessage("Unknown A-block solver: " + prm.a_block_solver));
+      AssertThrow(prm.schur_complement_solver == "cg" ||
+                    prm.schur_complement_solver == "preconditioner",
+                  dealii::ExcMessage("Unknown Schur complement solver: " +
+                                     prm.schur_complement_solver));
+    }
 
+    /**
+     * Record the residual of the outer solver, with which adaptive tolerances
+     * are determined. The first value is taken as the initial residual.
+     */
     void
-    vmult(typename LinearAlgebra::BlockVector       &dst,
-          const typename LinearAlgebra::BlockVector &src) const
+    set_outer_residual(const double residual) const
     {
-      dealii::TimerOutput::Scope t(getTimer(), "vmult_BlockSchurPreconditioner");
+      if (initial_outer_residual == 0.)
+        initial_outer_residual = residual;
+      outer_residual = residual;
+    }
+
+    void
+    vmult(BlockVectorType &dst, const BlockVectorType &src) const
+    {
+      Instrumentation::Scope t(Instrumentation::vmult_block_schur_preconditioner);
+
+      if (residual.size() != src.block(0).size() ||
+          residual_schur.size() != src.block(1).size())
+        {
+          residual.reinit(src.block(0));
+          correction.reinit(src.block(0));
+          residual_schur.reinit(src.block(1));
+          correction_schur.reinit(src.block(1));
+        }
 
       // This needs to be done explicitly, as GMRES does not initialize the data of the vector dst
       // before calling us. Otherwise we might use random data as our initial guess.
       // See also: https://github.com/geodynamics/aspect/pull/4973
       dst = 0.;
 
-      if (do_solve_Schur_complement)
+      if (prm.schur_complement_solver == "cg")
         {
-          dealii::SolverControl            solver_control(5000, 1e-6 * src.block(1).l2_norm());
+          dealii::SolverControl solver_control(5000,
+                                               get_tolerance(prm.schur_complement_tolerance) *
+                                                 src.block(1).l2_norm());
           typename LinearAlgebra::SolverCG solver(solver_control);
 
           solver.solve(*schur_complement_block,
@@ -87,31 +145,79 @@ namespace StokesMatrixFree
                        schur_complement_preconditioner);
         }
       else
-        schur_complement_preconditioner.vmult(dst.block(1), src.block(1));
+        apply_richardson(*schur_complement_block,
+                         schur_complement_preconditioner,
+                         prm.schur_complement_n_applications,
+                         dst.block(1),
+                         src.block(1),
+                         residual_schur,
+                         correction_schur);
 
       dst.block(1) *= -1.0;
 
-      typename LinearAlgebra::BlockVector utmp;
-      utmp.reinit(src);
+      // right hand side src_u - B^T p of the A-block
+      VectorType &a_block_rhs = (prm.a_block_solver == "cg") ? residual : rhs;
+      if (a_block_rhs.size() != src.block(0).size())
+        a_block_rhs.reinit(src.block(0), /*omit_zeroing_entries=*/true);
 
-      {
-        stokes_matrix->vmult(utmp, dst); // B^T
-        utmp.block(0) *= -1.0;
-        utmp.block(0) += src.block(0);
-      }
+      stokes_matrix->vmult_gradient(a_block_rhs, dst.block(1));
+      a_block_rhs.sadd(-1.0, 1.0, src.block(0));
 
-      if (do_solve_A == true)
+      if (prm.a_block_solver == "cg")
         {
-          dealii::SolverControl            solver_control(5000, 1e-2 * utmp.block(0).l2_norm());
+          dealii::SolverControl solver_control(5000,
+                                               get_tolerance(prm.a_block_tolerance) *
+                                                 a_block_rhs.l2_norm());
           typename LinearAlgebra::SolverCG solver(solver_control);
 
-          solver.solve(*a_block, dst.block(0), utmp.block(0), a_block_preconditioner);
+          solver.solve(*a_block, dst.block(0), a_block_rhs, a_block_preconditioner);
         }
       else
-        a_block_preconditioner.vmult(dst.block(0), utmp.block(0));
+        apply_richardson(*a_block,
+                         a_block_preconditioner,
+                         prm.a_block_n_applications,
+                         dst.block(0),
+                         a_block_rhs,
+                         residual,
+                         correction);
     }
 
   private:
+    double
+    get_tolerance(const double tolerance) const
+    {
+      if (prm.adaptive_tolerances == false || outer_residual == 0.)
+        return tolerance;
+
+      return std::min(prm.max_adaptive_tolerance,
+                      tolerance * initial_outer_residual / outer_residual);
+    }
+
+    /**
+     * Compute dst = P src, followed by n_applications - 1 corrections
+     * dst += P (src - A dst).
+     */
+    template <typename MatrixType, typename PreconditionerType>
+    static void
+    apply_richardson(const MatrixType         &matrix,
+                     const PreconditionerType &preconditioner,
+                     const unsigned int        n_applications,
+                     VectorType               &dst,
+                     const VectorType         &src,
+                     VectorType               &residual,
+                     VectorType               &correction)
+    {
+      preconditioner.vmult(dst, src);
+
+      for (unsigned int i = 1; i < n_applications; ++i)
+        {
+          matrix.vmult(residual, dst);
+          residual.sadd(-1., 1., src);
+          preconditioner.vmult(correction, residual);
+          dst += correction;
+        }
+    }
+
     const dealii::SmartPointer<const StokesMatrixType>          stokes_matrix;
     const dealii::SmartPointer<const ABlockMatrixType>          a_block;
     const dealii::SmartPointer<const SchurComplementMatrixType> schur_complement_block;
@@ -119,12 +225,35 @@ namespace StokesMatrixFree
     const ABlockPreconditionerType          &a_block_preconditioner;
     const SchurComplementPreconditionerType &schur_complement_preconditioner;
 
-    const bool do_solve_A;
-    const bool do_solve_Schur_complement;
+    const BlockSchurParameters &prm;
+
+    mutable double initial_outer_residual = 0.;
+    mutable double outer_residual         = 0.;
+
+    mutable VectorType residual, correction, rhs;
+    mutable VectorType residual_schur, correction_schur;
   };
 
 
 
+  /**
+   * Connect the outer solver with the preconditioner, so that inner
+   * tolerances can follow the outer residual.
+   */
+  template <typename SolverType, typename PreconditionerType>
+  void
+  connect_outer_residual(SolverType &solver, const PreconditionerType &preconditioner)
+  {
+    solver.connect([&preconditioner](const unsigned int,
+                                     const double residual,
+                                     const typename PreconditionerType::BlockVectorType &) {
+      preconditioner.set_outer_residual(residual);
+      return dealii::SolverControl::success;
+    });
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim = dim>
   static void
   solve_amg(dealii::SolverControl &solver_control_refined,
@@ -132,7 +261,8 @@ namespace StokesMatrixFree
             const OperatorType<dim, LinearAlgebra, spacedim>                     &a_block_operator,
             const OperatorType<dim, LinearAlgebra, spacedim> &schur_block_operator,
             typename LinearAlgebra::BlockVector              &dst,
-            const typename LinearAlgebra::BlockVector        &src)
+            const typename LinearAlgebra::BlockVector        &src,
+            const BlockSchurParameters                       &prm_block_schur)
   {
     typename LinearAlgebra::PreconditionAMG::AdditionalData Amg_data;
     if constexpr (std::is_same<LinearAlgebra, PETSc>::value)
@@ -154,6 +284,9 @@ namespace StokesMatrixFree
         Assert(false, dealii::ExcNotImplemented());
       }
 
+    AssertThrow(prm_block_schur.schur_complement_preconditioner == "jacobi",
+                dealii::ExcMessage("Only GMG supports other Schur complement preconditioners."));
+
     typename LinearAlgebra::PreconditionJacobi Mp_preconditioner;
     typename LinearAlgebra::PreconditionAMG    Amg_preconditioner;
 
@@ -174,8 +307,7 @@ namespace StokesMatrixFree
                      schur_block_operator.get_system_matrix(),
                      Amg_preconditioner,
                      Mp_preconditioner,
-                     /*do_solve_A=*/false,
-                     /*do_solve_Schur_complement=*/true);
+                     prm_block_schur);
 
     // set up solver
     dealii::PrimitiveVectorMemory<typename LinearAlgebra::BlockVector> mem;
@@ -185,312 +317,186 @@ namespace StokesMatrixFree
     dealii::SolverFGMRES<typename LinearAlgebra::BlockVector> solver(solver_control_refined,
                                                                      mem,
                                                                      fgmres_data);
+    connect_outer_residual(solver, preconditioner);
 
     solver.solve(stokes_operator, dst, src, preconditioner);
   }
 
 
 
-  template <typename SmootherPreconditionerType, int dim, typename LinearAlgebra, int spacedim>
+  /**
+   * Solve with a block preconditioner, in which the A-block is approximated by
+   * multigrid. Level operators are replicated from @p a_block_level_operator,
+   * whose LevelLinearAlgebra, and thus the precision of the whole multigrid
+   * hierarchy, might differ from the one of the outer solver.
+   *
+   * The multigrid hierarchy is stored in @p mg_hierarchy and persists across
+   * calls, so that levels that did not change are reused.
+   */
+  template <typename SmootherPreconditionerType,
+            int dim,
+            typename LinearAlgebra,
+            int spacedim,
+            typename LevelLinearAlgebra = LinearAlgebra>
   static void
   solve_gmg(dealii::SolverControl &solver_control_refined,
             const StokesMatrixFree::StokesOperator<dim, LinearAlgebra, spacedim> &stokes_operator,
             const OperatorType<dim, LinearAlgebra, spacedim>                     &a_block_operator,
-            const OperatorType<dim, LinearAlgebra, spacedim>             &schur_block_operator,
-            typename LinearAlgebra::BlockVector                          &dst,
-            const typename LinearAlgebra::BlockVector                    &src,
-            const MGSolverParameters                                     &mg_data,
-            const dealii::hp::MappingCollection<dim, spacedim>           &mapping_collection,
-            const dealii::hp::QCollection<dim>                           &q_collection_v,
+            const OperatorType<dim, LevelLinearAlgebra, spacedim> &a_block_level_operator,
+            const OperatorType<dim, LinearAlgebra, spacedim>      &schur_block_operator,
+            typename LinearAlgebra::BlockVector                   &dst,
+            const typename LinearAlgebra::BlockVector             &src,
+            const MGSolverParameters                              &mg_data,
+            const BlockSchurParameters                            &prm_block_schur,
             const std::vector<const dealii::DoFHandler<dim, spacedim> *> &stokes_dof_handlers,
+            std::unique_ptr<MGHierarchyBase>                             &mg_hierarchy,
             const std::string                                            &filename_mg_level)
   {
-    // poisson has mappingcollection and dofhandler as additional parameters
+    // poisson has the quadrature collection and dofhandler as additional parameters
 
     using namespace dealii;
 
-    using VectorType = typename LinearAlgebra::Vector;
+    using HierarchyType =
+      MGHierarchy<dim, LevelLinearAlgebra, SmootherPreconditionerType, spacedim>;
+    using Level       = typename HierarchyType::Level;
+    using VectorType  = typename HierarchyType::VectorType;
+    using LevelNumber = typename HierarchyType::LevelNumber;
 
     // TODO: this is only temporary
     // only work on velocity dofhandlers for now
     const DoFHandler<dim, spacedim> &dof_handler = *(stokes_dof_handlers[0]);
 
-    // Create a DoFHandler and operator for each multigrid level defined
-    // by p-coarsening, as well as, create transfer operators.
-    MGLevelObject<DoFHandler<dim, spacedim>>                                   dof_handlers;
-    MGLevelObject<std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>>> operators;
-    MGLevelObject<MGTwoLevelTransfer<dim, VectorType>>                         transfers;
-
-    std::vector<std::shared_ptr<const Triangulation<dim, spacedim>>> coarse_grid_triangulations;
-    if (mg_data.transfer.perform_h_transfer)
-      coarse_grid_triangulations =
-        MGTransferGlobalCoarseningTools::create_geometric_coarsening_sequence(
-          dof_handler.get_triangulation());
-    else
-      coarse_grid_triangulations.emplace_back(
-        const_cast<Triangulation<dim, spacedim> *>(&(dof_handler.get_triangulation())), [](auto &) {
-          // empty deleter, since fine_triangulation_in is an external field
-          // and its destructor is called somewhere else
-        });
-
-    const unsigned int n_h_levels = coarse_grid_triangulations.size() - 1;
-
-    // Determine the number of levels.
-    const auto get_max_active_fe_degree = [&](const auto &dof_handler) {
-      unsigned int max = 0;
-
-      for (auto &cell : dof_handler.active_cell_iterators())
-        if (cell->is_locally_owned())
-          max = std::max(max, dof_handler.get_fe(cell->active_fe_index()).degree);
-
-      return Utilities::MPI::max(max, MPI_COMM_WORLD);
-    };
-
-    const unsigned int n_p_levels =
-      MGTransferGlobalCoarseningTools::create_polynomial_coarsening_sequence(
-        get_max_active_fe_degree(dof_handler), mg_data.transfer.p_sequence)
-        .size();
-
-    std::map<unsigned int, unsigned int> fe_index_for_degree;
-    for (unsigned int i = 0; i < dof_handler.get_fe_collection().size(); ++i)
-      {
-        const unsigned int degree = dof_handler.get_fe(i).degree;
-        Assert(fe_index_for_degree.find(degree) == fe_index_for_degree.end(),
-               ExcMessage("FECollection does not contain unique degrees."));
-        fe_index_for_degree[degree] = i;
-      }
-
-    unsigned int minlevel   = 0;
-    unsigned int minlevel_p = n_h_levels;
-    unsigned int maxlevel   = n_h_levels + n_p_levels - 1;
-
-    // Allocate memory for all levels.
-    dof_handlers.resize(minlevel, maxlevel);
-    operators.resize(minlevel, maxlevel);
-    transfers.resize(minlevel, maxlevel);
-
-    // Loop from max to min level and set up DoFHandler with coarser mesh...
-    for (unsigned int l = 0; l < n_h_levels; ++l)
-      {
-        dof_handlers[l].reinit(*coarse_grid_triangulations[l]);
-        dof_handlers[l].distribute_dofs(dof_handler.get_fe_collection());
-      }
-
-    // ... with lower polynomial degrees
-    for (unsigned int i = 0, l = maxlevel; i < n_p_levels; ++i, --l)
-      {
-        dof_handlers[l].reinit(dof_handler.get_triangulation());
-
-        if (l == maxlevel) // finest level
-          {
-            auto &dof_handler_mg = dof_handlers[l];
-
-            auto cell_other = dof_handler.begin_active();
-            for (auto &cell : dof_handler_mg.active_cell_iterators())
-              {
-                if (cell->is_locally_owned())
-                  cell->set_active_fe_index(cell_other->active_fe_index());
-                cell_other++;
-              }
-          }
-        else // coarse level
-          {
-            auto &dof_handler_fine   = dof_handlers[l + 1];
-            auto &dof_handler_coarse = dof_handlers[l + 0];
-
-            auto cell_other = dof_handler_fine.begin_active();
-            for (auto &cell : dof_handler_coarse.active_cell_iterators())
-              {
-                if (cell->is_locally_owned())
-                  {
-                    const unsigned int next_degree =
-                      MGTransferGlobalCoarseningTools::create_next_polynomial_coarsening_degree(
-                        cell_other->get_fe().degree, mg_data.transfer.p_sequence);
-                    Assert(fe_index_for_degree.find(next_degree) != fe_index_for_degree.end(),
-                           ExcMessage("Next polynomial degree in sequence "
-                                      "does not exist in FECollection."));
-
-                    cell->set_active_fe_index(fe_index_for_degree[next_degree]);
-                  }
-                cell_other++;
-              }
-          }
-
-        dof_handlers[l].distribute_dofs(dof_handler.get_fe_collection());
-      }
-
-    // Create data structures on each multigrid level.
-    MGLevelObject<AffineConstraints<typename VectorType::value_type>> constraints(minlevel,
-                                                                                  maxlevel);
-
-    MGLevelObject<std::shared_ptr<SmootherPreconditionerType>> smoother_preconditioners(minlevel,
-                                                                                        maxlevel);
+    // Create a DoFHandler, operator and smoother for each multigrid level
+    // defined by h- and p-coarsening that has changed, as well as transfer
+    // operators.
+    if (dynamic_cast<HierarchyType *>(mg_hierarchy.get()) == nullptr)
+      mg_hierarchy = std::make_unique<HierarchyType>();
+    auto &hierarchy = static_cast<HierarchyType &>(*mg_hierarchy);
 
     //
     // TODO: Generalise, maybe for operator and blockoperatorbase?
     //       Pass this part as lambda function?
     //       Or just pass vector target?
     //
-    for (unsigned int level = minlevel; level <= maxlevel; level++)
-      {
-        const auto &dof_handler = dof_handlers[level];
-        auto       &constraint  = constraints[level];
+    const auto setup_level = [&](Level &level, const bool is_finest_level) {
+      const auto &dof_handler  = level.dof_handler;
+      const auto &partitioning = level.partitioning;
+      auto       &constraint   = level.constraints;
 
-        Partitioning partitioning;
-        partitioning.reinit(dof_handler);
+      // ... constraints (with homogenous Dirichlet BC)
+      constraint.reinit(partitioning.get_relevant_dofs());
 
-        // ... constraints (with homogenous Dirichlet BC)
-        constraint.reinit(partitioning.get_relevant_dofs());
+      // Homogeneous constraints only need the boundary DoFs, no evaluation of
+      // a function on the boundary faces.
+      DoFTools::make_hanging_node_constraints(dof_handler, constraint);
+      // TODO: externalize this
+      for (const types::boundary_id boundary_id : {0, 3})
+        DoFTools::make_zero_boundary_constraints(dof_handler, boundary_id, constraint);
 
-        DoFTools::make_hanging_node_constraints(dof_handler, constraint);
-        // TODO: externalize this
-        const Functions::ZeroFunction<dim> zero(dim);
-        VectorTools::interpolate_boundary_values(mapping_collection,
-                                                 dof_handler,
-                                                 {{0, &zero}, {3, &zero}},
-                                                 constraint);
+      constraint.close();
 
-        constraint.close();
+      if constexpr (!std::is_same_v<LevelNumber, double>)
+        level.constraints_level_precision.copy_from(constraint);
 
-        // ... operator (just like on the finest level)
-        operators[level] = a_block_operator.replicate();
-        operators[level]->reinit(partitioning, dof_handler, constraint);
+      // ... operator (just like on the finest level)
+      level.level_operator = a_block_level_operator.replicate();
+      level.level_operator->reinit(partitioning, dof_handler, level.get_level_constraints());
 
 
-        // WIP: build smoother preconditioners here
-        // necessary on all levels or just minlevel+1 to maxlevel?
+      // WIP: build smoother preconditioners here
+      // necessary on all levels or just minlevel+1 to maxlevel?
 
-        if constexpr (std::is_same_v<SmootherPreconditionerType, DiagonalMatrixTimer<VectorType>>)
-          {
-            smoother_preconditioners[level] =
-              std::make_shared<SmootherPreconditionerType>("vmult_diagonal_ABlock");
-            operators[level]->compute_inverse_diagonal(
-              smoother_preconditioners[level]->get_vector());
-          }
-        else if constexpr (std::is_same_v<SmootherPreconditionerType, PreconditionASM<VectorType>>)
-          {
-            const auto patch_indices = prepare_patch_indices(dof_handler, constraint);
-
-            if (level == maxlevel)
-              Log::log_patch_dofs(patch_indices, dof_handler);
-
-            // full matrix
-            // TODO: this is a nasty way to get the sparsity pattern
-            // so far I only created temporary sparsity patterns in the LinearAlgebra namespace,
-            // but they are no longer available here
-            // so for the sake of trying ASM out, I'll just create another one here
-            const unsigned int myid =
-              dealii::Utilities::MPI::this_mpi_process(dof_handler.get_communicator());
-            typename LinearAlgebra::SparsityPattern sparsity_pattern;
-            sparsity_pattern.reinit(partitioning.get_owned_dofs(),
-                                    partitioning.get_owned_dofs(),
-                                    partitioning.get_relevant_dofs(),
-                                    dof_handler.get_communicator());
-            DoFTools::make_sparsity_pattern(dof_handler, sparsity_pattern, constraint, false, myid);
-            sparsity_pattern.compress();
-
-            smoother_preconditioners[level] =
-              std::make_shared<SmootherPreconditionerType>(std::move(patch_indices));
-            smoother_preconditioners[level]->initialize(operators[level]->get_system_matrix(),
-                                                        sparsity_pattern,
-                                                        dof_handler);
-          }
-        else if constexpr (std::is_same_v<SmootherPreconditionerType,
-                                          PreconditionExtendedDiagonal<VectorType>>)
-          {
-            const auto patch_indices = prepare_patch_indices(dof_handler, constraint);
-
-            if (level == maxlevel)
-              Log::log_patch_dofs(patch_indices, dof_handler);
-
-            // full matrix
-            // const unsigned int myid = dealii::Utilities::MPI::this_mpi_process(communicator);
-            // DynamicSparsityPattern dsp(relevant_dofs);
-            // DoFTools::make_sparsity_pattern(dof_handler, dsp, constraints, false, myid);
-            // SparsityTools::distribute_sparsity_pattern(dsp, owned_dofs, communicator,
-            // relevant_dofs);
-
-            // reduced matrix
-            AffineConstraints<double> constraints_reduced;
-            constraints_reduced.reinit(partitioning.get_owned_dofs(),
-                                       partitioning.get_relevant_dofs());
-
-            const auto all_indices_relevant =
-              extract_relevant(patch_indices, partitioning, dof_handler);
-
-            std::set<types::global_dof_index> all_indices_assemble;
-            reduce_constraints(constraint,
-                               DoFTools::extract_locally_active_dofs(dof_handler),
-                               all_indices_relevant,
-                               constraints_reduced,
-                               all_indices_assemble);
-
-            // TODO: only works for Trilinos so far
-            typename LinearAlgebra::SparsityPattern reduced_sparsity_pattern;
-            reduced_sparsity_pattern.reinit(partitioning.get_owned_dofs(),
-                                            partitioning.get_owned_dofs(),
-                                            partitioning.get_relevant_dofs(),
-                                            dof_handler.get_communicator());
-            make_sparsity_pattern(dof_handler,
-                                  all_indices_assemble,
-                                  reduced_sparsity_pattern,
-                                  constraints_reduced);
-            reduced_sparsity_pattern.compress();
-
-            typename LinearAlgebra::SparseMatrix reduced_sparse_matrix;
-            reduced_sparse_matrix.reinit(reduced_sparsity_pattern);
-            partially_assemble_ablock(dof_handler,
-                                      constraints_reduced,
-                                      q_collection_v,
-                                      all_indices_assemble,
-                                      reduced_sparse_matrix);
-
-            VectorType inverse_diagonal;
-            operators[level]->compute_inverse_diagonal(inverse_diagonal);
-
-            smoother_preconditioners[level] =
-              std::make_shared<SmootherPreconditionerType>(std::move(patch_indices));
-            // smoother_preconditioners[level]->initialize(mg_matrices[level]->get_system_matrix(),
-            //                                             dsp,
-            //                                             inverse_diagonal,
-            //                                             all_indices_relevant);
-            smoother_preconditioners[level]->initialize(reduced_sparse_matrix,
-                                                        reduced_sparsity_pattern,
-                                                        inverse_diagonal,
-                                                        all_indices_relevant);
-          }
-        else
-          {
-            AssertThrow(false, ExcNotImplemented());
-          }
-      }
+      if constexpr (std::is_same_v<SmootherPreconditionerType, DiagonalMatrixTimer<VectorType>>)
+        {
+          level.smoother_preconditioner =
+            std::make_shared<SmootherPreconditionerType>(Instrumentation::vmult_diagonal_a_block);
+          level.level_operator->compute_inverse_diagonal(
+            level.smoother_preconditioner->get_vector());
+        }
+      else if constexpr (std::is_same_v<SmootherPreconditionerType, PreconditionASM<VectorType>> ||
+                         std::is_same_v<SmootherPreconditionerType,
+                                        PreconditionExtendedDiagonal<VectorType>>)
+        {
+          auto patch_indices = prepare_patch_indices(dof_handler, constraint);
+
+          if (is_finest_level)
+            Log::log_patch_dofs(patch_indices, dof_handler);
+
+          // Patch blocks are taken from a matrix that only couples patch DoFs. Its entries are
+          // computed matrix-free, so the full sparse matrix is never assembled on any level.
+
+          // reduced matrix
+          AffineConstraints<double> constraints_reduced;
+          constraints_reduced.reinit(partitioning.get_owned_dofs(),
+                                     partitioning.get_relevant_dofs());
+
+          const auto all_indices_relevant =
+            extract_relevant(patch_indices, partitioning, dof_handler);
+
+          IndexSet all_indices_assemble;
+          reduce_constraints(constraint,
+                             DoFTools::extract_locally_active_dofs(dof_handler),
+                             all_indices_relevant,
+                             constraints_reduced,
+                             all_indices_assemble);
+
+          // TODO: only works for Trilinos so far
+          typename LinearAlgebra::SparsityPattern reduced_sparsity_pattern;
+          reduced_sparsity_pattern.reinit(partitioning.get_owned_dofs(),
+                                          partitioning.get_owned_dofs(),
+                                          partitioning.get_relevant_dofs(),
+                                          dof_handler.get_communicator());
+          make_sparsity_pattern(dof_handler,
+                                all_indices_assemble,
+                                reduced_sparsity_pattern,
+                                constraints_reduced);
+          reduced_sparsity_pattern.compress();
+
+          typename LinearAlgebra::SparseMatrix reduced_sparse_matrix;
+          reduced_sparse_matrix.reinit(reduced_sparsity_pattern);
+          level.level_operator->compute_partial_matrix(all_indices_assemble,
+                                                       constraints_reduced,
+                                                       reduced_sparse_matrix);
+
+          VectorType inverse_diagonal;
+          level.level_operator->compute_inverse_diagonal(inverse_diagonal);
+
+          level.smoother_preconditioner =
+            std::make_shared<SmootherPreconditionerType>(std::move(patch_indices),
+                                                         mg_data.threaded_smoother_setup);
+
+          if constexpr (std::is_same_v<SmootherPreconditionerType, PreconditionASM<VectorType>>)
+            level.smoother_preconditioner->initialize(reduced_sparse_matrix,
+                                                      reduced_sparsity_pattern,
+                                                      dof_handler,
+                                                      &inverse_diagonal);
+          else
+            level.smoother_preconditioner->initialize(reduced_sparse_matrix,
+                                                      reduced_sparsity_pattern,
+                                                      inverse_diagonal,
+                                                      all_indices_relevant);
+        }
+      else
+        {
+          AssertThrow(false, ExcNotImplemented());
+        }
+    };
 
-    // Set up intergrid operators.
-    for (unsigned int level = minlevel; level < minlevel_p; ++level)
-      transfers[level + 1].reinit_geometric_transfer(dof_handlers[level + 1],
-                                                     dof_handlers[level],
-                                                     constraints[level + 1],
-                                                     constraints[level]);
-
-    for (unsigned int level = minlevel_p; level < maxlevel; ++level)
-      transfers[level + 1].reinit_polynomial_transfer(dof_handlers[level + 1],
-                                                      dof_handlers[level],
-                                                      constraints[level + 1],
-                                                      constraints[level]);
-
-    // Collect transfer operators within a single operator as needed by
-    // the Multigrid solver class.
-    MGTransferGlobalCoarsening<dim, VectorType> transfer(transfers, [&](const auto l, auto &vec) {
-      operators[l]->initialize_dof_vector(vec);
-    });
+    hierarchy.reinit(dof_handler, mg_data, setup_level);
+
+    const auto &operators                = hierarchy.get_operators();
+    const auto &smoother_preconditioners = hierarchy.get_smoother_preconditioners();
+    const auto &transfer                 = hierarchy.get_transfer();
+    auto       &eigenvalue_cache         = hierarchy.get_eigenvalue_cache();
+    const auto  min_level_p              = hierarchy.min_level_p();
 
     //
     // setup coarse solver
     //
 
     // using LevelMatrixType = StokesMatrixFree::ABlockOperator<dim, LinearAlgebra, spacedim>;
-    using LevelMatrixType = OperatorType<dim, LinearAlgebra, spacedim>;
-    using MGTransferType  = MGTransferGlobalCoarsening<dim, VectorType>;
+    using LevelMatrixType = OperatorType<dim, LevelLinearAlgebra, spacedim>;
+    using MGTransferType  = std::decay_t<decltype(transfer)>;
 
     using SmootherType =
       PreconditionChebyshev<LevelMatrixType, VectorType, SmootherPreconditionerType>;
@@ -507,9 +513,12 @@ namespace StokesMatrixFree
 
     for (unsigned int level = min_level; level <= max_level; level++)
       {
+        // Levels without smoothing still need a valid smoother, which is never applied.
+        const unsigned int degree = get_smoother_degree(mg_data, level, min_level_p);
+
         smoother_data[level].preconditioner      = smoother_preconditioners[level];
         smoother_data[level].smoothing_range     = mg_data.smoother.smoothing_range;
-        smoother_data[level].degree              = mg_data.smoother.degree;
+        smoother_data[level].degree              = (degree > 0) ? degree : mg_data.smoother.degree;
         smoother_data[level].eig_cg_n_iterations = mg_data.smoother.eig_cg_n_iterations;
       }
 
@@ -523,29 +532,46 @@ namespace StokesMatrixFree
       {
         for (unsigned int level = min_level + 1; level <= max_level; level++)
           {
-            SmootherType chebyshev;
-            chebyshev.initialize(*operators[level], smoother_data[level]);
+            // Levels without smoothing do not need eigenvalues.
+            if (get_smoother_degree(mg_data, level, min_level_p) == 0)
+              continue;
 
-            VectorType vec;
-            operators[level]->initialize_dof_vector(vec);
-            const auto evs = chebyshev.estimate_eigenvalues(vec);
+            // Only estimate eigenvalues of levels that did not appear before.
+            if (eigenvalue_cache.get(level, min_eigenvalues[level], max_eigenvalues[level]) ==
+                false)
+              {
+                SmootherType chebyshev;
+                chebyshev.initialize(*operators[level], smoother_data[level]);
 
-            min_eigenvalues[level] = evs.min_eigenvalue_estimate;
-            max_eigenvalues[level] = evs.max_eigenvalue_estimate;
+                VectorType vec;
+                operators[level]->initialize_dof_vector(vec);
+                const auto evs = chebyshev.estimate_eigenvalues(vec);
+
+                min_eigenvalues[level] = evs.min_eigenvalue_estimate;
+                max_eigenvalues[level] = evs.max_eigenvalue_estimate;
+
+                eigenvalue_cache.set(level, min_eigenvalues[level], max_eigenvalues[level]);
+              }
 
             // We already computed eigenvalues, reset the one in the actual smoother
             smoother_data[level].eig_cg_n_iterations = 0;
-            smoother_data[level].max_eigenvalue      = evs.max_eigenvalue_estimate * 1.1;
+            smoother_data[level].max_eigenvalue      = max_eigenvalues[level] * 1.1;
           }
 
-        // log maximum over all levels
-        const double max = *std::max_element(++(max_eigenvalues.begin()), max_eigenvalues.end());
+        // log maximum over all smoothed levels
+        double max = 0.;
+        for (unsigned int level = min_level + 1; level <= max_level; level++)
+          if (std::isnan(max_eigenvalues[level]) == false)
+            max = std::max(max, max_eigenvalues[level]);
         getPCOut() << "   Max EV on all MG levels:      " << max << std::endl;
         getTable().add_value("max_ev", max);
+        getTable().add_value("ev_cache_hits", eigenvalue_cache.n_hits());
+        getTable().add_value("ev_cache_misses", eigenvalue_cache.n_misses());
       }
     // ----------
 
-    MGSmootherRelaxation<LevelMatrixType, SmootherType, VectorType> mg_smoother;
+    MGSmootherSkipLevels<LevelMatrixType, SmootherType, VectorType> mg_smoother(mg_data,
+                                                                                min_level_p);
     mg_smoother.initialize(operators, smoother_data);
 
     // Initialize coarse-grid solver.
@@ -557,112 +583,157 @@ namespace StokesMatrixFree
     SolverCG<VectorType> coarse_grid_solver(coarse_grid_solver_control);
 
     std::unique_ptr<MGCoarseGridBase<VectorType>> mg_coarse;
+    auto &coarse_agglomeration = hierarchy.get_coarse_agglomeration();
 #ifdef DEAL_II_WITH_TRILINOS
-    TrilinosWrappers::PreconditionAMG                 precondition_amg;
-    TrilinosWrappers::PreconditionAMG::AdditionalData amg_data;
-    amg_data.smoother_sweeps = mg_data.coarse_solver.smoother_sweeps;
-    amg_data.n_cycles        = mg_data.coarse_solver.n_cycles;
-    amg_data.smoother_type   = mg_data.coarse_solver.smoother_type.c_str();
-
-    // CG with AMG as preconditioner
-    precondition_amg.initialize(operators[min_level]->get_system_matrix(), amg_data);
-
-    mg_coarse = std::make_unique<MGCoarseGridIterativeSolver<VectorType,
-                                                             SolverCG<VectorType>,
-                                                             LevelMatrixType,
-                                                             decltype(precondition_amg)>>(
-      coarse_grid_solver, *operators[min_level], precondition_amg);
-#endif
+    auto &coarse_amg = hierarchy.get_coarse_amg();
 
-    // Create multigrid object.
-    Multigrid<VectorType> mg_a_block(mg_matrix, *mg_coarse, transfer, mg_smoother, mg_smoother);
+    // AMG only works on double precision vectors
+    PreconditionMixedPrecision<VectorType, TrilinosWrappers::PreconditionAMG>
+      precondition_amg_mixed(coarse_amg.get_preconditioner());
 
-    // ----------
-    // TODO: timing based on peters dealii-multigrid
-    // https://github.com/peterrum/dealii-multigrid/blob/c50581883c0dbe35c83132699e6de40da9b1b255/multigrid_throughput.cc#L1183-L1192
-    std::vector<std::vector<std::pair<double, std::chrono::time_point<std::chrono::system_clock>>>>
-      all_mg_timers(max_level - min_level + 1);
-
-    for (unsigned int i = 0; i < all_mg_timers.size(); ++i)
-      all_mg_timers[i].resize(7);
-
-    if (mg_data.log_levels == true)
+    if (mg_data.coarse_solver_ranks > 0)
       {
-        const auto create_mg_timer_function = [&](const unsigned int i, const std::string &label) {
-          return [i, label, &all_mg_timers](const bool flag, const unsigned int level) {
-            // if (false && flag)
-            //   std::cout << label << " " << level << std::endl;
-            if (flag)
-              all_mg_timers[level][i].second = std::chrono::system_clock::now();
-            else
-              all_mg_timers[level][i].first +=
-                std::chrono::duration_cast<std::chrono::nanoseconds>(
-                  std::chrono::system_clock::now() - all_mg_timers[level][i].second)
-                  .count() /
-                1e9;
-          };
-        };
-
-        mg_a_block.connect_pre_smoother_step(create_mg_timer_function(0, "pre_smoother_step"));
-        mg_a_block.connect_residual_step(create_mg_timer_function(1, "residual_step"));
-        mg_a_block.connect_restriction(create_mg_timer_function(2, "restriction"));
-        mg_a_block.connect_coarse_solve(create_mg_timer_function(3, "coarse_solve"));
-        mg_a_block.connect_prolongation(create_mg_timer_function(4, "prolongation"));
-        mg_a_block.connect_edge_prolongation(create_mg_timer_function(5, "edge_prolongation"));
-        mg_a_block.connect_post_smoother_step(create_mg_timer_function(6, "post_smoother_step"));
+        // CG on a subset of ranks, which keeps the redistributed matrix, its
+        // communicator and AMG as long as the coarse level does not change
+        if (coarse_agglomeration == nullptr)
+          coarse_agglomeration = std::make_shared<MGCoarseGridAgglomeration<VectorType>>(
+            operators[min_level]->get_system_matrix(), mg_data);
       }
-    // ----------
+    else
+      {
+        TrilinosWrappers::PreconditionAMG::AdditionalData amg_data;
+        amg_data.smoother_sweeps = mg_data.coarse_solver.smoother_sweeps;
+        amg_data.n_cycles        = mg_data.coarse_solver.n_cycles;
+        amg_data.smoother_type   = mg_data.coarse_solver.smoother_type.c_str();
+
+        // CG with AMG as preconditioner, which is only set up again if the
+        // coarse matrix changed
+        const auto setup =
+          coarse_amg.initialize(operators[min_level]->get_system_matrix(), amg_data);
+        getTable().add_value("coarse_amg_setup", coarse_amg.get_name(setup));
+
+        mg_coarse = std::make_unique<MGCoarseGridIterativeSolver<VectorType,
+                                                                 SolverCG<VectorType>,
+                                                                 LevelMatrixType,
+                                                                 decltype(precondition_amg_mixed)>>(
+          coarse_grid_solver, *operators[min_level], precondition_amg_mixed);
+      }
+#endif
+
+    // Create multigrid object.
+    Multigrid<VectorType> mg_a_block(mg_matrix,
+                                     mg_coarse ? *mg_coarse : *coarse_agglomeration,
+                                     transfer,
+                                     mg_smoother,
+                                     mg_smoother,
+                                     min_level,
+                                     max_level,
+                                     get_mg_cycle<VectorType>(mg_data));
+
+    // Record the timings of each step of the multigrid cycle on each level.
+    MGLevelProfiler profiler(max_level - min_level + 1);
+    if (mg_data.log_levels == true)
+      profiler.connect(mg_a_block);
 
     // Convert it to a preconditioner.
     PreconditionerType a_block_preconditioner(dof_handler, mg_a_block, transfer);
 
-    DiagonalMatrixTimer<VectorType> inv_diagonal("vmult_diagonal_SchurBlock");
-    schur_block_operator.compute_inverse_diagonal(inv_diagonal.get_vector());
+    const auto solve = [&](const auto &schur_block_preconditioner) {
+      const BlockSchurPreconditioner<LinearAlgebra,
+                                     StokesMatrixFree::StokesOperator<dim, LinearAlgebra, spacedim>,
+                                     OperatorType<dim, LinearAlgebra, spacedim>,
+                                     OperatorType<dim, LinearAlgebra, spacedim>,
+                                     PreconditionerType,
+                                     std::decay_t<decltype(schur_block_preconditioner)>>
+        preconditioner(stokes_operator,
+                       a_block_operator,
+                       schur_block_operator,
+                       a_block_preconditioner,
+                       schur_block_preconditioner,
+                       prm_block_schur);
+
+      // set up solver
+      dealii::PrimitiveVectorMemory<typename LinearAlgebra::BlockVector> mem;
+
+      typename dealii::SolverFGMRES<typename LinearAlgebra::BlockVector>::AdditionalData
+        fgmres_data(50);
+      dealii::SolverFGMRES<typename LinearAlgebra::BlockVector> solver(solver_control_refined,
+                                                                       mem,
+                                                                       fgmres_data);
+      connect_outer_residual(solver, preconditioner);
+
+      solver.solve(stokes_operator, dst, src, preconditioner);
+    };
 
-    PreconditionJacobi<DiagonalMatrixTimer<VectorType>> schur_block_preconditioner;
-    schur_block_preconditioner.initialize(inv_diagonal);
+    using SchurVectorType = typename LinearAlgebra::Vector;
 
-    const BlockSchurPreconditioner<LinearAlgebra,
-                                   StokesMatrixFree::StokesOperator<dim, LinearAlgebra, spacedim>,
-                                   OperatorType<dim, LinearAlgebra, spacedim>,
-                                   OperatorType<dim, LinearAlgebra, spacedim>,
-                                   PreconditionerType,
-                                   PreconditionJacobi<DiagonalMatrixTimer<VectorType>>>
-      preconditioner(stokes_operator,
-                     a_block_operator,
-                     schur_block_operator,
-                     a_block_preconditioner,
-                     schur_block_preconditioner,
-                     /*do_solve_A=*/false,
-                     /*do_solve_Schur_complement=*/true);
+    if (prm_block_schur.schur_complement_preconditioner == "jacobi")
+      {
+        DiagonalMatrixTimer<SchurVectorType> inv_diagonal(
+          Instrumentation::vmult_diagonal_schur_block);
+        schur_block_operator.compute_inverse_diagonal(inv_diagonal.get_vector());
 
-    // set up solver
-    dealii::PrimitiveVectorMemory<typename LinearAlgebra::BlockVector> mem;
+        PreconditionJacobi<DiagonalMatrixTimer<SchurVectorType>> schur_block_preconditioner;
+        schur_block_preconditioner.initialize(inv_diagonal);
 
-    typename dealii::SolverFGMRES<typename LinearAlgebra::BlockVector>::AdditionalData fgmres_data(
-      50);
-    dealii::SolverFGMRES<typename LinearAlgebra::BlockVector> solver(solver_control_refined,
-                                                                     mem,
-                                                                     fgmres_data);
+        solve(schur_block_preconditioner);
+      }
+    else if (prm_block_schur.schur_complement_preconditioner == "chebyshev")
+      {
+        // Chebyshev iteration on the pressure mass matrix over its whole
+        // spectrum, which the diagonal keeps narrow
+        using SchurPreconditionerType =
+          PreconditionChebyshev<OperatorType<dim, LinearAlgebra, spacedim>,
+                                SchurVectorType,
+                                DiagonalMatrixTimer<SchurVectorType>>;
+
+        typename SchurPreconditionerType::AdditionalData chebyshev_data;
+        chebyshev_data.preconditioner = std::make_shared<DiagonalMatrixTimer<SchurVectorType>>(
+          Instrumentation::vmult_diagonal_schur_block);
+        schur_block_operator.compute_inverse_diagonal(chebyshev_data.preconditioner->get_vector());
+        chebyshev_data.degree              = prm_block_schur.schur_complement_chebyshev_degree;
+        chebyshev_data.smoothing_range     = 0.; // estimate both ends of the spectrum
+        chebyshev_data.eig_cg_n_iterations = mg_data.smoother.eig_cg_n_iterations;
+
+        SchurPreconditionerType schur_block_preconditioner;
+        schur_block_preconditioner.initialize(schur_block_operator, chebyshev_data);
+
+        solve(schur_block_preconditioner);
+      }
+    else
+      {
+        AssertThrow(false,
+                    ExcMessage("Unknown Schur complement preconditioner: " +
+                               prm_block_schur.schur_complement_preconditioner));
+      }
 
-    solver.solve(stokes_operator, dst, src, preconditioner);
+    hierarchy.log_memory_consumption();
+
+    // dump to Table and JSON file
+    if (mg_data.log_levels == true)
+      {
+        std::vector<types::global_dof_index> n_dofs;
+        for (unsigned int level = min_level; level <= max_level; ++level)
+          n_dofs.push_back(operators[level]->m());
+
+        std::string filename_json = filename_mg_level;
+        if (const auto pos = filename_json.rfind(".log"); pos != std::string::npos)
+          filename_json.erase(pos);
+        profiler.write_json(filename_json + ".json", n_dofs, dof_handler.get_communicator());
+      }
 
-    // ----------
-    // dump to Table and then file system
     if ((mg_data.log_levels == true) &&
         (Utilities::MPI::this_mpi_process(dof_handler.get_communicator()) == 0))
       {
         dealii::ConvergenceTable table;
-        for (unsigned int level = 0; level < all_mg_timers.size(); ++level)
+        for (unsigned int level = 0; level < profiler.n_levels(); ++level)
           {
             table.add_value("level", level);
-            table.add_value("pre_smoother_step", all_mg_timers[level][0].first);
-            table.add_value("residual_step", all_mg_timers[level][1].first);
-            table.add_value("restriction", all_mg_timers[level][2].first);
-            table.add_value("coarse_solve", all_mg_timers[level][3].first);
-            table.add_value("prolongation", all_mg_timers[level][4].first);
-            table.add_value("edge_prolongation", all_mg_timers[level][5].first);
-            table.add_value("post_smoother_step", all_mg_timers[level][6].first);
+            for (unsigned int step = 0; step < MGLevelProfiler::n_steps; ++step)
+              {
+                const auto s = static_cast<MGLevelProfiler::Step>(step);
+                table.add_value(MGLevelProfiler::get_name(s), profiler.get_wall_time(level, s));
+              }
             if (mg_data.estimate_eigenvalues == true)
               {
                 table.add_value("min_eigenvalue", min_eigenvalues[level]);
@@ -672,7 +743,174 @@ namespace StokesMatrixFree
         std::ofstream mg_level_stream(filename_mg_level);
         table.write_text(mg_level_stream);
       }
-    // ----------
+  }
+
+
+
+  /**
+   * Solve with monolithic multigrid, in which the whole Stokes operator is the
+   * level operator. A cell-based Vanka smoother acts on velocity and pressure
+   * at once, see PreconditionVanka, and replaces the block preconditioner and
+   * its inner solves.
+   *
+   * Coarser meshes carry the lowest Taylor-Hood pair of the FE collections,
+   * finer levels lower the polynomial degrees on the fine mesh down to it.
+   * Each level assembles its saddle point matrix for the patch inverses. The
+   * coarsest level is solved with GMRES and its Vanka smoother as
+   * preconditioner. The hierarchy, see MGHierarchyMonolithic, is stored in
+   * @p mg_hierarchy and reused across calls like in solve_gmg().
+   */
+  template <int dim, typename LinearAlgebra, int spacedim = dim>
+  static void
+  solve_gmg_monolithic(
+    dealii::SolverControl                                        &solver_control_refined,
+    const StokesOperator<dim, LinearAlgebra, spacedim>           &stokes_operator,
+    typename LinearAlgebra::BlockVector                          &dst,
+    const typename LinearAlgebra::BlockVector                    &src,
+    const MGSolverParameters                                     &mg_data,
+    const MonolithicParameters                                   &prm_monolithic,
+    const dealii::hp::MappingCollection<dim, spacedim>           &mapping_collection,
+    const std::vector<dealii::hp::QCollection<dim>>              &quadrature_collections,
+    const std::vector<const dealii::DoFHandler<dim, spacedim> *> &stokes_dof_handlers,
+    std::unique_ptr<MGHierarchyBase>                             &mg_hierarchy)
+  {
+    using namespace dealii;
+
+    using HierarchyType              = MGHierarchyMonolithic<dim, LinearAlgebra, spacedim>;
+    using Level                      = typename HierarchyType::Level;
+    using BlockVectorType            = typename HierarchyType::BlockVectorType;
+    using LevelMatrixType            = typename HierarchyType::LevelOperatorType;
+    using SmootherPreconditionerType = typename HierarchyType::SmootherPreconditionerType;
+    using MGTransferType             = typename HierarchyType::MGTransferType;
+
+    AssertThrow(mg_data.mixed_precision == false,
+                ExcMessage("Monolithic multigrid is only available in double precision!"));
+
+    const DoFHandler<dim, spacedim> &dof_handler_v = *(stokes_dof_handlers[0]);
+    const DoFHandler<dim, spacedim> &dof_handler_p = *(stokes_dof_handlers[1]);
+
+    if (dynamic_cast<HierarchyType *>(mg_hierarchy.get()) == nullptr)
+      mg_hierarchy = std::make_unique<HierarchyType>();
+    auto &hierarchy = static_cast<HierarchyType &>(*mg_hierarchy);
+
+    // Set up constraints, operator and smoother on each level that changed.
+    const auto setup_level = [&](Level &level) {
+      const MPI_Comm communicator = level.dof_handler_v.get_communicator();
+
+      // homogeneous Dirichlet BC on the velocity at the boundaries of
+      // setup_system(), hanging nodes on both
+      level.constraints_v.reinit(level.partitioning_v.get_relevant_dofs());
+      DoFTools::make_hanging_node_constraints(level.dof_handler_v, level.constraints_v);
+      for (const types::boundary_id boundary_id : {0, 3})
+        DoFTools::make_zero_boundary_constraints(level.dof_handler_v,
+                                                 boundary_id,
+                                                 level.constraints_v);
+      level.constraints_v.close();
+
+      level.constraints_p.reinit(level.partitioning_p.get_relevant_dofs());
+      DoFTools::make_hanging_node_constraints(level.dof_handler_p, level.constraints_p);
+      level.constraints_p.close();
+
+      level.level_operator =
+        std::make_shared<LevelMatrixType>(mapping_collection, quadrature_collections);
+      level.level_operator->reinit(level.partitionings, level.dof_handlers, level.constraints);
+
+      // Vanka patches need the whole saddle point matrix
+      level.numbering.reinit(
+        {level.partitioning_v.get_owned_dofs(), level.partitioning_p.get_owned_dofs()},
+        {level.partitioning_v.get_relevant_dofs(), level.partitioning_p.get_relevant_dofs()},
+        communicator);
+
+      typename LinearAlgebra::SparsityPattern sparsity_pattern;
+      typename LinearAlgebra::SparseMatrix    system_matrix;
+      level.level_operator->compute_monolithic_matrix(level.numbering,
+                                                      sparsity_pattern,
+                                                      system_matrix);
+
+      level.smoother_preconditioner = std::make_shared<SmootherPreconditionerType>(
+        prepare_vanka_patch_indices(level.dof_handler_v,
+                                    level.dof_handler_p,
+                                    level.constraints_v,
+                                    level.constraints_p,
+                                    level.numbering),
+        mg_data.threaded_smoother_setup);
+      level.smoother_preconditioner->initialize(system_matrix,
+                                                sparsity_pattern,
+                                                level.numbering,
+                                                communicator);
+    };
+
+    hierarchy.reinit(dof_handler_v, dof_handler_p, mg_data, setup_level);
+
+    const auto        &operators   = hierarchy.get_operators();
+    const auto        &transfer    = hierarchy.get_transfer();
+    const unsigned int min_level   = hierarchy.min_level();
+    const unsigned int min_level_p = hierarchy.min_level_p();
+    const unsigned int max_level   = hierarchy.max_level();
+
+    // Initialize level operators.
+    mg::Matrix<BlockVectorType> mg_matrix(operators);
+
+    // Initialize smoothers, i.e., Richardson iterations with the Vanka
+    // smoother as preconditioner.
+    using SmootherType = PreconditionRelaxation<LevelMatrixType, SmootherPreconditionerType>;
+
+    MGLevelObject<typename SmootherType::AdditionalData> smoother_data(min_level, max_level);
+    for (unsigned int level = min_level; level <= max_level; level++)
+      {
+        // Levels without smoothing still need a valid smoother, which is never applied.
+        const unsigned int degree = get_smoother_degree(mg_data, level, min_level_p);
+
+        smoother_data[level].preconditioner =
+          hierarchy.get_level(level).smoother_preconditioner;
+        smoother_data[level].relaxation   = prm_monolithic.vanka_relaxation;
+        smoother_data[level].n_iterations = (degree > 0) ? degree : mg_data.smoother.degree;
+      }
+
+    MGSmootherSkipLevels<LevelMatrixType, SmootherType, BlockVectorType> mg_smoother(mg_data,
+                                                                                     min_level_p);
+    mg_smoother.initialize(operators, smoother_data);
+
+    // Initialize coarse-grid solver.
+    ReductionControl coarse_grid_solver_control(mg_data.coarse_solver.maxiter,
+                                                mg_data.coarse_solver.abstol,
+                                                mg_data.coarse_solver.reltol,
+                                                /*log_history=*/true,
+                                                /*log_result=*/true);
+    SolverGMRES<BlockVectorType> coarse_grid_solver(coarse_grid_solver_control);
+
+    MGCoarseGridIterativeSolver<BlockVectorType,
+                                SolverGMRES<BlockVectorType>,
+                                LevelMatrixType,
+                                SmootherPreconditionerType>
+      mg_coarse(coarse_grid_solver,
+                *operators[min_level],
+                *hierarchy.get_level(min_level).smoother_preconditioner);
+
+    // Create multigrid object.
+    Multigrid<BlockVectorType> mg(mg_matrix,
+                                  mg_coarse,
+                                  transfer,
+                                  mg_smoother,
+                                  mg_smoother,
+                                  min_level,
+                                  max_level,
+                                  get_mg_cycle<BlockVectorType>(mg_data));
+
+    // Convert it to a preconditioner.
+    PreconditionMG<dim, BlockVectorType, MGTransferType> preconditioner(stokes_dof_handlers,
+                                                                        mg,
+                                                                        transfer);
+
+    // set up solver
+    PrimitiveVectorMemory<BlockVectorType> mem;
+
+    typename SolverFGMRES<BlockVectorType>::AdditionalData fgmres_data(50);
+    SolverFGMRES<BlockVectorType> solver(solver_control_refined, mem, fgmres_data);
+
+    solver.solve(stokes_operator, dst, src, preconditioner);
+
+    hierarchy.log_memory_consumption();
   }
 } // namespace StokesMatrixFree
 
@@ -18,7 +18,7 @@ import pandas as pd
 
 
 
-def build_dataframe(root, extension = "log"):
+def build_dataframe(root, extension = "log", exclude = "-mglevel-"):
   '''
   Generate a pandas.DataFrame from a set of log files.
   
@@ -26,7 +26,10 @@ def build_dataframe(root, extension = "log"):
   one row in the DataFrame object.
   
   All files with the file extenstion 'extension' in the folder 'root'
-  will be considered. Nested directories will be ignored.
+  will be considered. Nested directories will be ignored. Files with
+  extension 'jsonl' are read as one JSON object per cycle, as written
+  with the parameter 'log format = jsonl'. Columns missing in some of
+  the cycles are filled with NaN.
 
   Parameters
   ----------
@@ -34,7 +37,11 @@ def build_dataframe(root, extension = "log"):
     Path to the directory that will be scanned for files. No nested
     directories will be considered.
   extension : string
-    Only files with this extension will be considered.
+    Only files with this extension will be considered, either a text
+    table like 'log' or 'jsonl'.
+  exclude : string
+    Files containing this string will be ignored. By default, these are
+    the per-level multigrid tables, which come with different columns.
 
   Returns
   -------
@@ -43,10 +50,14 @@ def build_dataframe(root, extension = "log"):
   '''
   # get list of all files
   filenames = [os.path.join(root, f) for f in os.listdir(root)
-               if f.lower().endswith('.'+extension)]
+               if f.lower().endswith('.'+extension)
+               and (not exclude or exclude not in f)]
     
   # read first dataframe entirely and use first row as header
-  df = [pd.read_table(f, delim_whitespace=True) for f in filenames]
+  if extension.lower() == "jsonl":
+    df = [pd.read_json(f, lines=True) for f in filenames]
+  else:
+    df = [pd.read_table(f, delim_whitespace=True) for f in filenames]
   return pd.concat(df, ignore_index=True)
 
 
@@ -125,6 +136,99 @@ def reduce_dataframe(df, multiindex, parameters, check_errors=True):
 
 
 
+def summarize_memory(df, statistic = "max"):
+  '''
+  Extract the memory consumption of all subsystems from a pandas.DataFrame.
+
+  Each cycle row contains columns 'memory_<subsystem>_<statistic>' in MB,
+  reduced over all processes as minimum, maximum and average.
+
+  Parameters
+  ----------
+  df : pandas.DataFrame
+    DataFrame to work with. Will not be changed.
+  statistic : string
+    One of 'min', 'max' or 'avg'.
+
+  Returns
+  -------
+  df_memory : pandas.DataFrame
+    DataFrame with one column per subsystem, named after the subsystem.
+  '''
+  prefix = "memory_"
+  suffix = "_" + statistic
+  columns = [c for c in df.columns if c.startswith(prefix) and c.endswith(suffix)]
+
+  df_memory = df[columns].copy()
+  df_memory.columns = [c[len(prefix):-len(suffix)] for c in columns]
+  return df_memory
+
+
+
+def build_mglevel_dataframe(root):
+  '''
+  Generate a pandas.DataFrame from all per-level multigrid tables.
+
+  These are the files '<stem>-mglevel-cycle_<cycle>.log' written with the
+  parameter 'log levels'. Each level of each file makes up one row, with
+  additional columns 'stem' and 'cycle' derived from the filename.
+
+  Parameters
+  ----------
+  root : string
+    Path to the directory that will be scanned for files. No nested
+    directories will be considered.
+
+  Returns
+  -------
+  df : pandas.DataFrame
+    DataFrame containing data from all considered files.
+  '''
+  df = []
+  for f in os.listdir(root):
+    stem, separator, cycle = f.rpartition("-mglevel-cycle_")
+    if not separator or not cycle.endswith(".log"):
+      continue
+
+    df_file = pd.read_table(os.path.join(root, f), delim_whitespace=True)
+    df_file["stem"] = stem
+    df_file["cycle"] = int(cycle[:-len(".log")])
+    df.append(df_file)
+
+  return pd.concat(df, ignore_index=True)
+
+
+
+def summarize_phases(df, phases, statistic = "max"):
+  '''
+  Extract the wall times of certain phases from a pandas.DataFrame.
+
+  Each cycle row contains columns '<phase>_<statistic>' in seconds,
+  reduced over all processes as minimum, maximum and average.
+
+  Parameters
+  ----------
+  df : pandas.DataFrame
+    DataFrame to work with. Will not be changed.
+  phases : list of strings
+    Names of the timer sections, e.g., 'solve' or 'setup_system'.
+    Phases missing in the DataFrame will be skipped.
+  statistic : string
+    One of 'min', 'max' or 'avg'.
+
+  Returns
+  -------
+  df_phases : pandas.DataFrame
+    DataFrame with one column per phase, named after the phase.
+  '''
+  columns = [p for p in phases if p + "_" + statistic in df.columns]
+
+  df_phases = df[[p + "_" + statistic for p in columns]].copy()
+  df_phases.columns = columns
+  return df_phases
+
+
+
 def plot_dataframe(df, xylist):
   '''
   Present columns from a pandas.DataFrame in a double logarithmic plot.
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+scaling.py
+------------------------
+Run the Fichera, Kovasznay and Y-pipe configurations from the test
+parameter files at different numbers of processes and problem sizes,
+and summarize strong and weak scaling of their phases.
+"""
+
+
+
+import argparse
+import os
+import re
+import subprocess
+
+import pandas as pd
+
+from postprocess import build_dataframe, build_mglevel_dataframe, summarize_phases
+
+
+
+
+
+CONFIGURATIONS = {
+  "fichera"   : "fichera_matrixfree_gmg_extended.prm",
+  "kovasznay" : "kovasznay_matrixfree_gmg_extended.prm",
+  "ypipe"     : "ypipe_matrixfree_gmg_extended.prm",
+}
+
+PHASES = ["setup_system", "solve", "estimate_mark", "refine", "full_cycle"]
+
+
+
+def write_parameter_file(template, filename, stem, n_refinements):
+  '''
+  Write a copy of a parameter file with a different file stem and with
+  min and max level raised by a number of refinements. Per-level
+  multigrid tables are enabled.
+
+  Parameters
+  ----------
+  template : string
+    Path to the parameter file to start from.
+  filename : string
+    Path to the parameter file that will be written.
+  stem : string
+    File stem of the run, which identifies its log files.
+  n_refinements : int
+    Number of additional global refinements.
+  '''
+  with open(template) as f:
+    content = f.read()
+
+  levels = {}
+  for key in ["min level", "max level"]:
+    match = re.search(r"set " + key + r"\s*=\s*(\d+)", content)
+    if match:
+      levels[key] = int(match.group(1)) + n_refinements
+
+  # entering a subsection again overrides previous entries
+  with open(filename, "w") as f:
+    f.write(content)
+    f.write("subsection input output\n")
+    f.write("  set file stem = " + stem + "\n")
+    f.write("end\n")
+    f.write("subsection multigrid\n")
+    f.write("  set log levels = true\n")
+    f.write("end\n")
+    if levels:
+      f.write("subsection adaptation\n")
+      for key, value in levels.items():
+        f.write("  set " + key + " = " + str(value) + "\n")
+      f.write("end\n")
+
+
+
+def run(executable, tests, output, configurations, ranks, refinements, mpirun = "mpirun"):
+  '''
+  Run all combinations of configurations, numbers of processes and
+  problem sizes in the directory 'output'.
+
+  The stem of each run is '<configuration>-np<ranks>-r<refinements>'.
+
+  Parameters
+  ----------
+  executable : string
+    Path to the hprun executable.
+  tests : string
+    Directory with the parameter files in CONFIGURATIONS.
+  output : string
+    Directory for parameter and log files.
+  configurations : list of strings
+    Keys of CONFIGURATIONS.
+  ranks : list of int
+    Numbers of processes.
+  refinements : list of int
+    Numbers of additional global refinements.
+  mpirun : string
+    MPI launcher.
+  '''
+  os.makedirs(output, exist_ok=True)
+
+  for configuration in configurations:
+    for r in refinements:
+      for np in ranks:
+        stem = configuration + "-np" + str(np) + "-r" + str(r)
+        filename = os.path.join(output, stem + ".prm")
+        write_parameter_file(os.path.join(tests, CONFIGURATIONS[configuration]),
+                             filename, stem, r)
+
+        print("Running " + stem + "...", flush=True)
+        subprocess.run([mpirun, "-np", str(np), os.path.abspath(executable),
+                        os.path.basename(filename)],
+                       cwd=output, check=True, stdout=subprocess.DEVNULL)
+
+
+
+def scaling_reports(df, configurations, ranks, refinements, phases = PHASES):
+  '''
+  Summarize the wall times of the last cycle of each run.
+
+  Strong scaling compares all numbers of processes at the same problem
+  size. Weak scaling pairs the i-th number of processes with the i-th
+  number of refinements, so that the work per process stays roughly
+  constant.
+
+  Parameters
+  ----------
+  df : pandas.DataFrame
+    DataFrame from all cycle tables, see build_dataframe().
+  configurations, ranks, refinements : list
+    See run().
+  phases : list of strings
+    Timer sections to report.
+
+  Returns
+  -------
+  strong, weak : pandas.DataFrame
+    Maximum wall time over all processes, speedup and parallel
+    efficiency of each phase, indexed by configuration, refinements and
+    processes.
+  '''
+  df_last = df.loc[df.groupby("stem")["cycle"].idxmax()]
+  df_last = df_last.set_index("stem")
+
+  def report(runs):
+    rows = []
+    for configuration, r, np, np_base, stem_base in runs:
+      stem = configuration + "-np" + str(np) + "-r" + str(r)
+      if stem not in df_last.index or stem_base not in df_last.index:
+        continue
+
+      times = summarize_phases(df_last.loc[[stem]], phases).iloc[0]
+      times_base = summarize_phases(df_last.loc[[stem_base]], phases).iloc[0]
+
+      row = {"configuration": configuration, "refinements": r, "processes": np,
+             "dofs": df_last.loc[stem, "dofs"]}
+      for phase in times.index:
+        row[phase] = times[phase]
+        row[phase + "_speedup"] = times_base[phase] / times[phase]
+        row[phase + "_efficiency"] = row[phase + "_speedup"] * np_base / np
+      rows.append(row)
+
+    if not rows:
+      return pd.DataFrame()
+    return pd.DataFrame(rows).set_index(["configuration", "refinements", "processes"])
+
+  strong = report([(c, r, np, ranks[0], c + "-np" + str(ranks[0]) + "-r" + str(r))
+                   for c in configurations for r in refinements for np in ranks])
+
+  # the efficiency of weak scaling is the ratio of wall times
+  weak = report([(c, r, np, np, c + "-np" + str(ranks[0]) + "-r" + str(refinements[0]))
+                 for c in configurations for np, r in zip(ranks, refinements)])
+  weak = weak[[c for c in weak.columns if not c.endswith("_speedup")]]
+
+  return strong, weak
+
+
+
+def mglevel_breakdown(root):
+  '''
+  Sum up the wall times of all steps of the multigrid cycle over all
+  levels, for each run and cycle.
+
+  Parameters
+  ----------
+  root : string
+    Directory with the per-level tables.
+
+  Returns
+  -------
+  df : pandas.DataFrame
+    DataFrame indexed by stem and cycle.
+  '''
+  df = build_mglevel_dataframe(root)
+  df = df.drop(columns=[c for c in ["level", "min_eigenvalue", "max_eigenvalue"]
+                        if c in df.columns])
+  return df.groupby(["stem", "cycle"]).sum()
+
+
+
+
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser(description=__doc__,
+                                   formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument("--executable", default="hprun")
+  parser.add_argument("--tests", default=os.path.join(os.path.dirname(__file__),
+                                                      "..", "tests", "hprun"))
+  parser.add_argument("--output", default="scaling")
+  parser.add_argument("--mpirun", default="mpirun")
+  parser.add_argument("--configurations", default=",".join(CONFIGURATIONS))
+  parser.add_argument("--ranks", default="1,2,4")
+  parser.add_argument("--refinements", default="0,1,2")
+  parser.add_argument("--skip-runs", action="store_true",
+                      help="only summarize previously written log files")
+  args = parser.parse_args()
+
+  configurations = args.configurations.split(",")
+  ranks = [int(np) for np in args.ranks.split(",")]
+  refinements = [int(r) for r in args.refinements.split(",")]
+
+  '''
+  RUN
+  '''
+  if not args.skip_runs:
+    run(args.executable, args.tests, args.output, configurations, ranks, refinements,
+        args.mpirun)
+
+  '''
+  SUMMARIZE
+  '''
+  df_full = build_dataframe(args.output)
+  strong, weak = scaling_reports(df_full, configurations, ranks, refinements)
+
+  strong.to_csv(os.path.join(args.output, "strong_scaling.csv"))
+  weak.to_csv(os.path.join(args.output, "weak_scaling.csv"))
+  summarize_phases(df_full.set_index(["stem", "cycle"]), PHASES).to_csv(
+    os.path.join(args.output, "phases.csv"))
+
+  try:
+    mglevel_breakdown(args.output).to_csv(os.path.join(args.output, "mglevel.csv"))
+  except ValueError:
+    # no per-level tables have been written
+    pass
+
+  pd.set_option("display.width", 200)
+  print("\nStrong scaling:\n", strong, sep="")
+  print("\nWeak scaling:\n", weak, sep="")
@@ -17,14 +17,15 @@
 #include <deal.II/base/exceptions.h>
 #include <deal.II/base/quadrature_lib.h>
 
-#include <deal.II/distributed/grid_refinement.h>
-
 #include <deal.II/hp/refinement.h>
 
 #include <deal.II/numerics/error_estimator.h>
 #include <deal.II/numerics/smoothness_estimator.h>
 
+#include <adaptation/fe_series_cache.h>
 #include <adaptation/hp_fourier.h>
+#include <adaptation/kelly_matrixfree.h>
+#include <adaptation/marking.h>
 #include <global.h>
 #include <linear_algebra.h>
 
@@ -62,8 +63,8 @@ namespace Adaptation
                         "only one component."));
 
     // like SmoothnessEstimator::default_fe_series(), but with component_mask
+    std::vector<unsigned int> n_coefficients_per_direction;
     {
-      std::vector<unsigned int> n_coefficients_per_direction;
       for (unsigned int i = 0; i < fe_collection.size(); ++i)
         n_coefficients_per_direction.push_back(fe_collection[i].degree + 2);
 
@@ -98,10 +99,12 @@ namespace Adaptation
         });
       }
 
-    {
-      TimerOutput::Scope t(getTimer(), "calculate_transformation");
-      fourier->precalculate_all_transformation_matrices();
-    }
+    precalculate_transformation_matrices(*fourier,
+                                         "fourier",
+                                         fe_collection,
+                                         n_coefficients_per_direction,
+                                         prm.fe_series_cache_directory,
+                                         triangulation.get_communicator());
   }
 
 
@@ -115,23 +118,31 @@ namespace Adaptation
     // error estimates
     error_estimates.grow_or_shrink(triangulation->n_active_cells());
 
-    KellyErrorEstimator<dim, spacedim>::estimate(
-      *dof_handler,
-      face_quadrature_collection,
-      std::map<types::boundary_id, const Function<dim> *>(),
-      *locally_relevant_solution,
-      error_estimates,
-      component_mask,
-      /*coefficients=*/nullptr,
-      /*n_threads=*/numbers::invalid_unsigned_int,
-      /*subdomain_id=*/numbers::invalid_subdomain_id,
-      /*material_id=*/numbers::invalid_material_id,
-      /*strategy=*/
-      KellyErrorEstimator<dim>::Strategy::face_diameter_over_twice_max_degree);
+    if (prm.matrix_free_error_estimator)
+      KellyMatrixFree::estimate(*dof_handler,
+                                *locally_relevant_solution,
+                                error_estimates,
+                                get_matrix_free<dim>());
+    else
+      KellyErrorEstimator<dim, spacedim>::estimate(
+        *dof_handler,
+        face_quadrature_collection,
+        std::map<types::boundary_id, const Function<dim> *>(),
+        *locally_relevant_solution,
+        error_estimates,
+        component_mask,
+        /*coefficients=*/nullptr,
+        /*n_threads=*/numbers::invalid_unsigned_int,
+        /*subdomain_id=*/numbers::invalid_subdomain_id,
+        /*material_id=*/numbers::invalid_material_id,
+        /*strategy=*/
+        KellyErrorEstimator<dim>::Strategy::face_diameter_over_twice_max_degree);
 
     // flag cells
-    parallel::distributed::GridRefinement::refine_and_coarsen_fixed_number(
-      *triangulation, error_estimates, prm.total_refine_fraction, prm.total_coarsen_fraction);
+    Marking::refine_and_coarsen_fixed_number(*triangulation,
+                                             error_estimates,
+                                             prm.total_refine_fraction,
+                                             prm.total_coarsen_fraction);
 
     // hp-indicators
     hp_indicators.grow_or_shrink(triangulation->n_active_cells());
@@ -146,22 +157,13 @@ namespace Adaptation
       /*only_flagged_cells=*/true);
 
     // set future fe indices
-    hp::Refinement::p_adaptivity_fixed_number(*dof_handler,
-                                              hp_indicators,
-                                              prm.p_refine_fraction,
-                                              prm.p_coarsen_fraction);
+    Marking::p_adaptivity_fixed_number(*dof_handler,
+                                       hp_indicators,
+                                       prm.p_refine_fraction,
+                                       prm.p_coarsen_fraction);
 
     // limit levels
-    Assert(triangulation->n_global_levels() >= prm.min_h_level + 1 &&
-             triangulation->n_global_levels() <= prm.max_h_level + 1,
-           ExcInternalError());
-
-    if (triangulation->n_global_levels() > prm.max_h_level)
-      for (const auto &cell : triangulation->active_cell_iterators_on_level(prm.max_h_level))
-        cell->clear_refine_flag();
-
-    for (const auto &cell : triangulation->active_cell_iterators_on_level(prm.min_h_level))
-      cell->clear_coarsen_flag();
+    Marking::limit_levels(*triangulation, prm.min_h_level, prm.max_h_level);
 
     // decide hp
     hp::Refinement::choose_p_over_h(*dof_handler);
@@ -17,13 +17,13 @@
 #include <deal.II/base/exceptions.h>
 #include <deal.II/base/quadrature_lib.h>
 
-#include <deal.II/distributed/grid_refinement.h>
-
 #include <deal.II/hp/refinement.h>
 
 #include <deal.II/numerics/error_estimator.h>
 
 #include <adaptation/hp_full.h>
+#include <adaptation/kelly_matrixfree.h>
+#include <adaptation/marking.h>
 #include <global.h>
 #include <linear_algebra.h>
 
@@ -84,35 +84,34 @@ namespace Adaptation
     // error estimates
     error_estimates.grow_or_shrink(triangulation->n_active_cells());
 
-    KellyErrorEstimator<dim, spacedim>::estimate(
-      *dof_handler,
-      face_quadrature_collection,
-      std::map<types::boundary_id, const Function<dim> *>(),
-      *locally_relevant_solution,
-      error_estimates,
-      component_mask,
-      /*coefficients=*/nullptr,
-      /*n_threads=*/numbers::invalid_unsigned_int,
-      /*subdomain_id=*/numbers::invalid_subdomain_id,
-      /*material_id=*/numbers::invalid_material_id,
-      /*strategy=*/
-      KellyErrorEstimator<dim>::Strategy::face_diameter_over_twice_max_degree);
+    if (prm.matrix_free_error_estimator)
+      KellyMatrixFree::estimate(*dof_handler,
+                                *locally_relevant_solution,
+                                error_estimates,
+                                get_matrix_free<dim>());
+    else
+      KellyErrorEstimator<dim, spacedim>::estimate(
+        *dof_handler,
+        face_quadrature_collection,
+        std::map<types::boundary_id, const Function<dim> *>(),
+        *locally_relevant_solution,
+        error_estimates,
+        component_mask,
+        /*coefficients=*/nullptr,
+        /*n_threads=*/numbers::invalid_unsigned_int,
+        /*subdomain_id=*/numbers::invalid_subdomain_id,
+        /*material_id=*/numbers::invalid_material_id,
+        /*strategy=*/
+        KellyErrorEstimator<dim>::Strategy::face_diameter_over_twice_max_degree);
 
     // flag cells
-    parallel::distributed::GridRefinement::refine_and_coarsen_fixed_number(
-      *triangulation, error_estimates, prm.total_refine_fraction, prm.total_coarsen_fraction);
+    Marking::refine_and_coarsen_fixed_number(*triangulation,
+                                             error_estimates,
+                                             prm.total_refine_fraction,
+                                             prm.total_coarsen_fraction);
 
     // limit levels
-    Assert(triangulation->n_global_levels() >= prm.min_h_level + 1 &&
-             triangulation->n_global_levels() <= prm.max_h_level + 1,
-           ExcInternalError());
-
-    if (triangulation->n_global_levels() > prm.max_h_level)
-      for (const auto &cell : triangulation->active_cell_iterators_on_level(prm.max_h_level))
-        cell->clear_refine_flag();
-
-    for (const auto &cell : triangulation->active_cell_iterators_on_level(prm.min_h_level))
-      cell->clear_coarsen_flag();
+    Marking::limit_levels(*triangulation, prm.min_h_level, prm.max_h_level);
   }
 
 
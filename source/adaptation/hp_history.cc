@@ -17,14 +17,14 @@
 #include <deal.II/base/exceptions.h>
 #include <deal.II/base/quadrature_lib.h>
 
-#include <deal.II/distributed/grid_refinement.h>
-
 #include <deal.II/hp/refinement.h>
 
 #include <deal.II/numerics/adaptation_strategies.h>
 #include <deal.II/numerics/error_estimator.h>
 
 #include <adaptation/hp_history.h>
+#include <adaptation/kelly_matrixfree.h>
+#include <adaptation/marking.h>
 #include <global.h>
 #include <linear_algebra.h>
 
@@ -61,42 +61,19 @@ namespace Adaptation
     for (unsigned int degree = 1; degree <= prm.max_p_degree; ++degree)
       face_quadrature_collection.push_back(QGauss<dim - 1>(degree + 1));
 
-    // limit p-level difference *before* predicting errors
-    if (prm.max_p_level_difference > 0)
-      {
-        const unsigned int min_fe_index = prm.min_p_degree - 1;
-        triangulation.signals.post_p4est_refinement.connect([&, min_fe_index]() {
-          const parallel::distributed::TemporarilyMatchRefineFlags<dim, spacedim> refine_modifier(
-            triangulation);
-
-          hp::Refinement::limit_p_level_difference(dof_handler,
-                                                   prm.max_p_level_difference,
-                                                   /*contains=*/min_fe_index);
-
-          error_predictions.grow_or_shrink(triangulation.n_active_cells());
-          hp::Refinement::predict_error(dof_handler,
-                                        error_estimates,
-                                        error_predictions,
-                                        /*gamma_p=*/std::sqrt(0.4),
-                                        /*gamma_h=*/2.,
-                                        /*gamma_n=*/1.);
-        });
-      }
-    else
-      {
-        triangulation.signals.post_p4est_refinement.connect([&]() {
-          const parallel::distributed::TemporarilyMatchRefineFlags<dim, spacedim> refine_modifier(
-            triangulation);
-
-          error_predictions.grow_or_shrink(triangulation.n_active_cells());
-          hp::Refinement::predict_error(dof_handler,
-                                        error_estimates,
-                                        error_predictions,
-                                        /*gamma_p=*/std::sqrt(0.4),
-                                        /*gamma_h=*/2.,
-                                        /*gamma_n=*/1.);
-        });
-      }
+    triangulation.signals.post_p4est_refinement.connect([&]() {
+      const parallel::distributed::TemporarilyMatchRefineFlags<dim, spacedim> refine_modifier(
+        triangulation);
+
+      // limit p-level difference *before* predicting errors
+      if (prm.max_p_level_difference > 0)
+        hp::Refinement::limit_p_level_difference(dof_handler,
+                                                 prm.max_p_level_difference,
+                                                 /*contains=*/prm.min_p_degree - 1);
+
+      error_predictions.grow_or_shrink(triangulation.n_active_cells());
+      Marking::predict_error(dof_handler, error_estimates, error_predictions);
+    });
   }
 
 
@@ -110,19 +87,25 @@ namespace Adaptation
     // error estimates
     error_estimates.grow_or_shrink(triangulation->n_active_cells());
 
-    KellyErrorEstimator<dim, spacedim>::estimate(
-      *dof_handler,
-      face_quadrature_collection,
-      std::map<types::boundary_id, const Function<dim> *>(),
-      *locally_relevant_solution,
-      error_estimates,
-      component_mask,
-      /*coefficients=*/nullptr,
-      /*n_threads=*/numbers::invalid_unsigned_int,
-      /*subdomain_id=*/numbers::invalid_subdomain_id,
-      /*material_id=*/numbers::invalid_material_id,
-      /*strategy=*/
-      KellyErrorEstimator<dim>::Strategy::face_diameter_over_twice_max_degree);
+    if (prm.matrix_free_error_estimator)
+      KellyMatrixFree::estimate(*dof_handler,
+                                *locally_relevant_solution,
+                                error_estimates,
+                                get_matrix_free<dim>());
+    else
+      KellyErrorEstimator<dim, spacedim>::estimate(
+        *dof_handler,
+        face_quadrature_collection,
+        std::map<types::boundary_id, const Function<dim> *>(),
+        *locally_relevant_solution,
+        error_estimates,
+        component_mask,
+        /*coefficients=*/nullptr,
+        /*n_threads=*/numbers::invalid_unsigned_int,
+        /*subdomain_id=*/numbers::invalid_subdomain_id,
+        /*material_id=*/numbers::invalid_material_id,
+        /*strategy=*/
+        KellyErrorEstimator<dim>::Strategy::face_diameter_over_twice_max_degree);
 
     if (init_step)
       {
@@ -136,8 +119,10 @@ namespace Adaptation
     else
       {
         // flag cells
-        parallel::distributed::GridRefinement::refine_and_coarsen_fixed_number(
-          *triangulation, error_estimates, prm.total_refine_fraction, prm.total_coarsen_fraction);
+        Marking::refine_and_coarsen_fixed_number(*triangulation,
+                                                 error_estimates,
+                                                 prm.total_refine_fraction,
+                                                 prm.total_coarsen_fraction);
 
         // hp-indicators
         hp_indicators.grow_or_shrink(triangulation->n_active_cells());
@@ -157,22 +142,13 @@ namespace Adaptation
           }
 
         // set future fe indices
-        hp::Refinement::p_adaptivity_fixed_number(*dof_handler,
-                                                  hp_indicators,
-                                                  prm.p_refine_fraction,
-                                                  prm.p_coarsen_fraction);
+        Marking::p_adaptivity_fixed_number(*dof_handler,
+                                           hp_indicators,
+                                           prm.p_refine_fraction,
+                                           prm.p_coarsen_fraction);
 
         // limit levels
-        Assert(triangulation->n_global_levels() >= prm.min_h_level + 1 &&
-                 triangulation->n_global_levels() <= prm.max_h_level + 1,
-               ExcInternalError());
-
-        if (triangulation->n_global_levels() > prm.max_h_level)
-          for (const auto &cell : triangulation->active_cell_iterators_on_level(prm.max_h_level))
-            cell->clear_refine_flag();
-
-        for (const auto &cell : triangulation->active_cell_iterators_on_level(prm.min_h_level))
-          cell->clear_coarsen_flag();
+        Marking::limit_levels(*triangulation, prm.min_h_level, prm.max_h_level);
 
         // decide hp
         hp::Refinement::choose_p_over_h(*dof_handler);
@@ -188,7 +164,9 @@ namespace Adaptation
     TimerOutput::Scope t(getTimer(), "refine");
 
     // Errors will be predicted during the post_p4est_refinement signal,
-    // and their transfer will be issued afterwards.
+    // and their transfer will be issued afterwards. They are packed into the
+    // same per-cell buffers as all other data attached to the triangulation,
+    // like FE indices, so that they do not need a separate transfer.
 
     data_transfer.prepare_for_coarsening_and_refinement(error_predictions);
 
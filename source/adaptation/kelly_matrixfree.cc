@@ -0,0 +1,261 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/quadrature_lib.h>
+
+#include <deal.II/fe/mapping_q1.h>
+
+#include <deal.II/grid/cell_id.h>
+
+#include <deal.II/hp/mapping_collection.h>
+#include <deal.II/hp/q_collection.h>
+
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/la_parallel_vector.h>
+
+#include <deal.II/matrix_free/fe_evaluation.h>
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <adaptation/kelly_matrixfree.h>
+#include <global.h>
+#include <linear_algebra.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace dealii;
+
+
+namespace Adaptation
+{
+  namespace KellyMatrixFree
+  {
+    template <int dim, typename VectorType>
+    void
+    estimate(const DoFHandler<dim>         &dof_handler,
+             const VectorType              &solution,
+             Vector<float>                 &error_estimates,
+             const MatrixFree<dim, double> *matrix_free)
+    {
+      TimerOutput::Scope t(getTimer(), "kelly_matrixfree");
+
+      using MatrixFreeVectorType = LinearAlgebra::distributed::Vector<double>;
+      using FEFaceIntegrator     = FEFaceEvaluation<dim, -1, 0, 1, double>;
+
+      const auto &fe_collection = dof_handler.get_fe_collection();
+      AssertThrow(fe_collection.n_components() == 1, ExcNotImplemented());
+
+      // Set up a MatrixFree object only if the operator does not share its own.
+      std::unique_ptr<MatrixFree<dim, double>> own_matrix_free;
+      if (matrix_free == nullptr)
+        {
+          hp::QCollection<1> quadrature_collection;
+          for (unsigned int i = 0; i < fe_collection.size(); ++i)
+            quadrature_collection.push_back(QGauss<1>(fe_collection[i].degree + 1));
+
+          AffineConstraints<double> constraints;
+          constraints.close();
+
+          typename MatrixFree<dim, double>::AdditionalData data;
+          data.mapping_update_flags             = update_default;
+          data.mapping_update_flags_inner_faces = update_gradients | update_normal_vectors |
+                                                  update_JxW_values;
+
+          own_matrix_free = std::make_unique<MatrixFree<dim, double>>();
+          own_matrix_free->reinit(hp::MappingCollection<dim>(MappingQ1<dim>()),
+                                  dof_handler,
+                                  constraints,
+                                  quadrature_collection,
+                                  data);
+
+          matrix_free = own_matrix_free.get();
+        }
+      Assert(&matrix_free->get_dof_handler() == &dof_handler,
+             ExcMessage("The MatrixFree object has to be built on the same DoFHandler."));
+
+      MatrixFreeVectorType src, dst;
+      matrix_free->initialize_dof_vector(src);
+      matrix_free->initialize_dof_vector(dst);
+      for (const auto i : dof_handler.locally_owned_dofs())
+        src[i] = solution(i);
+
+      // Face batches might be processed concurrently, so each of them only
+      // stores its jump integrals. They are summed up for each cell afterwards.
+      std::vector<VectorizedArray<double>> jump_integrals(matrix_free->n_inner_face_batches());
+
+      // The solution has all constraints applied, so we read it as is.
+      const auto face_operation = [&](const MatrixFree<dim, double>               &matrix_free,
+                                      MatrixFreeVectorType                        &,
+                                      const MatrixFreeVectorType                  &src,
+                                      const std::pair<unsigned int, unsigned int> &range) {
+        FEFaceIntegrator phi_m(matrix_free, range, true);
+        FEFaceIntegrator phi_p(matrix_free, range, false);
+
+        for (unsigned int face = range.first; face < range.second; ++face)
+          {
+            phi_m.reinit(face);
+            phi_p.reinit(face);
+
+            phi_m.read_dof_values_plain(src);
+            phi_m.evaluate(EvaluationFlags::gradients);
+            phi_p.read_dof_values_plain(src);
+            phi_p.evaluate(EvaluationFlags::gradients);
+
+            // Both sides share the normal vector of the interior cell.
+            VectorizedArray<double> jump_integral = 0.;
+            for (const unsigned int q : phi_m.quadrature_point_indices())
+              {
+                const auto jump = phi_m.get_normal_derivative(q) - phi_p.get_normal_derivative(q);
+                jump_integral += jump * jump * phi_m.JxW(q);
+              }
+
+            jump_integrals[face] = jump_integral;
+          }
+      };
+
+      matrix_free->template loop<MatrixFreeVectorType, MatrixFreeVectorType>(
+        [](const auto &, auto &, const auto &, const auto &) {},
+        face_operation,
+        [](const auto &, auto &, const auto &, const auto &) {},
+        dst,
+        src,
+        /*zero_dst_vector=*/false,
+        MatrixFree<dim, double>::DataAccessOnFaces::none,
+        MatrixFree<dim, double>::DataAccessOnFaces::unspecified);
+
+      // sum of weighted face integrals for each cell, including ghost cells
+      Vector<float> face_sums(dof_handler.get_triangulation().n_active_cells());
+
+      for (unsigned int face = 0; face < matrix_free->n_inner_face_batches(); ++face)
+        for (unsigned int v = 0; v < matrix_free->n_active_entries_per_face_batch(face); ++v)
+          {
+            const auto [cell_m, face_no] = matrix_free->get_face_iterator(face, v, true);
+            const auto cell_p            = matrix_free->get_face_iterator(face, v, false).first;
+
+            // On faces with hanging nodes, the interior cell is the refined one.
+            const double       face_diameter = cell_m->face(face_no)->diameter();
+            const unsigned int max_degree =
+              std::max(cell_m->get_fe().degree, cell_p->get_fe().degree);
+
+            const float value = jump_integrals[face][v] * face_diameter / (2. * max_degree);
+
+            face_sums[cell_m->active_cell_index()] += value;
+            face_sums[cell_p->active_cell_index()] += value;
+          }
+
+      // send contributions of ghost cells to their owners
+      std::map<unsigned int, std::vector<std::pair<CellId, float>>> contributions_to_send;
+      for (const auto &cell : dof_handler.active_cell_iterators())
+        if (cell->is_ghost() && face_sums[cell->active_cell_index()] > 0.)
+          contributions_to_send[cell->subdomain_id()].emplace_back(
+            cell->id(), face_sums[cell->active_cell_index()]);
+
+      const auto contributions_received =
+        Utilities::MPI::some_to_some(dof_handler.get_communicator(), contributions_to_send);
+
+      for (const auto &[rank, contributions] : contributions_received)
+        for (const auto &[cell_id, value] : contributions)
+          face_sums[dof_handler.get_triangulation().create_cell_iterator(cell_id)
+                      ->active_cell_index()] += value;
+
+      error_estimates.reinit(dof_handler.get_triangulation().n_active_cells());
+      for (const auto &cell : dof_handler.active_cell_iterators())
+        if (cell->is_locally_owned())
+          error_estimates[cell->active_cell_index()] =
+            std::sqrt(face_sums[cell->active_cell_index()]);
+    }
+
+
+
+    // explicit instantiations
+    template void
+    estimate<2, LinearAlgebra::distributed::Vector<double>>(
+      const DoFHandler<2> &,
+      const LinearAlgebra::distributed::Vector<double> &,
+      Vector<float> &,
+      const MatrixFree<2, double> *);
+    template void
+    estimate<3, LinearAlgebra::distributed::Vector<double>>(
+      const DoFHandler<3> &,
+      const LinearAlgebra::distributed::Vector<double> &,
+      Vector<float> &,
+      const MatrixFree<3, double> *);
+    template void
+    estimate<2, LinearAlgebra::distributed::BlockVector<double>>(
+      const DoFHandler<2> &,
+      const LinearAlgebra::distributed::BlockVector<double> &,
+      Vector<float> &,
+      const MatrixFree<2, double> *);
+    template void
+    estimate<3, LinearAlgebra::distributed::BlockVector<double>>(
+      const DoFHandler<3> &,
+      const LinearAlgebra::distributed::BlockVector<double> &,
+      Vector<float> &,
+      const MatrixFree<3, double> *);
+
+#ifdef DEAL_II_WITH_TRILINOS
+    template void
+    estimate<2, TrilinosWrappers::MPI::Vector>(const DoFHandler<2> &,
+                                               const TrilinosWrappers::MPI::Vector &,
+                                               Vector<float> &,
+                                               const MatrixFree<2, double> *);
+    template void
+    estimate<3, TrilinosWrappers::MPI::Vector>(const DoFHandler<3> &,
+                                               const TrilinosWrappers::MPI::Vector &,
+                                               Vector<float> &,
+                                               const MatrixFree<3, double> *);
+    template void
+    estimate<2, TrilinosWrappers::MPI::BlockVector>(const DoFHandler<2> &,
+                                                    const TrilinosWrappers::MPI::BlockVector &,
+                                                    Vector<float> &,
+                                                    const MatrixFree<2, double> *);
+    template void
+    estimate<3, TrilinosWrappers::MPI::BlockVector>(const DoFHandler<3> &,
+                                                    const TrilinosWrappers::MPI::BlockVector &,
+                                                    Vector<float> &,
+                                                    const MatrixFree<3, double> *);
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+    template void
+    estimate<2, PETScWrappers::MPI::Vector>(const DoFHandler<2> &,
+                                            const PETScWrappers::MPI::Vector &,
+                                            Vector<float> &,
+                                            const MatrixFree<2, double> *);
+    template void
+    estimate<3, PETScWrappers::MPI::Vector>(const DoFHandler<3> &,
+                                            const PETScWrappers::MPI::Vector &,
+                                            Vector<float> &,
+                                            const MatrixFree<3, double> *);
+    template void
+    estimate<2, PETScWrappers::MPI::BlockVector>(const DoFHandler<2> &,
+                                                 const PETScWrappers::MPI::BlockVector &,
+                                                 Vector<float> &,
+                                                 const MatrixFree<2, double> *);
+    template void
+    estimate<3, PETScWrappers::MPI::BlockVector>(const DoFHandler<3> &,
+                                                 const PETScWrappers::MPI::BlockVector &,
+                                                 Vector<float> &,
+                                                 const MatrixFree<3, double> *);
+#endif
+  } // namespace KellyMatrixFree
+} // namespace Adaptation
@@ -0,0 +1,384 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/parallel.h>
+
+#include <deal.II/grid/filtered_iterator.h>
+
+#include <adaptation/marking.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace dealii;
+
+
+namespace Adaptation
+{
+  namespace Marking
+  {
+    float
+    compute_threshold(const ArrayView<const float>  &criteria,
+                      const types::global_cell_index n_target,
+                      const MPI_Comm                 mpi_communicator)
+    {
+      float local_min = std::numeric_limits<float>::max();
+      float local_max = std::numeric_limits<float>::lowest();
+      for (const auto c : criteria)
+        {
+          local_min = std::min(local_min, c);
+          local_max = std::max(local_max, c);
+        }
+
+      const float global_min = Utilities::MPI::min(local_min, mpi_communicator);
+      const float global_max = Utilities::MPI::max(local_max, mpi_communicator);
+
+      const types::global_cell_index n_total =
+        Utilities::MPI::sum<types::global_cell_index>(criteria.size(), mpi_communicator);
+
+      if (n_target == 0)
+        return global_max;
+      if (n_target >= n_total)
+        return std::numeric_limits<float>::lowest();
+
+      const auto count_larger = [&](const float threshold) {
+        const auto local_count = parallel::accumulate_from_subranges<types::global_cell_index>(
+          [&](const std::size_t begin, const std::size_t end) {
+            types::global_cell_index count = 0;
+            for (std::size_t i = begin; i < end; ++i)
+              count += (criteria[i] > threshold);
+            return count;
+          },
+          std::size_t(0),
+          criteria.size(),
+          /*grainsize=*/4096);
+
+        return Utilities::MPI::sum(local_count, mpi_communicator);
+      };
+
+      float lower = global_min, upper = global_max, threshold = global_max;
+      for (unsigned int iteration = 0; iteration < 25; ++iteration)
+        {
+          // criteria often span several orders of magnitude, so bisect in logarithmic scale
+          // whenever possible
+          threshold = (lower > 0.f) ? std::sqrt(lower * upper) : 0.5f * (lower + upper);
+
+          const types::global_cell_index n_larger = count_larger(threshold);
+          if (n_larger == n_target)
+            break;
+          else if (n_larger > n_target)
+            lower = threshold;
+          else
+            upper = threshold;
+        }
+
+      return threshold;
+    }
+
+
+
+    template <int dim, int spacedim>
+    void
+    refine_and_coarsen_fixed_number(
+      parallel::distributed::Triangulation<dim, spacedim> &triangulation,
+      const Vector<float>                                 &criteria,
+      const double                                         top_fraction_of_cells,
+      const double                                         bottom_fraction_of_cells)
+    {
+      AssertDimension(criteria.size(), triangulation.n_active_cells());
+      Assert(top_fraction_of_cells >= 0 && bottom_fraction_of_cells >= 0 &&
+               top_fraction_of_cells + bottom_fraction_of_cells <= 1,
+             ExcMessage("The fractions of cells need to be non-negative and add up to at most 1."));
+      Assert(criteria.is_non_negative(), ExcMessage("The criteria need to be non-negative."));
+
+      std::vector<float> locally_owned_criteria;
+      locally_owned_criteria.reserve(triangulation.n_locally_owned_active_cells());
+      for (const auto &cell :
+           triangulation.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
+        locally_owned_criteria.push_back(criteria(cell->active_cell_index()));
+
+      const types::global_cell_index n_global_cells = triangulation.n_global_active_cells();
+
+      const auto n_refine_cells = static_cast<types::global_cell_index>(
+        std::floor(top_fraction_of_cells * n_global_cells));
+      const auto n_coarsen_cells = static_cast<types::global_cell_index>(
+        std::floor(bottom_fraction_of_cells * n_global_cells));
+
+      const MPI_Comm mpi_communicator = triangulation.get_communicator();
+
+      const float top_threshold =
+        compute_threshold(locally_owned_criteria, n_refine_cells, mpi_communicator);
+      const float bottom_threshold =
+        (n_coarsen_cells > 0) ?
+          compute_threshold(locally_owned_criteria,
+                            n_global_cells - n_coarsen_cells,
+                            mpi_communicator) :
+          std::numeric_limits<float>::lowest();
+
+      for (const auto &cell :
+           triangulation.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
+        {
+          const float c = criteria(cell->active_cell_index());
+          if (c > top_threshold)
+            cell->set_refine_flag();
+          else if (n_coarsen_cells > 0 && c <= bottom_threshold)
+            cell->set_coarsen_flag();
+        }
+    }
+
+
+
+    template <int dim, int spacedim>
+    void
+    p_adaptivity_fixed_number(DoFHandler<dim, spacedim> &dof_handler,
+                              const Vector<float>       &hp_indicators,
+                              const double               p_refine_fraction,
+                              const double               p_coarsen_fraction)
+    {
+      AssertDimension(hp_indicators.size(), dof_handler.get_triangulation().n_active_cells());
+      Assert(p_refine_fraction >= 0 && p_refine_fraction <= 1 && p_coarsen_fraction >= 0 &&
+               p_coarsen_fraction <= 1,
+             ExcMessage("The fractions of cells need to be in [0, 1]."));
+
+      std::vector<float> indicators_refinement;
+      std::vector<float> indicators_coarsening;
+      for (const auto &cell :
+           dof_handler.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
+        if (cell->refine_flag_set())
+          indicators_refinement.push_back(hp_indicators(cell->active_cell_index()));
+        else if (cell->coarsen_flag_set())
+          indicators_coarsening.push_back(hp_indicators(cell->active_cell_index()));
+
+      const MPI_Comm mpi_communicator = dof_handler.get_communicator();
+
+      const types::global_cell_index n_flags_refinement =
+        Utilities::MPI::sum<types::global_cell_index>(indicators_refinement.size(),
+                                                      mpi_communicator);
+      const types::global_cell_index n_flags_coarsening =
+        Utilities::MPI::sum<types::global_cell_index>(indicators_coarsening.size(),
+                                                      mpi_communicator);
+
+      const auto n_p_refine = static_cast<types::global_cell_index>(
+        std::floor(p_refine_fraction * n_flags_refinement));
+      const auto n_p_coarsen = static_cast<types::global_cell_index>(
+        std::floor(p_coarsen_fraction * n_flags_coarsening));
+
+      const float threshold_refinement =
+        compute_threshold(indicators_refinement, n_p_refine, mpi_communicator);
+      const float threshold_coarsening =
+        compute_threshold(indicators_coarsening,
+                          n_flags_coarsening - n_p_coarsen,
+                          mpi_communicator);
+
+      const auto &fe_collection = dof_handler.get_fe_collection();
+      for (const auto &cell :
+           dof_handler.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
+        {
+          const float indicator = hp_indicators(cell->active_cell_index());
+          if (cell->refine_flag_set() && indicator > threshold_refinement)
+            {
+              const unsigned int super_fe_index =
+                fe_collection.next_in_hierarchy(cell->active_fe_index());
+              if (super_fe_index != cell->active_fe_index())
+                cell->set_future_fe_index(super_fe_index);
+            }
+          else if (cell->coarsen_flag_set() && n_p_coarsen > 0 &&
+                   indicator <= threshold_coarsening)
+            {
+              const unsigned int sub_fe_index =
+                fe_collection.previous_in_hierarchy(cell->active_fe_index());
+              if (sub_fe_index != cell->active_fe_index())
+                cell->set_future_fe_index(sub_fe_index);
+            }
+        }
+    }
+
+
+
+    template <int dim, int spacedim>
+    void
+    predict_error(const DoFHandler<dim, spacedim> &dof_handler,
+                  const Vector<float>             &error_indicators,
+                  Vector<float>                   &predicted_errors,
+                  const double                     gamma_p,
+                  const double                     gamma_h,
+                  const double                     gamma_n)
+    {
+      AssertDimension(error_indicators.size(), dof_handler.get_triangulation().n_active_cells());
+      AssertDimension(predicted_errors.size(), error_indicators.size());
+
+      const auto &fe_collection = dof_handler.get_fe_collection();
+
+      unsigned int n_degrees = 0;
+      for (unsigned int i = 0; i < fe_collection.size(); ++i)
+        n_degrees = std::max(n_degrees, fe_collection[i].degree + 1);
+
+      // Decay factors for all combinations of h-adaptation, current and future degree. The first
+      // two entries belong to cells that are not locally owned and cells that are not adapted.
+      // Without p-adaptation, the future degree equals the current one, except for cells that
+      // will be coarsened.
+      const auto factor_index =
+        [n_degrees](const unsigned int h, const unsigned int degree, const unsigned int future) {
+          return 2 + (h * n_degrees + degree) * n_degrees + future;
+        };
+
+      std::vector<float> factors(2 + 4 * n_degrees * n_degrees);
+      factors[0] = 1.;
+      factors[1] = gamma_n;
+      for (unsigned int degree = 0; degree < n_degrees; ++degree)
+        for (unsigned int future = 0; future < n_degrees; ++future)
+          {
+            const double p_decay = std::pow(gamma_p, int(future) - int(degree));
+            const double h_decay = gamma_h * std::pow(.5, future);
+
+            factors[factor_index(0, degree, future)] = p_decay;
+            factors[factor_index(1, degree, future)] = p_decay * h_decay;
+            factors[factor_index(2, degree, future)] = p_decay / h_decay;
+
+            // coarsening without p-adaptation, to the future degree of the parent
+            factors[factor_index(3, degree, future)] = 1. / h_decay;
+          }
+
+      // Siblings that will be coarsened share the future finite element of their parent.
+      std::map<typename DoFHandler<dim, spacedim>::cell_iterator, unsigned int>
+        future_fe_indices_on_parents;
+
+      std::vector<unsigned int> factor_indices(error_indicators.size(), 0);
+      for (const auto &cell :
+           dof_handler.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
+        {
+          const unsigned int i = cell->active_cell_index();
+
+          if (!cell->future_fe_index_set() && !cell->refine_flag_set() && !cell->coarsen_flag_set())
+            {
+              factor_indices[i] = 1;
+              continue;
+            }
+
+          unsigned int future_fe_index = cell->future_fe_index();
+          if (cell->coarsen_flag_set())
+            {
+              Assert(cell->level() > 0, ExcInternalError());
+              const auto parent = cell->parent();
+
+              const auto it = future_fe_indices_on_parents.find(parent);
+              if (it != future_fe_indices_on_parents.end())
+                future_fe_index = it->second;
+              else
+                {
+                  std::set<unsigned int> future_fe_indices_children;
+                  for (const auto &child : parent->child_iterators())
+                    future_fe_indices_children.insert(child->future_fe_index());
+
+                  future_fe_index =
+                    fe_collection.find_dominated_fe_extended(future_fe_indices_children,
+                                                             /*codim=*/0);
+                  future_fe_indices_on_parents.emplace(parent, future_fe_index);
+                }
+            }
+
+          const unsigned int degree = cell->get_fe().degree;
+          const unsigned int future = fe_collection[future_fe_index].degree;
+
+          unsigned int h = 0;
+          if (cell->refine_flag_set())
+            h = 1;
+          else if (cell->coarsen_flag_set())
+            h = cell->future_fe_index_set() ? 2 : 3;
+
+          factor_indices[i] = factor_index(h, degree, future);
+        }
+
+      // predict on the flat arrays
+      for (unsigned int i = 0; i < error_indicators.size(); ++i)
+        predicted_errors[i] = error_indicators[i] * factors[factor_indices[i]];
+    }
+
+
+
+    template <int dim, int spacedim>
+    void
+    limit_levels(parallel::distributed::Triangulation<dim, spacedim> &triangulation,
+                 const unsigned int                                   min_h_level,
+                 const unsigned int                                   max_h_level)
+    {
+      Assert(triangulation.n_global_levels() >= min_h_level + 1 &&
+               triangulation.n_global_levels() <= max_h_level + 1,
+             ExcInternalError());
+
+      if (triangulation.n_global_levels() > max_h_level)
+        for (const auto &cell : triangulation.active_cell_iterators_on_level(max_h_level))
+          cell->clear_refine_flag();
+
+      for (const auto &cell : triangulation.active_cell_iterators_on_level(min_h_level))
+        cell->clear_coarsen_flag();
+    }
+
+
+
+    // explicit instantiations
+    template void
+    refine_and_coarsen_fixed_number<2, 2>(parallel::distributed::Triangulation<2, 2> &,
+                                          const Vector<float> &,
+                                          const double,
+                                          const double);
+    template void
+    refine_and_coarsen_fixed_number<3, 3>(parallel::distributed::Triangulation<3, 3> &,
+                                          const Vector<float> &,
+                                          const double,
+                                          const double);
+
+    template void
+    p_adaptivity_fixed_number<2, 2>(DoFHandler<2, 2> &,
+                                    const Vector<float> &,
+                                    const double,
+                                    const double);
+    template void
+    p_adaptivity_fixed_number<3, 3>(DoFHandler<3, 3> &,
+                                    const Vector<float> &,
+                                    const double,
+                                    const double);
+
+    template void
+    predict_error<2, 2>(const DoFHandler<2, 2> &,
+                        const Vector<float> &,
+                        Vector<float> &,
+                        const double,
+                        const double,
+                        const double);
+    template void
+    predict_error<3, 3>(const DoFHandler<3, 3> &,
+                        const Vector<float> &,
+                        Vector<float> &,
+                        const double,
+                        const double,
+                        const double);
+
+    template void
+    limit_levels<2, 2>(parallel::distributed::Triangulation<2, 2> &,
+                       const unsigned int,
+                       const unsigned int);
+    template void
+    limit_levels<3, 3>(parallel::distributed::Triangulation<3, 3> &,
+                       const unsigned int,
+                       const unsigned int);
+  } // namespace Marking
+} // namespace Adaptation
@@ -0,0 +1,103 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+
+#include <async_writer.h>
+
+#include <fstream>
+
+using namespace dealii;
+
+
+AsyncWriter::AsyncWriter(const unsigned int max_queue_size)
+  : max_queue_size(max_queue_size)
+{
+  AssertThrow(max_queue_size > 0, ExcMessage("The output queue needs room for one file."));
+
+  thread = std::thread(&AsyncWriter::run, this);
+}
+
+
+
+AsyncWriter::~AsyncWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  queue_changed.notify_all();
+
+  thread.join();
+}
+
+
+
+void
+AsyncWriter::write(const std::string &filename, EncodeFunction &&encode)
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    queue_changed.wait(lock, [&] { return queue.size() < max_queue_size; });
+
+    queue.emplace_back(filename, std::move(encode));
+  }
+  queue_changed.notify_all();
+}
+
+
+
+void
+AsyncWriter::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  queue_changed.wait(lock, [&] { return queue.empty() && !busy; });
+}
+
+
+
+void
+AsyncWriter::run()
+{
+  while (true)
+    {
+      std::pair<std::string, EncodeFunction> file;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        queue_changed.wait(lock, [&] { return !queue.empty() || finished; });
+
+        // Write all pending files before we finish.
+        if (queue.empty())
+          return;
+
+        file = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+      }
+      queue_changed.notify_all();
+
+      std::ofstream stream(file.first);
+      file.second(stream);
+      stream.close();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy = false;
+      }
+      queue_changed.notify_all();
+    }
+}
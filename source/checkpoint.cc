@@ -0,0 +1,86 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/mpi.h>
+
+#include <checkpoint.h>
+
+#include <fstream>
+#include <vector>
+
+using namespace dealii;
+
+
+namespace Checkpoint
+{
+  template <int dim, int spacedim>
+  void
+  load(const std::string                                   &filename,
+       parallel::distributed::Triangulation<dim, spacedim> &triangulation)
+  {
+    triangulation.load(filename);
+  }
+
+
+
+  void
+  write_values(const std::string         &filename,
+               const std::vector<double> &values,
+               const MPI_Comm             mpi_communicator)
+  {
+    if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
+      {
+        std::ofstream file(filename + ".values");
+        file << values.size() << '\n';
+        file.precision(17);
+        for (const auto v : values)
+          file << v << '\n';
+      }
+  }
+
+
+
+  std::vector<double>
+  read_values(const std::string &filename, const MPI_Comm mpi_communicator)
+  {
+    std::vector<double> values;
+    if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
+      {
+        std::ifstream file(filename + ".values");
+
+        unsigned int n_values = 0;
+        if (file >> n_values)
+          {
+            values.resize(n_values);
+            for (auto &v : values)
+              file >> v;
+
+            if (!file)
+              values.clear();
+          }
+      }
+
+    return Utilities::MPI::broadcast(mpi_communicator, values);
+  }
+
+
+
+  // explicit instantiations
+  template void
+  load<2, 2>(const std::string &, parallel::distributed::Triangulation<2, 2> &);
+  template void
+  load<3, 3>(const std::string &, parallel::distributed::Triangulation<3, 3> &);
+} // namespace Checkpoint
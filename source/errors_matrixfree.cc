@@ -0,0 +1,167 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/mpi.h>
+
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/la_parallel_vector.h>
+
+#include <deal.II/matrix_free/fe_evaluation.h>
+#include <deal.II/matrix_free/matrix_free.h>
+
+#include <errors_matrixfree.h>
+#include <function.h>
+#include <global.h>
+#include <linear_algebra.h>
+
+#include <cmath>
+
+using namespace dealii;
+
+
+namespace ErrorsMatrixFree
+{
+  template <int dim, typename VectorType>
+  std::pair<double, double>
+  compute_L2_H1_errors(const hp::MappingCollection<dim> &mapping_collection,
+                       const DoFHandler<dim>            &dof_handler,
+                       const VectorType                 &solution,
+                       const dealii::Function<dim>      &exact_solution,
+                       const hp::QCollection<dim>       &quadrature_collection)
+  {
+    TimerOutput::Scope t(getTimer(), "errors_matrixfree");
+
+    using MatrixFreeVectorType = LinearAlgebra::distributed::Vector<double>;
+    using FECellIntegrator     = FEEvaluation<dim, -1, 0, 1, double>;
+
+    AssertThrow(dof_handler.get_fe_collection().n_components() == 1, ExcNotImplemented());
+
+    // The solution has all constraints applied, so we read it as is.
+    AffineConstraints<double> constraints;
+    constraints.close();
+
+    // Contributions of all cell batches are summed up in sequence.
+    typename MatrixFree<dim, double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim, double>::AdditionalData::none;
+    data.mapping_update_flags =
+      update_values | update_gradients | update_quadrature_points | update_JxW_values;
+
+    MatrixFree<dim, double> matrix_free;
+    matrix_free.reinit(mapping_collection, dof_handler, constraints, quadrature_collection, data);
+
+    MatrixFreeVectorType src, dst;
+    matrix_free.initialize_dof_vector(src);
+    for (const auto i : dof_handler.locally_owned_dofs())
+      src[i] = solution(i);
+
+    const ::Function::VectorizedEvaluator<dim> exact(exact_solution);
+
+    double L2_error_sqr = 0., H1_seminorm_error_sqr = 0.;
+
+    const auto cell_operation = [&](const MatrixFree<dim, double>               &matrix_free,
+                                    MatrixFreeVectorType                        &,
+                                    const MatrixFreeVectorType                  &src,
+                                    const std::pair<unsigned int, unsigned int> &range) {
+      FECellIntegrator phi(matrix_free, range);
+
+      for (unsigned int cell = range.first; cell < range.second; ++cell)
+        {
+          phi.reinit(cell);
+          phi.gather_evaluate(src, EvaluationFlags::values | EvaluationFlags::gradients);
+
+          VectorizedArray<double> value_integral = 0., gradient_integral = 0.;
+          for (const unsigned int q : phi.quadrature_point_indices())
+            {
+              const auto p = phi.quadrature_point(q);
+
+              const auto exact_value    = exact.value(p);
+              const auto exact_gradient = exact.gradient(p);
+
+              const auto value_difference    = phi.get_value(q) - exact_value;
+              const auto gradient_difference = phi.get_gradient(q) - exact_gradient;
+
+              value_integral += value_difference * value_difference * phi.JxW(q);
+              gradient_integral += gradient_difference * gradient_difference * phi.JxW(q);
+            }
+
+          for (unsigned int v = 0; v < matrix_free.n_active_entries_per_cell_batch(cell); ++v)
+            {
+              L2_error_sqr += value_integral[v];
+              H1_seminorm_error_sqr += gradient_integral[v];
+            }
+        }
+    };
+
+    matrix_free.template cell_loop<MatrixFreeVectorType, MatrixFreeVectorType>(cell_operation,
+                                                                              dst,
+                                                                              src);
+
+    double local_sums[2] = {L2_error_sqr, L2_error_sqr + H1_seminorm_error_sqr};
+    double global_sums[2];
+    Utilities::MPI::sum(local_sums, dof_handler.get_communicator(), global_sums);
+
+    return {std::sqrt(global_sums[0]), std::sqrt(global_sums[1])};
+  }
+
+
+
+  // explicit instantiations
+  template std::pair<double, double>
+  compute_L2_H1_errors<2, LinearAlgebra::distributed::Vector<double>>(
+    const hp::MappingCollection<2> &,
+    const DoFHandler<2> &,
+    const LinearAlgebra::distributed::Vector<double> &,
+    const dealii::Function<2> &,
+    const hp::QCollection<2> &);
+  template std::pair<double, double>
+  compute_L2_H1_errors<3, LinearAlgebra::distributed::Vector<double>>(
+    const hp::MappingCollection<3> &,
+    const DoFHandler<3> &,
+    const LinearAlgebra::distributed::Vector<double> &,
+    const dealii::Function<3> &,
+    const hp::QCollection<3> &);
+
+#ifdef DEAL_II_WITH_TRILINOS
+  template std::pair<double, double>
+  compute_L2_H1_errors<2, TrilinosWrappers::MPI::Vector>(const hp::MappingCollection<2> &,
+                                                         const DoFHandler<2> &,
+                                                         const TrilinosWrappers::MPI::Vector &,
+                                                         const dealii::Function<2> &,
+                                                         const hp::QCollection<2> &);
+  template std::pair<double, double>
+  compute_L2_H1_errors<3, TrilinosWrappers::MPI::Vector>(const hp::MappingCollection<3> &,
+                                                         const DoFHandler<3> &,
+                                                         const TrilinosWrappers::MPI::Vector &,
+                                                         const dealii::Function<3> &,
+                                                         const hp::QCollection<3> &);
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+  template std::pair<double, double>
+  compute_L2_H1_errors<2, PETScWrappers::MPI::Vector>(const hp::MappingCollection<2> &,
+                                                      const DoFHandler<2> &,
+                                                      const PETScWrappers::MPI::Vector &,
+                                                      const dealii::Function<2> &,
+                                                      const hp::QCollection<2> &);
+  template std::pair<double, double>
+  compute_L2_H1_errors<3, PETScWrappers::MPI::Vector>(const hp::MappingCollection<3> &,
+                                                      const DoFHandler<3> &,
+                                                      const PETScWrappers::MPI::Vector &,
+                                                      const dealii::Function<3> &,
+                                                      const hp::QCollection<3> &);
+#endif
+} // namespace ErrorsMatrixFree
@@ -21,13 +21,305 @@
 
 #include <function.h>
 
+#include <array>
 #include <cmath>
+#include <type_traits>
 
 using namespace dealii;
 
 
 namespace Function
 {
+  namespace
+  {
+    /**
+     * Coordinates of a single point of a batch.
+     */
+    template <int dim>
+    Point<dim>
+    get_lane(const VectorizedPoint<dim> &p, const unsigned int v)
+    {
+      Point<dim> p_lane;
+      for (unsigned int d = 0; d < dim; ++d)
+        p_lane[d] = p[d][v];
+      return p_lane;
+    }
+
+
+
+    /**
+     * Same as GeometricUtilities::Coordinates::to_spherical() for the first
+     * two coordinates.
+     */
+    template <int dim, typename Number>
+    std::array<Number, 2>
+    to_polar(const Point<dim, Number> &p)
+    {
+      if constexpr (std::is_same_v<Number, double>)
+        {
+          return GeometricUtilities::Coordinates::to_spherical(Point<2>(p[0], p[1]));
+        }
+      else
+        {
+          std::array<Number, 2> polar;
+          polar[0] = std::sqrt(p[0] * p[0] + p[1] * p[1]);
+
+          // there is no vectorized atan2
+          for (unsigned int v = 0; v < Number::size(); ++v)
+            {
+              const double angle = std::atan2(p[1][v], p[0][v]);
+              polar[1][v]        = (angle < 0.) ? angle + 2. * numbers::PI : angle;
+            }
+
+          return polar;
+        }
+    }
+
+
+
+    template <int dim, typename Number>
+    Number
+    reentrant_corner_value(const Point<dim, Number> &p, const double alpha)
+    {
+      const std::array<Number, 2> polar = to_polar(p);
+
+      return std::pow(polar[0], alpha) * std::sin(alpha * polar[1]);
+    }
+
+
+
+    template <int dim, typename Number>
+    Tensor<1, dim, Number>
+    reentrant_corner_gradient(const Point<dim, Number> &p, const double alpha)
+    {
+      const std::array<Number, 2> polar = to_polar(p);
+
+      // gradient in polar coordinates
+      std::array<Number, 2> result_polar;
+      const Number          factor = alpha * std::pow(polar[0], alpha - 1);
+      result_polar[0]              = factor * std::sin(alpha * polar[1]);
+      result_polar[1]              = factor * std::cos(alpha * polar[1]);
+
+      // transform back to cartesian coordinates by considering polar unit vectors
+      const Number cos_angle = std::cos(polar[1]);
+      const Number sin_angle = std::sin(polar[1]);
+
+      Tensor<1, dim, Number> result;
+      result[0] = result_polar[0] * cos_angle - result_polar[1] * sin_angle;
+      result[1] = result_polar[0] * sin_angle + result_polar[1] * cos_angle;
+      return result;
+    }
+
+
+
+    // exponent of the Kovasznay flow from step-55
+    const double kovasznay_lambda = -std::sqrt(25.0 + 4 * numbers::PI * numbers::PI) + 5.0;
+
+    // all terms of the Kovasznay pressure that do not depend on the position
+    const double kovasznay_pressure_offset = []() {
+      const double sqrt_term = std::sqrt(25.0 + 4 * numbers::PI * numbers::PI);
+
+      return -2.0 * (-6538034.74494422 + 0.0134758939981709 * std::exp(4 * sqrt_term)) /
+               (-80.0 * std::exp(3 * sqrt_term) + 16.0 * sqrt_term * std::exp(3 * sqrt_term)) -
+             1634508.68623606 * std::exp(-3.0 * sqrt_term) / (-10.0 + 2.0 * sqrt_term) +
+             (-0.00673794699908547 * std::exp(sqrt_term) +
+              3269017.37247211 * std::exp(-3 * sqrt_term)) /
+               (-8 * sqrt_term + 40.0) +
+             0.00336897349954273 * std::exp(1.0 * sqrt_term) / (-10.0 + 2.0 * sqrt_term);
+    }();
+
+
+
+    template <int dim, typename Number>
+    std::array<Number, dim>
+    kovasznay_velocity(const Point<dim, Number> &p)
+    {
+      constexpr double pi = numbers::PI;
+
+      const Number exp_x = std::exp(kovasznay_lambda * p[0]);
+
+      std::array<Number, dim> velocity;
+      velocity[0] = 1. - exp_x * std::cos(2. * pi * p[1]);
+      velocity[1] = kovasznay_lambda / (2. * pi) * exp_x * std::sin(2. * pi * p[1]);
+      for (unsigned int d = 2; d < dim; ++d)
+        velocity[d] = 0.;
+      return velocity;
+    }
+
+
+
+    template <int dim, typename Number>
+    Number
+    kovasznay_pressure(const Point<dim, Number> &p)
+    {
+      return -0.5 * std::exp(2. * kovasznay_lambda * p[0]) + kovasznay_pressure_offset;
+    }
+
+
+
+    template <int dim, typename Number>
+    std::array<Number, dim>
+    kovasznay_rhs_velocity(const Point<dim, Number> &p)
+    {
+      constexpr double pi     = numbers::PI;
+      constexpr double pi2    = numbers::PI * numbers::PI;
+      const double     lambda = kovasznay_lambda;
+
+      const Number exp_x = std::exp(lambda * p[0]);
+      const Number cos_y = std::cos(2. * pi * p[1]);
+      const Number sin_y = std::sin(2. * pi * p[1]);
+
+      std::array<Number, dim> rhs;
+      rhs[0] = -lambda * std::exp(2. * lambda * p[0]) +
+               (0.1 * lambda * lambda - 0.4 * pi2) * exp_x * cos_y;
+      rhs[1] = (0.2 * pi * lambda - 0.05 * lambda * lambda * lambda / pi) * exp_x * sin_y;
+      for (unsigned int d = 2; d < dim; ++d)
+        rhs[d] = 0.;
+      return rhs;
+    }
+
+
+
+    template <int dim, typename Number>
+    std::array<Number, dim>
+    poiseuille_velocity(const Point<dim, Number> &p, const double inv_sqr_radius)
+    {
+      // First, compute the square of the distance to the x-axis divided by the radius.
+      Number r2(0.);
+      for (unsigned int d = 1; d < dim; ++d)
+        r2 += p[d] * p[d];
+      r2 *= inv_sqr_radius;
+
+      std::array<Number, dim> velocity;
+      // x-velocity
+      velocity[0] = 1. - r2;
+      // other velocities
+      for (unsigned int d = 1; d < dim; ++d)
+        velocity[d] = 0.;
+      return velocity;
+    }
+
+
+
+    template <int dim, typename Number>
+    Number
+    poiseuille_pressure(const Point<dim, Number> &p,
+                        const double              inv_sqr_radius,
+                        const double              Reynolds)
+    {
+      return -2. * (dim - 1) * inv_sqr_radius * p[0] / Reynolds; // + this->mean_pressure;
+    }
+  } // namespace
+
+
+
+  template <int dim>
+  VectorizedArray<double>
+  VectorizedFunction<dim>::value(const VectorizedPoint<dim> &, const unsigned int) const
+  {
+    Assert(false, ExcPureFunctionCalled());
+    return VectorizedArray<double>(0.);
+  }
+
+  template <int dim>
+  VectorizedTensor<dim>
+  VectorizedFunction<dim>::gradient(const VectorizedPoint<dim> &, const unsigned int) const
+  {
+    Assert(false, ExcPureFunctionCalled());
+    return VectorizedTensor<dim>();
+  }
+
+  template <int dim>
+  void
+  VectorizedFunction<dim>::vector_value(const VectorizedPoint<dim>               &p,
+                                        const ArrayView<VectorizedArray<double>> &values) const
+  {
+    for (unsigned int c = 0; c < values.size(); ++c)
+      values[c] = value(p, c);
+  }
+
+
+
+  template <int dim>
+  VectorizedEvaluator<dim>::VectorizedEvaluator(const dealii::Function<dim> &function)
+    : function(function)
+    , vectorized_function(dynamic_cast<const VectorizedFunction<dim> *>(&function))
+  {
+    if (dynamic_cast<const Functions::ConstantFunction<dim> *>(&function) != nullptr)
+      {
+        Vector<double> values(function.n_components);
+        function.vector_value(Point<dim>(), values);
+        constant_values.assign(values.begin(), values.end());
+      }
+  }
+
+  template <int dim>
+  VectorizedArray<double>
+  VectorizedEvaluator<dim>::value(const VectorizedPoint<dim> &p, const unsigned int component) const
+  {
+    if (constant_values.size() > 0)
+      return VectorizedArray<double>(constant_values[component]);
+
+    if (vectorized_function != nullptr)
+      return vectorized_function->value(p, component);
+
+    VectorizedArray<double> result;
+    for (unsigned int v = 0; v < VectorizedArray<double>::size(); ++v)
+      result[v] = function.value(get_lane(p, v), component);
+    return result;
+  }
+
+  template <int dim>
+  VectorizedTensor<dim>
+  VectorizedEvaluator<dim>::gradient(const VectorizedPoint<dim> &p,
+                                     const unsigned int         component) const
+  {
+    if (constant_values.size() > 0)
+      return VectorizedTensor<dim>();
+
+    if (vectorized_function != nullptr)
+      return vectorized_function->gradient(p, component);
+
+    VectorizedTensor<dim> result;
+    for (unsigned int v = 0; v < VectorizedArray<double>::size(); ++v)
+      {
+        const Tensor<1, dim> gradient = function.gradient(get_lane(p, v), component);
+        for (unsigned int d = 0; d < dim; ++d)
+          result[d][v] = gradient[d];
+      }
+    return result;
+  }
+
+  template <int dim>
+  void
+  VectorizedEvaluator<dim>::vector_value(const VectorizedPoint<dim>               &p,
+                                         const ArrayView<VectorizedArray<double>> &values) const
+  {
+    AssertDimension(values.size(), function.n_components);
+
+    if (constant_values.size() > 0)
+      {
+        for (unsigned int c = 0; c < values.size(); ++c)
+          values[c] = constant_values[c];
+      }
+    else if (vectorized_function != nullptr)
+      {
+        vectorized_function->vector_value(p, values);
+      }
+    else
+      {
+        Vector<double> lane_values(function.n_components);
+        for (unsigned int v = 0; v < VectorizedArray<double>::size(); ++v)
+          {
+            function.vector_value(get_lane(p, v), lane_values);
+            for (unsigned int c = 0; c < values.size(); ++c)
+              values[c][v] = lane_values[c];
+          }
+      }
+  }
+
+
+
   template <int dim>
   ReentrantCorner<dim>::ReentrantCorner(const double alpha)
     : dealii::Function<dim>()
@@ -41,30 +333,40 @@ namespace Function
   double
   ReentrantCorner<dim>::value(const Point<dim> &p, const unsigned int /*component*/) const
   {
-    const std::array<double, 2> polar =
-      GeometricUtilities::Coordinates::to_spherical(Point<2>(p[0], p[1]));
-
-    return std::pow(polar[0], alpha) * std::sin(alpha * polar[1]);
+    return reentrant_corner_value(p, alpha);
   }
 
   template <int dim>
   Tensor<1, dim>
   ReentrantCorner<dim>::gradient(const Point<dim> &p, const unsigned int /*component*/) const
   {
-    const std::array<double, 2> polar =
-      GeometricUtilities::Coordinates::to_spherical(Point<2>(p[0], p[1]));
+    return reentrant_corner_gradient(p, alpha);
+  }
 
-    // gradient in polar coordinates
-    Tensor<1, 2> result_polar;
-    const double factor = alpha * std::pow(polar[0], alpha - 1);
-    result_polar[0]     = factor * std::sin(alpha * polar[1]);
-    result_polar[1]     = factor * std::cos(alpha * polar[1]);
+  template <int dim>
+  void
+  ReentrantCorner<dim>::value_list(const std::vector<Point<dim>> &points,
+                                   std::vector<double>           &values,
+                                   const unsigned int /*component*/) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      values[i] = reentrant_corner_value(points[i], alpha);
+  }
 
-    // transform back to cartesian coordinates by considering polar unit vectors
-    Tensor<1, dim> result;
-    result[0] = result_polar[0] * std::cos(polar[1]) - result_polar[1] * std::sin(polar[1]);
-    result[1] = result_polar[0] * std::sin(polar[1]) + result_polar[1] * std::cos(polar[1]);
-    return result;
+  template <int dim>
+  VectorizedArray<double>
+  ReentrantCorner<dim>::value(const VectorizedPoint<dim> &p, const unsigned int /*component*/) const
+  {
+    return reentrant_corner_value(p, alpha);
+  }
+
+  template <int dim>
+  VectorizedTensor<dim>
+  ReentrantCorner<dim>::gradient(const VectorizedPoint<dim> &p,
+                                 const unsigned int /*component*/) const
+  {
+    return reentrant_corner_gradient(p, alpha);
   }
 
 
@@ -80,15 +382,33 @@ namespace Function
   void
   KovasznayExactVelocity<dim>::vector_value(const Point<dim> &p, Vector<double> &values) const
   {
-    const double R_x = p[0];
-    const double R_y = p[1];
+    const auto velocity = kovasznay_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = velocity[d];
+  }
 
-    constexpr double pi  = numbers::PI;
-    constexpr double pi2 = numbers::PI * numbers::PI;
+  template <int dim>
+  void
+  KovasznayExactVelocity<dim>::vector_value_list(const std::vector<Point<dim>> &points,
+                                                 std::vector<Vector<double>>   &values) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      {
+        const auto velocity = kovasznay_velocity(points[i]);
+        for (unsigned int d = 0; d < dim; ++d)
+          values[i][d] = velocity[d];
+      }
+  }
 
-    values[0] = -std::exp(R_x * (-std::sqrt(25.0 + 4 * pi2) + 5.0)) * std::cos(2 * R_y * pi) + 1;
-    values[1] = (1.0L / 2.0L) * (-std::sqrt(25.0 + 4 * pi2) + 5.0) *
-                std::exp(R_x * (-std::sqrt(25.0 + 4 * pi2) + 5.0)) * std::sin(2 * R_y * pi) / pi;
+  template <int dim>
+  void
+  KovasznayExactVelocity<dim>::vector_value(const VectorizedPoint<dim>               &p,
+                                            const ArrayView<VectorizedArray<double>> &values) const
+  {
+    const auto velocity = kovasznay_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = velocity[d];
   }
 
 
@@ -102,22 +422,26 @@ namespace Function
   double
   KovasznayExactPressure<dim>::value(const Point<dim> &p, const unsigned int /*component*/) const
   {
-    const double R_x = p[0];
+    return kovasznay_pressure(p);
+  }
 
-    constexpr double pi2 = numbers::PI * numbers::PI;
+  template <int dim>
+  void
+  KovasznayExactPressure<dim>::value_list(const std::vector<Point<dim>> &points,
+                                          std::vector<double>           &values,
+                                          const unsigned int /*component*/) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      values[i] = kovasznay_pressure(points[i]);
+  }
 
-    return -1.0L / 2.0L * std::exp(R_x * (-2 * std::sqrt(25.0 + 4 * pi2) + 10.0)) -
-           2.0 *
-             (-6538034.74494422 + 0.0134758939981709 * std::exp(4 * std::sqrt(25.0 + 4 * pi2))) /
-             (-80.0 * std::exp(3 * std::sqrt(25.0 + 4 * pi2)) +
-              16.0 * std::sqrt(25.0 + 4 * pi2) * std::exp(3 * std::sqrt(25.0 + 4 * pi2))) -
-           1634508.68623606 * std::exp(-3.0 * std::sqrt(25.0 + 4 * pi2)) /
-             (-10.0 + 2.0 * std::sqrt(25.0 + 4 * pi2)) +
-           (-0.00673794699908547 * std::exp(std::sqrt(25.0 + 4 * pi2)) +
-            3269017.37247211 * std::exp(-3 * std::sqrt(25.0 + 4 * pi2))) /
-             (-8 * std::sqrt(25.0 + 4 * pi2) + 40.0) +
-           0.00336897349954273 * std::exp(1.0 * std::sqrt(25.0 + 4 * pi2)) /
-             (-10.0 + 2.0 * std::sqrt(25.0 + 4 * pi2));
+  template <int dim>
+  VectorizedArray<double>
+  KovasznayExactPressure<dim>::value(const VectorizedPoint<dim> &p,
+                                     const unsigned int /*component*/) const
+  {
+    return kovasznay_pressure(p);
   }
 
 
@@ -131,8 +455,31 @@ namespace Function
   void
   KovasznayExact<dim>::vector_value(const Point<dim> &p, Vector<double> &values) const
   {
-    velocity_function.vector_value(p, values);
-    values[dim] = pressure_function.value(p);
+    const auto velocity = kovasznay_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = velocity[d];
+    values[dim] = kovasznay_pressure(p);
+  }
+
+  template <int dim>
+  void
+  KovasznayExact<dim>::vector_value_list(const std::vector<Point<dim>> &points,
+                                         std::vector<Vector<double>>   &values) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      vector_value(points[i], values[i]);
+  }
+
+  template <int dim>
+  void
+  KovasznayExact<dim>::vector_value(const VectorizedPoint<dim>               &p,
+                                    const ArrayView<VectorizedArray<double>> &values) const
+  {
+    const auto velocity = kovasznay_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = velocity[d];
+    values[dim] = kovasznay_pressure(p);
   }
 
 
@@ -148,22 +495,33 @@ namespace Function
   void
   KovasznayRHSVelocity<dim>::vector_value(const Point<dim> &p, Vector<double> &values) const
   {
-    const double R_x = p[0];
-    const double R_y = p[1];
+    const auto rhs = kovasznay_rhs_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = rhs[d];
+  }
 
-    constexpr double pi  = numbers::PI;
-    constexpr double pi2 = numbers::PI * numbers::PI;
+  template <int dim>
+  void
+  KovasznayRHSVelocity<dim>::vector_value_list(const std::vector<Point<dim>> &points,
+                                               std::vector<Vector<double>>   &values) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      {
+        const auto rhs = kovasznay_rhs_velocity(points[i]);
+        for (unsigned int d = 0; d < dim; ++d)
+          values[i][d] = rhs[d];
+      }
+  }
 
-    values[0] =
-      -1.0L / 2.0L * (-2 * std::sqrt(25.0 + 4 * pi2) + 10.0) *
-        std::exp(R_x * (-2 * std::sqrt(25.0 + 4 * pi2) + 10.0)) -
-      0.4 * pi2 * std::exp(R_x * (-std::sqrt(25.0 + 4 * pi2) + 5.0)) * std::cos(2 * R_y * pi) +
-      0.1 * std::pow(-std::sqrt(25.0 + 4 * pi2) + 5.0, 2) *
-        std::exp(R_x * (-std::sqrt(25.0 + 4 * pi2) + 5.0)) * std::cos(2 * R_y * pi);
-    values[1] = 0.2 * pi * (-std::sqrt(25.0 + 4 * pi2) + 5.0) *
-                  std::exp(R_x * (-std::sqrt(25.0 + 4 * pi2) + 5.0)) * std::sin(2 * R_y * pi) -
-                0.05 * std::pow(-std::sqrt(25.0 + 4 * pi2) + 5.0, 3) *
-                  std::exp(R_x * (-std::sqrt(25.0 + 4 * pi2) + 5.0)) * std::sin(2 * R_y * pi) / pi;
+  template <int dim>
+  void
+  KovasznayRHSVelocity<dim>::vector_value(const VectorizedPoint<dim>               &p,
+                                          const ArrayView<VectorizedArray<double>> &values) const
+  {
+    const auto rhs = kovasznay_rhs_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = rhs[d];
   }
 
 
@@ -177,7 +535,30 @@ namespace Function
   void
   KovasznayRHS<dim>::vector_value(const Point<dim> &p, Vector<double> &values) const
   {
-    velocity_function.vector_value(p, values);
+    const auto rhs = kovasznay_rhs_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = rhs[d];
+    values[dim] = 0.;
+  }
+
+  template <int dim>
+  void
+  KovasznayRHS<dim>::vector_value_list(const std::vector<Point<dim>> &points,
+                                       std::vector<Vector<double>>   &values) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      vector_value(points[i], values[i]);
+  }
+
+  template <int dim>
+  void
+  KovasznayRHS<dim>::vector_value(const VectorizedPoint<dim>               &p,
+                                  const ArrayView<VectorizedArray<double>> &values) const
+  {
+    const auto rhs = kovasznay_rhs_velocity(p);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = rhs[d];
     values[dim] = 0.;
   }
 
@@ -193,17 +574,33 @@ namespace Function
   void
   PoisseuilleFlowVelocity<dim>::vector_value(const Point<dim> &p, Vector<double> &values) const
   {
-    // First, compute the square of the distance to the x-axis divided by the radius.
-    double r2 = 0;
-    for (unsigned int d = 1; d < dim; ++d)
-      r2 += p(d) * p(d);
-    r2 *= inv_sqr_radius;
+    const auto velocity = poiseuille_velocity(p, inv_sqr_radius);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = velocity[d];
+  }
+
+  template <int dim>
+  void
+  PoisseuilleFlowVelocity<dim>::vector_value_list(const std::vector<Point<dim>> &points,
+                                                  std::vector<Vector<double>>   &values) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      {
+        const auto velocity = poiseuille_velocity(points[i], inv_sqr_radius);
+        for (unsigned int d = 0; d < dim; ++d)
+          values[i][d] = velocity[d];
+      }
+  }
 
-    // x-velocity
-    values[0] = 1. - r2;
-    // other velocities
-    for (unsigned int d = 1; d < dim; ++d)
-      values[d] = 0.;
+  template <int dim>
+  void
+  PoisseuilleFlowVelocity<dim>::vector_value(const VectorizedPoint<dim>               &p,
+                                             const ArrayView<VectorizedArray<double>> &values) const
+  {
+    const auto velocity = poiseuille_velocity(p, inv_sqr_radius);
+    for (unsigned int d = 0; d < dim; ++d)
+      values[d] = velocity[d];
   }
 
 
@@ -221,12 +618,35 @@ namespace Function
   double
   PoisseuilleFlowPressure<dim>::value(const Point<dim> &p, const unsigned int /*component*/) const
   {
-    return -2 * (dim - 1) * inv_sqr_radius * p(0) / Reynolds; // + this->mean_pressure;
+    return poiseuille_pressure(p, inv_sqr_radius, Reynolds);
+  }
+
+  template <int dim>
+  void
+  PoisseuilleFlowPressure<dim>::value_list(const std::vector<Point<dim>> &points,
+                                           std::vector<double>           &values,
+                                           const unsigned int /*component*/) const
+  {
+    AssertDimension(points.size(), values.size());
+    for (unsigned int i = 0; i < points.size(); ++i)
+      values[i] = poiseuille_pressure(points[i], inv_sqr_radius, Reynolds);
+  }
+
+  template <int dim>
+  VectorizedArray<double>
+  PoisseuilleFlowPressure<dim>::value(const VectorizedPoint<dim> &p,
+                                      const unsigned int /*component*/) const
+  {
+    return poiseuille_pressure(p, inv_sqr_radius, Reynolds);
   }
 
 
 
   // explicit instantiations
+  template class VectorizedFunction<2>;
+  template class VectorizedFunction<3>;
+  template class VectorizedEvaluator<2>;
+  template class VectorizedEvaluator<3>;
   template class ReentrantCorner<2>;
   template class ReentrantCorner<3>;
   template class KovasznayExactVelocity<2>;
@@ -18,16 +18,107 @@
 
 #include <global.h>
 
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 using namespace dealii;
 
 
+namespace
+{
+  void
+  write_json_string(std::ostream &out, const std::string &string)
+  {
+    out << '"';
+    for (const char c : string)
+      {
+        if (c == '"' || c == '\\')
+          out << '\\' << c;
+        else if (c == '\n')
+          out << "\\n";
+        else if (c == '\t')
+          out << "\\t";
+        else
+          out << c;
+      }
+    out << '"';
+  }
+
+
+
+  // numbers as formatted by std::ostream, which excludes inf and nan
+  bool
+  is_json_number(const std::string &string)
+  {
+    if (string.empty() || string.find_first_not_of("0123456789+-.eE") != std::string::npos)
+      return false;
+
+    char *end = nullptr;
+    std::strtod(string.c_str(), &end);
+    return end == string.c_str() + string.size();
+  }
+} // namespace
+
+
+
+void
+CycleTable::write_current_row_json(std::ostream &out) const
+{
+  const unsigned int row = n_rows() - 1;
+
+  bool first = true;
+  out << '{';
+  for (const auto &key : column_order)
+    {
+      const Column &column = columns.at(key);
+      if (row >= column.entries.size())
+        continue;
+
+      column.entries[row].cache_string(column.scientific, column.precision);
+      const std::string &value = column.entries[row].get_cached_string();
+      if (value.empty())
+        continue;
+
+      if (!first)
+        out << ',';
+      first = false;
+
+      write_json_string(out, key);
+      out << ':';
+      if (is_json_number(value))
+        out << value;
+      else
+        write_json_string(out, value);
+    }
+  out << '}' << std::endl;
+}
+
+
+
+MPI_Comm &
+getCommunicator()
+{
+  static MPI_Comm communicator = MPI_COMM_WORLD;
+  return communicator;
+}
+
+
+
+MPI_Comm &
+getSharedMemoryCommunicator()
+{
+  static MPI_Comm communicator = MPI_COMM_SELF;
+  return communicator;
+}
+
+
+
 ConditionalOStream &
 getPCOut()
 {
   static ConditionalOStream pcout(std::cout,
-                                  (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0));
+                                  (Utilities::MPI::this_mpi_process(getCommunicator()) == 0));
   return pcout;
 }
 
@@ -42,9 +133,9 @@ getTimer()
 
 
 
-TableHandler &
+CycleTable &
 getTable()
 {
-  static TableHandler table_handler;
+  static CycleTable table_handler;
   return table_handler;
 }
@@ -0,0 +1,208 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+
+#include <instrumentation.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace dealii;
+
+
+namespace Instrumentation
+{
+  namespace
+  {
+    struct Counters
+    {
+      std::array<double, n_sections>             wall_time = {};
+      std::array<unsigned long long, n_sections> n_calls   = {};
+    };
+
+    Mode mode = Mode::off;
+
+    // counters of all threads, which only get registered on their first use
+    std::mutex                             mutex;
+    std::vector<std::unique_ptr<Counters>> all_counters;
+
+    Counters &
+    get_thread_counters()
+    {
+      thread_local Counters *counters = nullptr;
+      if (counters == nullptr)
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          all_counters.push_back(std::make_unique<Counters>());
+          counters = all_counters.back().get();
+        }
+      return *counters;
+    }
+
+
+
+    // sum over threads, optionally resetting the counters of all threads
+    Counters
+    sum_counters(const bool reset)
+    {
+      Counters sum;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto &counters : all_counters)
+        {
+          for (unsigned int s = 0; s < n_sections; ++s)
+            {
+              sum.wall_time[s] += counters->wall_time[s];
+              sum.n_calls[s] += counters->n_calls[s];
+            }
+          if (reset)
+            *counters = Counters();
+        }
+
+      return sum;
+    }
+  } // namespace
+
+
+
+  void
+  set_mode(const std::string &name)
+  {
+    if (name == "off")
+      mode = Mode::off;
+    else if (name == "summary")
+      mode = Mode::summary;
+    else if (name == "detailed")
+      mode = Mode::detailed;
+    else
+      AssertThrow(false, ExcMessage("Unknown instrumentation mode: " + name));
+  }
+
+
+
+  Mode
+  get_mode()
+  {
+    return mode;
+  }
+
+
+
+  std::string
+  get_name(const Section section)
+  {
+    switch (section)
+      {
+        case vmult:
+          return "vmult";
+        case vmult_asm:
+          return "vmult_asm";
+        case vmult_extdiag:
+          return "vmult_extdiag";
+        case vmult_diagonal:
+          return "vmult_diagonal";
+        case vmult_diagonal_a_block:
+          return "vmult_diagonal_ABlock";
+        case vmult_diagonal_schur_block:
+          return "vmult_diagonal_SchurBlock";
+        case vmult_a_block_operator:
+          return "vmult_ABlockOperator";
+        case vmult_schur_block_operator:
+          return "vmult_SchurBlockOperator";
+        case vmult_stokes_operator:
+          return "vmult_StokesOperator";
+        case vmult_block_schur_preconditioner:
+          return "vmult_BlockSchurPreconditioner";
+        default:
+          Assert(false, ExcNotImplemented());
+      }
+    return "";
+  }
+
+
+
+  void
+  add(const Section section, const double wall_time)
+  {
+    Counters &counters = get_thread_counters();
+    counters.wall_time[section] += wall_time;
+    ++counters.n_calls[section];
+  }
+
+
+
+  Discard::Discard()
+  {
+    const Counters sum = sum_counters(/*reset=*/false);
+    wall_time.assign(sum.wall_time.begin(), sum.wall_time.end());
+    n_calls.assign(sum.n_calls.begin(), sum.n_calls.end());
+  }
+
+
+
+  Discard::~Discard()
+  {
+    sum_counters(/*reset=*/true);
+
+    // only the sums over threads enter the table
+    std::lock_guard<std::mutex> lock(mutex);
+    if (all_counters.empty() == false)
+      {
+        std::copy(wall_time.begin(), wall_time.end(), all_counters.front()->wall_time.begin());
+        std::copy(n_calls.begin(), n_calls.end(), all_counters.front()->n_calls.begin());
+      }
+  }
+
+
+
+  void
+  add_to_table(TableHandler &table, const MPI_Comm mpi_communicator)
+  {
+    if (mode == Mode::off)
+      return;
+
+    const Counters local = sum_counters(/*reset=*/true);
+
+    // reduce over processes, all sections at once
+    const std::vector<double> wall_times(local.wall_time.begin(), local.wall_time.end());
+    const std::vector<Utilities::MPI::MinMaxAvg> statistics =
+      Utilities::MPI::min_max_avg(wall_times, mpi_communicator);
+
+    std::vector<unsigned long long> n_calls(local.n_calls.begin(), local.n_calls.end());
+    Utilities::MPI::max(n_calls, mpi_communicator, n_calls);
+
+    for (unsigned int s = 0; s < n_sections; ++s)
+      if (n_calls[s] > 0)
+        {
+          const std::string name = get_name(static_cast<Section>(s));
+
+          if (mode == Mode::detailed)
+            {
+              table.add_value(name + "_min", statistics[s].min);
+              table.set_scientific(name + "_min", true);
+              table.add_value(name + "_avg", statistics[s].avg);
+              table.set_scientific(name + "_avg", true);
+            }
+          table.add_value(name + "_max", statistics[s].max);
+          table.set_scientific(name + "_max", true);
+          table.add_value(name + "_ncalls", n_calls[s]);
+        }
+  }
+} // namespace Instrumentation
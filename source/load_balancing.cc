@@ -0,0 +1,80 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+
+#include <load_balancing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace dealii;
+
+
+namespace LoadBalancing
+{
+  std::vector<unsigned int>
+  fit_weights(const std::vector<double> &costs, const std::vector<unsigned int> &n_dofs_per_cell)
+  {
+    AssertDimension(costs.size(), n_dofs_per_cell.size());
+
+    // least-squares fit of log(cost) = log(c) + e * log(n)
+    double       sum_x = 0., sum_y = 0., sum_xx = 0., sum_xy = 0.;
+    unsigned int n_measured = 0;
+    for (unsigned int i = 0; i < costs.size(); ++i)
+      if (costs[i] > 0.)
+        {
+          const double x = std::log(n_dofs_per_cell[i]);
+          const double y = std::log(costs[i]);
+
+          sum_x += x;
+          sum_y += y;
+          sum_xx += x * x;
+          sum_xy += x * y;
+          ++n_measured;
+        }
+
+    AssertThrow(n_measured > 0, ExcMessage("No cell costs have been measured."));
+
+    double exponent = 1.;
+    if (const double denominator = n_measured * sum_xx - sum_x * sum_x;
+        n_measured > 1 && denominator > 0.)
+      exponent = (n_measured * sum_xy - sum_x * sum_y) / denominator;
+
+    const double log_factor = (sum_y - exponent * sum_x) / n_measured;
+
+    std::vector<double> fitted_costs(costs);
+    for (unsigned int i = 0; i < costs.size(); ++i)
+      if (costs[i] <= 0.)
+        fitted_costs[i] = std::exp(log_factor + exponent * std::log(n_dofs_per_cell[i]));
+
+    const double min_cost = *std::min_element(fitted_costs.begin(), fitted_costs.end());
+
+    std::vector<unsigned int> weights(costs.size());
+    for (unsigned int i = 0; i < costs.size(); ++i)
+      {
+        const double weight = std::round(1000. * fitted_costs[i] / min_cost);
+
+        AssertThrow(weight <= static_cast<double>(std::numeric_limits<unsigned int>::max()),
+                    ExcMessage("Cannot cast determined weight for this cell to unsigned int!"));
+
+        weights[i] = static_cast<unsigned int>(weight);
+      }
+
+    return weights;
+  }
+} // namespace LoadBalancing
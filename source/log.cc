@@ -14,17 +14,24 @@
 // ---------------------------------------------------------------------
 
 
+#include <deal.II/base/index_set.h>
 #include <deal.II/base/mpi.h>
+#include <deal.II/base/utilities.h>
 
 #include <deal.II/grid/tria.h>
 
 #include <deal.II/hp/fe_collection.h>
 
+#include <deal.II/lac/la_parallel_vector.h>
+
 #include <global.h>
+#include <instrumentation.h>
 #include <linear_algebra.h>
 #include <log.h>
 
 #include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <vector>
 
 using namespace dealii;
@@ -40,7 +47,7 @@ namespace Log
     getPCOut() << "Cycle " << cycle << ':' << std::endl;
     table.add_value("cycle", cycle);
 
-    table.add_value("processes", Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD));
+    table.add_value("processes", Utilities::MPI::n_mpi_processes(getCommunicator()));
     table.add_value("stem", prm.file_stem);
     table.add_value("weighting_exponent", prm.prm_adaptation.weighting_exponent);
   }
@@ -71,17 +78,30 @@ namespace Log
 
     const MPI_Comm &mpi_communicator = triangulation.get_communicator();
 
-    const unsigned int first_n_processes =
-      std::min<unsigned int>(8, Utilities::MPI::n_mpi_processes(mpi_communicator));
-    const bool output_cropped =
-      first_n_processes < Utilities::MPI::n_mpi_processes(mpi_communicator);
+    // distribution among processes is only reported in terms of reductions, so that the cost of
+    // logging does not grow with the number of processes
+    types::global_dof_index n_locally_owned_dofs = 0;
+    for (const auto &dof_handler : dof_handlers)
+      n_locally_owned_dofs += dof_handler->n_locally_owned_dofs();
 
-    const auto pcout_first_n = [&pcout, first_n_processes, output_cropped](const auto &container) {
-      for (unsigned int i = 0; i < first_n_processes; ++i)
-        pcout << ' ' << container[i];
-      if (output_cropped)
-        pcout << " ...";
-      pcout << std::endl;
+    types::global_dof_index n_constraints = 0, n_identities = 0;
+    for (const auto constraint : constraints)
+      {
+        n_constraints += constraint->n_constraints();
+        n_identities += constraint->n_identities();
+      }
+
+    const std::vector<double> local_counts = {
+      static_cast<double>(triangulation.n_locally_owned_active_cells()),
+      static_cast<double>(n_locally_owned_dofs),
+      static_cast<double>(n_constraints),
+      static_cast<double>(n_identities)};
+    const std::vector<Utilities::MPI::MinMaxAvg> partition =
+      Utilities::MPI::min_max_avg(local_counts, mpi_communicator);
+
+    const auto pcout_partition = [&pcout](const Utilities::MPI::MinMaxAvg &data) {
+      pcout << "     min/avg/max by partition:   " << data.min << ' ' << data.avg << ' ' << data.max
+            << std::endl;
     };
 
     {
@@ -94,11 +114,8 @@ namespace Log
             << std::endl;
       table.add_value("active_cells", triangulation.n_global_active_cells());
 
-      const std::vector<unsigned int> n_active_cells_per_subdomain =
-        Utilities::MPI::gather(mpi_communicator, triangulation.n_locally_owned_active_cells());
-
-      pcout << "     by partition:              ";
-      pcout_first_n(n_active_cells_per_subdomain);
+      pcout_partition(partition[0]);
+      table.add_value("active_cells_imbalance", partition[0].max / partition[0].avg);
     }
 
     {
@@ -135,54 +152,50 @@ namespace Log
       for (const auto &dof_handler : dof_handlers)
         global_dofs += dof_handler->n_dofs();
 
-      types::global_dof_index n_locally_owned_dofs = 0;
-      for (const auto &dof_handler : dof_handlers)
-        n_locally_owned_dofs += dof_handler->n_locally_owned_dofs();
-      const std::vector<types::global_dof_index> n_dofs_per_subdomain =
-        Utilities::MPI::gather(mpi_communicator, n_locally_owned_dofs);
-
       pcout << "   Number of degrees of freedom: " << global_dofs << std::endl;
       table.add_value("dofs", global_dofs);
 
-      pcout << "     by partition:              ";
-      pcout_first_n(n_dofs_per_subdomain);
+      pcout_partition(partition[1]);
+      table.add_value("dofs_imbalance", partition[1].max / partition[1].avg);
+
+      // histogram of locally owned dofs with equidistant bins between min and max
+      constexpr unsigned int               n_bins = 8;
+      std::vector<types::global_dof_index> histogram(n_bins, 0);
+      {
+        const double       width = (partition[1].max - partition[1].min) / n_bins;
+        const unsigned int bin =
+          (width > 0.) ?
+            std::min<unsigned int>((n_locally_owned_dofs - partition[1].min) / width, n_bins - 1) :
+            0;
+        histogram[bin] = 1;
+      }
+      Utilities::MPI::sum(histogram, mpi_communicator, histogram);
+
+      pcout << "     histogram by partition:    ";
+      for (const auto count : histogram)
+        pcout << ' ' << count;
+      pcout << std::endl;
     }
 
     {
-      types::global_dof_index n_constraints = 0;
-      for (const auto constraint : constraints)
-        n_constraints += constraint->n_constraints();
-
-      const std::vector<types::global_dof_index> n_constraints_per_subdomain =
-        Utilities::MPI::gather(mpi_communicator, n_constraints);
-      const types::global_dof_index global_constraints =
-        std::accumulate(n_constraints_per_subdomain.begin(), n_constraints_per_subdomain.end(), 0);
+      const types::global_dof_index global_constraints = std::llround(partition[2].sum);
 
       pcout << "   Number of constraints:        " << global_constraints << std::endl;
       table.add_value("constraints", global_constraints);
 
-      pcout << "     by partition:              ";
-      pcout_first_n(n_constraints_per_subdomain);
+      pcout_partition(partition[2]);
 
       const float fraction = static_cast<float>(global_constraints) / global_dofs;
       pcout << "   Fraction of constraints:      " << 100 * fraction << "%" << std::endl;
     }
 
     {
-      types::global_dof_index n_identities = 0;
-      for (const auto constraint : constraints)
-        n_identities += constraint->n_identities();
-
-      const std::vector<types::global_dof_index> n_identities_per_subdomain =
-        Utilities::MPI::gather(mpi_communicator, n_identities);
-      const types::global_dof_index global_identities =
-        std::accumulate(n_identities_per_subdomain.begin(), n_identities_per_subdomain.end(), 0);
+      const types::global_dof_index global_identities = std::llround(partition[3].sum);
 
       pcout << "   Number of identities:         " << global_identities << std::endl;
       table.add_value("identities", global_identities);
 
-      pcout << "     by partition:              ";
-      pcout_first_n(n_identities_per_subdomain);
+      pcout_partition(partition[3]);
 
       const float fraction = static_cast<float>(global_identities) / global_dofs;
       pcout << "   Fraction of identities:       " << 100 * fraction << "%" << std::endl;
@@ -231,27 +244,104 @@ namespace Log
 
     for (const auto &summary : getTimer().get_summary_data(TimerOutput::n_calls))
       getTable().add_value(summary.first + "_ncalls", summary.second);
+
+    Instrumentation::add_to_table(getTable(), mpi_communicator);
+  }
+
+
+
+  void
+  log_memory_consumption(const std::string &name,
+                         const std::size_t  bytes,
+                         const MPI_Comm     mpi_communicator)
+  {
+    const Utilities::MPI::MinMaxAvg data =
+      Utilities::MPI::min_max_avg(bytes / 1e6, mpi_communicator);
+
+    const std::string column = "memory_" + name;
+    getTable().add_value(column + "_min", data.min);
+    getTable().add_value(column + "_max", data.max);
+    getTable().add_value(column + "_avg", data.avg);
+    getTable().set_scientific(column + "_min", true);
+    getTable().set_scientific(column + "_max", true);
+    getTable().set_scientific(column + "_avg", true);
   }
 
 
 
-  template <int dim, int spacedim>
   void
-  log_patch_dofs(const std::vector<std::vector<types::global_dof_index>> &patch_indices,
-                 const DoFHandler<dim, spacedim>                         &dof_handler)
+  log_memory_statistics(const MPI_Comm mpi_communicator)
   {
-    std::set<types::global_dof_index> all_indices;
+    Utilities::System::MemoryStats stats;
+    Utilities::System::get_memory_stats(stats);
+
+    // memory statistics are given in kB
+    log_memory_consumption("rss", stats.VmRSS * 1024, mpi_communicator);
+    log_memory_consumption("rss_peak", stats.VmHWM * 1024, mpi_communicator);
+  }
+
 
-    // patch_indices contains locally active dofs. patches are unique among all processes, but not
-    // all patch indices. so ideally we would need to exchange all patch indices via MPI. currently,
-    // it is just an estimate.
-    for (const auto &indices : patch_indices)
-      for (const auto i : indices)
-        all_indices.insert(i);
+
+  void
+  write_table(const std::string &filename,
+              const std::string &format,
+              const MPI_Comm     mpi_communicator)
+  {
+    if (Utilities::MPI::this_mpi_process(mpi_communicator) != 0)
+      return;
+
+    if (format == "text")
+      {
+        std::ofstream logstream(filename);
+        getTable().write_text(logstream);
+      }
+    else if (format == "jsonl")
+      {
+        std::string filename_jsonl = filename;
+        if (const auto pos = filename_jsonl.rfind(".log"); pos != std::string::npos)
+          filename_jsonl.erase(pos);
+
+        std::ofstream logstream(filename_jsonl + ".jsonl", std::ios::app);
+        getTable().write_current_row_json(logstream);
+      }
+    else
+      {
+        AssertThrow(false, ExcMessage("Unknown log format: " + format));
+      }
+  }
+
+
+
+  template <int dim, int spacedim>
+  void
+  log_patch_dofs(const PatchIndices &patch_indices, const DoFHandler<dim, spacedim> &dof_handler)
+  {
+    // patch_indices contains locally active dofs, and patches of different processes may share
+    // some of them. mark all of them in a vector with ghost entries, so that each dof is counted
+    // exactly once by its owner after the ghost exchange with the neighbors.
+    std::vector<types::global_dof_index> indices(patch_indices.get_all_indices().begin(),
+                                                 patch_indices.get_all_indices().end());
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    IndexSet ghost_indices(dof_handler.n_dofs());
+    ghost_indices.add_indices(indices.begin(), indices.end());
+    ghost_indices.subtract_set(dof_handler.locally_owned_dofs());
+
+    LinearAlgebra::distributed::Vector<float> marker(dof_handler.locally_owned_dofs(),
+                                                     ghost_indices,
+                                                     dof_handler.get_communicator());
+    for (const auto i : indices)
+      marker[i] = 1.;
+    marker.compress(VectorOperation::add);
+
+    types::global_dof_index n_patch_dofs = 0;
+    for (unsigned int i = 0; i < marker.locally_owned_size(); ++i)
+      if (marker.local_element(i) > 0.)
+        ++n_patch_dofs;
 
     const auto n_global_patch_dofs =
-      Utilities::MPI::sum<types::global_dof_index>(all_indices.size(),
-                                                   dof_handler.get_communicator());
+      Utilities::MPI::sum<types::global_dof_index>(n_patch_dofs, dof_handler.get_communicator());
 
     getPCOut() << "   Number of patch DoFs:         " << n_global_patch_dofs << std::endl;
     getTable().add_value("patch_dofs", n_global_patch_dofs);
@@ -273,11 +363,9 @@ namespace Log
                                    const AffineConstraints<double> &);
 
   template void
-  log_patch_dofs<2, 2>(const std::vector<std::vector<dealii::types::global_dof_index>> &,
-                       const DoFHandler<2, 2> &);
+  log_patch_dofs<2, 2>(const PatchIndices &, const DoFHandler<2, 2> &);
   template void
-  log_patch_dofs<3, 3>(const std::vector<std::vector<dealii::types::global_dof_index>> &,
-                       const DoFHandler<3, 3> &);
+  log_patch_dofs<3, 3>(const PatchIndices &, const DoFHandler<3, 3> &);
 
 #ifdef DEAL_II_WITH_TRILINOS
   template void
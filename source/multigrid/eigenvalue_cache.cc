@@ -0,0 +1,90 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+
+#include <multigrid/eigenvalue_cache.h>
+
+#include <algorithm>
+
+using namespace dealii;
+
+
+void
+EigenvalueCache::reinit(const std::vector<std::size_t> &level_hashes,
+                        const MPI_Comm                  communicator,
+                        const bool                      enabled,
+                        const unsigned int              max_age)
+{
+  this->level_hashes = level_hashes;
+  this->communicator = communicator;
+  this->enabled      = enabled;
+  this->max_age      = max_age;
+
+  hits   = 0;
+  misses = 0;
+
+  // Drop estimates of levels that are no longer part of the hierarchy.
+  for (auto it = entries.begin(); it != entries.end();)
+    if (std::find(level_hashes.begin(), level_hashes.end(), it->first) == level_hashes.end())
+      it = entries.erase(it);
+    else
+      ++it;
+}
+
+
+
+bool
+EigenvalueCache::get(const unsigned int level, double &min_eigenvalue, double &max_eigenvalue)
+{
+  AssertIndexRange(level, level_hashes.size());
+
+  if (enabled == false)
+    return false;
+
+  const auto it = entries.find(level_hashes[level]);
+
+  const bool local_hit = (it != entries.end()) && (max_age == 0 || it->second.age < max_age);
+
+  if (Utilities::MPI::min(local_hit ? 1u : 0u, communicator) == 0)
+    {
+      ++misses;
+      return false;
+    }
+
+  ++hits;
+  ++(it->second.age);
+
+  min_eigenvalue = it->second.min_eigenvalue;
+  max_eigenvalue = it->second.max_eigenvalue;
+
+  return true;
+}
+
+
+
+void
+EigenvalueCache::set(const unsigned int level,
+                     const double       min_eigenvalue,
+                     const double       max_eigenvalue)
+{
+  AssertIndexRange(level, level_hashes.size());
+
+  if (enabled == false)
+    return;
+
+  entries[level_hashes[level]] = {min_eigenvalue, max_eigenvalue, 0};
+}
@@ -0,0 +1,138 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+
+#include <multigrid/mg_level_profiler.h>
+
+#include <fstream>
+
+using namespace dealii;
+
+
+MGLevelProfiler::MGLevelProfiler(const unsigned int n_levels)
+  : records(n_levels)
+{
+  for (unsigned int level = 0; level < n_levels; ++level)
+    for (unsigned int step = 0; step < n_steps; ++step)
+      records[level][step].region =
+        "mg_level_" + std::to_string(level) + "_" + get_name(static_cast<Step>(step));
+}
+
+
+
+std::string
+MGLevelProfiler::get_name(const Step step)
+{
+  switch (step)
+    {
+      case pre_smoother_step:
+        return "pre_smoother_step";
+      case residual_step:
+        return "residual_step";
+      case restriction:
+        return "restriction";
+      case coarse_solve:
+        return "coarse_solve";
+      case prolongation:
+        return "prolongation";
+      case edge_prolongation:
+        return "edge_prolongation";
+      case post_smoother_step:
+        return "post_smoother_step";
+      default:
+        Assert(false, ExcInternalError());
+        return "";
+    }
+}
+
+
+
+void
+MGLevelProfiler::signal(const unsigned int level, const Step step, const bool start)
+{
+  AssertIndexRange(level, records.size());
+  Record &record = records[level][step];
+
+  if (start)
+    {
+#ifdef LIKWID_PERFMON
+      LIKWID_MARKER_START(record.region.c_str());
+#endif
+      record.start = std::chrono::steady_clock::now();
+    }
+  else
+    {
+      record.wall_time +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - record.start).count();
+      ++record.n_calls;
+#ifdef LIKWID_PERFMON
+      LIKWID_MARKER_STOP(record.region.c_str());
+#endif
+    }
+}
+
+
+
+void
+MGLevelProfiler::write_json(const std::string                          &filename,
+                            const std::vector<types::global_dof_index> &n_dofs,
+                            const MPI_Comm                              communicator) const
+{
+  AssertDimension(n_dofs.size(), records.size());
+
+  std::vector<double> wall_times;
+  for (const auto &level_records : records)
+    for (const auto &record : level_records)
+      wall_times.push_back(record.wall_time);
+
+  const std::vector<Utilities::MPI::MinMaxAvg> statistics =
+    Utilities::MPI::min_max_avg(wall_times, communicator);
+
+  if (Utilities::MPI::this_mpi_process(communicator) != 0)
+    return;
+
+  std::ofstream file(filename);
+  file << "{\n";
+  file << "  \"n_processes\": " << Utilities::MPI::n_mpi_processes(communicator) << ",\n";
+  file << "  \"levels\": [\n";
+
+  for (unsigned int level = 0; level < records.size(); ++level)
+    {
+      file << "    {\n";
+      file << "      \"level\": " << level << ",\n";
+      file << "      \"n_dofs\": " << n_dofs[level] << ",\n";
+      file << "      \"steps\": {\n";
+
+      for (unsigned int step = 0; step < n_steps; ++step)
+        {
+          const auto &data = statistics[level * n_steps + step];
+
+          file << "        \"" << get_name(static_cast<Step>(step)) << "\": {"
+               << "\"n_calls\": " << records[level][step].n_calls << ", "
+               << "\"wall_time_min\": " << data.min << ", "
+               << "\"wall_time_max\": " << data.max << ", "
+               << "\"wall_time_avg\": " << data.avg << "}"
+               << ((step + 1 < n_steps) ? ",\n" : "\n");
+        }
+
+      file << "      }\n";
+      file << "    }" << ((level + 1 < records.size()) ? ",\n" : "\n");
+    }
+
+  file << "  ]\n";
+  file << "}\n";
+}
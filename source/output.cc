@@ -0,0 +1,87 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/exceptions.h>
+
+#include <output.h>
+
+#include <algorithm>
+
+using namespace dealii;
+
+
+namespace Output
+{
+  bool
+  has_field(const Parameter &prm, const std::string &field)
+  {
+    return std::find(prm.output_fields.begin(), prm.output_fields.end(), field) !=
+           prm.output_fields.end();
+  }
+
+
+
+  template <int dim, int spacedim>
+  void
+  write_vtu_with_pvtu_record(DataOut<dim, spacedim> &data_out,
+                             const Parameter        &prm,
+                             const unsigned int      cycle,
+                             const MPI_Comm          mpi_communicator,
+                             AsyncWriter            *async_writer)
+  {
+#if DEAL_II_VERSION_GTE(9, 5, 0)
+    using CompressionLevel = DataOutBase::CompressionLevel;
+#else
+    using CompressionLevel = DataOutBase::VtkFlags::ZlibCompressionLevel;
+#endif
+
+    DataOutBase::VtkFlags flags;
+    if (prm.output_compression == "none")
+      flags.compression_level = CompressionLevel::no_compression;
+    else if (prm.output_compression == "best speed")
+      flags.compression_level = CompressionLevel::best_speed;
+    else if (prm.output_compression == "best compression")
+      flags.compression_level = CompressionLevel::best_compression;
+    else if (prm.output_compression == "default")
+      flags.compression_level = CompressionLevel::default_compression;
+    else
+      AssertThrow(false, ExcMessage("Unknown output compression: " + prm.output_compression));
+    data_out.set_flags(flags);
+
+    if (async_writer != nullptr)
+      ::write_vtu_with_pvtu_record(
+        *async_writer, data_out, flags, "./", prm.file_stem, cycle, mpi_communicator, 2);
+    else
+      data_out.write_vtu_with_pvtu_record(
+        "./", prm.file_stem, cycle, mpi_communicator, 2, prm.output_file_groups);
+  }
+
+
+
+  // explicit instantiations
+  template void
+  write_vtu_with_pvtu_record<2, 2>(DataOut<2, 2> &,
+                                   const Parameter &,
+                                   const unsigned int,
+                                   const MPI_Comm,
+                                   AsyncWriter *);
+  template void
+  write_vtu_with_pvtu_record<3, 3>(DataOut<3, 3> &,
+                                   const Parameter &,
+                                   const unsigned int,
+                                   const MPI_Comm,
+                                   AsyncWriter *);
+} // namespace Output
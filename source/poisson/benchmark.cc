@@ -0,0 +1,280 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2023 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE.md at
+// the top level directory of deal.II.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/base/timer.h>
+
+#include <deal.II/fe/fe_q.h>
+
+#include <deal.II/lac/solver_control.h>
+
+#include <deal.II/numerics/vector_tools.h>
+
+#include <factory.h>
+#include <global.h>
+#include <linear_algebra.h>
+#include <log.h>
+#include <poisson/benchmark.h>
+#include <poisson/solvers.h>
+
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+using namespace dealii;
+
+
+namespace Poisson
+{
+  template <int dim, typename LinearAlgebra, int spacedim>
+  Benchmark<dim, LinearAlgebra, spacedim>::Benchmark(const Parameter &prm)
+    : mpi_communicator(getCommunicator())
+    , prm(prm)
+    , triangulation(mpi_communicator)
+    , dof_handler(triangulation)
+  {
+    TimerOutput::Scope t(getTimer(), "initialize_problem");
+
+    // prepare name for logfile
+    {
+      time_t             now = time(nullptr);
+      tm                *ltm = localtime(&now);
+      std::ostringstream oss;
+      oss << prm.file_stem << "-" << std::put_time(ltm, "%Y%m%d-%H%M%S");
+      filename_stem = oss.str();
+    }
+
+    // prepare collections
+    mapping_collection.push_back(MappingQ1<dim, spacedim>());
+
+    for (unsigned int degree = 1; degree <= prm.prm_adaptation.max_p_degree; ++degree)
+      {
+        fe_collection.push_back(FE_Q<dim, spacedim>(degree));
+        quadrature_collection.push_back(QGauss<dim>(degree + 1));
+      }
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Benchmark<dim, LinearAlgebra, spacedim>::initialize_grid()
+  {
+    TimerOutput::Scope t(getTimer(), "initialize_grid");
+
+    Factory::create_grid(prm.grid_type, triangulation);
+    triangulation.refine_global(prm.prm_adaptation.min_h_level);
+
+    const unsigned int min_fe_index = prm.prm_adaptation.min_p_degree - 1;
+    const unsigned int max_fe_index = prm.prm_adaptation.max_p_degree - 1;
+
+    // Derive the degree from the cell id, so that the distribution does not
+    // depend on the number of processes.
+    for (const auto &cell : dof_handler.active_cell_iterators())
+      if (cell->is_locally_owned())
+        {
+          if (prm.random_degrees)
+            cell->set_active_fe_index(
+              min_fe_index +
+              std::hash<std::string>()(cell->id().to_string()) % (max_fe_index - min_fe_index + 1));
+          else
+            cell->set_active_fe_index(max_fe_index);
+        }
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Benchmark<dim, LinearAlgebra, spacedim>::setup_system()
+  {
+    TimerOutput::Scope t(getTimer(), "setup_system");
+
+    dof_handler.distribute_dofs(fe_collection);
+    partitioning.reinit(dof_handler);
+
+    // homogeneous Dirichlet boundary conditions, just like on the multigrid levels
+    constraints.clear();
+    constraints.reinit(partitioning.get_relevant_dofs());
+
+    DoFTools::make_hanging_node_constraints(dof_handler, constraints);
+    DoFTools::make_zero_boundary_constraints(dof_handler, 0, constraints);
+
+    constraints.close();
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Benchmark<dim, LinearAlgebra, spacedim>::benchmark_operator(const std::string &operator_type)
+  {
+    getPCOut() << "Benchmarking " << operator_type << " operator:" << std::endl;
+
+    const unsigned int n_processes = Utilities::MPI::n_mpi_processes(mpi_communicator);
+    const double       n_dofs      = dof_handler.n_dofs();
+
+    TableHandler &table = getTable();
+    table.add_value("operator_type", operator_type);
+    table.add_value("processes", n_processes);
+    table.add_value("repetitions", prm.n_repetitions);
+
+    Log::log_hp_diagnostics(triangulation, dof_handler, constraints);
+
+    auto poisson_operator =
+      Factory::create_poisson_operator<dim, LinearAlgebra, spacedim>(operator_type,
+                                                                     mapping_collection,
+                                                                     quadrature_collection,
+                                                                     fe_collection);
+
+    typename LinearAlgebra::Vector system_rhs;
+    {
+      TimerOutput::Scope t(getTimer(), "setup_operator");
+
+      poisson_operator->reinit(partitioning, dof_handler, constraints, system_rhs, nullptr);
+    }
+
+    // Report the time of the slowest process per repetition.
+    const auto report = [&](const std::string &name, const double local_time) {
+      const double time_per_repetition =
+        Utilities::MPI::max(local_time, mpi_communicator) / prm.n_repetitions;
+
+      getPCOut() << "   " << std::left << std::setw(20) << name << time_per_repetition << "s, "
+                 << n_dofs / time_per_repetition << " DoFs/s, "
+                 << n_dofs / time_per_repetition / n_processes << " DoFs/s/core" << std::endl;
+
+      table.add_value(name + "_time", time_per_repetition);
+      table.add_value(name + "_dofs_per_s", n_dofs / time_per_repetition);
+      table.add_value(name + "_dofs_per_s_per_core", n_dofs / time_per_repetition / n_processes);
+      table.set_scientific(name + "_time", true);
+      table.set_scientific(name + "_dofs_per_s", true);
+      table.set_scientific(name + "_dofs_per_s_per_core", true);
+    };
+
+    typename LinearAlgebra::Vector src, dst;
+    poisson_operator->initialize_dof_vector(src);
+    poisson_operator->initialize_dof_vector(dst);
+    src = 1.;
+
+    // operator application, warmed up once
+    {
+      poisson_operator->vmult(dst, src);
+
+      MPI_Barrier(mpi_communicator);
+      Timer timer;
+      for (unsigned int i = 0; i < prm.n_repetitions; ++i)
+        poisson_operator->vmult(dst, src);
+      timer.stop();
+
+      report("vmult", timer.wall_time());
+    }
+
+    // CG iterations with one V-cycle each
+    if (prm.solver_type == "GMG" || prm.solver_type == "GMG pipelined")
+      {
+        if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos>)
+          {
+            const std::string filename_mg_level =
+              filename_stem + "-mglevel-" + operator_type + ".log";
+
+            std::unique_ptr<MGHierarchyBase> mg_hierarchy;
+
+            // The hierarchy including smoothers is set up on a first solve,
+            // which is reused in the timed one.
+            dst = 0.;
+            IterationNumberControl setup_control(1, 0.);
+            solve_gmg_with_smoother<dim, LinearAlgebra, spacedim, LinearAlgebra>(
+              setup_control,
+              *poisson_operator,
+              *poisson_operator,
+              dst,
+              src,
+              prm.prm_multigrid,
+              prm.prm_multigrid.smoother_preconditioner_type,
+              quadrature_collection,
+              dof_handler,
+              mg_hierarchy,
+              filename_mg_level,
+              prm.solver_type == "GMG pipelined");
+
+            dst = 0.;
+            IterationNumberControl solver_control(prm.n_repetitions, 0.);
+
+            MPI_Barrier(mpi_communicator);
+            Timer timer;
+            solve_gmg_with_smoother<dim, LinearAlgebra, spacedim, LinearAlgebra>(
+              solver_control,
+              *poisson_operator,
+              *poisson_operator,
+              dst,
+              src,
+              prm.prm_multigrid,
+              prm.prm_multigrid.smoother_preconditioner_type,
+              quadrature_collection,
+              dof_handler,
+              mg_hierarchy,
+              filename_mg_level,
+              prm.solver_type == "GMG pipelined");
+            timer.stop();
+
+            report("cg_vcycle", timer.wall_time());
+          }
+        else
+          {
+            AssertThrow(false, ExcMessage("GMG is only available with dealii & Trilinos!"));
+          }
+      }
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Benchmark<dim, LinearAlgebra, spacedim>::run()
+  {
+    getTable().set_auto_fill_mode(true);
+
+    initialize_grid();
+    setup_system();
+
+    for (const auto &operator_type : prm.benchmark_operator_types)
+      {
+        benchmark_operator(operator_type);
+
+        Log::log_timing_statistics(mpi_communicator);
+
+        Log::write_table(filename_stem + ".log", prm.log_format, mpi_communicator);
+
+        getTimer().reset();
+        getTable().start_new_row();
+      }
+  }
+
+
+
+  // explicit instantiations
+#ifdef DEAL_II_WITH_TRILINOS
+  template class Benchmark<2, dealiiTrilinos, 2>;
+  template class Benchmark<3, dealiiTrilinos, 3>;
+  template class Benchmark<2, Trilinos, 2>;
+  template class Benchmark<3, Trilinos, 3>;
+#endif
+
+#ifdef DEAL_II_WITH_PETSC
+  template class Benchmark<2, PETSc, 2>;
+  template class Benchmark<3, PETSc, 3>;
+#endif
+} // namespace Poisson
@@ -14,10 +14,19 @@
 // ---------------------------------------------------------------------
 
 
+#include <deal.II/base/work_stream.h>
+
+#include <deal.II/fe/mapping_q.h>
+
+#include <deal.II/grid/filtered_iterator.h>
+
 #include <deal.II/lac/full_matrix.h>
 #include <deal.II/lac/vector.h>
 
+#include <deal.II/meshworker/copy_data.h>
+
 #include <global.h>
+#include <instrumentation.h>
 #include <linear_algebra.h>
 #include <poisson/matrixbased_operator.h>
 
@@ -26,6 +35,54 @@ using namespace dealii;
 
 namespace PoissonMatrixBased
 {
+  namespace
+  {
+    /**
+     * Return whether @p cell is a parallelepiped with mutually orthogonal
+     * edges, like an axis-aligned box, and fill @p edge_lengths in that case.
+     * The Jacobian of the affine map onto such a cell has orthogonal columns.
+     */
+    template <int dim, int spacedim, typename CellIteratorType>
+    bool
+    is_orthogonal_parallelepiped(const CellIteratorType  &cell,
+                                 std::array<double, dim> &edge_lengths)
+    {
+      if (cell->reference_cell() != ReferenceCells::get_hypercube<dim>())
+        return false;
+
+      const double tolerance = 1e-10 * cell->diameter();
+
+      const Point<spacedim> origin = cell->vertex(0);
+
+      std::array<Tensor<1, spacedim>, dim> edges;
+      for (unsigned int d = 0; d < dim; ++d)
+        {
+          edges[d]        = cell->vertex(1u << d) - origin;
+          edge_lengths[d] = edges[d].norm();
+        }
+
+      for (unsigned int d = 0; d < dim; ++d)
+        for (unsigned int e = d + 1; e < dim; ++e)
+          if (std::abs(edges[d] * edges[e]) > tolerance * edge_lengths[e])
+            return false;
+
+      for (const unsigned int v : cell->vertex_indices())
+        {
+          Point<spacedim> vertex = origin;
+          for (unsigned int d = 0; d < dim; ++d)
+            if (v & (1u << d))
+              vertex += edges[d];
+
+          if (vertex.distance(cell->vertex(v)) > tolerance)
+            return false;
+        }
+
+      return true;
+    }
+  } // namespace
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   PoissonOperator<dim, LinearAlgebra, spacedim>::PoissonOperator(
     const hp::MappingCollection<dim, spacedim> &mapping_collection,
@@ -87,43 +144,12 @@ namespace PoissonMatrixBased
       {
         TimerOutput::Scope t(getTimer(), "reinit_matrix");
 
-        initialize_sparse_matrix(system_matrix, dof_handler, constraints, partitioning);
+        reinit_or_zero_sparse_matrix(
+          system_matrix, sparsity_hash, dof_handler, constraints, partitioning);
       }
     }
 
-    {
-      TimerOutput::Scope t(getTimer(), "assemble_system");
-
-      FullMatrix<double>                   cell_matrix;
-      std::vector<types::global_dof_index> local_dof_indices;
-      for (const auto &cell : dof_handler.active_cell_iterators())
-        {
-          if (cell->is_locally_owned() == false)
-            continue;
-
-          const unsigned int dofs_per_cell = cell->get_fe().dofs_per_cell;
-          cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
-          cell_matrix = 0;
-
-          fe_values_collection.reinit(cell);
-          const FEValues<dim> &fe_values = fe_values_collection.get_present_fe_values();
-
-          for (unsigned int q_point = 0; q_point < fe_values.n_quadrature_points; ++q_point)
-            for (unsigned int i = 0; i < dofs_per_cell; ++i)
-              {
-                for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                  cell_matrix(i, j) += (fe_values.shape_grad(i, q_point) * // grad phi_i(x_q)
-                                        fe_values.shape_grad(j, q_point) * // grad phi_j(x_q)
-                                        fe_values.JxW(q_point));           // dx
-              }
-          local_dof_indices.resize(dofs_per_cell);
-          cell->get_dof_indices(local_dof_indices);
-
-          constraints.distribute_local_to_global(cell_matrix, local_dof_indices, system_matrix);
-        }
-
-      system_matrix.compress(VectorOperation::values::add);
-    }
+    assemble_system(dof_handler, constraints, nullptr);
   }
 
 
@@ -148,7 +174,8 @@ namespace PoissonMatrixBased
       {
         TimerOutput::Scope t(getTimer(), "reinit_matrix");
 
-        initialize_sparse_matrix(system_matrix, dof_handler, constraints, partitioning);
+        reinit_or_zero_sparse_matrix(
+          system_matrix, sparsity_hash, dof_handler, constraints, partitioning);
       }
 
       {
@@ -158,44 +185,155 @@ namespace PoissonMatrixBased
       }
     }
 
-    {
-      TimerOutput::Scope t(getTimer(), "assemble_system");
+    assemble_system(dof_handler, constraints, &system_rhs);
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  PoissonOperator<dim, LinearAlgebra, spacedim>::assemble_system(
+    const DoFHandler<dim, spacedim>     &dof_handler,
+    const AffineConstraints<value_type> &constraints,
+    VectorType                          *system_rhs)
+  {
+    TimerOutput::Scope t(getTimer(), "assemble_system");
+
+    using CellFilter  = FilteredIterator<typename DoFHandler<dim, spacedim>::active_cell_iterator>;
+    using ScratchData = hp::FEValues<dim, spacedim>;
+    using CopyData    = MeshWorker::CopyData<1, 1, 1>;
+
+    // With a linear mapping, the Laplace matrix of a cell with orthogonal
+    // edges of lengths h_d is a weighted sum of the reference matrices, i.e.,
+    // sum_d (h_0 ... h_{dim-1} / h_d^2) reference_matrices[fe_index][d].
+    bool linear_mapping = true;
+    for (unsigned int i = 0; i < mapping_collection->size(); ++i)
+      {
+        const auto *mapping_q =
+          dynamic_cast<const MappingQ<dim, spacedim> *>(&(*mapping_collection)[i]);
+        if (mapping_q == nullptr || mapping_q->get_degree() != 1)
+          linear_mapping = false;
+      }
+
+    if (linear_mapping)
+      setup_reference_matrices(dof_handler);
 
-      FullMatrix<double>                   cell_matrix;
-      Vector<double>                       cell_rhs;
-      std::vector<types::global_dof_index> local_dof_indices;
-      for (const auto &cell : dof_handler.active_cell_iterators())
+    // Cell matrices are computed in parallel tasks, each with its own copy of
+    // fe_values_collection. WorkStream calls the copier in order on one
+    // thread at a time, since the matrix can not be written concurrently.
+    const auto worker = [&](const typename DoFHandler<dim, spacedim>::active_cell_iterator &cell,
+                            ScratchData &fe_values_collection,
+                            CopyData    &copy_data) {
+      const unsigned int dofs_per_cell = cell->get_fe().dofs_per_cell;
+
+      auto &cell_matrix = copy_data.matrices[0];
+      cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
+      copy_data.vectors[0].reinit(dofs_per_cell);
+
+      copy_data.local_dof_indices[0].resize(dofs_per_cell);
+      cell->get_dof_indices(copy_data.local_dof_indices[0]);
+
+      std::array<double, dim> edge_lengths;
+      if (linear_mapping && is_orthogonal_parallelepiped<dim, spacedim>(cell, edge_lengths))
         {
-          if (cell->is_locally_owned() == false)
-            continue;
-
-          const unsigned int dofs_per_cell = cell->get_fe().dofs_per_cell;
-          cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
-          cell_matrix = 0;
-          cell_rhs.reinit(dofs_per_cell);
-          cell_rhs = 0;
-
-          fe_values_collection.reinit(cell);
-          const FEValues<dim> &fe_values = fe_values_collection.get_present_fe_values();
-
-          for (unsigned int q_point = 0; q_point < fe_values.n_quadrature_points; ++q_point)
-            for (unsigned int i = 0; i < dofs_per_cell; ++i)
-              {
-                for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                  cell_matrix(i, j) += (fe_values.shape_grad(i, q_point) * // grad phi_i(x_q)
-                                        fe_values.shape_grad(j, q_point) * // grad phi_j(x_q)
-                                        fe_values.JxW(q_point));           // dx
-              }
-          local_dof_indices.resize(dofs_per_cell);
-          cell->get_dof_indices(local_dof_indices);
-
-          constraints.distribute_local_to_global(
-            cell_matrix, cell_rhs, local_dof_indices, system_matrix, system_rhs);
+          double volume = 1.;
+          for (unsigned int d = 0; d < dim; ++d)
+            volume *= edge_lengths[d];
+
+          const auto &matrices = reference_matrices[cell->active_fe_index()];
+          for (unsigned int d = 0; d < dim; ++d)
+            cell_matrix.add(volume / (edge_lengths[d] * edge_lengths[d]), matrices[d]);
+
+          return;
         }
 
-      system_rhs.compress(VectorOperation::values::add);
-      system_matrix.compress(VectorOperation::values::add);
-    }
+      fe_values_collection.reinit(cell);
+      const FEValues<dim> &fe_values = fe_values_collection.get_present_fe_values();
+
+      for (unsigned int q_point = 0; q_point < fe_values.n_quadrature_points; ++q_point)
+        for (unsigned int i = 0; i < dofs_per_cell; ++i)
+          {
+            for (unsigned int j = 0; j < dofs_per_cell; ++j)
+              cell_matrix(i, j) += (fe_values.shape_grad(i, q_point) * // grad phi_i(x_q)
+                                    fe_values.shape_grad(j, q_point) * // grad phi_j(x_q)
+                                    fe_values.JxW(q_point));           // dx
+          }
+    };
+
+    const auto copier = [&](const CopyData &copy_data) {
+      if (system_rhs != nullptr)
+        constraints.distribute_local_to_global(copy_data.matrices[0],
+                                               copy_data.vectors[0],
+                                               copy_data.local_dof_indices[0],
+                                               system_matrix,
+                                               *system_rhs);
+      else
+        constraints.distribute_local_to_global(copy_data.matrices[0],
+                                               copy_data.local_dof_indices[0],
+                                               system_matrix);
+    };
+
+    WorkStream::run(CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.begin_active()),
+                    CellFilter(IteratorFilters::LocallyOwnedCell(), dof_handler.end()),
+                    worker,
+                    copier,
+                    ScratchData(fe_values_collection),
+                    CopyData(0));
+
+    if (system_rhs != nullptr)
+      system_rhs->compress(VectorOperation::values::add);
+    system_matrix.compress(VectorOperation::values::add);
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  PoissonOperator<dim, LinearAlgebra, spacedim>::setup_reference_matrices(
+    const DoFHandler<dim, spacedim> &dof_handler)
+  {
+    const auto &fe_collection = fe_values_collection.get_fe_collection();
+
+    reference_matrices.resize(fe_collection.size());
+
+    // only set up matrices for elements in use that are not known yet
+    std::vector<bool> in_use(fe_collection.size(), false);
+    for (const auto &cell :
+         dof_handler.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
+      in_use[cell->active_fe_index()] = true;
+
+    for (unsigned int f = 0; f < fe_collection.size(); ++f)
+      if (in_use[f] && reference_matrices[f][0].m() == 0)
+        {
+          const auto &fe = fe_collection[f];
+          const auto &quadrature =
+            (*quadrature_collection)[quadrature_collection->size() > 1 ? f : 0];
+
+          const unsigned int dofs_per_cell = fe.n_dofs_per_cell();
+
+          // derivatives in each direction at the quadrature points of the
+          // unit cell, scaled such that A_d = G_d G_d^T
+          std::array<FullMatrix<double>, dim> gradients;
+          for (unsigned int d = 0; d < dim; ++d)
+            gradients[d].reinit(dofs_per_cell, quadrature.size());
+
+          for (unsigned int q = 0; q < quadrature.size(); ++q)
+            {
+              const double sqrt_weight = std::sqrt(quadrature.weight(q));
+              for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                {
+                  const Tensor<1, dim> gradient = fe.shape_grad(i, quadrature.point(q));
+                  for (unsigned int d = 0; d < dim; ++d)
+                    gradients[d](i, q) = gradient[d] * sqrt_weight;
+                }
+            }
+
+          for (unsigned int d = 0; d < dim; ++d)
+            {
+              reference_matrices[f][d].reinit(dofs_per_cell, dofs_per_cell);
+              gradients[d].mTmult(reference_matrices[f][d], gradients[d]);
+            }
+        }
   }
 
 
@@ -204,7 +342,7 @@ namespace PoissonMatrixBased
   void
   PoissonOperator<dim, LinearAlgebra, spacedim>::vmult(VectorType &dst, const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult");
+    Instrumentation::Scope t(Instrumentation::vmult);
 
     system_matrix.vmult(dst, src);
   }
@@ -259,6 +397,15 @@ namespace PoissonMatrixBased
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  PoissonOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    return system_matrix.memory_consumption();
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   PoissonOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType       &dst,
@@ -18,9 +18,13 @@
 #include <deal.II/lac/vector.h>
 
 #include <global.h>
+#include <instrumentation.h>
 #include <linear_algebra.h>
+#include <matrix_free_dispatch.h>
 #include <poisson/matrixfree_operator.h>
 
+#include <chrono>
+
 using namespace dealii;
 
 
@@ -63,6 +67,10 @@ namespace PoissonMatrixFree
 
     typename MatrixFree<dim, value_type>::AdditionalData data;
     data.mapping_update_flags = update_gradients;
+    data.communicator_sm      = getSharedMemoryCommunicator();
+    if (inner_faces)
+      data.mapping_update_flags_inner_faces =
+        update_gradients | update_normal_vectors | update_JxW_values;
 
     matrix_free.reinit(*mapping_collection, dof_handler, constraints, *quadrature_collection, data);
   }
@@ -87,31 +95,45 @@ namespace PoissonMatrixFree
 
     typename MatrixFree<dim, value_type>::AdditionalData data;
     data.mapping_update_flags = update_gradients;
+    data.communicator_sm      = getSharedMemoryCommunicator();
+    if (inner_faces)
+      data.mapping_update_flags_inner_faces =
+        update_gradients | update_normal_vectors | update_JxW_values;
 
     matrix_free.reinit(*mapping_collection, dof_handler, constraints, *quadrature_collection, data);
 
 
     this->initialize_dof_vector(system_rhs);
     {
-      AffineConstraints<value_type> constraints_without_dbc;
-
-      constraints_without_dbc.reinit(partitioning.get_relevant_dofs());
-
-      DoFTools::make_hanging_node_constraints(dof_handler, constraints_without_dbc);
-      constraints_without_dbc.close();
+      // Apply the operator to the Dirichlet values in x. Reading them without
+      // resolving constraints spares a second MatrixFree object with hanging
+      // node constraints only, and thus a second setup of all mapping data.
+      const std::function<void(const MatrixFree<dim, value_type> &,
+                               VectorType &,
+                               const VectorType &,
+                               const std::pair<unsigned int, unsigned int> &)>
+        cell_integral_plain_range = [&](const auto &matrix_free,
+                                        auto       &dst,
+                                        const auto &src,
+                                        const auto &range) {
+          FECellIntegrator integrator(matrix_free, range);
+          for (unsigned int cell = range.first; cell < range.second; ++cell)
+            {
+              integrator.reinit(cell);
+              integrator.read_dof_values_plain(src);
+              do_cell_integral_local(integrator);
+              integrator.distribute_local_to_global(dst);
+            }
+        };
 
       VectorType b, x;
 
-      MatrixFree<dim, value_type> matrix_free;
-      matrix_free.reinit(
-        *mapping_collection, dof_handler, constraints_without_dbc, *quadrature_collection, data);
-
-      matrix_free.initialize_dof_vector(b);
-      matrix_free.initialize_dof_vector(x);
+      this->initialize_dof_vector(b);
+      this->initialize_dof_vector(x);
 
       constraints.distribute(x);
 
-      matrix_free.cell_loop(&PoissonOperator::do_cell_integral_range, this, b, x);
+      matrix_free.cell_loop(cell_integral_plain_range, b, x, true);
 
       constraints.set_zero(b);
 
@@ -125,13 +147,34 @@ namespace PoissonMatrixFree
   void
   PoissonOperator<dim, LinearAlgebra, spacedim>::vmult(VectorType &dst, const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult");
+    Instrumentation::Scope t(Instrumentation::vmult);
 
     this->matrix_free.cell_loop(&PoissonOperator::do_cell_integral_range, this, dst, src, true);
   }
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  PoissonOperator<dim, LinearAlgebra, spacedim>::vmult(
+    VectorType                                                        &dst,
+    const VectorType                                                  &src,
+    const std::function<void(const unsigned int, const unsigned int)> &operation_before_loop,
+    const std::function<void(const unsigned int, const unsigned int)> &operation_after_loop) const
+  {
+    Instrumentation::Scope t(Instrumentation::vmult);
+
+    // dst is not zeroed here, this is left to operation_before_loop
+    this->matrix_free.cell_loop(&PoissonOperator::do_cell_integral_range,
+                                this,
+                                dst,
+                                src,
+                                operation_before_loop,
+                                operation_after_loop);
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   PoissonOperator<dim, LinearAlgebra, spacedim>::initialize_dof_vector(VectorType &vec) const
@@ -177,10 +220,29 @@ namespace PoissonMatrixFree
       {
         const auto &dof_handler = this->matrix_free.get_dof_handler();
 
-        initialize_sparse_matrix(system_matrix, dof_handler, *constraints, partitioning);
-
-        MatrixFreeTools::compute_matrix(
-          matrix_free, *constraints, system_matrix, &PoissonOperator::do_cell_integral_local, this);
+        if constexpr (std::is_same_v<value_type, double>)
+          {
+            initialize_sparse_matrix(system_matrix, dof_handler, *constraints, partitioning);
+
+            MatrixFreeTools::compute_matrix(matrix_free,
+                                            *constraints,
+                                            system_matrix,
+                                            &PoissonOperator::do_cell_integral_local,
+                                            this);
+          }
+        else
+          {
+            // Trilinos matrices only exist in double precision. We assemble them
+            // with a double precision replica of this operator.
+            AffineConstraints<double> constraints_double;
+            constraints_double.copy_from(*constraints);
+
+            PoissonOperator<dim, dealiiTrilinos, spacedim> operator_double(
+              *mapping_collection, *quadrature_collection, hp::FECollection<dim, spacedim>());
+            operator_double.reinit(partitioning, dof_handler, constraints_double);
+
+            system_matrix.copy_from(operator_double.get_system_matrix());
+          }
       }
 
     return this->system_matrix;
@@ -188,6 +250,86 @@ namespace PoissonMatrixFree
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  PoissonOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    std::size_t memory = matrix_free.memory_consumption();
+
+    // the system matrix is only assembled on demand
+    if (system_matrix.m() > 0)
+      memory += system_matrix.memory_consumption();
+
+    return memory;
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::vector<double>
+  PoissonOperator<dim, LinearAlgebra, spacedim>::measure_cost_per_cell(
+    const unsigned int n_repetitions) const
+  {
+    TimerOutput::Scope t(getTimer(), "measure_cost_per_cell");
+
+    const auto        &dof_handler  = matrix_free.get_dof_handler();
+    const unsigned int n_fe_indices = dof_handler.get_fe_collection().size();
+
+    std::vector<double> wall_times(n_fe_indices, 0.);
+    std::vector<double> n_cells(n_fe_indices, 0.);
+
+    for (unsigned int cell = 0; cell < matrix_free.n_cell_batches(); ++cell)
+      n_cells[matrix_free.get_cell_active_fe_index({cell, cell + 1})] +=
+        matrix_free.n_active_entries_per_cell_batch(cell);
+
+    // Time contiguous ranges of cell batches with the same FE index one after
+    // the other, so that neither threads nor the overlapping ghost exchange of
+    // cell_loop() distort the measurement.
+    std::vector<std::pair<unsigned int, unsigned int>> ranges;
+    for (unsigned int cell = 0; cell < matrix_free.n_cell_batches(); ++cell)
+      if (ranges.empty() || matrix_free.get_cell_active_fe_index({cell, cell + 1}) !=
+                              matrix_free.get_cell_active_fe_index(ranges.back()))
+        ranges.emplace_back(cell, cell + 1);
+      else
+        ++ranges.back().second;
+
+    VectorType dst, src;
+    initialize_dof_vector(dst);
+    initialize_dof_vector(src);
+    src = 1.;
+
+    for (unsigned int i = 0; i < n_repetitions; ++i)
+      {
+        src.update_ghost_values();
+        dst = 0.;
+
+        for (const auto &range : ranges)
+          {
+            const auto start = std::chrono::steady_clock::now();
+
+            do_cell_integral_range(matrix_free, dst, src, range);
+
+            wall_times[matrix_free.get_cell_active_fe_index(range)] +=
+              std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+          }
+
+        dst.compress(VectorOperation::add);
+      }
+
+    const MPI_Comm communicator = dof_handler.get_communicator();
+    wall_times                  = Utilities::MPI::sum(wall_times, communicator);
+    n_cells                     = Utilities::MPI::sum(n_cells, communicator);
+
+    std::vector<double> costs(n_fe_indices, 0.);
+    for (unsigned int i = 0; i < n_fe_indices; ++i)
+      if (n_cells[i] > 0)
+        costs[i] = wall_times[i] / (n_cells[i] * n_repetitions);
+
+    return costs;
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   PoissonOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType       &dst,
@@ -198,6 +340,24 @@ namespace PoissonMatrixFree
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  PoissonOperator<dim, LinearAlgebra, spacedim>::enable_inner_faces()
+  {
+    inner_faces = true;
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  const MatrixFree<dim, typename PoissonOperator<dim, LinearAlgebra, spacedim>::value_type> &
+  PoissonOperator<dim, LinearAlgebra, spacedim>::get_matrix_free() const
+  {
+    return matrix_free;
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   PoissonOperator<dim, LinearAlgebra, spacedim>::do_cell_integral_local(
@@ -214,9 +374,10 @@ namespace PoissonMatrixFree
 
 
   template <int dim, typename LinearAlgebra, int spacedim>
+  template <typename Integrator>
   void
   PoissonOperator<dim, LinearAlgebra, spacedim>::do_cell_integral_global(
-    FECellIntegrator &integrator,
+    Integrator       &integrator,
     VectorType       &dst,
     const VectorType &src) const
   {
@@ -238,13 +399,27 @@ namespace PoissonMatrixFree
     const VectorType                            &src,
     const std::pair<unsigned int, unsigned int> &range) const
   {
-    FECellIntegrator integrator(matrix_free, range);
+    const auto cell_loop = [&](auto &integrator) {
+      for (unsigned int cell = range.first; cell < range.second; ++cell)
+        {
+          integrator.reinit(cell);
 
-    for (unsigned int cell = range.first; cell < range.second; ++cell)
-      {
-        integrator.reinit(cell);
+          do_cell_integral_global(integrator, dst, src);
+        }
+    };
 
-        do_cell_integral_global(integrator, dst, src);
+    // Use sum factorization with fixed polynomial degree if possible.
+    const bool dispatched = dispatch_fe_degree(matrix_free, range, [&](const auto degree) {
+      constexpr int fe_degree = decltype(degree)::value;
+
+      FEEvaluation<dim, fe_degree, fe_degree + 1, 1, value_type> integrator(matrix_free, range);
+      cell_loop(integrator);
+    });
+
+    if (dispatched == false)
+      {
+        FECellIntegrator integrator(matrix_free, range);
+        cell_loop(integrator);
       }
   }
 
@@ -254,6 +429,8 @@ namespace PoissonMatrixFree
 #ifdef DEAL_II_WITH_TRILINOS
   template class PoissonOperator<2, dealiiTrilinos, 2>;
   template class PoissonOperator<3, dealiiTrilinos, 3>;
+  template class PoissonOperator<2, dealiiTrilinosFloat, 2>;
+  template class PoissonOperator<3, dealiiTrilinosFloat, 3>;
 #endif
 
 } // namespace PoissonMatrixFree
@@ -16,60 +16,42 @@
 
 #include <deal.II/fe/fe_q.h>
 
+#include <deal.II/lac/solver_control.h>
+
 #include <deal.II/matrix_free/tools.h>
 
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/numerics/vector_tools.h>
 
+#include <checkpoint.h>
+#include <errors_matrixfree.h>
 #include <factory.h>
 #include <global.h>
+#include <instrumentation.h>
 #include <linear_algebra.h>
+#include <load_balancing.h>
 #include <log.h>
+#include <output.h>
 #include <poisson/matrixbased_operator.h>
 #include <poisson/matrixfree_operator.h>
 #include <poisson/problem.h>
 #include <poisson/solvers.h>
 
+#include <cmath>
 #include <ctime>
 #include <iomanip>
+#include <limits>
 #include <sstream>
+#include <tuple>
 
 using namespace dealii;
 
 
-template <int dim, typename LinearAlgebra, int spacedim = dim, typename... Args>
-static std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>>
-create_operator(const std::string type, Args &&...args)
-{
-  if (type == "MatrixBased")
-    {
-      return std::make_unique<PoissonMatrixBased::PoissonOperator<dim, LinearAlgebra, spacedim>>(
-        std::forward<Args>(args)...);
-    }
-  else if (type == "MatrixFree")
-    {
-      if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos>)
-        {
-          return std::make_unique<PoissonMatrixFree::PoissonOperator<dim, LinearAlgebra, spacedim>>(
-            std::forward<Args>(args)...);
-        }
-      else
-        {
-          AssertThrow(false, ExcMessage("MatrixFree only available with dealii & Trilinos!"));
-        }
-    }
-
-  AssertThrow(false, ExcNotImplemented());
-  return std::unique_ptr<OperatorType<dim, LinearAlgebra, spacedim>>();
-}
-
-
-
 namespace Poisson
 {
   template <int dim, typename LinearAlgebra, int spacedim>
   Problem<dim, LinearAlgebra, spacedim>::Problem(const Parameter &prm)
-    : mpi_communicator(MPI_COMM_WORLD)
+    : mpi_communicator(getCommunicator())
     , prm(prm)
     , triangulation(mpi_communicator,
                     typename Triangulation<dim>::MeshSmoothing(
@@ -113,11 +95,20 @@ namespace Poisson
       });
 
     // prepare operator
-    poisson_operator = create_operator<dim, LinearAlgebra, spacedim>(prm.operator_type,
+    poisson_operator =
+      Factory::create_poisson_operator<dim, LinearAlgebra, spacedim>(prm.operator_type,
                                                                      mapping_collection,
                                                                      quadrature_collection,
                                                                      fe_collection);
 
+    // share the mapping data of the operator with the matrix-free error estimator
+    if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos>)
+      if (prm.prm_adaptation.matrix_free_error_estimator)
+        if (const auto matrix_free_operator =
+              dynamic_cast<PoissonMatrixFree::PoissonOperator<dim, LinearAlgebra, spacedim> *>(
+                poisson_operator.get()))
+          matrix_free_operator->enable_inner_faces();
+
     // choose functions
     if (prm.grid_type == "reentrant corner")
       {
@@ -139,6 +130,10 @@ namespace Poisson
       dof_handler,
       triangulation);
 
+    // write output files in the background
+    if (prm.output_asynchronously)
+      async_writer = std::make_unique<AsyncWriter>(prm.output_queue_size);
+
     // cell weighting
     if (prm.adaptation_type != "h")
       {
@@ -247,87 +242,286 @@ namespace Poisson
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Problem<dim, LinearAlgebra, spacedim>::measure_cell_weights()
+  {
+    TimerOutput::Scope t(getTimer(), "measure_cell_weights");
+
+    AssertThrow(prm.operator_type == "MatrixFree",
+                ExcMessage("Cell costs can only be measured with matrix-free operators."));
+
+    // enough operator applications to even out the noise of single cell batches
+    set_cell_weights(poisson_operator->measure_cost_per_cell(10));
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Problem<dim, LinearAlgebra, spacedim>::set_cell_weights(const std::vector<double> &costs)
+  {
+    std::vector<unsigned int> n_dofs_per_cell(fe_collection.size());
+    for (unsigned int i = 0; i < fe_collection.size(); ++i)
+      n_dofs_per_cell[i] = fe_collection[i].n_dofs_per_cell();
+
+    const std::vector<unsigned int> weights = LoadBalancing::fit_weights(costs, n_dofs_per_cell);
+
+    adaptation_strategy->set_cost_per_cell(costs);
+
+    // The weighting function only knows the future finite element, which we
+    // identify by its degree.
+    std::vector<unsigned int> weights_per_degree(fe_collection.max_degree() + 1, 0);
+    for (unsigned int i = 0; i < fe_collection.size(); ++i)
+      weights_per_degree[fe_collection[i].degree] = weights[i];
+
+    cell_weights.reinit(dof_handler,
+                        [weights_per_degree](const auto &,
+                                             const FiniteElement<dim, spacedim> &future_fe) {
+                          return weights_per_degree[future_fe.degree];
+                        });
+
+    getPCOut() << "   Measured cell weights:       ";
+    for (unsigned int i = 0; i < fe_collection.size(); ++i)
+      getPCOut() << ' ' << fe_collection[i].degree << ":" << weights[i];
+    getPCOut() << std::endl;
+
+    cell_costs            = costs;
+    cell_weights_measured = true;
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Problem<dim, LinearAlgebra, spacedim>::solve_with_gmg(
+    SolverControl                    &solver_control,
+    typename LinearAlgebra::Vector   &dst,
+    const std::string                &smoother_preconditioner_type,
+    const unsigned int                smoother_degree,
+    std::unique_ptr<MGHierarchyBase> &hierarchy)
+  {
+    if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos>)
+      {
+        const std::string filename_mg_level =
+          filename_stem + "-mglevel-cycle_" + std::to_string(cycle) + ".log";
+
+        if (prm.prm_multigrid.mixed_precision)
+          {
+            // level operators in single precision
+            const auto level_operator =
+              Factory::create_poisson_operator<dim, dealiiTrilinosFloat, spacedim>(
+                prm.operator_type, mapping_collection, quadrature_collection, fe_collection);
+
+            solve_gmg_with_smoother<dim, LinearAlgebra, spacedim, dealiiTrilinosFloat>(
+              solver_control,
+              *poisson_operator,
+              *level_operator,
+              dst,
+              system_rhs,
+              prm.prm_multigrid,
+              smoother_preconditioner_type,
+              quadrature_collection,
+              dof_handler,
+              hierarchy,
+              filename_mg_level,
+              prm.solver_type == "GMG pipelined",
+              smoother_degree);
+          }
+        else
+          {
+            solve_gmg_with_smoother<dim, LinearAlgebra, spacedim, LinearAlgebra>(
+              solver_control,
+              *poisson_operator,
+              *poisson_operator,
+              dst,
+              system_rhs,
+              prm.prm_multigrid,
+              smoother_preconditioner_type,
+              quadrature_collection,
+              dof_handler,
+              hierarchy,
+              filename_mg_level,
+              prm.solver_type == "GMG pipelined",
+              smoother_degree);
+          }
+      }
+    else
+      {
+        AssertThrow(false, ExcMessage("GMG is only available with dealii & Trilinos!"));
+      }
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Problem<dim, LinearAlgebra, spacedim>::calibrate_smoother()
+  {
+    TimerOutput::Scope t(getTimer(), "calibrate_smoother");
+
+    // Calibration solves must neither leave their entries in the row of this
+    // cycle nor in the instrumentation counters.
+    const CycleTable               table = getTable();
+    const Instrumentation::Discard discard;
+
+    const MGSolverParameters &mg_data = prm.prm_multigrid;
+
+    const std::vector<std::string> types =
+      (mg_data.smoother_preconditioner_type == "auto") ?
+        mg_data.auto_smoother_preconditioner_types :
+        std::vector<std::string>{mg_data.smoother_preconditioner_type};
+    const std::vector<unsigned int> degrees = mg_data.auto_smoother_degrees.empty() ?
+                                                std::vector<unsigned int>{0} :
+                                                mg_data.auto_smoother_degrees;
+
+    // The time of a full solve is predicted from the setup of the hierarchy,
+    // which happens during a first solve with a single iteration, and the
+    // time per digit of residual reduction in further solves, which reuse
+    // the hierarchy for all degrees. Times are maximized over all processes,
+    // so that all of them pick the same candidate.
+    const double n_digits = -std::log10(prm.solver_tolerance_factor);
+
+    std::string                      best_type;
+    unsigned int                     best_degree = 0;
+    double                           best_time   = std::numeric_limits<double>::max();
+    std::unique_ptr<MGHierarchyBase> best_hierarchy;
+
+    for (const auto &type : types)
+      {
+        std::unique_ptr<MGHierarchyBase> hierarchy;
+        bool                             best_is_this_type = false;
+
+        typename LinearAlgebra::Vector calibration_solution;
+        poisson_operator->initialize_dof_vector(calibration_solution);
+
+        Timer                  timer;
+        IterationNumberControl setup_control(1, 0.);
+        solve_with_gmg(setup_control, calibration_solution, type, degrees.front(), hierarchy);
+        const double setup_time = Utilities::MPI::max(timer.wall_time(), mpi_communicator);
+
+        for (const auto degree : degrees)
+          {
+            calibration_solution = 0.;
+
+            timer.restart();
+            IterationNumberControl calibration_control(mg_data.auto_n_iterations, 0.);
+            solve_with_gmg(calibration_control, calibration_solution, type, degree, hierarchy);
+            const double solve_time = Utilities::MPI::max(timer.wall_time(), mpi_communicator);
+
+            const double digits =
+              std::log10(calibration_control.initial_value() / calibration_control.last_value());
+
+            const double predicted_time = (digits > 0.) ?
+                                            setup_time + n_digits * solve_time / digits :
+                                            std::numeric_limits<double>::max();
+
+            getPCOut() << "   Calibrated " << std::setw(17) << std::left << type << std::right;
+            if (degree > 0)
+              getPCOut() << " degree " << degree;
+            getPCOut() << " setup: " << setup_time << "s, per digit: " << solve_time / digits
+                       << "s, predicted: " << predicted_time << "s" << std::endl;
+
+            if (predicted_time < best_time)
+              {
+                best_type         = type;
+                best_degree       = degree;
+                best_time         = predicted_time;
+                best_is_this_type = true;
+              }
+          }
+
+        // keep the hierarchy of the best candidate for the actual solve
+        if (best_is_this_type)
+          best_hierarchy = std::move(hierarchy);
+      }
+
+    AssertThrow(!best_type.empty(),
+                ExcMessage("None of the smoother candidates reduced the residual."));
+
+    getPCOut() << "   Picked smoother preconditioner: " << best_type;
+    if (best_degree > 0)
+      getPCOut() << " with degree " << best_degree;
+    getPCOut() << std::endl;
+
+    auto_smoother_preconditioner_type = best_type;
+    auto_smoother_degree              = best_degree;
+    smoother_calibrated               = true;
+
+    mg_hierarchy = std::move(best_hierarchy);
+
+    getTable() = table;
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   Problem<dim, LinearAlgebra, spacedim>::solve()
   {
+    const bool gmg = (prm.solver_type == "GMG" || prm.solver_type == "GMG pipelined");
+
+    // Calibration solves are timed on their own, not as part of this solve.
+    if (gmg && !smoother_calibrated &&
+        (prm.prm_multigrid.smoother_preconditioner_type == "auto" ||
+         !prm.prm_multigrid.auto_smoother_degrees.empty()))
+      calibrate_smoother();
+
     TimerOutput::Scope t(getTimer(), "solve");
 
     // We need to introduce a vector that does not contain all ghost elements.
     typename LinearAlgebra::Vector completely_distributed_solution;
     poisson_operator->initialize_dof_vector(completely_distributed_solution);
 
-    SolverControl solver_control(system_rhs.size(),
-                                 prm.solver_tolerance_factor * system_rhs.l2_norm());
+    // Start from the solution of the previous cycle. The tolerance remains
+    // relative to the right hand side, so that the accuracy of the solution
+    // does not depend on the initial guess.
+    if (solution_transfer)
+      {
+        solution_transfer->interpolate(completely_distributed_solution);
+        constraints.set_zero(completely_distributed_solution);
+
+        solution_transfer.reset();
+      }
+
+    // During nested iteration, the solution only serves to mark cells and as initial guess on the
+    // next mesh, for which a fixed number of iterations suffices.
+    const double tolerance = prm.solver_tolerance_factor * system_rhs.l2_norm();
+
+    SolverControl          full_solver_control(system_rhs.size(), tolerance);
+    IterationNumberControl inexact_solver_control(prm.nested_iteration_n_iterations, tolerance);
+
+    SolverControl &solver_control =
+      nested_iteration_step ? inexact_solver_control : full_solver_control;
 
     if (prm.solver_type == "AMG")
       {
         solve_amg<dim, LinearAlgebra, spacedim>(solver_control,
                                                 *poisson_operator,
                                                 completely_distributed_solution,
-                                                system_rhs);
+                                                system_rhs,
+                                                amg);
       }
-    else if (prm.solver_type == "GMG")
+    else if (gmg)
       {
-        if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos>)
+        std::string  smoother_preconditioner_type = prm.prm_multigrid.smoother_preconditioner_type;
+        unsigned int smoother_degree              = 0;
+        if (smoother_calibrated)
           {
-            const std::string filename_mg_level =
-              filename_stem + "-mglevel-cycle_" + std::to_string(cycle) + ".log";
+            smoother_preconditioner_type = auto_smoother_preconditioner_type;
+            smoother_degree              = auto_smoother_degree;
 
-            if (prm.prm_multigrid.smoother_preconditioner_type == "Extended Diagonal")
-              {
-                solve_gmg<PreconditionExtendedDiagonal<typename LinearAlgebra::Vector>,
-                          dim,
-                          LinearAlgebra,
-                          spacedim>(solver_control,
-                                    *poisson_operator,
-                                    completely_distributed_solution,
-                                    system_rhs,
-                                    prm.prm_multigrid,
-                                    /*boundary_values=*/mapping_collection,
-                                    quadrature_collection,
-                                    dof_handler,
-                                    filename_mg_level);
-              }
-            else if (prm.prm_multigrid.smoother_preconditioner_type == "ASM")
-              {
-                solve_gmg<PreconditionASM<typename LinearAlgebra::Vector>,
-                          dim,
-                          LinearAlgebra,
-                          spacedim>(solver_control,
-                                    *poisson_operator,
-                                    completely_distributed_solution,
-                                    system_rhs,
-                                    prm.prm_multigrid,
-                                    /*boundary_values=*/mapping_collection,
-                                    quadrature_collection,
-                                    dof_handler,
-                                    filename_mg_level);
-              }
-            else if (prm.prm_multigrid.smoother_preconditioner_type == "Diagonal")
-              {
-                solve_gmg<DiagonalMatrixTimer<typename LinearAlgebra::Vector>,
-                          dim,
-                          LinearAlgebra,
-                          spacedim>(solver_control,
-                                    *poisson_operator,
-                                    completely_distributed_solution,
-                                    system_rhs,
-                                    prm.prm_multigrid,
-                                    /*boundary_values=*/mapping_collection,
-                                    quadrature_collection,
-                                    dof_handler,
-                                    filename_mg_level);
-              }
-            else
-              {
-                AssertThrow(false, ExcNotImplemented());
-              }
-          }
-        else
-          {
-            AssertThrow(false, ExcMessage("GMG is only available with dealii & Trilinos!"));
+            if (prm.prm_multigrid.smoother_preconditioner_type == "auto")
+              getTable().add_value("smoother_preconditioner", smoother_preconditioner_type);
+            if (smoother_degree > 0)
+              getTable().add_value("smoother_degree", smoother_degree);
           }
+
+        solve_with_gmg(solver_control,
+                       completely_distributed_solution,
+                       smoother_preconditioner_type,
+                       smoother_degree,
+                       mg_hierarchy);
       }
     else
       {
@@ -350,24 +544,39 @@ namespace Poisson
   {
     TimerOutput::Scope t(getTimer(), "compute_errors");
 
-    Vector<float> difference_per_cell(triangulation.n_active_cells());
-    VectorTools::integrate_difference(dof_handler,
-                                      locally_relevant_solution,
-                                      *solution_function,
-                                      difference_per_cell,
-                                      quadrature_collection,
-                                      VectorTools::L2_norm);
-    const double L2_error =
-      VectorTools::compute_global_error(triangulation, difference_per_cell, VectorTools::L2_norm);
-
-    VectorTools::integrate_difference(dof_handler,
-                                      locally_relevant_solution,
-                                      *solution_function,
-                                      difference_per_cell,
-                                      quadrature_collection,
-                                      VectorTools::H1_norm);
-    const double H1_error =
-      VectorTools::compute_global_error(triangulation, difference_per_cell, VectorTools::H1_norm);
+    double L2_error = 0., H1_error = 0.;
+    if (prm.matrix_free_error_computation)
+      {
+        std::tie(L2_error, H1_error) =
+          ErrorsMatrixFree::compute_L2_H1_errors(mapping_collection,
+                                                 dof_handler,
+                                                 locally_relevant_solution,
+                                                 *solution_function,
+                                                 quadrature_collection);
+      }
+    else
+      {
+        Vector<float> difference_per_cell(triangulation.n_active_cells());
+        VectorTools::integrate_difference(dof_handler,
+                                          locally_relevant_solution,
+                                          *solution_function,
+                                          difference_per_cell,
+                                          quadrature_collection,
+                                          VectorTools::L2_norm);
+        L2_error = VectorTools::compute_global_error(triangulation,
+                                                     difference_per_cell,
+                                                     VectorTools::L2_norm);
+
+        VectorTools::integrate_difference(dof_handler,
+                                          locally_relevant_solution,
+                                          *solution_function,
+                                          difference_per_cell,
+                                          quadrature_collection,
+                                          VectorTools::H1_norm);
+        H1_error = VectorTools::compute_global_error(triangulation,
+                                                     difference_per_cell,
+                                                     VectorTools::H1_norm);
+      }
 
     getPCOut() << "   L2 error:                     " << L2_error << std::endl
                << "   H1 error:                     " << H1_error << std::endl;
@@ -399,18 +608,23 @@ namespace Poisson
     DataOut<dim> data_out;
     data_out.attach_dof_handler(dof_handler);
 
-    data_out.add_data_vector(locally_relevant_solution, "solution");
-    data_out.add_data_vector(fe_degrees, "fe_degree");
-    data_out.add_data_vector(subdomain, "subdomain");
+    if (Output::has_field(prm, "solution"))
+      data_out.add_data_vector(locally_relevant_solution, "solution");
+    if (Output::has_field(prm, "fe_degree"))
+      data_out.add_data_vector(fe_degrees, "fe_degree");
+    if (Output::has_field(prm, "subdomain"))
+      data_out.add_data_vector(subdomain, "subdomain");
 
-    if (adaptation_strategy->get_error_estimates().size() > 0)
+    if (Output::has_field(prm, "error") &&
+        (adaptation_strategy->get_error_estimates().size() > 0))
       data_out.add_data_vector(adaptation_strategy->get_error_estimates(), "error");
-    if (adaptation_strategy->get_hp_indicators().size() > 0)
+    if (Output::has_field(prm, "hp_indicator") &&
+        (adaptation_strategy->get_hp_indicators().size() > 0))
       data_out.add_data_vector(adaptation_strategy->get_hp_indicators(), "hp_indicator");
 
-    data_out.build_patches(mapping_collection);
+    data_out.build_patches(mapping_collection, prm.output_subdivisions);
 
-    data_out.write_vtu_with_pvtu_record("./", prm.file_stem, cycle, mpi_communicator, 2, 1);
+    Output::write_vtu_with_pvtu_record(data_out, prm, cycle, mpi_communicator, async_writer.get());
   }
 
 
@@ -433,15 +647,34 @@ namespace Poisson
         AssertThrow(false, ExcMessage("Checkpoint: invalid cycle!"));
       }
 
-    triangulation.load(prm.resume_filename);
+    Checkpoint::load(prm.resume_filename, triangulation);
 
     // custom repartitioning using DoFs requires correctly assigned FEs
     dof_handler.deserialize_active_fe_indices();
     dof_handler.distribute_dofs(fe_collection);
+
+    // Measured cell costs are stored next to solution checkpoints. They have to
+    // be in place before repartitioning, so that they determine the weights.
+    const std::vector<double> costs =
+      Checkpoint::read_values(prm.resume_filename, mpi_communicator);
+    if (costs.size() == fe_collection.size())
+      set_cell_weights(costs);
+
     triangulation.repartition();
 
     // unpack after repartitioning to avoid unnecessary data transfer
     adaptation_strategy->unpack_after_serialization();
+
+    if (prm.resume_filename.find(".solution.checkpoint") != std::string::npos)
+      {
+        dof_handler.distribute_dofs(fe_collection);
+
+        resumed_solution = std::make_unique<typename LinearAlgebra::Vector>();
+        resumed_solution->reinit(dof_handler.locally_owned_dofs(), mpi_communicator);
+
+        SolutionTransferType transfer(dof_handler);
+        transfer.deserialize(*resumed_solution);
+      }
   }
 
 
@@ -463,13 +696,37 @@ namespace Poisson
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  Problem<dim, LinearAlgebra, spacedim>::write_solution_to_checkpoint()
+  {
+    // the order of attached data has to match the one in resume_from_checkpoint()
+    dof_handler.prepare_for_serialization_of_active_fe_indices();
+    adaptation_strategy->prepare_for_serialization();
+
+    SolutionTransferType transfer(dof_handler);
+    transfer.prepare_for_serialization(locally_relevant_solution);
+
+    const std::string filename =
+      prm.file_stem + ".cycle-" + Utilities::to_string(cycle, 2) + ".solution.checkpoint";
+    triangulation.save(filename);
+    if (cell_weights_measured)
+      Checkpoint::write_values(filename, cell_costs, mpi_communicator);
+
+    getPCOut() << "Solution checkpoint written." << std::endl;
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   Problem<dim, LinearAlgebra, spacedim>::run()
   {
     getTable().set_auto_fill_mode(true);
 
-    for (cycle = 0; cycle < adaptation_strategy->get_n_cycles(); ++cycle)
+    nested_iteration_step = (prm.nested_iteration_dofs > 0);
+
+    for (cycle = 0; cycle < adaptation_strategy->get_n_cycles() + n_nested_iteration_steps; ++cycle)
       {
         {
           TimerOutput::Scope t(getTimer(), "full_cycle");
@@ -480,6 +737,13 @@ namespace Poisson
             }
           else
             {
+              if (prm.initial_guess_from_previous_cycle || nested_iteration_step)
+                {
+                  solution_transfer = std::make_unique<SolutionTransferType>(dof_handler);
+                  solution_transfer->prepare_for_coarsening_and_refinement(
+                    locally_relevant_solution);
+                }
+
               adaptation_strategy->refine();
 
               if ((prm.checkpoint_frequency > 0) && (cycle % prm.checkpoint_frequency == 0))
@@ -490,16 +754,64 @@ namespace Poisson
 
           setup_system();
 
+          // switch to full solves for good once the mesh is fine enough
+          if (nested_iteration_step && dof_handler.n_dofs() >= prm.nested_iteration_dofs)
+            nested_iteration_step = false;
+          if (nested_iteration_step)
+            ++n_nested_iteration_steps;
+          if (prm.nested_iteration_dofs > 0)
+            getTable().add_value("nested_iteration",
+                                 static_cast<unsigned int>(nested_iteration_step));
+
           Log::log_hp_diagnostics(triangulation, dof_handler, constraints);
 
-          poisson_operator->reinit(partitioning, dof_handler, constraints, system_rhs, nullptr);
+          const bool resumed_cycle = static_cast<bool>(resumed_solution);
+          if (resumed_solution)
+            {
+              locally_relevant_solution = *resumed_solution;
+              locally_relevant_solution.update_ghost_values();
+
+              resumed_solution.reset();
+            }
+          else
+            {
+              poisson_operator->reinit(
+                partitioning, dof_handler, constraints, system_rhs, nullptr);
+
+              if (prm.prm_adaptation.measured_cell_weights && (prm.adaptation_type != "h") &&
+                  !cell_weights_measured)
+                measure_cell_weights();
+
+              if (prm.operator_type == "MatrixBased" || prm.log_nonzero_elements)
+                Log::log_nonzero_elements(poisson_operator->get_system_matrix());
 
-          if (prm.operator_type == "MatrixBased" || prm.log_nonzero_elements)
-            Log::log_nonzero_elements(poisson_operator->get_system_matrix());
+              solve();
 
-          solve();
+              Log::log_memory_consumption("operators",
+                                          poisson_operator->memory_consumption(),
+                                          mpi_communicator);
+              Log::log_memory_consumption("vectors",
+                                          locally_relevant_solution.memory_consumption() +
+                                            system_rhs.memory_consumption(),
+                                          mpi_communicator);
+
+              if (prm.checkpoint_solution && (prm.checkpoint_frequency > 0) &&
+                  (cycle % prm.checkpoint_frequency == 0))
+                write_solution_to_checkpoint();
+            }
 
           compute_errors();
+
+          // the operator has not been set up on resumed cycles
+          const MatrixFree<dim, double> *matrix_free = nullptr;
+          if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos>)
+            if (prm.prm_adaptation.matrix_free_error_estimator && !resumed_cycle)
+              if (const auto matrix_free_operator = dynamic_cast<
+                    const PoissonMatrixFree::PoissonOperator<dim, LinearAlgebra, spacedim> *>(
+                    poisson_operator.get()))
+                matrix_free = &matrix_free_operator->get_matrix_free();
+          adaptation_strategy->set_matrix_free(matrix_free);
+
           adaptation_strategy->estimate_mark();
 
           if ((prm.output_frequency > 0) && (cycle % prm.output_frequency == 0))
@@ -507,12 +819,9 @@ namespace Poisson
         }
 
         Log::log_timing_statistics(mpi_communicator);
+        Log::log_memory_statistics(mpi_communicator);
 
-        if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
-          {
-            std::ofstream logstream(filename_log);
-            getTable().write_text(logstream);
-          }
+        Log::write_table(filename_log, prm.log_format, mpi_communicator);
 
         getTimer().reset();
         getTable().start_new_row();
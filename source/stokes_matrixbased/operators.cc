@@ -14,12 +14,17 @@
 // ---------------------------------------------------------------------
 
 
+#include <deal.II/base/work_stream.h>
+
 #include <deal.II/grid/filtered_iterator.h>
 
 #include <deal.II/lac/full_matrix.h>
 #include <deal.II/lac/vector.h>
 
+#include <deal.II/meshworker/copy_data.h>
+
 #include <global.h>
+#include <instrumentation.h>
 #include <linear_algebra.h>
 #include <stokes_matrixbased/operators.h>
 
@@ -28,6 +33,34 @@ using namespace dealii;
 
 namespace StokesMatrixBased
 {
+  namespace
+  {
+    // Cell matrices are computed in parallel tasks with WorkStream, each with
+    // its own copy of this scratch data. The copier is called in order on one
+    // thread at a time, since matrices can not be written concurrently.
+    template <int dim, int spacedim>
+    struct ScratchData
+    {
+      ScratchData(const hp::FEValues<dim, spacedim> &fe_values_collection)
+        : fe_values_collection(fe_values_collection)
+      {}
+
+      hp::FEValues<dim, spacedim> fe_values_collection;
+
+      std::vector<Tensor<2, dim>> grad_phi_u;
+      std::vector<double>         div_phi_u;
+      std::vector<double>         phi_p;
+      std::vector<Vector<double>> rhs_values;
+    };
+
+    using CopyData = MeshWorker::CopyData<1, 1, 1>;
+
+    template <int dim, int spacedim>
+    using CellFilter = FilteredIterator<typename DoFHandler<dim, spacedim>::active_cell_iterator>;
+  } // namespace
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   ABlockOperator<dim, LinearAlgebra, spacedim>::ABlockOperator(
     const hp::MappingCollection<dim, spacedim> &mapping_collection,
@@ -93,8 +126,6 @@ namespace StokesMatrixBased
       {
         TimerOutput::Scope t(getTimer(), "reinit_matrices");
 
-        a_block_matrix.clear();
-
         Table<2, DoFTools::Coupling> coupling(dim + 1, dim + 1);
         for (unsigned int c = 0; c < dim + 1; ++c)
           for (unsigned int d = 0; d < dim + 1; ++d)
@@ -103,8 +134,8 @@ namespace StokesMatrixBased
             else
               coupling[c][d] = DoFTools::none;
 
-        initialize_block_sparse_matrix(
-          a_block_matrix, dof_handler, constraints, partitioning, coupling);
+        reinit_or_zero_block_sparse_matrix(
+          a_block_matrix, sparsity_hash, dof_handler, constraints, partitioning, coupling);
       }
 
       {
@@ -114,45 +145,58 @@ namespace StokesMatrixBased
         // preconditioner_matrix = 0;
         // system_rhs            = 0;
 
-        FullMatrix<double> cell_matrix;
+        const auto worker = [](const typename DoFHandler<dim, spacedim>::active_cell_iterator &cell,
+                               ScratchData<dim, spacedim> &scratch_data,
+                               CopyData                   &copy_data) {
+          const FEValuesExtractors::Vector velocities(0);
 
-        std::vector<Tensor<2, dim>> grad_phi_u;
+          auto &fe_values_collection = scratch_data.fe_values_collection;
+          fe_values_collection.reinit(cell);
 
-        std::vector<types::global_dof_index> local_dof_indices;
-        const FEValuesExtractors::Vector     velocities(0);
-        for (const auto &cell :
-             dof_handler.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
-          {
-            fe_values_collection.reinit(cell);
+          const FEValues<dim> &fe_values     = fe_values_collection.get_present_fe_values();
+          const unsigned int   n_q_points    = fe_values.n_quadrature_points;
+          const unsigned int   dofs_per_cell = fe_values.dofs_per_cell;
 
-            const FEValues<dim> &fe_values     = fe_values_collection.get_present_fe_values();
-            const unsigned int   n_q_points    = fe_values.n_quadrature_points;
-            const unsigned int   dofs_per_cell = fe_values.dofs_per_cell;
+          auto &cell_matrix = copy_data.matrices[0];
+          cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
 
-            cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
-            cell_matrix = 0;
+          auto &grad_phi_u = scratch_data.grad_phi_u;
+          grad_phi_u.resize(dofs_per_cell);
 
-            grad_phi_u.resize(dofs_per_cell);
+          // TODO: move to parameter
+          const double viscosity = 0.1;
 
-            // TODO: move to parameter
-            const double viscosity = 0.1;
+          for (unsigned int q_point = 0; q_point < n_q_points; ++q_point)
+            {
+              for (unsigned int k = 0; k < dofs_per_cell; ++k)
+                grad_phi_u[k] = fe_values[velocities].gradient(k, q_point);
 
-            for (unsigned int q_point = 0; q_point < n_q_points; ++q_point)
-              {
-                for (unsigned int k = 0; k < dofs_per_cell; ++k)
-                  grad_phi_u[k] = fe_values[velocities].gradient(k, q_point);
+              for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                for (unsigned int j = 0; j < dofs_per_cell; ++j)
+                  cell_matrix(i, j) += viscosity * scalar_product(grad_phi_u[i], grad_phi_u[j]) *
+                                       fe_values.JxW(q_point);
+            }
 
-                for (unsigned int i = 0; i < dofs_per_cell; ++i)
-                  for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                    cell_matrix(i, j) += viscosity * scalar_product(grad_phi_u[i], grad_phi_u[j]) *
-                                         fe_values.JxW(q_point);
-              }
+          copy_data.local_dof_indices[0].resize(dofs_per_cell);
+          cell->get_dof_indices(copy_data.local_dof_indices[0]);
+        };
+
+        const auto copier = [&](const CopyData &copy_data) {
+          constraints.distribute_local_to_global(copy_data.matrices[0],
+                                                 copy_data.local_dof_indices[0],
+                                                 a_block_matrix);
+        };
 
-            local_dof_indices.resize(dofs_per_cell);
-            cell->get_dof_indices(local_dof_indices);
+        const CellFilter<dim, spacedim> begin(IteratorFilters::LocallyOwnedCell(),
+                                              dof_handler.begin_active());
+        const CellFilter<dim, spacedim> end(IteratorFilters::LocallyOwnedCell(), dof_handler.end());
 
-            constraints.distribute_local_to_global(cell_matrix, local_dof_indices, a_block_matrix);
-          }
+        WorkStream::run(begin,
+                        end,
+                        worker,
+                        copier,
+                        ScratchData<dim, spacedim>(fe_values_collection),
+                        CopyData(0));
 
         a_block_matrix.compress(VectorOperation::values::add);
       }
@@ -229,6 +273,15 @@ namespace StokesMatrixBased
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  ABlockOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    return a_block_matrix.memory_consumption();
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   ABlockOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType &dst, const VectorType &src) const
@@ -302,8 +355,6 @@ namespace StokesMatrixBased
       {
         TimerOutput::Scope t(getTimer(), "reinit_matrices");
 
-        schur_block_matrix.clear();
-
         Table<2, DoFTools::Coupling> coupling(dim + 1, dim + 1);
         for (unsigned int c = 0; c < dim + 1; ++c)
           for (unsigned int d = 0; d < dim + 1; ++d)
@@ -312,8 +363,8 @@ namespace StokesMatrixBased
             else
               coupling[c][d] = DoFTools::none;
 
-        initialize_block_sparse_matrix(
-          schur_block_matrix, dof_handler, constraints, partitioning, coupling);
+        reinit_or_zero_block_sparse_matrix(
+          schur_block_matrix, sparsity_hash, dof_handler, constraints, partitioning, coupling);
       }
 
       {
@@ -323,48 +374,58 @@ namespace StokesMatrixBased
         // preconditioner_matrix = 0;
         // system_rhs            = 0;
 
-        FullMatrix<double> cell_matrix;
+        const auto worker = [](const typename DoFHandler<dim, spacedim>::active_cell_iterator &cell,
+                               ScratchData<dim, spacedim> &scratch_data,
+                               CopyData                   &copy_data) {
+          const FEValuesExtractors::Scalar pressure(dim);
 
-        std::vector<double> phi_p;
+          auto &fe_values_collection = scratch_data.fe_values_collection;
+          fe_values_collection.reinit(cell);
 
-        std::vector<types::global_dof_index> local_dof_indices;
-        const FEValuesExtractors::Scalar     pressure(dim);
-        for (const auto &cell :
-             dof_handler.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
-          {
-            fe_values_collection.reinit(cell);
+          const FEValues<dim> &fe_values     = fe_values_collection.get_present_fe_values();
+          const unsigned int   n_q_points    = fe_values.n_quadrature_points;
+          const unsigned int   dofs_per_cell = fe_values.dofs_per_cell;
 
-            const FEValues<dim> &fe_values     = fe_values_collection.get_present_fe_values();
-            const unsigned int   n_q_points    = fe_values.n_quadrature_points;
-            const unsigned int   dofs_per_cell = fe_values.dofs_per_cell;
+          auto &cell_matrix = copy_data.matrices[0];
+          cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
 
-            cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
-            cell_matrix = 0;
+          auto &phi_p = scratch_data.phi_p;
+          phi_p.resize(dofs_per_cell);
 
-            phi_p.resize(dofs_per_cell);
+          // TODO: move to parameter
+          constexpr double viscosity     = 0.1;
+          constexpr double inv_viscosity = 1 / viscosity;
 
-            // TODO: move to parameter
-            constexpr double viscosity     = 0.1;
-            constexpr double inv_viscosity = 1 / viscosity;
+          for (unsigned int q_point = 0; q_point < n_q_points; ++q_point)
+            {
+              for (unsigned int k = 0; k < dofs_per_cell; ++k)
+                phi_p[k] = fe_values[pressure].value(k, q_point);
 
-            for (unsigned int q_point = 0; q_point < n_q_points; ++q_point)
-              {
-                for (unsigned int k = 0; k < dofs_per_cell; ++k)
-                  phi_p[k] = fe_values[pressure].value(k, q_point);
+              for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                for (unsigned int j = 0; j < dofs_per_cell; ++j)
+                  cell_matrix(i, j) += inv_viscosity * phi_p[i] * phi_p[j] * fe_values.JxW(q_point);
+            }
 
-                for (unsigned int i = 0; i < dofs_per_cell; ++i)
-                  for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                    cell_matrix(i, j) +=
-                      inv_viscosity * phi_p[i] * phi_p[j] * fe_values.JxW(q_point);
-              }
+          copy_data.local_dof_indices[0].resize(dofs_per_cell);
+          cell->get_dof_indices(copy_data.local_dof_indices[0]);
+        };
 
-            local_dof_indices.resize(dofs_per_cell);
-            cell->get_dof_indices(local_dof_indices);
+        const auto copier = [&](const CopyData &copy_data) {
+          constraints.distribute_local_to_global(copy_data.matrices[0],
+                                                 copy_data.local_dof_indices[0],
+                                                 schur_block_matrix);
+        };
 
-            constraints.distribute_local_to_global(cell_matrix,
-                                                   local_dof_indices,
-                                                   schur_block_matrix);
-          }
+        const CellFilter<dim, spacedim> begin(IteratorFilters::LocallyOwnedCell(),
+                                              dof_handler.begin_active());
+        const CellFilter<dim, spacedim> end(IteratorFilters::LocallyOwnedCell(), dof_handler.end());
+
+        WorkStream::run(begin,
+                        end,
+                        worker,
+                        copier,
+                        ScratchData<dim, spacedim>(fe_values_collection),
+                        CopyData(0));
 
         schur_block_matrix.compress(VectorOperation::values::add);
       }
@@ -441,6 +502,15 @@ namespace StokesMatrixBased
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  SchurBlockOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    return schur_block_matrix.memory_consumption();
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   SchurBlockOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType       &dst,
@@ -534,8 +604,6 @@ namespace StokesMatrixBased
       {
         TimerOutput::Scope t(getTimer(), "reinit_matrices");
 
-        system_matrix.clear();
-
         Table<2, DoFTools::Coupling> coupling(dim + 1, dim + 1);
         for (unsigned int c = 0; c < dim + 1; ++c)
           for (unsigned int d = 0; d < dim + 1; ++d)
@@ -544,8 +612,8 @@ namespace StokesMatrixBased
             else
               coupling[c][d] = DoFTools::none;
 
-        initialize_block_sparse_matrix(
-          system_matrix, dof_handler, constraints, partitioning, coupling);
+        reinit_or_zero_block_sparse_matrix(
+          system_matrix, sparsity_hash, dof_handler, constraints, partitioning, coupling);
       }
 
       {
@@ -560,80 +628,92 @@ namespace StokesMatrixBased
         // system_matrix         = 0;
         // system_rhs            = 0;
 
-        FullMatrix<double> cell_matrix;
-        Vector<double>     cell_rhs;
-
-        std::vector<Vector<double>> rhs_values;
-
-        std::vector<Tensor<2, dim>> grad_phi_u;
-        std::vector<double>         div_phi_u;
-        std::vector<double>         phi_p;
-
-        std::vector<types::global_dof_index> local_dof_indices;
-        const FEValuesExtractors::Vector     velocities(0);
-        const FEValuesExtractors::Scalar     pressure(dim);
-        for (const auto &cell :
-             dof_handler.active_cell_iterators() | IteratorFilters::LocallyOwnedCell())
-          {
-            fe_values_collection.reinit(cell);
-
-            const FEValues<dim> &fe_values     = fe_values_collection.get_present_fe_values();
-            const unsigned int   n_q_points    = fe_values.n_quadrature_points;
-            const unsigned int   dofs_per_cell = fe_values.dofs_per_cell;
-
-            cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
-            cell_matrix = 0;
-            cell_rhs.reinit(dofs_per_cell);
-            cell_rhs = 0;
-
-            grad_phi_u.resize(dofs_per_cell);
-            div_phi_u.resize(dofs_per_cell);
-            phi_p.resize(dofs_per_cell);
-
-            local_dof_indices.resize(dofs_per_cell);
-
-            // TODO: Move this part to the problem class???
-            //       Not possible...
-            rhs_values.resize(n_q_points, Vector<double>(dim + 1));
-
-            // TODO: Make rhs function a parameter?
-            if (rhs_function != nullptr)
-              rhs_function->vector_value_list(fe_values.get_quadrature_points(), rhs_values);
-
-            // TODO: move to parameter
-            const double viscosity = 0.1;
-
-            for (unsigned int q_point = 0; q_point < fe_values.n_quadrature_points; ++q_point)
-              {
-                for (unsigned int k = 0; k < dofs_per_cell; ++k)
-                  {
-                    grad_phi_u[k] = fe_values[velocities].gradient(k, q_point);
-                    div_phi_u[k]  = fe_values[velocities].divergence(k, q_point);
-                    phi_p[k]      = fe_values[pressure].value(k, q_point);
-                  }
-
-                for (unsigned int i = 0; i < dofs_per_cell; ++i)
-                  {
-                    for (unsigned int j = 0; j < dofs_per_cell; ++j)
-                      {
-                        cell_matrix(i, j) +=
-                          (viscosity * scalar_product(grad_phi_u[i], grad_phi_u[j]) -
-                           div_phi_u[i] * phi_p[j] - phi_p[i] * div_phi_u[j]) *
-                          fe_values.JxW(q_point);
-                      }
-
-                    const unsigned int component_i =
-                      cell->get_fe().system_to_component_index(i).first;
-                    cell_rhs(i) += fe_values.shape_value(i, q_point) *
-                                   rhs_values[q_point](component_i) * fe_values.JxW(q_point);
-                  }
-              }
-            local_dof_indices.resize(dofs_per_cell);
-            cell->get_dof_indices(local_dof_indices);
-
-            constraints.distribute_local_to_global(
-              cell_matrix, cell_rhs, local_dof_indices, system_matrix, system_rhs);
-          }
+        const auto worker = [rhs_function](
+                              const typename DoFHandler<dim, spacedim>::active_cell_iterator &cell,
+                              ScratchData<dim, spacedim> &scratch_data,
+                              CopyData                   &copy_data) {
+          const FEValuesExtractors::Vector velocities(0);
+          const FEValuesExtractors::Scalar pressure(dim);
+
+          auto &fe_values_collection = scratch_data.fe_values_collection;
+          fe_values_collection.reinit(cell);
+
+          const FEValues<dim> &fe_values     = fe_values_collection.get_present_fe_values();
+          const unsigned int   n_q_points    = fe_values.n_quadrature_points;
+          const unsigned int   dofs_per_cell = fe_values.dofs_per_cell;
+
+          auto &cell_matrix = copy_data.matrices[0];
+          auto &cell_rhs    = copy_data.vectors[0];
+          cell_matrix.reinit(dofs_per_cell, dofs_per_cell);
+          cell_rhs.reinit(dofs_per_cell);
+
+          auto &grad_phi_u = scratch_data.grad_phi_u;
+          auto &div_phi_u  = scratch_data.div_phi_u;
+          auto &phi_p      = scratch_data.phi_p;
+          grad_phi_u.resize(dofs_per_cell);
+          div_phi_u.resize(dofs_per_cell);
+          phi_p.resize(dofs_per_cell);
+
+          // TODO: Move this part to the problem class???
+          //       Not possible...
+          auto &rhs_values = scratch_data.rhs_values;
+          rhs_values.resize(n_q_points, Vector<double>(dim + 1));
+
+          // TODO: Make rhs function a parameter?
+          if (rhs_function != nullptr)
+            rhs_function->vector_value_list(fe_values.get_quadrature_points(), rhs_values);
+
+          // TODO: move to parameter
+          const double viscosity = 0.1;
+
+          for (unsigned int q_point = 0; q_point < fe_values.n_quadrature_points; ++q_point)
+            {
+              for (unsigned int k = 0; k < dofs_per_cell; ++k)
+                {
+                  grad_phi_u[k] = fe_values[velocities].gradient(k, q_point);
+                  div_phi_u[k]  = fe_values[velocities].divergence(k, q_point);
+                  phi_p[k]      = fe_values[pressure].value(k, q_point);
+                }
+
+              for (unsigned int i = 0; i < dofs_per_cell; ++i)
+                {
+                  for (unsigned int j = 0; j < dofs_per_cell; ++j)
+                    {
+                      cell_matrix(i, j) +=
+                        (viscosity * scalar_product(grad_phi_u[i], grad_phi_u[j]) -
+                         div_phi_u[i] * phi_p[j] - phi_p[i] * div_phi_u[j]) *
+                        fe_values.JxW(q_point);
+                    }
+
+                  const unsigned int component_i =
+                    cell->get_fe().system_to_component_index(i).first;
+                  cell_rhs(i) += fe_values.shape_value(i, q_point) *
+                                 rhs_values[q_point](component_i) * fe_values.JxW(q_point);
+                }
+            }
+
+          copy_data.local_dof_indices[0].resize(dofs_per_cell);
+          cell->get_dof_indices(copy_data.local_dof_indices[0]);
+        };
+
+        const auto copier = [&](const CopyData &copy_data) {
+          constraints.distribute_local_to_global(copy_data.matrices[0],
+                                                 copy_data.vectors[0],
+                                                 copy_data.local_dof_indices[0],
+                                                 system_matrix,
+                                                 system_rhs);
+        };
+
+        const CellFilter<dim, spacedim> begin(IteratorFilters::LocallyOwnedCell(),
+                                              dof_handler.begin_active());
+        const CellFilter<dim, spacedim> end(IteratorFilters::LocallyOwnedCell(), dof_handler.end());
+
+        WorkStream::run(begin,
+                        end,
+                        worker,
+                        copier,
+                        ScratchData<dim, spacedim>(fe_values_collection),
+                        CopyData(0));
 
         system_rhs.compress(VectorOperation::values::add);
         system_matrix.compress(VectorOperation::values::add);
@@ -647,7 +727,7 @@ namespace StokesMatrixBased
   void
   StokesOperator<dim, LinearAlgebra, spacedim>::vmult(VectorType &dst, const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult");
+    Instrumentation::Scope t(Instrumentation::vmult);
 
     system_matrix.vmult(dst, src);
   }
@@ -701,6 +781,15 @@ namespace StokesMatrixBased
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  StokesOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    return system_matrix.memory_consumption();
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   StokesOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType &dst, const VectorType &src) const
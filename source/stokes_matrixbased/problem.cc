@@ -28,10 +28,12 @@
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/numerics/vector_tools.h>
 
+#include <checkpoint.h>
 #include <factory.h>
 #include <global.h>
 #include <linear_algebra.h>
 #include <log.h>
+#include <output.h>
 #include <stokes_matrixbased/problem.h>
 #include <stokes_matrixbased/solvers.h>
 
@@ -47,7 +49,7 @@ namespace StokesMatrixBased
 {
   template <int dim, typename LinearAlgebra, int spacedim>
   Problem<dim, LinearAlgebra, spacedim>::Problem(const Parameter &prm)
-    : mpi_communicator(MPI_COMM_WORLD)
+    : mpi_communicator(getCommunicator())
     , prm(prm)
     , triangulation(mpi_communicator,
                     typename Triangulation<dim>::MeshSmoothing(
@@ -140,6 +142,10 @@ namespace StokesMatrixBased
         triangulation,
         fe_collection.component_mask(pressure));
 
+    // write output files in the background
+    if (prm.output_asynchronously)
+      async_writer = std::make_unique<AsyncWriter>(prm.output_queue_size);
+
     // cell weighting
     if (prm.adaptation_type != "h")
       {
@@ -456,21 +462,26 @@ namespace StokesMatrixBased
     DataOut<dim> data_out;
     data_out.attach_dof_handler(dof_handler);
 
-    data_out.add_data_vector(locally_relevant_solution,
-                             solution_names,
-                             DataOut<dim>::type_dof_data,
-                             data_component_interpretation);
-    data_out.add_data_vector(fe_degrees, "fe_degree");
-    data_out.add_data_vector(subdomain, "subdomain");
-
-    if (adaptation_strategy->get_error_estimates().size() > 0)
+    if (Output::has_field(prm, "solution"))
+      data_out.add_data_vector(locally_relevant_solution,
+                               solution_names,
+                               DataOut<dim>::type_dof_data,
+                               data_component_interpretation);
+    if (Output::has_field(prm, "fe_degree"))
+      data_out.add_data_vector(fe_degrees, "fe_degree");
+    if (Output::has_field(prm, "subdomain"))
+      data_out.add_data_vector(subdomain, "subdomain");
+
+    if (Output::has_field(prm, "error") &&
+        (adaptation_strategy->get_error_estimates().size() > 0))
       data_out.add_data_vector(adaptation_strategy->get_error_estimates(), "error");
-    if (adaptation_strategy->get_hp_indicators().size() > 0)
+    if (Output::has_field(prm, "hp_indicator") &&
+        (adaptation_strategy->get_hp_indicators().size() > 0))
       data_out.add_data_vector(adaptation_strategy->get_hp_indicators(), "hp_indicator");
 
-    data_out.build_patches(mapping_collection);
+    data_out.build_patches(mapping_collection, prm.output_subdivisions);
 
-    data_out.write_vtu_with_pvtu_record("./", prm.file_stem, cycle, mpi_communicator, 2, 1);
+    Output::write_vtu_with_pvtu_record(data_out, prm, cycle, mpi_communicator, async_writer.get());
   }
 
 
@@ -493,11 +504,12 @@ namespace StokesMatrixBased
         AssertThrow(false, ExcMessage("Checkpoint: invalid cycle!"));
       }
 
-    triangulation.load(prm.resume_filename);
+    Checkpoint::load(prm.resume_filename, triangulation);
 
     // custom repartitioning using DoFs requires correctly assigned FEs
     dof_handler.deserialize_active_fe_indices();
     dof_handler.distribute_dofs(fe_collection);
+
     triangulation.repartition();
 
     // unpack after repartitioning to avoid unnecessary data transfer
@@ -559,6 +571,16 @@ namespace StokesMatrixBased
 
           solve();
 
+          Log::log_memory_consumption("operators",
+                                      stokes_operator->memory_consumption() +
+                                        a_block_operator->memory_consumption() +
+                                        schur_block_operator->memory_consumption(),
+                                      mpi_communicator);
+          Log::log_memory_consumption("vectors",
+                                      locally_relevant_solution.memory_consumption() +
+                                        system_rhs.memory_consumption(),
+                                      mpi_communicator);
+
           if (prm.grid_type == "kovasznay")
             compute_errors();
           adaptation_strategy->estimate_mark();
@@ -568,12 +590,9 @@ namespace StokesMatrixBased
         }
 
         Log::log_timing_statistics(mpi_communicator);
+        Log::log_memory_statistics(mpi_communicator);
 
-        if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
-          {
-            std::ofstream logstream(filename_log);
-            getTable().write_text(logstream);
-          }
+        Log::write_table(filename_log, prm.log_format, mpi_communicator);
 
         getTimer().reset();
         getTable().start_new_row();
@@ -19,10 +19,16 @@
 #include <deal.II/lac/full_matrix.h>
 #include <deal.II/lac/vector.h>
 
+#include <function.h>
 #include <global.h>
+#include <instrumentation.h>
 #include <linear_algebra.h>
+#include <matrix_free_dispatch.h>
+#include <multigrid/reduce_and_assemble.h>
 #include <stokes_matrixfree/operators.h>
 
+#include <array>
+
 using namespace dealii;
 
 
@@ -62,11 +68,37 @@ namespace StokesMatrixFree
 
     this->partitioning = partitioning;
     this->constraints  = &constraints;
+    this->dof_index    = 0;
+    this->quad_index   = 0;
 
     typename MatrixFree<dim, value_type>::AdditionalData data;
     data.mapping_update_flags = update_gradients;
+    data.communicator_sm      = getSharedMemoryCommunicator();
+
+    const auto matrix_free = std::make_shared<MatrixFree<dim, value_type>>();
+    matrix_free->reinit(
+      *mapping_collection, dof_handler, constraints, *quadrature_collection, data);
+    this->matrix_free = matrix_free;
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  ABlockOperator<dim, LinearAlgebra, spacedim>::reinit(
+    const Partitioning                                       &partitioning,
+    const std::shared_ptr<const MatrixFree<dim, value_type>> &matrix_free,
+    const unsigned int                                        dof_index,
+    const unsigned int                                        quad_index,
+    const AffineConstraints<value_type>                      &constraints)
+  {
+    this->a_block_matrix.clear();
 
-    matrix_free.reinit(*mapping_collection, dof_handler, constraints, *quadrature_collection, data);
+    this->partitioning = partitioning;
+    this->constraints  = &constraints;
+    this->matrix_free  = matrix_free;
+    this->dof_index    = dof_index;
+    this->quad_index   = quad_index;
   }
 
 
@@ -88,9 +120,31 @@ namespace StokesMatrixFree
   void
   ABlockOperator<dim, LinearAlgebra, spacedim>::vmult(VectorType &dst, const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult_ABlockOperator");
+    Instrumentation::Scope t(Instrumentation::vmult_a_block_operator);
+
+    this->matrix_free->cell_loop(&ABlockOperator::do_cell_integral_range, this, dst, src, true);
+  }
+
 
-    this->matrix_free.cell_loop(&ABlockOperator::do_cell_integral_range, this, dst, src, true);
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  ABlockOperator<dim, LinearAlgebra, spacedim>::vmult(
+    VectorType                                                        &dst,
+    const VectorType                                                  &src,
+    const std::function<void(const unsigned int, const unsigned int)> &operation_before_loop,
+    const std::function<void(const unsigned int, const unsigned int)> &operation_after_loop) const
+  {
+    Instrumentation::Scope t(Instrumentation::vmult_a_block_operator);
+
+    // dst is not zeroed here, this is left to operation_before_loop
+    this->matrix_free->cell_loop(&ABlockOperator::do_cell_integral_range,
+                                 this,
+                                 dst,
+                                 src,
+                                 operation_before_loop,
+                                 operation_after_loop,
+                                 dof_index);
   }
 
 
@@ -99,7 +153,7 @@ namespace StokesMatrixFree
   void
   ABlockOperator<dim, LinearAlgebra, spacedim>::initialize_dof_vector(VectorType &vec) const
   {
-    matrix_free.initialize_dof_vector(vec);
+    matrix_free->initialize_dof_vector(vec, dof_index);
   }
 
 
@@ -108,7 +162,7 @@ namespace StokesMatrixFree
   types::global_dof_index
   ABlockOperator<dim, LinearAlgebra, spacedim>::m() const
   {
-    return matrix_free.get_dof_handler().n_dofs();
+    return matrix_free->get_dof_handler(dof_index).n_dofs();
   }
 
 
@@ -117,11 +171,13 @@ namespace StokesMatrixFree
   void
   ABlockOperator<dim, LinearAlgebra, spacedim>::compute_inverse_diagonal(VectorType &diagonal) const
   {
-    matrix_free.initialize_dof_vector(diagonal);
-    MatrixFreeTools::compute_diagonal(matrix_free,
+    matrix_free->initialize_dof_vector(diagonal, dof_index);
+    MatrixFreeTools::compute_diagonal(*matrix_free,
                                       diagonal,
                                       &ABlockOperator::do_cell_integral_local,
-                                      this);
+                                      this,
+                                      dof_index,
+                                      quad_index);
 
     // invert diagonal
     for (auto &i : diagonal)
@@ -137,12 +193,33 @@ namespace StokesMatrixFree
     // Check if matrix has already been set up.
     if (a_block_matrix.m() == 0 && a_block_matrix.n() == 0)
       {
-        const auto &dof_handler = this->matrix_free.get_dof_handler();
+        const auto &dof_handler = this->matrix_free->get_dof_handler(dof_index);
+
+        if constexpr (std::is_same_v<value_type, double>)
+          {
+            initialize_sparse_matrix(a_block_matrix, dof_handler, *constraints, partitioning);
+
+            MatrixFreeTools::compute_matrix(*matrix_free,
+                                            *constraints,
+                                            a_block_matrix,
+                                            &ABlockOperator::do_cell_integral_local,
+                                            this,
+                                            dof_index,
+                                            quad_index);
+          }
+        else
+          {
+            // Trilinos matrices only exist in double precision. We assemble them
+            // with a double precision replica of this operator.
+            AffineConstraints<double> constraints_double;
+            constraints_double.copy_from(*constraints);
 
-        initialize_sparse_matrix(a_block_matrix, dof_handler, *constraints, partitioning);
+            ABlockOperator<dim, dealiiTrilinos, spacedim> operator_double(*mapping_collection,
+                                                                          *quadrature_collection);
+            operator_double.reinit(partitioning, dof_handler, constraints_double);
 
-        MatrixFreeTools::compute_matrix(
-          matrix_free, *constraints, a_block_matrix, &ABlockOperator::do_cell_integral_local, this);
+            a_block_matrix.copy_from(operator_double.get_system_matrix());
+          }
       }
 
     return this->a_block_matrix;
@@ -150,6 +227,43 @@ namespace StokesMatrixFree
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  ABlockOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    // a shared MatrixFree object is accounted for by its owner
+    std::size_t memory = matrix_free.use_count() == 1 ? matrix_free->memory_consumption() : 0;
+
+    // the matrix is only assembled on demand
+    if (a_block_matrix.m() > 0)
+      memory += a_block_matrix.memory_consumption();
+
+    return memory;
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  ABlockOperator<dim, LinearAlgebra, spacedim>::compute_partial_matrix(
+    const IndexSet                       &all_indices_assemble,
+    const AffineConstraints<double>      &constraints_reduced,
+    typename LinearAlgebra::SparseMatrix &matrix) const
+  {
+    TimerOutput::Scope t(getTimer(), "compute_partial_matrix");
+
+    Assert(dof_index == 0 && quad_index == 0, ExcNotImplemented());
+
+    partially_compute_matrix<FECellIntegrator>(
+      *matrix_free,
+      constraints_reduced,
+      all_indices_assemble,
+      matrix,
+      [&](FECellIntegrator &velocity) { do_cell_integral_local(velocity); });
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   ABlockOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType &dst, const VectorType &src) const
@@ -165,42 +279,79 @@ namespace StokesMatrixFree
     FECellIntegrator &velocity) const
   {
     velocity.evaluate(EvaluationFlags::gradients);
+    do_quadrature(velocity);
+    velocity.integrate(EvaluationFlags::gradients);
+  }
 
-    for (unsigned int q = 0; q < velocity.n_q_points; ++q)
-      {
-        Tensor<1, dim, Tensor<1, dim, VectorizedArray<double>>> grad_u = velocity.get_gradient(q);
 
-        // TODO: Move viscosity to class member
-        constexpr double viscosity = 0.1;
-        grad_u *= viscosity;
 
-        velocity.submit_gradient(grad_u, q);
-      }
+  template <int dim, typename LinearAlgebra, int spacedim>
+  template <typename Integrator>
+  void
+  ABlockOperator<dim, LinearAlgebra, spacedim>::do_quadrature(Integrator &velocity) const
+  {
+    using VectorizedArrayType = VectorizedArray<value_type>;
+
+    // TODO: Move viscosity to class member
+    constexpr value_type viscosity = 0.1;
+
+    // The viscous term is a Laplacian of each velocity component. Instead of
+    // transforming the gradients of each component to the real cell and back,
+    // the metric JxW J^{-1} J^{-T} is computed once per quadrature point and
+    // applied to the gradients of all components on the reference cell.
+    const unsigned int   n_q_points = velocity.n_q_points;
+    VectorizedArrayType *gradients  = velocity.begin_gradients();
+
+    const auto index = [n_q_points](const unsigned int c,
+                                    const unsigned int d,
+                                    const unsigned int q) {
+#if DEAL_II_VERSION_GTE(9, 6, 0)
+      return (c * n_q_points + q) * dim + d;
+#else
+      return (c * dim + d) * n_q_points + q;
+#endif
+    };
 
-    velocity.integrate(EvaluationFlags::gradients);
+    for (unsigned int q = 0; q < n_q_points; ++q)
+      {
+        // rows refer to the real cell, columns to the reference cell
+        const Tensor<2, dim, VectorizedArrayType> inverse_jacobian = velocity.inverse_jacobian(q);
+        const VectorizedArrayType                 factor           = viscosity * velocity.JxW(q);
+
+        Tensor<2, dim, VectorizedArrayType> metric;
+        for (unsigned int d = 0; d < dim; ++d)
+          for (unsigned int e = d; e < dim; ++e)
+            {
+              VectorizedArrayType sum = inverse_jacobian[0][d] * inverse_jacobian[0][e];
+              for (unsigned int k = 1; k < dim; ++k)
+                sum += inverse_jacobian[k][d] * inverse_jacobian[k][e];
+              metric[d][e] = factor * sum;
+              metric[e][d] = metric[d][e];
+            }
+
+        for (unsigned int c = 0; c < dim; ++c)
+          {
+            Tensor<1, dim, VectorizedArrayType> reference_gradient;
+            for (unsigned int d = 0; d < dim; ++d)
+              reference_gradient[d] = gradients[index(c, d, q)];
+
+            for (unsigned int d = 0; d < dim; ++d)
+              gradients[index(c, d, q)] = metric[d] * reference_gradient;
+          }
+      }
   }
 
 
 
   template <int dim, typename LinearAlgebra, int spacedim>
+  template <typename Integrator>
   void
-  ABlockOperator<dim, LinearAlgebra, spacedim>::do_cell_integral_global(FECellIntegrator &velocity,
+  ABlockOperator<dim, LinearAlgebra, spacedim>::do_cell_integral_global(Integrator       &velocity,
                                                                         VectorType       &dst,
                                                                         const VectorType &src) const
   {
     velocity.gather_evaluate(src, EvaluationFlags::gradients);
-
-    for (unsigned int q = 0; q < velocity.n_q_points; ++q)
-      {
-        Tensor<1, dim, Tensor<1, dim, VectorizedArray<double>>> grad_u = velocity.get_gradient(q);
-
-        // TODO: Move viscosity to class member
-        constexpr double viscosity = 0.1;
-        grad_u *= viscosity;
-
-        velocity.submit_gradient(grad_u, q);
-      }
-
+    do_quadrature(velocity);
     velocity.integrate_scatter(EvaluationFlags::gradients, dst);
   }
 
@@ -214,13 +365,31 @@ namespace StokesMatrixFree
     const VectorType                            &src,
     const std::pair<unsigned int, unsigned int> &range) const
   {
-    FECellIntegrator velocity(matrix_free, range);
-
-    for (unsigned int cell = range.first; cell < range.second; ++cell)
+    const auto cell_loop = [&](auto &velocity) {
+      for (unsigned int cell = range.first; cell < range.second; ++cell)
+        {
+          velocity.reinit(cell);
+
+          do_cell_integral_global(velocity, dst, src);
+        }
+    };
+
+    // Use sum factorization with fixed polynomial degree if possible.
+    const bool dispatched =
+      dispatch_fe_degree(matrix_free, range, dof_index, quad_index, [&](const auto degree) {
+        constexpr int fe_degree = decltype(degree)::value;
+
+        FEEvaluation<dim, fe_degree, fe_degree + 1, dim, value_type> velocity(matrix_free,
+                                                                              range,
+                                                                              dof_index,
+                                                                              quad_index);
+        cell_loop(velocity);
+      });
+
+    if (dispatched == false)
       {
-        velocity.reinit(cell);
-
-        do_cell_integral_global(velocity, dst, src);
+        FECellIntegrator velocity(matrix_free, range, dof_index, quad_index);
+        cell_loop(velocity);
       }
   }
 
@@ -259,11 +428,37 @@ namespace StokesMatrixFree
 
     this->partitioning = partitioning;
     this->constraints  = &constraints;
+    this->dof_index    = 0;
+    this->quad_index   = 0;
 
     typename MatrixFree<dim, value_type>::AdditionalData data;
     data.mapping_update_flags = update_gradients;
+    data.communicator_sm      = getSharedMemoryCommunicator();
+
+    const auto matrix_free = std::make_shared<MatrixFree<dim, value_type>>();
+    matrix_free->reinit(
+      *mapping_collection, dof_handler, constraints, *quadrature_collection, data);
+    this->matrix_free = matrix_free;
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  SchurBlockOperator<dim, LinearAlgebra, spacedim>::reinit(
+    const Partitioning                                       &partitioning,
+    const std::shared_ptr<const MatrixFree<dim, value_type>> &matrix_free,
+    const unsigned int                                        dof_index,
+    const unsigned int                                        quad_index,
+    const AffineConstraints<value_type>                      &constraints)
+  {
+    this->schur_block_matrix.clear();
 
-    matrix_free.reinit(*mapping_collection, dof_handler, constraints, *quadrature_collection, data);
+    this->partitioning = partitioning;
+    this->constraints  = &constraints;
+    this->matrix_free  = matrix_free;
+    this->dof_index    = dof_index;
+    this->quad_index   = quad_index;
   }
 
 
@@ -286,9 +481,9 @@ namespace StokesMatrixFree
   SchurBlockOperator<dim, LinearAlgebra, spacedim>::vmult(VectorType       &dst,
                                                           const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult_SchurBlockOperator");
+    Instrumentation::Scope t(Instrumentation::vmult_schur_block_operator);
 
-    this->matrix_free.cell_loop(&SchurBlockOperator::do_cell_integral_range, this, dst, src, true);
+    this->matrix_free->cell_loop(&SchurBlockOperator::do_cell_integral_range, this, dst, src, true);
   }
 
 
@@ -297,7 +492,7 @@ namespace StokesMatrixFree
   void
   SchurBlockOperator<dim, LinearAlgebra, spacedim>::initialize_dof_vector(VectorType &vec) const
   {
-    matrix_free.initialize_dof_vector(vec);
+    matrix_free->initialize_dof_vector(vec, dof_index);
   }
 
 
@@ -306,7 +501,7 @@ namespace StokesMatrixFree
   types::global_dof_index
   SchurBlockOperator<dim, LinearAlgebra, spacedim>::m() const
   {
-    return matrix_free.get_dof_handler().n_dofs();
+    return matrix_free->get_dof_handler(dof_index).n_dofs();
   }
 
 
@@ -316,11 +511,13 @@ namespace StokesMatrixFree
   SchurBlockOperator<dim, LinearAlgebra, spacedim>::compute_inverse_diagonal(
     VectorType &diagonal) const
   {
-    matrix_free.initialize_dof_vector(diagonal);
-    MatrixFreeTools::compute_diagonal(matrix_free,
+    matrix_free->initialize_dof_vector(diagonal, dof_index);
+    MatrixFreeTools::compute_diagonal(*matrix_free,
                                       diagonal,
                                       &SchurBlockOperator::do_cell_integral_local,
-                                      this);
+                                      this,
+                                      dof_index,
+                                      quad_index);
 
     // invert diagonal
     for (auto &i : diagonal)
@@ -336,15 +533,17 @@ namespace StokesMatrixFree
     // Check if matrix has already been set up.
     if (schur_block_matrix.m() == 0 && schur_block_matrix.n() == 0)
       {
-        const auto &dof_handler = this->matrix_free.get_dof_handler();
+        const auto &dof_handler = this->matrix_free->get_dof_handler(dof_index);
 
         initialize_sparse_matrix(schur_block_matrix, dof_handler, *constraints, partitioning);
 
-        MatrixFreeTools::compute_matrix(matrix_free,
+        MatrixFreeTools::compute_matrix(*matrix_free,
                                         *constraints,
                                         schur_block_matrix,
                                         &SchurBlockOperator::do_cell_integral_local,
-                                        this);
+                                        this,
+                                        dof_index,
+                                        quad_index);
       }
 
     return this->schur_block_matrix;
@@ -352,6 +551,22 @@ namespace StokesMatrixFree
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  SchurBlockOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    // a shared MatrixFree object is accounted for by its owner
+    std::size_t memory = matrix_free.use_count() == 1 ? matrix_free->memory_consumption() : 0;
+
+    // the matrix is only assembled on demand
+    if (schur_block_matrix.m() > 0)
+      memory += schur_block_matrix.memory_consumption();
+
+    return memory;
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   SchurBlockOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType       &dst,
@@ -387,9 +602,10 @@ namespace StokesMatrixFree
 
 
   template <int dim, typename LinearAlgebra, int spacedim>
+  template <typename Integrator>
   void
   SchurBlockOperator<dim, LinearAlgebra, spacedim>::do_cell_integral_global(
-    FECellIntegrator &pressure,
+    Integrator       &pressure,
     VectorType       &dst,
     const VectorType &src) const
   {
@@ -420,13 +636,31 @@ namespace StokesMatrixFree
     const VectorType                            &src,
     const std::pair<unsigned int, unsigned int> &range) const
   {
-    FECellIntegrator pressure(matrix_free, range);
-
-    for (unsigned int cell = range.first; cell < range.second; ++cell)
+    const auto cell_loop = [&](auto &pressure) {
+      for (unsigned int cell = range.first; cell < range.second; ++cell)
+        {
+          pressure.reinit(cell);
+
+          do_cell_integral_global(pressure, dst, src);
+        }
+    };
+
+    // Use sum factorization with fixed polynomial degree if possible.
+    const bool dispatched =
+      dispatch_fe_degree(matrix_free, range, dof_index, quad_index, [&](const auto degree) {
+        constexpr int fe_degree = decltype(degree)::value;
+
+        FEEvaluation<dim, fe_degree, fe_degree + 1, 1, value_type> pressure(matrix_free,
+                                                                            range,
+                                                                            dof_index,
+                                                                            quad_index);
+        cell_loop(pressure);
+      });
+
+    if (dispatched == false)
       {
-        pressure.reinit(cell);
-
-        do_cell_integral_global(pressure, dst, src);
+        FECellIntegrator pressure(matrix_free, range, dof_index, quad_index);
+        cell_loop(pressure);
       }
   }
 
@@ -445,7 +679,7 @@ namespace StokesMatrixFree
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   StokesOperator<dim, LinearAlgebra, spacedim>::reinit(
-    const std::vector<const Partitioning *>                  &partitionings,
+    const std::vector<const Partitioning *> & /*partitionings*/,
     const std::vector<const DoFHandler<dim, spacedim> *>     &dof_handlers,
     const std::vector<const AffineConstraints<value_type> *> &constraints,
     VectorType                                               &system_rhs,
@@ -458,49 +692,58 @@ namespace StokesMatrixFree
 
     typename MatrixFree<dim, value_type>::AdditionalData data;
     data.mapping_update_flags = update_gradients | update_quadrature_points;
+    data.communicator_sm      = getSharedMemoryCommunicator();
     // TODO: we need quad points only for rhs function. hide between nullptr check
 
-    matrix_free.reinit(
+    const auto matrix_free = std::make_shared<MatrixFree<dim, value_type>>();
+    matrix_free->reinit(
       *mapping_collection, dof_handlers, constraints, *quadrature_collections, data);
+    this->matrix_free = matrix_free;
 
     this->initialize_dof_vector(system_rhs);
     // TODO: check if nullptr
-    matrix_free.cell_loop(&StokesOperator::do_cell_rhs_function_range,
-                          this,
-                          system_rhs,
-                          system_rhs);
+    matrix_free->cell_loop(&StokesOperator::do_cell_rhs_function_range,
+                           this,
+                           system_rhs,
+                           system_rhs);
 
     // residual: r = f - Au0
     // TODO: that is just the -Au0 part. add the rhs function part (check step-37/step-67)
     {
-      AffineConstraints<value_type> constraints_v_without_dbc;
-      constraints_v_without_dbc.reinit(partitionings[0]->get_relevant_dofs());
-      DoFTools::make_hanging_node_constraints(*dof_handlers[0], constraints_v_without_dbc);
-      constraints_v_without_dbc.close();
-
-      AffineConstraints<value_type> constraints_p_without_dbc;
-      constraints_p_without_dbc.reinit(partitionings[1]->get_relevant_dofs());
-      DoFTools::make_hanging_node_constraints(*dof_handlers[1], constraints_p_without_dbc);
-      constraints_p_without_dbc.close();
-
-      const std::vector<const AffineConstraints<value_type> *> constraints_without_dbc = {
-        &constraints_v_without_dbc, &constraints_p_without_dbc};
-
-      MatrixFree<dim, value_type> matrix_free;
-      matrix_free.reinit(
-        *mapping_collection, dof_handlers, constraints_without_dbc, *quadrature_collections, data);
-
-      VectorType b;
-      b.reinit(2);
-      matrix_free.initialize_dof_vector(b.block(0), 0);
-      matrix_free.initialize_dof_vector(b.block(1), 1);
-      b.collect_sizes();
-
-      VectorType x;
-      x.reinit(2);
-      matrix_free.initialize_dof_vector(x.block(0), 0);
-      matrix_free.initialize_dof_vector(x.block(1), 1);
-      x.collect_sizes();
+      // Reading the Dirichlet values in x without resolving constraints
+      // spares a second MatrixFree object with hanging node constraints only.
+      const std::function<void(const MatrixFree<dim, value_type> &,
+                               VectorType &,
+                               const VectorType &,
+                               const std::pair<unsigned int, unsigned int> &)>
+        cell_integral_plain_range = [&](const auto &matrix_free,
+                                        auto       &dst,
+                                        const auto &src,
+                                        const auto &range) {
+          FEVelocityIntegrator velocity(matrix_free, range, 0);
+          FEPressureIntegrator pressure(matrix_free, range, 1);
+
+          for (unsigned int cell = range.first; cell < range.second; ++cell)
+            {
+              velocity.reinit(cell);
+              velocity.read_dof_values_plain(src.block(0));
+              velocity.evaluate(EvaluationFlags::gradients);
+              pressure.reinit(cell);
+              pressure.read_dof_values_plain(src.block(1));
+              pressure.evaluate(EvaluationFlags::values);
+
+              do_quadrature_point_operation(velocity, pressure);
+
+              velocity.integrate(EvaluationFlags::gradients);
+              velocity.distribute_local_to_global(dst.block(0));
+              pressure.integrate(EvaluationFlags::values);
+              pressure.distribute_local_to_global(dst.block(1));
+            }
+        };
+
+      VectorType b, x;
+      this->initialize_dof_vector(b);
+      this->initialize_dof_vector(x);
 
       constraints[0]->distribute(x.block(0));
       constraints[1]->distribute(x.block(1));
@@ -508,7 +751,7 @@ namespace StokesMatrixFree
       // only zero rhs function supported for now
       // TODO: evaluate rhs function here
 
-      matrix_free.cell_loop(&StokesOperator::do_cell_integral_range, this, b, x);
+      matrix_free->cell_loop(cell_integral_plain_range, b, x, true);
 
       constraints[0]->set_zero(b.block(0));
       constraints[1]->set_zero(b.block(1));
@@ -519,13 +762,196 @@ namespace StokesMatrixFree
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  StokesOperator<dim, LinearAlgebra, spacedim>::reinit(
+    const std::vector<const Partitioning *> & /*partitionings*/,
+    const std::vector<const DoFHandler<dim, spacedim> *>     &dof_handlers,
+    const std::vector<const AffineConstraints<value_type> *> &constraints)
+  {
+    TimerOutput::Scope t(getTimer(), "reinit");
+
+    this->constraints   = &constraints;
+    this->rhs_functions = nullptr;
+
+    typename MatrixFree<dim, value_type>::AdditionalData data;
+    data.mapping_update_flags = update_gradients;
+    data.communicator_sm      = getSharedMemoryCommunicator();
+
+    const auto matrix_free = std::make_shared<MatrixFree<dim, value_type>>();
+    matrix_free->reinit(
+      *mapping_collection, dof_handlers, constraints, *quadrature_collections, data);
+    this->matrix_free = matrix_free;
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   StokesOperator<dim, LinearAlgebra, spacedim>::vmult(VectorType &dst, const VectorType &src) const
   {
-    TimerOutput::Scope t(getTimer(), "vmult_StokesOperator");
+    Instrumentation::Scope t(Instrumentation::vmult_stokes_operator);
+
+    this->matrix_free->cell_loop(&StokesOperator::do_cell_integral_range, this, dst, src, true);
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  StokesOperator<dim, LinearAlgebra, spacedim>::compute_monolithic_matrix(
+    const MonolithicNumbering               &numbering,
+    typename LinearAlgebra::SparsityPattern &sparsity_pattern,
+    typename LinearAlgebra::SparseMatrix    &system_matrix) const
+  {
+    TimerOutput::Scope t(getTimer(), "compute_monolithic_matrix");
+
+    const auto &dof_handler_v = matrix_free->get_dof_handler(0);
+    const auto &dof_handler_p = matrix_free->get_dof_handler(1);
+
+    const IndexSet &owned_dofs    = numbering.get_owned_dofs();
+    const IndexSet &relevant_dofs = numbering.get_relevant_dofs();
+
+    // Constraints of both blocks in the monolithic numbering. The matrix does
+    // not depend on inhomogeneities.
+    AffineConstraints<double> constraints_monolithic;
+    constraints_monolithic.reinit(owned_dofs, relevant_dofs);
+    for (unsigned int b = 0; b < 2; ++b)
+      for (const auto &line : (*constraints)[b]->get_lines())
+        {
+          const auto index = numbering.to_monolithic(b, line.index);
+
+          constraints_monolithic.add_line(index);
+          for (const auto &entry : line.entries)
+            constraints_monolithic.add_entry(index,
+                                             numbering.to_monolithic(b, entry.first),
+                                             entry.second);
+        }
+    constraints_monolithic.close();
+
+    std::vector<types::global_dof_index> dof_indices_v, dof_indices_p, dof_indices;
+
+    // sparsity pattern
+    sparsity_pattern.reinit(owned_dofs,
+                            owned_dofs,
+                            relevant_dofs,
+                            dof_handler_v.get_communicator());
+
+    auto cell_p = dof_handler_p.begin_active();
+    for (const auto &cell_v : dof_handler_v.active_cell_iterators())
+      {
+        if (cell_v->is_locally_owned())
+          {
+            dof_indices_v.resize(cell_v->get_fe().n_dofs_per_cell());
+            cell_v->get_dof_indices(dof_indices_v);
+            dof_indices_p.resize(cell_p->get_fe().n_dofs_per_cell());
+            cell_p->get_dof_indices(dof_indices_p);
+
+            dof_indices.clear();
+            for (const auto i : dof_indices_v)
+              dof_indices.push_back(numbering.to_monolithic(0, i));
+            for (const auto i : dof_indices_p)
+              dof_indices.push_back(numbering.to_monolithic(1, i));
+
+            constraints_monolithic.add_entries_local_to_global(dof_indices,
+                                                               sparsity_pattern,
+                                                               false);
+          }
+        ++cell_p;
+      }
+
+    sparsity_pattern.compress();
+    system_matrix.reinit(sparsity_pattern);
+
+    // cell matrices of all cells in a batch, column by column
+    std::vector<FullMatrix<double>> cell_matrices;
+
+    for (unsigned int cell = 0; cell < matrix_free->n_cell_batches(); ++cell)
+      {
+        const std::pair<unsigned int, unsigned int> range(cell, cell + 1);
+
+        FEVelocityIntegrator velocity(*matrix_free, range, 0);
+        FEPressureIntegrator pressure(*matrix_free, range, 1);
+
+        velocity.reinit(cell);
+        pressure.reinit(cell);
+
+        const unsigned int n_dofs_v = velocity.dofs_per_cell;
+        const unsigned int n_dofs_p = pressure.dofs_per_cell;
+        const unsigned int n_lanes  = matrix_free->n_active_entries_per_cell_batch(cell);
+
+        cell_matrices.assign(n_lanes, FullMatrix<double>(n_dofs_v + n_dofs_p));
+
+        for (unsigned int j = 0; j < n_dofs_v + n_dofs_p; ++j)
+          {
+            for (unsigned int i = 0; i < n_dofs_v; ++i)
+              velocity.begin_dof_values()[i] = (i == j) ? 1. : 0.;
+            for (unsigned int i = 0; i < n_dofs_p; ++i)
+              pressure.begin_dof_values()[i] = (n_dofs_v + i == j) ? 1. : 0.;
+
+            velocity.evaluate(EvaluationFlags::gradients);
+            pressure.evaluate(EvaluationFlags::values);
+
+            do_quadrature_point_operation(velocity, pressure);
+
+            velocity.integrate(EvaluationFlags::gradients);
+            pressure.integrate(EvaluationFlags::values);
+
+            for (unsigned int v = 0; v < n_lanes; ++v)
+              {
+                for (unsigned int i = 0; i < n_dofs_v; ++i)
+                  cell_matrices[v](i, j) = velocity.begin_dof_values()[i][v];
+                for (unsigned int i = 0; i < n_dofs_p; ++i)
+                  cell_matrices[v](n_dofs_v + i, j) = pressure.begin_dof_values()[i][v];
+              }
+          }
+
+        // FEEvaluation works on the lexicographic numbering of DoFs
+        const auto &lexicographic_v =
+          matrix_free
+            ->get_shape_info(
+              0, 0, 0, velocity.get_active_fe_index(), velocity.get_active_quadrature_index())
+            .lexicographic_numbering;
+        const auto &lexicographic_p =
+          matrix_free
+            ->get_shape_info(
+              1, 0, 0, pressure.get_active_fe_index(), pressure.get_active_quadrature_index())
+            .lexicographic_numbering;
+
+        dof_indices.resize(n_dofs_v + n_dofs_p);
+        dof_indices_v.resize(n_dofs_v);
+        dof_indices_p.resize(n_dofs_p);
+
+        for (unsigned int v = 0; v < n_lanes; ++v)
+          {
+            matrix_free->get_cell_iterator(cell, v, 0)->get_dof_indices(dof_indices_v);
+            matrix_free->get_cell_iterator(cell, v, 1)->get_dof_indices(dof_indices_p);
+
+            for (unsigned int i = 0; i < n_dofs_v; ++i)
+              dof_indices[i] = numbering.to_monolithic(0, dof_indices_v[lexicographic_v[i]]);
+            for (unsigned int i = 0; i < n_dofs_p; ++i)
+              dof_indices[n_dofs_v + i] =
+                numbering.to_monolithic(1, dof_indices_p[lexicographic_p[i]]);
+
+            constraints_monolithic.distribute_local_to_global(cell_matrices[v],
+                                                              dof_indices,
+                                                              system_matrix);
+          }
+      }
+
+    system_matrix.compress(VectorOperation::add);
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  StokesOperator<dim, LinearAlgebra, spacedim>::vmult_gradient(BlockType       &dst,
+                                                               const BlockType &src) const
+  {
+    Instrumentation::Scope t(Instrumentation::vmult_stokes_operator);
 
-    this->matrix_free.cell_loop(&StokesOperator::do_cell_integral_range, this, dst, src, true);
+    this->matrix_free->cell_loop(&StokesOperator::do_cell_gradient_range, this, dst, src, true);
   }
 
 
@@ -535,8 +961,8 @@ namespace StokesMatrixFree
   StokesOperator<dim, LinearAlgebra, spacedim>::initialize_dof_vector(VectorType &vec) const
   {
     vec.reinit(2);
-    matrix_free.initialize_dof_vector(vec.block(0), 0);
-    matrix_free.initialize_dof_vector(vec.block(1), 1);
+    matrix_free->initialize_dof_vector(vec.block(0), 0);
+    matrix_free->initialize_dof_vector(vec.block(1), 1);
     vec.collect_sizes();
   }
 
@@ -546,7 +972,7 @@ namespace StokesMatrixFree
   types::global_dof_index
   StokesOperator<dim, LinearAlgebra, spacedim>::m() const
   {
-    return matrix_free.get_dof_handler(0).n_dofs() + matrix_free.get_dof_handler(1).n_dofs();
+    return matrix_free->get_dof_handler(0).n_dofs() + matrix_free->get_dof_handler(1).n_dofs();
   }
 
 
@@ -554,9 +980,22 @@ namespace StokesMatrixFree
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   StokesOperator<dim, LinearAlgebra, spacedim>::compute_inverse_diagonal(
-    VectorType & /*diagonal*/) const
+    VectorType &diagonal) const
   {
-    Assert(false, ExcNotImplemented());
+    this->initialize_dof_vector(diagonal);
+
+    // The diagonal of the velocity block is the one of the A-block. The
+    // pressure block of the saddle point system vanishes.
+    MatrixFreeTools::compute_diagonal(*matrix_free,
+                                      diagonal.block(0),
+                                      &StokesOperator::do_cell_integral_velocity_local,
+                                      this,
+                                      /*dof_no=*/0);
+
+    // invert diagonal
+    for (unsigned int b = 0; b < diagonal.n_blocks(); ++b)
+      for (auto &i : diagonal.block(b))
+        i = (std::abs(i) > 1.0e-10) ? (1.0 / i) : 1.0;
   }
 
 
@@ -571,6 +1010,25 @@ namespace StokesMatrixFree
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::size_t
+  StokesOperator<dim, LinearAlgebra, spacedim>::memory_consumption() const
+  {
+    return matrix_free->memory_consumption();
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  std::shared_ptr<
+    const MatrixFree<dim, typename StokesOperator<dim, LinearAlgebra, spacedim>::value_type>>
+  StokesOperator<dim, LinearAlgebra, spacedim>::get_matrix_free() const
+  {
+    return matrix_free;
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   StokesOperator<dim, LinearAlgebra, spacedim>::Tvmult(VectorType &dst, const VectorType &src) const
@@ -580,6 +1038,30 @@ namespace StokesMatrixFree
 
 
 
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  StokesOperator<dim, LinearAlgebra, spacedim>::do_cell_integral_velocity_local(
+    FEVelocityIntegrator &velocity) const
+  {
+    velocity.evaluate(EvaluationFlags::gradients);
+
+    for (unsigned int q = 0; q < velocity.n_q_points; ++q)
+      {
+        Tensor<1, dim, Tensor<1, dim, VectorizedArray<value_type>>> grad_u =
+          velocity.get_gradient(q);
+
+        // TODO: Move viscosity to class member
+        constexpr value_type viscosity = 0.1;
+        grad_u *= viscosity;
+
+        velocity.submit_gradient(grad_u, q);
+      }
+
+    velocity.integrate(EvaluationFlags::gradients);
+  }
+
+
+
   template <int dim, typename LinearAlgebra, int spacedim>
   void
   StokesOperator<dim, LinearAlgebra, spacedim>::do_cell_integral_range(
@@ -588,8 +1070,8 @@ namespace StokesMatrixFree
     const VectorType                            &src,
     const std::pair<unsigned int, unsigned int> &range) const
   {
-    FEEvaluation<dim, -1, 0, dim, value_type> velocity(matrix_free, range, 0);
-    FEEvaluation<dim, -1, 0, 1, value_type>   pressure(matrix_free, range, 1);
+    FEVelocityIntegrator velocity(matrix_free, range, 0);
+    FEPressureIntegrator pressure(matrix_free, range, 1);
 
     for (unsigned int cell = range.first; cell < range.second; ++cell)
       {
@@ -598,27 +1080,70 @@ namespace StokesMatrixFree
         pressure.reinit(cell);
         pressure.gather_evaluate(src.block(1), EvaluationFlags::values);
 
-        for (unsigned int q = 0; q < velocity.n_q_points; ++q)
-          {
-            Tensor<1, dim, Tensor<1, dim, VectorizedArray<double>>> grad_u =
-              velocity.get_gradient(q);
-            VectorizedArray<double> pres  = pressure.get_value(q);
-            VectorizedArray<double> div_u = velocity.get_divergence(q);
-            pressure.submit_value(-div_u, q);
+        do_quadrature_point_operation(velocity, pressure);
+
+        velocity.integrate_scatter(EvaluationFlags::gradients, dst.block(0));
+        pressure.integrate_scatter(EvaluationFlags::values, dst.block(1));
+      }
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  StokesOperator<dim, LinearAlgebra, spacedim>::do_quadrature_point_operation(
+    FEVelocityIntegrator &velocity,
+    FEPressureIntegrator &pressure) const
+  {
+    for (unsigned int q = 0; q < velocity.n_q_points; ++q)
+      {
+        Tensor<1, dim, Tensor<1, dim, VectorizedArray<double>>> grad_u = velocity.get_gradient(q);
+        VectorizedArray<double> pres  = pressure.get_value(q);
+        VectorizedArray<double> div_u = velocity.get_divergence(q);
+        pressure.submit_value(-div_u, q);
+
+        // TODO: Move viscosity to class member
+        constexpr double viscosity = 0.1;
+        grad_u *= viscosity;
 
-            // TODO: Move viscosity to class member
-            constexpr double viscosity = 0.1;
-            grad_u *= viscosity;
+        // subtract p * I
+        for (unsigned int d = 0; d < dim; ++d)
+          grad_u[d][d] -= pres;
 
-            // subtract p * I
+        velocity.submit_gradient(grad_u, q);
+      }
+  }
+
+
+
+  template <int dim, typename LinearAlgebra, int spacedim>
+  void
+  StokesOperator<dim, LinearAlgebra, spacedim>::do_cell_gradient_range(
+    const MatrixFree<dim, value_type>           &matrix_free,
+    BlockType                                   &dst,
+    const BlockType                             &src,
+    const std::pair<unsigned int, unsigned int> &range) const
+  {
+    FEVelocityIntegrator velocity(matrix_free, range, 0);
+    FEPressureIntegrator pressure(matrix_free, range, 1);
+
+    for (unsigned int cell = range.first; cell < range.second; ++cell)
+      {
+        velocity.reinit(cell);
+        pressure.reinit(cell);
+        pressure.gather_evaluate(src, EvaluationFlags::values);
+
+        // same as do_quadrature_point_operation() with zero velocity
+        for (unsigned int q = 0; q < velocity.n_q_points; ++q)
+          {
+            Tensor<1, dim, Tensor<1, dim, VectorizedArray<double>>> grad_u;
             for (unsigned int d = 0; d < dim; ++d)
-              grad_u[d][d] -= pres;
+              grad_u[d][d] = -pressure.get_value(q);
 
             velocity.submit_gradient(grad_u, q);
           }
 
-        velocity.integrate_scatter(EvaluationFlags::gradients, dst.block(0));
-        pressure.integrate_scatter(EvaluationFlags::values, dst.block(1));
+        velocity.integrate_scatter(EvaluationFlags::gradients, dst);
       }
   }
 
@@ -635,6 +1160,12 @@ namespace StokesMatrixFree
     FEEvaluation<dim, -1, 0, dim, value_type> velocity(matrix_free, range, 0);
     FEEvaluation<dim, -1, 0, 1, value_type>   pressure(matrix_free, range, 1);
 
+    // evaluate the right hand side on whole cell batches
+    const ::Function::VectorizedEvaluator<dim> rhs_velocity(*(*rhs_functions)[0]);
+    const ::Function::VectorizedEvaluator<dim> rhs_pressure(*(*rhs_functions)[1]);
+
+    std::array<VectorizedArray<value_type>, dim> f_values;
+
     for (unsigned int cell = range.first; cell < range.second; ++cell)
       {
         velocity.reinit(cell);
@@ -642,34 +1173,17 @@ namespace StokesMatrixFree
 
         for (unsigned int q = 0; q < velocity.n_q_points; ++q)
           {
-            const Point<dim, VectorizedArray<value_type>> p_vect = velocity.quadrature_point(q);
-            Tensor<1, dim, VectorizedArray<value_type>>   f_vect;
-            for (unsigned int i = 0; i < VectorizedArray<value_type>::size(); ++i)
-              {
-                Point<dim> p;
-                for (unsigned int d = 0; d < dim; ++d)
-                  p[d] = p_vect[d][i];
-                Vector<value_type> f(dim);
-                (*rhs_functions)[0]->vector_value(p, f);
-                for (unsigned int d = 0; d < dim; ++d)
-                  f_vect[d][i] = f[d];
-              }
+            rhs_velocity.vector_value(velocity.quadrature_point(q),
+                                      ArrayView<VectorizedArray<value_type>>(f_values.data(), dim));
+
+            Tensor<1, dim, VectorizedArray<value_type>> f_vect;
+            for (unsigned int d = 0; d < dim; ++d)
+              f_vect[d] = f_values[d];
             velocity.submit_value(f_vect, q);
           }
 
         for (unsigned int q = 0; q < pressure.n_q_points; ++q)
-          {
-            const Point<dim, VectorizedArray<value_type>> p_vect = pressure.quadrature_point(q);
-            VectorizedArray<value_type>                   f_vect = 0.;
-            for (unsigned int i = 0; i < VectorizedArray<value_type>::size(); ++i)
-              {
-                Point<dim> p;
-                for (unsigned int d = 0; d < dim; ++d)
-                  p[d] = p_vect[d][i];
-                f_vect[i] = (*rhs_functions)[1]->value(p);
-              }
-            pressure.submit_value(f_vect, q);
-          }
+          pressure.submit_value(rhs_pressure.value(pressure.quadrature_point(q)), q);
 
         velocity.integrate_scatter(EvaluationFlags::values, system_rhs.block(0));
         pressure.integrate_scatter(EvaluationFlags::values, system_rhs.block(1));
@@ -682,6 +1196,8 @@ namespace StokesMatrixFree
 #ifdef DEAL_II_WITH_TRILINOS
   template class ABlockOperator<2, dealiiTrilinos, 2>;
   template class ABlockOperator<3, dealiiTrilinos, 3>;
+  template class ABlockOperator<2, dealiiTrilinosFloat, 2>;
+  template class ABlockOperator<3, dealiiTrilinosFloat, 3>;
   template class SchurBlockOperator<2, dealiiTrilinos, 2>;
   template class SchurBlockOperator<3, dealiiTrilinos, 3>;
   template class StokesOperator<2, dealiiTrilinos, 2>;
@@ -26,10 +26,13 @@
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/numerics/vector_tools.h>
 
+#include <checkpoint.h>
 #include <factory.h>
 #include <global.h>
 #include <linear_algebra.h>
 #include <log.h>
+#include <multigrid/smoother_dispatch.h>
+#include <output.h>
 #include <stokes_matrixfree/operators.h>
 #include <stokes_matrixfree/problem.h>
 #include <stokes_matrixfree/solvers.h>
@@ -42,11 +45,52 @@ using namespace dealii;
 
 
 
+template <int dim, typename LinearAlgebra, int spacedim, typename LevelLinearAlgebra>
+static void
+solve_gmg_with_smoother(
+  SolverControl                                                        &solver_control,
+  const StokesMatrixFree::StokesOperator<dim, LinearAlgebra, spacedim> &stokes_operator,
+  const OperatorType<dim, LinearAlgebra, spacedim>                     &a_block_operator,
+  const OperatorType<dim, LevelLinearAlgebra, spacedim>                &a_block_level_operator,
+  const OperatorType<dim, LinearAlgebra, spacedim>                     &schur_block_operator,
+  typename LinearAlgebra::BlockVector                                  &dst,
+  const typename LinearAlgebra::BlockVector                            &src,
+  const MGSolverParameters                                             &mg_data,
+  const StokesMatrixFree::BlockSchurParameters                         &prm_block_schur,
+  const std::vector<const DoFHandler<dim, spacedim> *>                 &dof_handlers,
+  std::unique_ptr<MGHierarchyBase>                                     &mg_hierarchy,
+  const std::string                                                    &filename_mg_level)
+{
+  using LevelVectorType = typename LevelLinearAlgebra::Vector;
+
+  dispatch_smoother_preconditioner<LevelVectorType>(
+    mg_data.smoother_preconditioner_type, [&](const auto smoother_preconditioner) {
+      using SmootherPreconditionerType = typename decltype(smoother_preconditioner)::type;
+
+      StokesMatrixFree::
+        solve_gmg<SmootherPreconditionerType, dim, LinearAlgebra, spacedim, LevelLinearAlgebra>(
+          solver_control,
+          stokes_operator,
+          a_block_operator,
+          a_block_level_operator,
+          schur_block_operator,
+          dst,
+          src,
+          mg_data,
+          prm_block_schur,
+          dof_handlers,
+          mg_hierarchy,
+          filename_mg_level);
+    });
+}
+
+
+
 namespace StokesMatrixFree
 {
   template <int dim, typename LinearAlgebra, int spacedim>
   Problem<dim, LinearAlgebra, spacedim>::Problem(const Parameter &prm)
-    : mpi_communicator(MPI_COMM_WORLD)
+    : mpi_communicator(getCommunicator())
     , prm(prm)
     , triangulation(mpi_communicator,
                     typename Triangulation<dim>::MeshSmoothing(
@@ -163,6 +207,10 @@ namespace StokesMatrixFree
         dof_handler_p,
         triangulation);
 
+    // write output files in the background
+    if (prm.output_asynchronously)
+      async_writer = std::make_unique<AsyncWriter>(prm.output_queue_size);
+
     // cell weighting
     if (prm.adaptation_type != "h")
       {
@@ -281,6 +329,41 @@ namespace StokesMatrixFree
     std::vector<unsigned int> stokes_sub_blocks(dim + 1, 0);
     stokes_sub_blocks[dim] = 1;
 
+    const auto make_constraints_v = [&]() {
+      constraints_v.clear();
+      constraints_v.reinit(partitioning_v.get_relevant_dofs());
+
+      DoFTools::make_hanging_node_constraints(dof_handler_v, constraints_v);
+
+      // TODO: introduce boundary_function
+      if (prm.grid_type == "kovasznay")
+        {
+          VectorTools::interpolate_boundary_values(mapping_collection,
+                                                   dof_handler_v,
+                                                   /*boundary_component=*/0,
+                                                   *solution_function_v,
+                                                   constraints_v);
+        }
+      else if (prm.grid_type == "y-pipe")
+        {
+          ::Function::PoisseuilleFlowVelocity<dim> inflow(/*radius=*/1.);
+          Functions::ZeroFunction<dim>             zero(/*n_components=*/dim);
+
+          // flow at inlet opening 0
+          // no slip on walls
+          VectorTools::interpolate_boundary_values(mapping_collection,
+                                                   dof_handler_v,
+                                                   /*function_map=*/{{0, &inflow}, {3, &zero}},
+                                                   constraints_v);
+        }
+      else
+        {
+          Assert(false, ExcNotImplemented());
+        }
+
+      constraints_v.close();
+    };
+
     {
       TimerOutput::Scope t(getTimer(), "distribute_dofs");
 
@@ -292,6 +375,22 @@ namespace StokesMatrixFree
       partitionings = {&partitioning_v, &partitioning_p};
     }
 
+    if (prm.velocity_data_locality)
+      {
+        TimerOutput::Scope t(getTimer(), "renumber_dofs");
+
+        // The components of each velocity node are numbered consecutively
+        // already. Nodes are renumbered in the order in which the cell loops
+        // of the A-block visit them, which requires the constraints.
+        make_constraints_v();
+
+        typename MatrixFree<dim, double>::AdditionalData data;
+        data.mapping_update_flags = update_gradients;
+        DoFRenumbering::matrix_free_data_locality(dof_handler_v, constraints_v, data);
+
+        partitioning_v.reinit(dof_handler_v);
+      }
+
     {
       TimerOutput::Scope(getTimer(), "reinit_vectors");
 
@@ -307,40 +406,7 @@ namespace StokesMatrixFree
     {
       TimerOutput::Scope t(getTimer(), "make_constraints");
 
-      {
-        constraints_v.clear();
-        constraints_v.reinit(partitioning_v.get_relevant_dofs());
-
-        DoFTools::make_hanging_node_constraints(dof_handler_v, constraints_v);
-
-        // TODO: introduce boundary_function
-        if (prm.grid_type == "kovasznay")
-          {
-            VectorTools::interpolate_boundary_values(mapping_collection,
-                                                     dof_handler_v,
-                                                     /*boundary_component=*/0,
-                                                     *solution_function_v,
-                                                     constraints_v);
-          }
-        else if (prm.grid_type == "y-pipe")
-          {
-            ::Function::PoisseuilleFlowVelocity<dim> inflow(/*radius=*/1.);
-            Functions::ZeroFunction<dim>             zero(/*n_components=*/dim);
-
-            // flow at inlet opening 0
-            // no slip on walls
-            VectorTools::interpolate_boundary_values(mapping_collection,
-                                                     dof_handler_v,
-                                                     /*function_map=*/{{0, &inflow}, {3, &zero}},
-                                                     constraints_v);
-          }
-        else
-          {
-            Assert(false, ExcNotImplemented());
-          }
-
-        constraints_v.close();
-      }
+      make_constraints_v();
 
       {
         constraints_p.clear();
@@ -378,69 +444,76 @@ namespace StokesMatrixFree
                                                 *a_block_operator,
                                                 *schur_block_operator,
                                                 completely_distributed_solution,
-                                                system_rhs);
+                                                system_rhs,
+                                                prm.prm_block_schur);
       }
     else if (prm.solver_type == "GMG")
       {
         const std::string filename_mg_level =
           filename_stem + "-mglevel-cycle_" + std::to_string(cycle) + ".log";
 
-        if (prm.prm_multigrid.smoother_preconditioner_type == "Extended Diagonal")
-          {
-            solve_gmg<PreconditionExtendedDiagonal<typename LinearAlgebra::Vector>,
-                      dim,
-                      LinearAlgebra,
-                      spacedim>(solver_control_refined,
-                                *stokes_operator,
-                                *a_block_operator,
-                                *schur_block_operator,
-                                completely_distributed_solution,
-                                system_rhs,
-                                prm.prm_multigrid,
-                                mapping_collection,
-                                quadrature_collection_v,
-                                dof_handlers,
-                                filename_mg_level);
-          }
-        else if (prm.prm_multigrid.smoother_preconditioner_type == "ASM")
+        if (prm.prm_multigrid.mixed_precision)
           {
-            solve_gmg<PreconditionASM<typename LinearAlgebra::Vector>,
-                      dim,
-                      LinearAlgebra,
-                      spacedim>(solver_control_refined,
-                                *stokes_operator,
-                                *a_block_operator,
-                                *schur_block_operator,
-                                completely_distributed_solution,
-                                system_rhs,
-                                prm.prm_multigrid,
-                                mapping_collection,
-                                quadrature_collection_v,
-                                dof_handlers,
-                                filename_mg_level);
-          }
-        else if (prm.prm_multigrid.smoother_preconditioner_type == "Diagonal")
-          {
-            solve_gmg<DiagonalMatrixTimer<typename LinearAlgebra::Vector>,
-                      dim,
-                      LinearAlgebra,
-                      spacedim>(solver_control_refined,
-                                *stokes_operator,
-                                *a_block_operator,
-                                *schur_block_operator,
-                                completely_distributed_solution,
-                                system_rhs,
-                                prm.prm_multigrid,
-                                mapping_collection,
-                                quadrature_collection_v,
-                                dof_handlers,
-                                filename_mg_level);
+            if constexpr (std::is_same_v<LinearAlgebra, dealiiTrilinos>)
+              {
+                // level operators in single precision
+                const ABlockOperator<dim, dealiiTrilinosFloat, spacedim> a_block_level_operator(
+                  mapping_collection, quadrature_collection_v);
+
+                solve_gmg_with_smoother<dim, LinearAlgebra, spacedim, dealiiTrilinosFloat>(
+                  solver_control_refined,
+                  *stokes_operator,
+                  *a_block_operator,
+                  a_block_level_operator,
+                  *schur_block_operator,
+                  completely_distributed_solution,
+                  system_rhs,
+                  prm.prm_multigrid,
+                  prm.prm_block_schur,
+                  dof_handlers,
+                  mg_hierarchy,
+                  filename_mg_level);
+              }
+            else
+              {
+                AssertThrow(false,
+                            ExcMessage("Mixed precision is only available with dealii & Trilinos!"));
+              }
           }
         else
           {
-            AssertThrow(false, ExcNotImplemented());
+            solve_gmg_with_smoother<dim, LinearAlgebra, spacedim, LinearAlgebra>(
+              solver_control_refined,
+              *stokes_operator,
+              *a_block_operator,
+              *a_block_operator,
+              *schur_block_operator,
+              completely_distributed_solution,
+              system_rhs,
+              prm.prm_multigrid,
+              prm.prm_block_schur,
+              dof_handlers,
+              mg_hierarchy,
+              filename_mg_level);
           }
       }
+    else if (prm.solver_type == "GMG monolithic")
+      {
+        // the finest level numbers DoFs just like a fresh DoFHandler does
+        AssertThrow(prm.velocity_data_locality == false,
+                    ExcMessage("Monolithic multigrid does not support renumbered velocity DoFs!"));
+
+        solve_gmg_monolithic<dim, LinearAlgebra, spacedim>(solver_control_refined,
+                                                           *stokes_operator,
+                                                           completely_distributed_solution,
+                                                           system_rhs,
+                                                           prm.prm_multigrid,
+                                                           prm.prm_monolithic,
+                                                           mapping_collection,
+                                                           quadrature_collections,
+                                                           dof_handlers,
+                                                           mg_hierarchy);
+      }
     else
       {
         Assert(false, ExcNotImplemented());
@@ -576,26 +649,37 @@ namespace StokesMatrixFree
 
     DataOut<dim> data_out;
     data_out.attach_dof_handler(dof_handler_p);
-    data_out.add_data_vector(locally_relevant_solution.block(1), "pressure");
-    data_out.add_data_vector(fe_degrees_p, "fe_degree_p");
-    data_out.add_data_vector(fe_degrees_v, "fe_degree_v");
-    data_out.add_data_vector(subdomain, "subdomain");
+    if (Output::has_field(prm, "solution"))
+      data_out.add_data_vector(locally_relevant_solution.block(1), "pressure");
+    if (Output::has_field(prm, "fe_degree"))
+      {
+        data_out.add_data_vector(fe_degrees_p, "fe_degree_p");
+        data_out.add_data_vector(fe_degrees_v, "fe_degree_v");
+      }
+    if (Output::has_field(prm, "subdomain"))
+      data_out.add_data_vector(subdomain, "subdomain");
 
-    if (adaptation_strategy_p->get_error_estimates().size() > 0)
+    if (Output::has_field(prm, "error") &&
+        (adaptation_strategy_p->get_error_estimates().size() > 0))
       data_out.add_data_vector(adaptation_strategy_p->get_error_estimates(), "error");
-    if (adaptation_strategy_p->get_hp_indicators().size() > 0)
+    if (Output::has_field(prm, "hp_indicator") &&
+        (adaptation_strategy_p->get_hp_indicators().size() > 0))
       data_out.add_data_vector(adaptation_strategy_p->get_hp_indicators(), "hp_indicator");
 
-    std::vector<DataComponentInterpretation::DataComponentInterpretation>
-      data_component_interpretation(dim, DataComponentInterpretation::component_is_part_of_vector);
-    data_out.add_data_vector(dof_handler_v,
-                             locally_relevant_solution.block(0),
-                             "velocity",
-                             data_component_interpretation);
+    if (Output::has_field(prm, "solution"))
+      {
+        std::vector<DataComponentInterpretation::DataComponentInterpretation>
+          data_component_interpretation(dim,
+                                        DataComponentInterpretation::component_is_part_of_vector);
+        data_out.add_data_vector(dof_handler_v,
+                                 locally_relevant_solution.block(0),
+                                 "velocity",
+                                 data_component_interpretation);
+      }
 
-    data_out.build_patches(mapping_collection);
+    data_out.build_patches(mapping_collection, prm.output_subdivisions);
 
-    data_out.write_vtu_with_pvtu_record("./", prm.file_stem, cycle, mpi_communicator, 2, 1);
+    Output::write_vtu_with_pvtu_record(data_out, prm, cycle, mpi_communicator, async_writer.get());
   }
 
 
@@ -618,7 +702,7 @@ namespace StokesMatrixFree
         AssertThrow(false, ExcMessage("Checkpoint: invalid cycle!"));
       }
 
-    triangulation.load(prm.resume_filename);
+    Checkpoint::load(prm.resume_filename, triangulation);
 
     // custom repartitioning using DoFs requires correctly assigned FEs
     dof_handler_p.deserialize_active_fe_indices();
@@ -688,16 +772,30 @@ namespace StokesMatrixFree
                  ExcMessage("Active FE indices differ!"));
 #endif
 
-          a_block_operator->reinit(partitioning_v, dof_handler_v, constraints_v);
-          schur_block_operator->reinit(partitioning_p, dof_handler_p, constraints_p);
           stokes_operator->reinit(
             partitionings, dof_handlers, constraints, system_rhs, rhs_functions);
 
+          // the blocks work on the MatrixFree object of the full operator,
+          // so that all vectors share the same partitioners
+          const auto matrix_free = stokes_operator->get_matrix_free();
+          a_block_operator->reinit(partitioning_v, matrix_free, 0, 0, constraints_v);
+          schur_block_operator->reinit(partitioning_p, matrix_free, 1, 1, constraints_p);
+
           if (prm.log_nonzero_elements)
             Log::log_nonzero_elements(stokes_operator->get_system_matrix());
 
           solve();
 
+          Log::log_memory_consumption("operators",
+                                      stokes_operator->memory_consumption() +
+                                        a_block_operator->memory_consumption() +
+                                        schur_block_operator->memory_consumption(),
+                                      mpi_communicator);
+          Log::log_memory_consumption("vectors",
+                                      locally_relevant_solution.memory_consumption() +
+                                        system_rhs.memory_consumption(),
+                                      mpi_communicator);
+
           if (prm.grid_type == "kovasznay")
             compute_errors();
           adaptation_strategy_p->estimate_mark();
@@ -707,12 +805,9 @@ namespace StokesMatrixFree
         }
 
         Log::log_timing_statistics(mpi_communicator);
+        Log::log_memory_statistics(mpi_communicator);
 
-        if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
-          {
-            std::ofstream logstream(filename_log);
-            getTable().write_text(logstream);
-          }
+        Log::write_table(filename_log, prm.log_format, mpi_communicator);
 
         getTimer().reset();
         getTable().start_new_row();